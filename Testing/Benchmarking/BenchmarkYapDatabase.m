@@ -194,6 +194,8 @@ static NSMutableArray *keys;
 	NSTimeInterval elapsed = [start timeIntervalSinceNow] * -1.0;
 	if (useLongLivedReadTransaction)
 		NSLog(@"ReadOnly transaction overhead : %.8f  (using longLivedReadTransaction)", (elapsed / loopCount));
+	else if (connection.readTransactionReuseEnabled)
+		NSLog(@"ReadOnly transaction overhead : %.8f  (using readTransactionReuseEnabled)", (elapsed / loopCount));
 	else
 		NSLog(@"ReadOnly transaction overhead : %.8f", (elapsed / loopCount));
 	
@@ -298,6 +300,10 @@ static NSMutableArray *keys;
 		
 		[self readTransactionOverhead:1000 withLongLivedReadTransaction:YES];
 		[self readTransactionOverhead:1000 withLongLivedReadTransaction:NO];
+		
+		connection.readTransactionReuseEnabled = YES;
+		[self readTransactionOverhead:1000 withLongLivedReadTransaction:NO];
+		connection.readTransactionReuseEnabled = NO;
 		[self readWriteTransactionOverhead:1000];
 		
 		NSLog(@"====================================================");
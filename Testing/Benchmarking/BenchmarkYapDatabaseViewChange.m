@@ -0,0 +1,145 @@
+#import "BenchmarkYapDatabaseViewChange.h"
+#import "YapDatabaseViewChangePrivate.h"
+#import "YapDatabaseViewMappingsPrivate.h"
+#import "YapCollectionKey.h"
+
+#define CHANGE_COUNT 20000
+#define LOOP_COUNT 5
+
+
+/**
+ * Times the processing of large changesets (the same scenarios as the test_large_* unit tests).
+ * The unit tests verify the results. Here we only care about how long it takes.
+**/
+@implementation BenchmarkYapDatabaseViewChange
+
+/**
+ * Insert a large number of items, each one at index zero (reverse order).
+**/
++ (NSTimeInterval)testInsertsAtFront
+{
+	NSMutableArray *changes = [NSMutableArray arrayWithCapacity:CHANGE_COUNT];
+	
+	for (NSUInteger i = 0; i < CHANGE_COUNT; i++)
+	{
+		NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long)i];
+		YapCollectionKey *ck = [[YapCollectionKey alloc] initWithCollection:@"" key:key];
+		
+		[changes addObject:[YapDatabaseViewRowChange insertCollectionKey:ck inGroup:@"A" atIndex:0]];
+	}
+	
+	YapDatabaseViewMappings *mappings = [[YapDatabaseViewMappings alloc] initWithGroups:@[@"A"] view:nil];
+	
+	[mappings updateWithCounts:@{ @"A": @(0) } forceUpdateRangeOptions:NO];
+	YapDatabaseViewMappings *originalMappings = [mappings copy];
+	[mappings updateWithCounts:@{ @"A": @(CHANGE_COUNT) } forceUpdateRangeOptions:NO];
+	
+	NSArray *sChanges = nil;
+	NSArray *rChanges = nil;
+	
+	NSDate *start = [NSDate date];
+	
+	[YapDatabaseViewChange getSectionChanges:&sChanges
+	                              rowChanges:&rChanges
+	                    withOriginalMappings:originalMappings
+	                           finalMappings:mappings
+	                             fromChanges:changes];
+	
+	NSTimeInterval elapsed = [start timeIntervalSinceNow] * -1.0;
+	
+	NSLog(@"Inserts at front        : elapsed = %.6f (row changes = %lu)", elapsed, (unsigned long)[rChanges count]);
+	
+	return elapsed;
+}
+
+/**
+ * Delete every other item from a large group (front to back), and update all the remaining items.
+**/
++ (NSTimeInterval)testDeletesAndUpdates
+{
+	NSUInteger deleteCount = CHANGE_COUNT / 2;
+	NSMutableArray *changes = [NSMutableArray arrayWithCapacity:CHANGE_COUNT];
+	
+	for (NSUInteger i = 0; i < deleteCount; i++)
+	{
+		NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long)(i * 2)];
+		YapCollectionKey *ck = [[YapCollectionKey alloc] initWithCollection:@"" key:key];
+		
+		[changes addObject:[YapDatabaseViewRowChange deleteCollectionKey:ck inGroup:@"A" atIndex:i]];
+	}
+	
+	for (NSUInteger i = 0; i < deleteCount; i++)
+	{
+		NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long)(i * 2 + 1)];
+		YapCollectionKey *ck = [[YapCollectionKey alloc] initWithCollection:@"" key:key];
+		
+		[changes addObject:[YapDatabaseViewRowChange updateCollectionKey:ck
+		                                                         inGroup:@"A"
+		                                                         atIndex:i
+		                                                     withChanges:YapDatabaseViewChangedObject]];
+	}
+	
+	YapDatabaseViewMappings *mappings = [[YapDatabaseViewMappings alloc] initWithGroups:@[@"A"] view:nil];
+	
+	[mappings updateWithCounts:@{ @"A": @(CHANGE_COUNT) } forceUpdateRangeOptions:NO];
+	YapDatabaseViewMappings *originalMappings = [mappings copy];
+	[mappings updateWithCounts:@{ @"A": @(CHANGE_COUNT - deleteCount) } forceUpdateRangeOptions:NO];
+	
+	NSArray *sChanges = nil;
+	NSArray *rChanges = nil;
+	
+	NSDate *start = [NSDate date];
+	
+	[YapDatabaseViewChange getSectionChanges:&sChanges
+	                              rowChanges:&rChanges
+	                    withOriginalMappings:originalMappings
+	                           finalMappings:mappings
+	                             fromChanges:changes];
+	
+	NSTimeInterval elapsed = [start timeIntervalSinceNow] * -1.0;
+	
+	NSLog(@"Deletes & updates       : elapsed = %.6f (row changes = %lu)", elapsed, (unsigned long)[rChanges count]);
+	
+	return elapsed;
+}
+
++ (void)runTestsWithCompletion:(dispatch_block_t)completionBlock
+{
+	dispatch_async(dispatch_get_main_queue(), ^{ @autoreleasepool {
+		
+		NSLog(@" \n\n\n ");
+		NSLog(@"YapDatabaseViewChange Benchmarks:");
+		NSLog(@"====================================================");
+		NSLog(@"INSERTS AT FRONT: %d changes", CHANGE_COUNT);
+		
+		NSTimeInterval total = 0.0;
+		for (int i = 0; i < LOOP_COUNT; i++)
+		{
+			total += [self testInsertsAtFront];
+		}
+		
+		NSLog(@"Average: %.6f", (total / LOOP_COUNT));
+		NSLog(@"====================================================");
+	}});
+	
+	dispatch_async(dispatch_get_main_queue(), ^{ @autoreleasepool {
+		
+		NSLog(@"DELETES & UPDATES: %d changes", CHANGE_COUNT);
+		
+		NSTimeInterval total = 0.0;
+		for (int i = 0; i < LOOP_COUNT; i++)
+		{
+			total += [self testDeletesAndUpdates];
+		}
+		
+		NSLog(@"Average: %.6f", (total / LOOP_COUNT));
+		NSLog(@"====================================================");
+	}});
+	
+	dispatch_async(dispatch_get_main_queue(), ^{
+		
+		completionBlock();
+	});
+}
+
+@end
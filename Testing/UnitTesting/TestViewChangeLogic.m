@@ -2753,4 +2753,260 @@ static YapDatabaseViewRowChange* (^RowOp)(NSArray*, NSUInteger) = ^(NSArray *rCh
 	XCTAssertTrue(RowOp(rowChanges, 1).originalIndex == 1, @"");
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Large Changesets
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (void)test_large_1A
+{
+	// Insert a large number of items, each one at index zero (reverse order).
+	//
+	// The final index of each insert is shifted by every later insert.
+	
+	NSUInteger count = 20000;
+	
+	for (NSUInteger i = 0; i < count; i++)
+	{
+		NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long)i];
+		
+		[changes addObject:[YapDatabaseViewRowChange insertCollectionKey:YCK(nil, key) inGroup:@"A" atIndex:0]];
+	}
+	
+	// Process
+	
+	NSArray *sChanges;
+	NSArray *rChanges;
+	
+	YapDatabaseViewMappings *mappings;
+	YapDatabaseViewMappings *originalMappings;
+	
+	mappings = [[YapDatabaseViewMappings alloc] initWithGroups:@[@"A"] view:nil];
+	
+	[mappings updateWithCounts:@{ @"A": @(0) } forceUpdateRangeOptions:NO];
+	originalMappings = [mappings copy];
+	[mappings updateWithCounts:@{ @"A": @(count) } forceUpdateRangeOptions:NO];
+	
+	[YapDatabaseViewChange getSectionChanges:&sChanges
+	                              rowChanges:&rChanges
+	                    withOriginalMappings:originalMappings
+	                           finalMappings:mappings
+	                             fromChanges:changes];
+	
+	// Expecting:
+	//
+	// i) Row Insert: [~ -> (count-1-i)] (key i)
+	
+	XCTAssertTrue([sChanges count] == 0, @"");
+	XCTAssertTrue([rChanges count] == count, @"");
+	
+	for (NSUInteger i = 0; i < count; i++)
+	{
+		XCTAssertTrue(RowOp(rChanges, i).type == YapDatabaseViewChangeInsert, @"");
+		XCTAssertTrue(RowOp(rChanges, i).finalIndex == (count - 1 - i), @"");
+	}
+}
+
+- (void)test_large_1B
+{
+	// Delete every other item from a large group (front to back),
+	// and update all the remaining items.
+	//
+	// The recorded index of each delete is shifted by every earlier delete.
+	
+	NSUInteger count = 20000;
+	NSUInteger deleteCount = count / 2;
+	
+	for (NSUInteger i = 0; i < deleteCount; i++)
+	{
+		NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long)(i * 2)];
+		
+		[changes addObject:[YapDatabaseViewRowChange deleteCollectionKey:YCK(nil, key) inGroup:@"A" atIndex:i]];
+	}
+	
+	for (NSUInteger i = 0; i < deleteCount; i++)
+	{
+		NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long)(i * 2 + 1)];
+		
+		[changes addObject:[YapDatabaseViewRowChange updateCollectionKey:YCK(nil, key)
+		                                                         inGroup:@"A"
+		                                                         atIndex:i
+		                                                     withChanges:YapDatabaseViewChangedObject]];
+	}
+	
+	// Process
+	
+	NSArray *sChanges;
+	NSArray *rChanges;
+	
+	YapDatabaseViewMappings *mappings;
+	YapDatabaseViewMappings *originalMappings;
+	
+	mappings = [[YapDatabaseViewMappings alloc] initWithGroups:@[@"A"] view:nil];
+	
+	[mappings updateWithCounts:@{ @"A": @(count) } forceUpdateRangeOptions:NO];
+	originalMappings = [mappings copy];
+	[mappings updateWithCounts:@{ @"A": @(count - deleteCount) } forceUpdateRangeOptions:NO];
+	
+	[YapDatabaseViewChange getSectionChanges:&sChanges
+	                              rowChanges:&rChanges
+	                    withOriginalMappings:originalMappings
+	                           finalMappings:mappings
+	                             fromChanges:changes];
+	
+	// Expecting:
+	//
+	// i) Row Delete: [(i*2) -> ~] (key i*2)
+	// ...
+	// i) Row Update: [(i*2+1) -> i] (key i*2+1)
+	
+	XCTAssertTrue([sChanges count] == 0, @"");
+	XCTAssertTrue([rChanges count] == count, @"");
+	
+	for (NSUInteger i = 0; i < deleteCount; i++)
+	{
+		XCTAssertTrue(RowOp(rChanges, i).type == YapDatabaseViewChangeDelete, @"");
+		XCTAssertTrue(RowOp(rChanges, i).originalIndex == (i * 2), @"");
+	}
+	
+	for (NSUInteger i = 0; i < deleteCount; i++)
+	{
+		YapDatabaseViewRowChange *rowChange = RowOp(rChanges, deleteCount + i);
+		
+		XCTAssertTrue(rowChange.originalIndex == (i * 2 + 1), @"");
+		XCTAssertTrue(rowChange.finalIndex == i, @"");
+	}
+}
+
+- (void)test_large_2A
+{
+	//           orig   final
+	//
+	// A[0, 0] | a0   | a0   |
+	// ...
+	// A[0, 99]| a99  | a99  |
+	// A[0,100]|      | a100 | <- 50 inserts (exceeds resetGroupThreshold)
+	// ...
+	// --------|------|------|
+	// B[1, 0] | b0   | b0   |
+	// B[1, 1] |      | b1   | <- 1 insert
+	// --------|------|------|
+	
+	for (NSUInteger i = 0; i < 50; i++)
+	{
+		NSString *key = [NSString stringWithFormat:@"a%lu", (unsigned long)(100 + i)];
+		
+		[changes addObject:[YapDatabaseViewRowChange insertCollectionKey:YCK(nil, key) inGroup:@"A" atIndex:(100 + i)]];
+	}
+	
+	[changes addObject:[YapDatabaseViewRowChange insertCollectionKey:YCK(nil, @"b1") inGroup:@"B" atIndex:1]];
+	
+	// Process
+	
+	NSArray *sChanges;
+	NSArray *rChanges;
+	
+	YapDatabaseViewMappings *mappings;
+	YapDatabaseViewMappings *originalMappings;
+	
+	mappings = [[YapDatabaseViewMappings alloc] initWithGroups:@[@"A", @"B"] view:nil];
+	[mappings setResetGroupThreshold:10];
+	
+	[mappings updateWithCounts:@{ @"A": @(100), @"B": @(1) } forceUpdateRangeOptions:NO];
+	originalMappings = [mappings copy];
+	[mappings updateWithCounts:@{ @"A": @(150), @"B": @(2) } forceUpdateRangeOptions:NO];
+	
+	[YapDatabaseViewChange getSectionChanges:&sChanges
+	                              rowChanges:&rChanges
+	                    withOriginalMappings:originalMappings
+	                           finalMappings:mappings
+	                             fromChanges:changes];
+	
+	// Expecting:
+	//
+	// 0) Section Delete: 0 (A)
+	// 1) Section Insert: 0 (A)
+	//
+	// 0) Row Insert: [~ -> 1, 1] (b1)
+	
+	XCTAssertTrue([sChanges count] == 2, @"");
+	
+	XCTAssertTrue(SectionOp(sChanges, 0).type == YapDatabaseViewChangeDelete, @"");
+	XCTAssertTrue(SectionOp(sChanges, 0).index == 0, @"");
+	
+	XCTAssertTrue(SectionOp(sChanges, 1).type == YapDatabaseViewChangeInsert, @"");
+	XCTAssertTrue(SectionOp(sChanges, 1).index == 0, @"");
+	
+	XCTAssertTrue([rChanges count] == 1, @"");
+	
+	XCTAssertTrue(RowOp(rChanges, 0).type == YapDatabaseViewChangeInsert, @"");
+	XCTAssertTrue(RowOp(rChanges, 0).finalSection == 1, @"");
+	XCTAssertTrue(RowOp(rChanges, 0).finalIndex == 1, @"");
+}
+
+- (void)test_large_2B
+{
+	//           orig   final
+	//
+	// A[0, 0] | a0   | a1   | <- a0 moved from A to B
+	// A[0, 1] | a1   | a2   |
+	// ...     |      |      | <- 20 updates (exceeds resetGroupThreshold)
+	// --------|------|------|
+	// B[1, 0] | b0   | a0   |
+	// B[1, 1] |      | b0   |
+	// --------|------|------|
+	
+	[changes addObject:[YapDatabaseViewRowChange deleteCollectionKey:YCK(nil, @"a0") inGroup:@"A" atIndex:0]];
+	[changes addObject:[YapDatabaseViewRowChange insertCollectionKey:YCK(nil, @"a0") inGroup:@"B" atIndex:0]];
+	
+	for (NSUInteger i = 0; i < 20; i++)
+	{
+		NSString *key = [NSString stringWithFormat:@"a%lu", (unsigned long)(i + 1)];
+		
+		[changes addObject:[YapDatabaseViewRowChange updateCollectionKey:YCK(nil, key)
+		                                                         inGroup:@"A"
+		                                                         atIndex:i
+		                                                     withChanges:YapDatabaseViewChangedObject]];
+	}
+	
+	// Process
+	
+	NSArray *sChanges;
+	NSArray *rChanges;
+	
+	YapDatabaseViewMappings *mappings;
+	YapDatabaseViewMappings *originalMappings;
+	
+	mappings = [[YapDatabaseViewMappings alloc] initWithGroups:@[@"A", @"B"] view:nil];
+	[mappings setResetGroupThreshold:10];
+	
+	[mappings updateWithCounts:@{ @"A": @(21), @"B": @(1) } forceUpdateRangeOptions:NO];
+	originalMappings = [mappings copy];
+	[mappings updateWithCounts:@{ @"A": @(20), @"B": @(2) } forceUpdateRangeOptions:NO];
+	
+	[YapDatabaseViewChange getSectionChanges:&sChanges
+	                              rowChanges:&rChanges
+	                    withOriginalMappings:originalMappings
+	                           finalMappings:mappings
+	                             fromChanges:changes];
+	
+	// Expecting:
+	//
+	// 0) Section Delete: 0 (A)
+	// 1) Section Insert: 0 (A)
+	//
+	// 0) Row Insert: [~ -> 1, 0] (a0) (the move out of the reset group becomes an insert)
+	
+	XCTAssertTrue([sChanges count] == 2, @"");
+	
+	XCTAssertTrue(SectionOp(sChanges, 0).type == YapDatabaseViewChangeDelete, @"");
+	XCTAssertTrue(SectionOp(sChanges, 1).type == YapDatabaseViewChangeInsert, @"");
+	
+	XCTAssertTrue([rChanges count] == 1, @"");
+	
+	XCTAssertTrue(RowOp(rChanges, 0).type == YapDatabaseViewChangeInsert, @"");
+	XCTAssertTrue(RowOp(rChanges, 0).finalSection == 1, @"");
+	XCTAssertTrue(RowOp(rChanges, 0).finalIndex == 0, @"");
+}
+
 @end
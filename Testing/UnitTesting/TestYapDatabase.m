@@ -554,6 +554,393 @@
 	}
 }
 
+- (void)testChangesetCacheInvalidation
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	/// Ensure the caches of other connections are properly updated,
+	/// both for commits smaller than the caches, and for commits larger than the caches.
+	
+	YapDatabaseConnection *connection1 = [database newConnection];
+	YapDatabaseConnection *connection2 = [database newConnection];
+	
+	NSUInteger count = 2000;
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (NSUInteger i = 0; i < count; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"%lu", (unsigned long)i];
+			[transaction setObject:@"v1" forKey:key inCollection:nil withMetadata:@"m1"];
+		}
+	}];
+	
+	// Fill the caches of connection2
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		[transaction enumerateKeysAndObjectsInCollection:nil usingBlock:^(NSString *key, id object, BOOL *stop) {
+			
+			XCTAssertEqualObjects(object, @"v1", @"Bad object");
+		}];
+		
+		for (NSUInteger i = 0; i < 100; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"%lu", (unsigned long)i];
+			XCTAssertEqualObjects([transaction metadataForKey:key inCollection:nil], @"m1", @"Bad metadata");
+		}
+	}];
+	
+	// Small commit (smaller than the caches)
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"v2" forKey:@"0" inCollection:nil withMetadata:@"m2"];
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertEqualObjects([transaction objectForKey:@"0" inCollection:nil], @"v2", @"Bad object");
+		XCTAssertEqualObjects([transaction metadataForKey:@"0" inCollection:nil], @"m2", @"Bad metadata");
+		XCTAssertEqualObjects([transaction objectForKey:@"1" inCollection:nil], @"v1", @"Bad object");
+	}];
+	
+	// Large commit (larger than the caches), with updates & removals
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (NSUInteger i = 0; i < count; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"%lu", (unsigned long)i];
+			
+			if (i % 2 == 0)
+				[transaction setObject:@"v3" forKey:key inCollection:nil withMetadata:@"m3"];
+			else
+				[transaction removeObjectForKey:key inCollection:nil];
+		}
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertTrue([transaction numberOfKeysInCollection:nil] == (count / 2), @"Bad count");
+		
+		for (NSUInteger i = 0; i < 100; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"%lu", (unsigned long)i];
+			
+			if (i % 2 == 0)
+			{
+				XCTAssertEqualObjects([transaction objectForKey:key inCollection:nil], @"v3", @"Bad object");
+				XCTAssertEqualObjects([transaction metadataForKey:key inCollection:nil], @"m3", @"Bad metadata");
+			}
+			else
+			{
+				XCTAssertNil([transaction objectForKey:key inCollection:nil], @"Expected nil object");
+				XCTAssertNil([transaction metadataForKey:key inCollection:nil], @"Expected nil metadata");
+			}
+		}
+		
+		[transaction enumerateKeysAndObjectsInCollection:nil usingBlock:^(NSString *key, id object, BOOL *stop) {
+			
+			XCTAssertTrue([key integerValue] % 2 == 0, @"Enumerated removed key");
+			XCTAssertEqualObjects(object, @"v3", @"Bad object");
+		}];
+	}];
+}
+
+- (void)testLazyChangesetProcessing
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection1 = [database newConnection];
+	YapDatabaseConnection *connection2 = [database newConnection];
+	
+	connection2.lazyChangesetProcessing = YES;
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"v0" forKey:@"key" inCollection:nil withMetadata:@"m0"];
+	}];
+	
+	// Fill the caches of connection2
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertEqualObjects([transaction objectForKey:@"key" inCollection:nil], @"v0", @"Bad object");
+		XCTAssertEqualObjects([transaction metadataForKey:@"key" inCollection:nil], @"m0", @"Bad metadata");
+	}];
+	
+	// A few commits: connection2 stays idle, and catches up from the retained changesets.
+	
+	for (NSUInteger i = 1; i <= 5; i++)
+	{
+		[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+			
+			NSString *object = [NSString stringWithFormat:@"v%lu", (unsigned long)i];
+			[transaction setObject:object forKey:@"key" inCollection:nil withMetadata:@"m1"];
+		}];
+	}
+	
+	XCTAssertTrue(connection2.snapshot < database.snapshot, @"Lazy connection was sent changesets");
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertEqualObjects([transaction objectForKey:@"key" inCollection:nil], @"v5", @"Bad object");
+		XCTAssertEqualObjects([transaction metadataForKey:@"key" inCollection:nil], @"m1", @"Bad metadata");
+	}];
+	
+	XCTAssertTrue(connection2.snapshot == database.snapshot, @"Lazy connection didn't catch up");
+	
+	// Many more commits than the database retains: connection2 has to drop its caches.
+	
+	NSUInteger commitCount = database.options.maxRetainedChangesets * 2;
+	
+	for (NSUInteger i = 0; i < commitCount; i++)
+	{
+		[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+			
+			NSString *object = [NSString stringWithFormat:@"w%lu", (unsigned long)i];
+			[transaction setObject:object forKey:@"key" inCollection:nil withMetadata:@"m2"];
+			
+			if (i == 0)
+				[transaction setObject:@"other" forKey:@"other" inCollection:nil];
+		}];
+	}
+	
+	NSString *lastObject = [NSString stringWithFormat:@"w%lu", (unsigned long)(commitCount - 1)];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertEqualObjects([transaction objectForKey:@"key" inCollection:nil], lastObject, @"Bad object");
+		XCTAssertEqualObjects([transaction metadataForKey:@"key" inCollection:nil], @"m2", @"Bad metadata");
+		XCTAssertEqualObjects([transaction objectForKey:@"other" inCollection:nil], @"other", @"Bad object");
+	}];
+	
+	// Switching back to eager processing
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"x0" forKey:@"key" inCollection:nil];
+	}];
+	
+	connection2.lazyChangesetProcessing = NO;
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"x1" forKey:@"key" inCollection:nil];
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertEqualObjects([transaction objectForKey:@"key" inCollection:nil], @"x1", @"Bad object");
+	}];
+	
+	XCTAssertTrue(connection2.snapshot == database.snapshot, @"Eager connection out of sync");
+}
+
+- (void)testReadTransactionReuse
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection1 = [database newConnection];
+	YapDatabaseConnection *connection2 = [database newConnection];
+	
+	connection2.readTransactionReuseEnabled = YES;
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"v0" forKey:@"key" inCollection:nil];
+	}];
+	
+	// Consecutive reads with no commits in between share a transaction.
+	
+	__block YapDatabaseReadTransaction *firstTransaction = nil;
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertEqualObjects([transaction objectForKey:@"key" inCollection:nil], @"v0", @"Bad object");
+		firstTransaction = transaction;
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertEqualObjects([transaction objectForKey:@"key" inCollection:nil], @"v0", @"Bad object");
+		XCTAssertTrue(transaction == firstTransaction, @"Expected reused transaction");
+	}];
+	
+	// A commit from another connection must not be hidden by the reused transaction.
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"v1" forKey:@"key" inCollection:nil];
+		[transaction setObject:@"other" forKey:@"other" inCollection:nil];
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertTrue(transaction != firstTransaction, @"Reused stale transaction");
+		XCTAssertEqualObjects([transaction objectForKey:@"key" inCollection:nil], @"v1", @"Bad object");
+		XCTAssertEqualObjects([transaction objectForKey:@"other" inCollection:nil], @"other", @"Bad object");
+	}];
+	
+	// The connection can still write, and start long-lived read transactions.
+	
+	[connection2 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"v2" forKey:@"key" inCollection:nil];
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertEqualObjects([transaction objectForKey:@"key" inCollection:nil], @"v2", @"Bad object");
+	}];
+	
+	[connection2 beginLongLivedReadTransaction];
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"v3" forKey:@"key" inCollection:nil];
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertEqualObjects([transaction objectForKey:@"key" inCollection:nil], @"v2", @"Bad object");
+	}];
+	
+	[connection2 endLongLivedReadTransaction];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertEqualObjects([transaction objectForKey:@"key" inCollection:nil], @"v3", @"Bad object");
+	}];
+	
+	connection2.readTransactionReuseEnabled = NO;
+}
+
+- (void)testConnectionPool
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *writeConnection = [database newConnection];
+	YapDatabaseConnectionPool *pool = [[YapDatabaseConnectionPool alloc] initWithDatabase:database connectionCount:4];
+	
+	XCTAssertTrue([pool.connections count] == 4, @"Wrong connection count");
+	
+	NSUInteger count = 100;
+	
+	[writeConnection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (NSUInteger i = 0; i < count; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"%lu", (unsigned long)i];
+			[transaction setObject:key forKey:key inCollection:@"pool"];
+		}
+	}];
+	
+	// Sync reads from many threads at once
+	
+	__block int32_t matches = 0;
+	
+	dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+		
+		NSString *key = [NSString stringWithFormat:@"%lu", (unsigned long)i];
+		
+		[pool readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+			
+			if ([[transaction objectForKey:key inCollection:@"pool"] isEqual:key])
+				OSAtomicIncrement32(&matches);
+		}];
+	});
+	
+	XCTAssertTrue(matches == (int32_t)count, @"Bad read results");
+	XCTAssertTrue([pool totalQueueDepth] == 0, @"Queue depth should be zero when idle");
+	
+	// Async reads
+	
+	matches = 0;
+	
+	dispatch_group_t group = dispatch_group_create();
+	dispatch_queue_t completionQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+	
+	for (NSUInteger i = 0; i < count; i++)
+	{
+		NSString *key = [NSString stringWithFormat:@"%lu", (unsigned long)i];
+		
+		dispatch_group_enter(group);
+		[pool asyncReadWithBlock:^(YapDatabaseReadTransaction *transaction) {
+			
+			if ([[transaction objectForKey:key inCollection:@"pool"] isEqual:key])
+				OSAtomicIncrement32(&matches);
+			
+		} completionQueue:completionQueue completionBlock:^{
+			
+			dispatch_group_leave(group);
+		}];
+	}
+	
+	dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+	
+	XCTAssertTrue(matches == (int32_t)count, @"Bad read results");
+	XCTAssertTrue([pool totalQueueDepth] == 0, @"Queue depth should be zero when idle");
+	
+	for (NSNumber *depth in [pool queueDepths])
+	{
+		XCTAssertTrue([depth intValue] == 0, @"Queue depth should be zero when idle");
+	}
+	
+	// Collection affinity: an idle pool always picks the same connection for the same collection.
+	
+	__block YapDatabaseConnection *affinityConnection = nil;
+	
+	[pool readWithCollectionAffinity:@"pool" block:^(YapDatabaseReadTransaction *transaction) {
+		
+		affinityConnection = transaction.connection;
+	}];
+	
+	for (NSUInteger i = 0; i < 10; i++)
+	{
+		[pool readWithCollectionAffinity:@"pool" block:^(YapDatabaseReadTransaction *transaction) {
+			
+			XCTAssertTrue(transaction.connection == affinityConnection, @"Affinity not respected");
+		}];
+	}
+	
+	// Pool connections see subsequent commits
+	
+	[writeConnection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"updated" forKey:@"0" inCollection:@"pool"];
+	}];
+	
+	for (NSUInteger i = 0; i < [pool.connections count]; i++)
+	{
+		[pool readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+			
+			XCTAssertEqualObjects([transaction objectForKey:@"0" inCollection:@"pool"], @"updated", @"Bad object");
+		}];
+	}
+}
+
 - (void)testPropertyListSerializerDeserializer
 {
 	YapDatabaseSerializer propertyListSerializer = [YapDatabase propertyListSerializer];
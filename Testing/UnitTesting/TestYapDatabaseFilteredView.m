@@ -476,6 +476,166 @@
 #pragma mark -
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+- (void)testRepopulateConcurrent_persistent
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	YapDatabaseViewOptions *options = [[YapDatabaseViewOptions alloc] init];
+	options.isPersistent = YES;
+	options.allowsConcurrentFiltering = YES;
+	
+	[self _testRepopulateConcurrent_withPath:databasePath options:options];
+}
+
+- (void)testRepopulateConcurrent_nonPersistent
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	YapDatabaseViewOptions *options = [[YapDatabaseViewOptions alloc] init];
+	options.isPersistent = NO;
+	options.allowsConcurrentFiltering = YES;
+	
+	[self _testRepopulateConcurrent_withPath:databasePath options:options];
+}
+
+- (void)_testRepopulateConcurrent_withPath:(NSString *)databasePath options:(YapDatabaseViewOptions *)options
+{
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection1 = [database newConnection];
+	YapDatabaseConnection *connection2 = [database newConnection];
+	
+	// Use enough items to span multiple filtering chunks,
+	// and don't let them all fit in the cache.
+	
+	connection1.objectCacheLimit = 100;
+	
+	int itemCount = 2000;
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction){
+		
+		for (int i = 0; i < itemCount; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"key%d", i];
+			
+			[transaction setObject:@(i) forKey:key inCollection:nil];
+		}
+	}];
+	
+	YapDatabaseViewGrouping *grouping = [YapDatabaseViewGrouping withObjectBlock:
+	    ^NSString *(NSString *collection, NSString *key, id object)
+	{
+		return ([(NSNumber *)object intValue] < (itemCount / 2)) ? @"low" : @"high";
+	}];
+	
+	YapDatabaseViewSorting *sorting = [YapDatabaseViewSorting withObjectBlock:
+	    ^(NSString *group, NSString *collection1, NSString *key1, id obj1,
+	                       NSString *collection2, NSString *key2, id obj2)
+	{
+		__unsafe_unretained NSNumber *number1 = (NSNumber *)obj1;
+		__unsafe_unretained NSNumber *number2 = (NSNumber *)obj2;
+		
+		return [number1 compare:number2];
+	}];
+	
+	YapDatabaseView *view =
+	  [[YapDatabaseView alloc] initWithGrouping:grouping
+	                                    sorting:sorting
+	                                 versionTag:@"1"
+	                                    options:options];
+	
+	BOOL registerResult1 = [database registerExtension:view withName:@"order"];
+	XCTAssertTrue(registerResult1, @"Failure registering view extension");
+	
+	YapDatabaseViewFiltering *filtering = [YapDatabaseViewFiltering withObjectBlock:
+	    ^BOOL (NSString *group, NSString *collection, NSString *key, id object)
+	{
+		return ([(NSNumber *)object intValue] % 2 == 0); // even
+	}];
+	
+	YapDatabaseFilteredView *filteredView =
+	  [[YapDatabaseFilteredView alloc] initWithParentViewName:@"order"
+	                                                filtering:filtering
+	                                               versionTag:@"even"
+	                                                  options:options];
+	
+	BOOL registerResult2 = [database registerExtension:filteredView withName:@"filter"];
+	XCTAssertTrue(registerResult2, @"Failure registering filteredView extension");
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction){
+		
+		NSUInteger filterCount = [[transaction ext:@"filter"] numberOfItemsInAllGroups];
+		XCTAssertTrue(filterCount == 1000, @"Bad count in filter. Expected 1000, got %d", (int)filterCount);
+	}];
+	
+	//
+	// Now update the filterBlock (using a key block)
+	//
+	
+	filtering = [YapDatabaseViewFiltering withKeyBlock:
+	    ^BOOL (NSString *group, NSString *collection, NSString *key)
+	{
+		return [key hasSuffix:@"5"];
+	}];
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[[transaction ext:@"filter"] setFiltering:filtering versionTag:@"suffix5"];
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction){
+		
+		NSUInteger filterCount = [[transaction ext:@"filter"] numberOfItemsInAllGroups];
+		XCTAssertTrue(filterCount == 200, @"Bad count in filter. Expected 200, got %d", (int)filterCount);
+		
+		// Order must match the parentView
+		
+		__block int lastNum = -1;
+		[[transaction ext:@"filter"] enumerateKeysAndObjectsInGroup:@"low"
+		                                                 usingBlock:
+		    ^(NSString *collection, NSString *key, id object, NSUInteger index, BOOL *stop)
+		{
+			int num = [(NSNumber *)object intValue];
+			
+			XCTAssertTrue(num > lastNum, @"Bad order in filter");
+			XCTAssertTrue(num % 10 == 5, @"Bad item in filter");
+			
+			lastNum = num;
+		}];
+	}];
+	
+	//
+	// And once more (using a row block)
+	//
+	
+	filtering = [YapDatabaseViewFiltering withRowBlock:
+	    ^BOOL (NSString *group, NSString *collection, NSString *key, id object, id metadata)
+	{
+		return ([(NSNumber *)object intValue] % 3 == 0);
+	}];
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[[transaction ext:@"filter"] setFiltering:filtering versionTag:@"mod3"];
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction){
+		
+		NSUInteger filterCount = [[transaction ext:@"filter"] numberOfItemsInAllGroups];
+		XCTAssertTrue(filterCount == 667, @"Bad count in filter. Expected 667, got %d", (int)filterCount);
+	}];
+	
+	connection1 = nil;
+	connection2 = nil;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 - (void)testUnregistration_persistent
 {
 	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
@@ -3,6 +3,8 @@
 #import "YapDatabase.h"
 #import "YapDatabaseFullTextSearch.h"
 
+#import "sqlite3.h"
+
 #import "DDLog.h"
 #import "DDTTYLogger.h"
 
@@ -227,4 +229,319 @@
 	}];
 }
 
+- (void)testRankedFTS5
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	
+	YapDatabaseFullTextSearchHandler *handler = [YapDatabaseFullTextSearchHandler withObjectBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object){
+		
+		NSArray *parts = (NSArray *)object;
+		[dict setObject:parts[0] forKey:@"title"];
+		[dict setObject:parts[1] forKey:@"body"];
+	}];
+	
+	// Create an fts4 table (the default)
+	
+	@autoreleasepool {
+		
+		YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+		XCTAssertNotNil(database, @"Oops");
+		
+		YapDatabaseConnection *connection = [database newConnection];
+		
+		YapDatabaseFullTextSearch *fts =
+		  [[YapDatabaseFullTextSearch alloc] initWithColumnNames:@[@"title", @"body"]
+		                                                 handler:handler];
+		
+		XCTAssertTrue([database registerExtension:fts withName:@"fts"], @"Oops");
+		
+		[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+			
+			[transaction setObject:@[@"coffee", @"tea"]               forKey:@"key1" inCollection:nil];
+			[transaction setObject:@[@"tea",    @"coffee coffee tea"] forKey:@"key2" inCollection:nil];
+			[transaction setObject:@[@"tea",    @"coffee"]            forKey:@"key3" inCollection:nil];
+			[transaction setObject:@[@"tea",    @"biscuits"]          forKey:@"key4" inCollection:nil];
+		}];
+		
+		[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+			
+			// Ranking isn't available with fts4, but the limit is still honored
+			
+			__block NSUInteger count = 0;
+			[[transaction ext:@"fts"] enumerateKeysMatching:@"coffee"
+			                             withRankingWeights:nil
+			                                          limit:2
+			                                     usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+				count++;
+			}];
+			XCTAssertTrue(count == 2, @"Bad count: %lu", (unsigned long)count);
+		}];
+	}
+	
+	// Re-open the database with fts5 (and prefix indexes).
+	// The existing fts4 table should be migrated automatically.
+	
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	YapDatabaseFullTextSearch *fts =
+	  [[YapDatabaseFullTextSearch alloc] initWithColumnNames:@[@"title", @"body"]
+	                                                 options:@{ @"prefix": @"2 3" }
+	                                                 handler:handler
+	                                              ftsVersion:YapDatabaseFullTextSearchFTS5Version
+	                                              versionTag:nil];
+	
+	XCTAssertTrue([database registerExtension:fts withName:@"fts"], @"Oops");
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSMutableArray *keys = [NSMutableArray array];
+		
+		// Matches in the title are worth more
+		
+		[[transaction ext:@"fts"] enumerateKeysMatching:@"coffee"
+		                             withRankingWeights:@{ @"title": @(10.0) }
+		                                          limit:0
+		                                     usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			[keys addObject:key];
+		}];
+		XCTAssertEqualObjects(keys, (@[@"key1", @"key2", @"key3"]), @"Bad ranking");
+		
+		// Matches in the body are worth more
+		
+		[keys removeAllObjects];
+		[[transaction ext:@"fts"] enumerateKeysMatching:@"coffee"
+		                             withRankingWeights:@{ @"body": @(10.0) }
+		                                          limit:0
+		                                     usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			[keys addObject:key];
+		}];
+		XCTAssertEqualObjects(keys, (@[@"key2", @"key3", @"key1"]), @"Bad ranking");
+		
+		// Top-k prefix query
+		
+		[keys removeAllObjects];
+		[[transaction ext:@"fts"] enumerateKeysMatching:@"cof*"
+		                             withRankingWeights:@{ @"body": @(10.0) }
+		                                          limit:2
+		                                     usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			[keys addObject:key];
+		}];
+		XCTAssertEqualObjects(keys, (@[@"key2", @"key3"]), @"Bad ranking");
+		
+		// Snippets use the fts5 snippet function
+		
+		__block NSString *snippet = nil;
+		[[transaction ext:@"fts"] enumerateKeysMatching:@"biscuits"
+		                             withSnippetOptions:nil
+		                                     usingBlock:
+		    ^(NSString *aSnippet, NSString *collection, NSString *key, BOOL *stop) {
+			
+			snippet = aSnippet;
+		}];
+		XCTAssertEqualObjects(snippet, @"<b>biscuits</b>", @"Bad snippet");
+	}];
+}
+
+- (void)testContentless
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	YapDatabaseFullTextSearchHandler *handler = [YapDatabaseFullTextSearchHandler withObjectBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object){
+		
+		[dict setObject:object forKey:@"content"];
+	}];
+	
+	YapDatabaseFullTextSearch *fts =
+	  [[YapDatabaseFullTextSearch alloc] initWithColumnNames:@[@"content"]
+	                                                 options:@{ @"content": @"" }
+	                                                 handler:handler
+	                                              ftsVersion:YapDatabaseFullTextSearchFTS5Version
+	                                              versionTag:nil];
+	
+	if (![database registerExtension:fts withName:@"fts"])
+	{
+		// Contentless tables require sqlite 3.43 or later
+		NSLog(@"Skipping %@ : sqlite version too old", NSStringFromSelector(_cmd));
+		return;
+	}
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"hello world"       forKey:@"key1" inCollection:nil];
+		[transaction setObject:@"hello coffee shop" forKey:@"key2" inCollection:nil];
+		[transaction setObject:@"hello laptop"      forKey:@"key3" inCollection:nil];
+		[transaction setObject:@"hello work"        forKey:@"key4" inCollection:nil];
+	}];
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"hello distraction" forKey:@"key4" inCollection:nil];
+		[transaction removeObjectForKey:@"key3" inCollection:nil];
+	}];
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		__block NSUInteger count;
+		
+		count = 0;
+		[[transaction ext:@"fts"] enumerateKeysMatching:@"hello"
+		                                     usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			count++;
+		}];
+		XCTAssertTrue(count == 3, @"Bad count: %lu", (unsigned long)count);
+		
+		count = 0;
+		[[transaction ext:@"fts"] enumerateKeysMatching:@"work OR laptop"
+		                                     usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			count++;
+		}];
+		XCTAssertTrue(count == 0, @"Bad count: %lu", (unsigned long)count);
+		
+		// Snippets are generated on demand
+		
+		YapDatabaseFullTextSearchSnippetOptions *options = [YapDatabaseFullTextSearchSnippetOptions new];
+		options.startMatchText = @"[[";
+		options.endMatchText   = @"]]";
+		
+		NSMutableDictionary *snippets = [NSMutableDictionary dictionary];
+		[[transaction ext:@"fts"] enumerateKeysMatching:@"coffee OR distraction"
+		                             withSnippetOptions:options
+		                                     usingBlock:
+		    ^(NSString *snippet, NSString *collection, NSString *key, BOOL *stop) {
+			
+			if (snippet) snippets[key] = snippet;
+		}];
+		
+		XCTAssertTrue([snippets count] == 2, @"Missing search results");
+		XCTAssertEqualObjects(snippets[@"key2"], @"hello [[coffee]] shop", @"Bad snippet");
+		XCTAssertEqualObjects(snippets[@"key4"], @"hello [[distraction]]", @"Bad snippet");
+	}];
+}
+
+- (void)testPopulate
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	// Add the rows before registering the extension,
+	// so the FTS table is built in bulk (multiple chunks, plus a partial batch at the end).
+	
+	NSUInteger total = 2503;
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (NSUInteger i = 0; i < total; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long)i];
+			NSString *text = (i % 2 == 0) ? @"hello even world" : @"hello odd world";
+			
+			[transaction setObject:text forKey:key inCollection:nil];
+		}
+		
+		[transaction setObject:@[@"not a string"] forKey:@"skip" inCollection:nil];
+	}];
+	
+	YapDatabaseFullTextSearchHandler *handler = [YapDatabaseFullTextSearchHandler withObjectBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object){
+		
+		if ([object isKindOfClass:[NSString class]])
+		{
+			[dict setObject:object forKey:@"content"];
+		}
+	}];
+	handler.concurrentTextExtraction = YES;
+	
+	YapDatabaseFullTextSearch *fts =
+	  [[YapDatabaseFullTextSearch alloc] initWithColumnNames:@[@"content"]
+	                                                 options:nil
+	                                                 handler:handler
+	                                              ftsVersion:YapDatabaseFullTextSearchFTS5Version
+	                                              versionTag:nil];
+	
+	XCTAssertTrue([database registerExtension:fts withName:@"fts"], @"Oops");
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		__block NSUInteger count;
+		
+		count = 0;
+		[[transaction ext:@"fts"] enumerateKeysMatching:@"hello"
+		                                     usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			count++;
+		}];
+		XCTAssertTrue(count == total, @"Bad count: %lu", (unsigned long)count);
+		
+		count = 0;
+		[[transaction ext:@"fts"] enumerateKeysMatching:@"odd"
+		                                     usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			count++;
+		}];
+		XCTAssertTrue(count == (total / 2), @"Bad count: %lu", (unsigned long)count);
+	}];
+	
+	// The merge settings are restored after the bulk build (they're stored in the table's config shadow table)
+	
+	sqlite3 *db = NULL;
+	if (sqlite3_open_v2([databasePath UTF8String], &db, SQLITE_OPEN_READONLY, NULL) == SQLITE_OK)
+	{
+		sqlite3_stmt *statement = NULL;
+		sqlite3_prepare_v2(db, "SELECT \"k\", \"v\" FROM \"fts_fts_config\";", -1, &statement, NULL);
+		
+		NSMutableDictionary *config = [NSMutableDictionary dictionary];
+		
+		while (statement && sqlite3_step(statement) == SQLITE_ROW)
+		{
+			NSString *k = [NSString stringWithUTF8String:(const char *)sqlite3_column_text(statement, 0)];
+			config[k] = @(sqlite3_column_int(statement, 1));
+		}
+		
+		sqlite3_finalize(statement);
+		
+		XCTAssertEqualObjects(config[@"automerge"], @(4), @"automerge wasn't restored");
+		XCTAssertEqualObjects(config[@"crisismerge"], @(16), @"crisismerge wasn't restored");
+	}
+	else
+	{
+		XCTFail(@"Unable to open database");
+	}
+	sqlite3_close(db);
+	
+	// Regular updates still work after the bulk build
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"goodbye" forKey:@"key0" inCollection:nil];
+	}];
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		__block NSUInteger count = 0;
+		[[transaction ext:@"fts"] enumerateKeysMatching:@"hello"
+		                                     usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			count++;
+		}];
+		XCTAssertTrue(count == (total - 1), @"Bad count: %lu", (unsigned long)count);
+	}];
+}
+
 @end
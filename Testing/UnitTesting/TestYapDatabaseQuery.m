@@ -43,4 +43,24 @@
 	XCTAssertTrue([query.queryParameters isEqualToArray:expectedArguments], @"Incorrect queryParameters");
 }
 
+- (void)testCompiledQueryParameterCount
+{
+	YapDatabaseCompiledQuery *query;
+	
+	query = [YapDatabaseCompiledQuery compiledQueryWithString:@"WHERE col > ? AND col < ?"];
+	XCTAssertTrue(query.parameterCount == 2, @"Bad parameterCount: %lu", (unsigned long)query.parameterCount);
+	
+	query = [YapDatabaseCompiledQuery compiledQueryWithString:@"WHERE col = 'what?' AND \"odd?\" = ?"];
+	XCTAssertTrue(query.parameterCount == 1, @"Bad parameterCount: %lu", (unsigned long)query.parameterCount);
+	
+	query = [YapDatabaseCompiledQuery compiledQueryWithString:@"WHERE col = 'it''s ?' AND [x?] = ? -- why?\n AND y = ?"];
+	XCTAssertTrue(query.parameterCount == 2, @"Bad parameterCount: %lu", (unsigned long)query.parameterCount);
+	
+	query = [YapDatabaseCompiledQuery compiledQueryWithString:@"WHERE /* ? */ col > ?1 AND col < ?1 + ?2"];
+	XCTAssertTrue(query.parameterCount == 2, @"Bad parameterCount: %lu", (unsigned long)query.parameterCount);
+	
+	query = [YapDatabaseCompiledQuery compiledQueryWithString:@"WHERE col > ?3 AND col < ?"];
+	XCTAssertTrue(query.parameterCount == 4, @"Bad parameterCount: %lu", (unsigned long)query.parameterCount);
+}
+
 @end
\ No newline at end of file
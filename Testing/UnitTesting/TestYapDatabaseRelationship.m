@@ -4006,4 +4006,1064 @@
 	XCTAssertTrue(!exists2, @"Oops");
 }
 
+- (void)testTraversal
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection1 = [database newConnection];
+	YapDatabaseConnection *connection2 = [database newConnection];
+	
+	YapDatabaseRelationship *relationship = [[YapDatabaseRelationship alloc] init];
+	
+	BOOL registered = [database registerExtension:relationship withName:@"relationship"];
+	
+	XCTAssertTrue(registered, @"Error registering extension");
+	
+	// n1 -> n2 -> n4 -> n1 (cycle)
+	//          -> n5 -> file
+	//    -> n3 -> n6 -> n4
+	//          -> n7 (edge named "other")
+	
+	NSArray *childEdges = @[ @[@"n1", @"n2"], @[@"n1", @"n3"], @[@"n2", @"n4"], @[@"n2", @"n5"],
+	                         @[@"n3", @"n6"], @[@"n4", @"n1"], @[@"n6", @"n4"] ];
+	
+	NSString *filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"traversal"];
+	
+	void (^verify)(YapDatabaseReadTransaction *transaction) = ^(YapDatabaseReadTransaction *transaction){
+		
+		NSMutableArray *keys = [NSMutableArray array];
+		NSMutableArray *depths = [NSMutableArray array];
+		
+		[[transaction ext:@"relationship"] enumerateNodesReachableFromKey:@"n1"
+		                                                     inCollection:nil
+		                                                    withEdgeNames:@[ @"child" ]
+		                                                        direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                            order:YapDatabaseRelationshipTraversalBreadthFirst
+		                                                         maxDepth:0
+		                                                       usingBlock:
+		    ^(NSString *collection, NSString *key, NSUInteger depth, BOOL *stop)
+		{
+			[keys addObject:key];
+			[depths addObject:@(depth)];
+		}];
+		
+		XCTAssertTrue([keys count] == 5, @"Oops");
+		XCTAssertTrue([[NSSet setWithArray:keys] count] == 5, @"Visited a node twice");
+		XCTAssertEqualObjects([NSSet setWithArray:[keys subarrayWithRange:NSMakeRange(0, 2)]],
+		                      ([NSSet setWithObjects:@"n2", @"n3", nil]), @"Oops");
+		XCTAssertEqualObjects(depths, (@[ @1, @1, @2, @2, @2 ]), @"Oops");
+		
+		// Traversals from within the block of another traversal don't disturb the outer one
+		
+		NSMutableDictionary *expectedCounts = [NSMutableDictionary dictionary];
+		
+		for (NSString *key in keys)
+		{
+			expectedCounts[key] =
+			  @([[transaction ext:@"relationship"] nodeCountReachableFromKey:key
+			                                                    inCollection:nil
+			                                                   withEdgeNames:@[ @"child" ]
+			                                                       direction:YapDatabaseRelationshipTraversalIncoming
+			                                                        maxDepth:0]);
+		}
+		
+		NSArray *outerKeys = [keys copy];
+		[keys removeAllObjects];
+		
+		[[transaction ext:@"relationship"] enumerateNodesReachableFromKey:@"n1"
+		                                                     inCollection:nil
+		                                                    withEdgeNames:@[ @"child" ]
+		                                                        direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                            order:YapDatabaseRelationshipTraversalBreadthFirst
+		                                                         maxDepth:0
+		                                                       usingBlock:
+		    ^(NSString *collection, NSString *key, NSUInteger depth, BOOL *stop)
+		{
+			[keys addObject:key];
+			
+			NSUInteger nestedCount =
+			  [[transaction ext:@"relationship"] nodeCountReachableFromKey:key
+			                                                  inCollection:nil
+			                                                 withEdgeNames:@[ @"child" ]
+			                                                     direction:YapDatabaseRelationshipTraversalIncoming
+			                                                      maxDepth:0];
+			
+			XCTAssertEqualObjects(@(nestedCount), expectedCounts[key], @"Bad nested count for %@", key);
+			
+			__block NSUInteger nestedEnumerated = 0;
+			[[transaction ext:@"relationship"] enumerateNodesReachableFromKey:key
+			                                                     inCollection:nil
+			                                                    withEdgeNames:@[ @"child" ]
+			                                                        direction:YapDatabaseRelationshipTraversalIncoming
+			                                                            order:YapDatabaseRelationshipTraversalBreadthFirst
+			                                                         maxDepth:0
+			                                                       usingBlock:
+			    ^(NSString *innerCollection, NSString *innerKey, NSUInteger innerDepth, BOOL *innerStop)
+			{
+				nestedEnumerated++;
+			}];
+			
+			XCTAssertEqualObjects(@(nestedEnumerated), expectedCounts[key], @"Bad nested enumeration for %@", key);
+		}];
+		
+		XCTAssertEqualObjects(keys, outerKeys, @"Nested traversal disturbed the outer traversal");
+		
+		[keys removeAllObjects];
+		[[transaction ext:@"relationship"] enumerateNodesReachableFromKey:@"n1"
+		                                                     inCollection:nil
+		                                                    withEdgeNames:nil
+		                                                        direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                            order:YapDatabaseRelationshipTraversalDepthFirst
+		                                                         maxDepth:0
+		                                                       usingBlock:
+		    ^(NSString *collection, NSString *key, NSUInteger depth, BOOL *stop)
+		{
+			[keys addObject:key];
+		}];
+		
+		XCTAssertTrue([keys count] == 6, @"Oops");
+		
+		NSUInteger n2 = [keys indexOfObject:@"n2"];
+		NSUInteger n3 = [keys indexOfObject:@"n3"];
+		NSUInteger n4 = [keys indexOfObject:@"n4"];
+		NSUInteger n6 = [keys indexOfObject:@"n6"];
+		
+		if (n2 < n3) {
+			XCTAssertTrue(n4 < n3, @"Depth first should finish n2's subtree before moving on to n3");
+		} else {
+			XCTAssertTrue(n6 < n2, @"Depth first should finish n3's subtree before moving on to n2");
+		}
+		
+		[keys removeAllObjects];
+		[[transaction ext:@"relationship"] enumerateNodesReachableFromKey:@"n4"
+		                                                     inCollection:nil
+		                                                    withEdgeNames:@[ @"child" ]
+		                                                        direction:YapDatabaseRelationshipTraversalIncoming
+		                                                            order:YapDatabaseRelationshipTraversalBreadthFirst
+		                                                         maxDepth:1
+		                                                       usingBlock:
+		    ^(NSString *collection, NSString *key, NSUInteger depth, BOOL *stop)
+		{
+			[keys addObject:key];
+		}];
+		
+		XCTAssertEqualObjects([NSSet setWithArray:keys], ([NSSet setWithObjects:@"n2", @"n6", nil]), @"Oops");
+		
+		NSUInteger count;
+		
+		count = [[transaction ext:@"relationship"] nodeCountReachableFromKey:@"n1"
+		                                                        inCollection:nil
+		                                                       withEdgeNames:nil
+		                                                           direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                            maxDepth:0];
+		XCTAssertTrue(count == 6, @"Oops");
+		
+		count = [[transaction ext:@"relationship"] nodeCountReachableFromKey:@"n1"
+		                                                        inCollection:nil
+		                                                       withEdgeNames:@[ @"child", @"other" ]
+		                                                           direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                            maxDepth:1];
+		XCTAssertTrue(count == 2, @"Oops");
+		
+		count = [[transaction ext:@"relationship"] nodeCountReachableFromKey:@"n5"
+		                                                        inCollection:nil
+		                                                       withEdgeNames:nil
+		                                                           direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                            maxDepth:0];
+		XCTAssertTrue(count == 0, @"File edges should not be followed");
+		
+		count = [[transaction ext:@"relationship"] nodeCountReachableFromKey:@"n4"
+		                                                        inCollection:nil
+		                                                       withEdgeNames:@[ @"child" ]
+		                                                           direction:YapDatabaseRelationshipTraversalIncoming
+		                                                            maxDepth:0];
+		XCTAssertTrue(count == 4, @"Oops"); // n2, n6, n1, n3
+	};
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (NSUInteger i = 1; i <= 7; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"n%lu", (unsigned long)i];
+			[transaction setObject:key forKey:key inCollection:nil];
+		}
+		
+		for (NSArray *pair in childEdges)
+		{
+			YapDatabaseRelationshipEdge *edge =
+			  [YapDatabaseRelationshipEdge edgeWithName:@"child"
+			                                  sourceKey:[pair objectAtIndex:0]
+			                                 collection:nil
+			                             destinationKey:[pair objectAtIndex:1]
+			                                 collection:nil
+			                            nodeDeleteRules:0];
+			
+			[[transaction ext:@"relationship"] addEdge:edge];
+		}
+		
+		[[transaction ext:@"relationship"] addEdge:
+		  [YapDatabaseRelationshipEdge edgeWithName:@"other"
+		                                  sourceKey:@"n3"
+		                                 collection:nil
+		                             destinationKey:@"n7"
+		                                 collection:nil
+		                            nodeDeleteRules:0]];
+		
+		[[transaction ext:@"relationship"] addEdge:
+		  [YapDatabaseRelationshipEdge edgeWithName:@"attachment"
+		                                  sourceKey:@"n5"
+		                                 collection:nil
+		                        destinationFilePath:filePath
+		                            nodeDeleteRules:0]];
+		
+		// Edges are still in memory (hop by hop traversal)
+		verify(transaction);
+		
+		// Edges are in the database table (recursive query)
+		[[transaction ext:@"relationship"] flush];
+		verify(transaction);
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		verify(transaction);
+	}];
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		// Deleting n6 breaks the n3 -> n6 -> n4 path (but not n1 -> n2 -> n4)
+		[transaction removeObjectForKey:@"n6" inCollection:nil];
+		
+		NSUInteger count =
+		  [[transaction ext:@"relationship"] nodeCountReachableFromKey:@"n1"
+		                                                  inCollection:nil
+		                                                 withEdgeNames:nil
+		                                                     direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                      maxDepth:0];
+		XCTAssertTrue(count == 5, @"Oops");
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSUInteger count =
+		  [[transaction ext:@"relationship"] nodeCountReachableFromKey:@"n1"
+		                                                  inCollection:nil
+		                                                 withEdgeNames:nil
+		                                                     direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                      maxDepth:0];
+		XCTAssertTrue(count == 5, @"Oops");
+	}];
+}
+
+- (void)testTraversalLayeredDiamonds
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection1 = [database newConnection];
+	YapDatabaseConnection *connection2 = [database newConnection];
+	
+	YapDatabaseRelationship *relationship = [[YapDatabaseRelationship alloc] init];
+	
+	BOOL registered = [database registerExtension:relationship withName:@"relationship"];
+	
+	XCTAssertTrue(registered, @"Error registering extension");
+	
+	// start -> 1a, 1b
+	// Each node in layer k -> both nodes in layer k+1
+	// start -> 2a (shortcut)
+	//
+	// There are 2^30 distinct paths from start to the last layer.
+	// A traversal that follows every path (rather than expanding each node once) would never finish.
+	
+	NSUInteger layerCount = 30;
+	
+	void (^verify)(YapDatabaseReadTransaction *transaction) = ^(YapDatabaseReadTransaction *transaction){
+		
+		NSMutableArray *keys = [NSMutableArray array];
+		NSMutableDictionary *depths = [NSMutableDictionary dictionary];
+		
+		[[transaction ext:@"relationship"] enumerateNodesReachableFromKey:@"start"
+		                                                     inCollection:nil
+		                                                    withEdgeNames:nil
+		                                                        direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                            order:YapDatabaseRelationshipTraversalBreadthFirst
+		                                                         maxDepth:0
+		                                                       usingBlock:
+		    ^(NSString *collection, NSString *key, NSUInteger depth, BOOL *stop)
+		{
+			[keys addObject:key];
+			[depths setObject:@(depth) forKey:key];
+		}];
+		
+		XCTAssertTrue([keys count] == (layerCount * 2), @"Bad count: %lu", (unsigned long)[keys count]);
+		XCTAssertTrue([depths count] == (layerCount * 2), @"Visited a node twice");
+		
+		XCTAssertEqualObjects([depths objectForKey:@"1a"], @(1), @"Oops");
+		XCTAssertEqualObjects([depths objectForKey:@"2a"], @(1), @"Oops");
+		XCTAssertEqualObjects([depths objectForKey:@"2b"], @(2), @"Oops");
+		XCTAssertEqualObjects([depths objectForKey:@"3b"], @(2), @"Oops");
+		XCTAssertEqualObjects([depths objectForKey:@"30a"], @(29), @"Oops");
+		
+		[keys removeAllObjects];
+		[[transaction ext:@"relationship"] enumerateNodesReachableFromKey:@"start"
+		                                                     inCollection:nil
+		                                                    withEdgeNames:nil
+		                                                        direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                            order:YapDatabaseRelationshipTraversalDepthFirst
+		                                                         maxDepth:0
+		                                                       usingBlock:
+		    ^(NSString *collection, NSString *key, NSUInteger depth, BOOL *stop)
+		{
+			[keys addObject:key];
+		}];
+		
+		XCTAssertTrue([keys count] == (layerCount * 2), @"Bad count: %lu", (unsigned long)[keys count]);
+		XCTAssertTrue([[NSSet setWithArray:keys] count] == (layerCount * 2), @"Visited a node twice");
+		
+		// Within 3 hops: 1a, 1b, 2a (shortcut), 2b, 3a, 3b, 4a, 4b
+		//
+		// Depth first may reach 2a via 1a (depth 2) before it follows the shortcut (depth 1).
+		// The 4th layer is only within reach via the shortcut.
+		
+		NSSet *expected = [NSSet setWithObjects:@"1a", @"1b", @"2a", @"2b", @"3a", @"3b", @"4a", @"4b", nil];
+		
+		[keys removeAllObjects];
+		[[transaction ext:@"relationship"] enumerateNodesReachableFromKey:@"start"
+		                                                     inCollection:nil
+		                                                    withEdgeNames:nil
+		                                                        direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                            order:YapDatabaseRelationshipTraversalDepthFirst
+		                                                         maxDepth:3
+		                                                       usingBlock:
+		    ^(NSString *collection, NSString *key, NSUInteger depth, BOOL *stop)
+		{
+			[keys addObject:key];
+		}];
+		
+		XCTAssertTrue([keys count] == [expected count], @"Bad count: %lu", (unsigned long)[keys count]);
+		XCTAssertEqualObjects([NSSet setWithArray:keys], expected, @"Oops");
+		
+		[keys removeAllObjects];
+		[[transaction ext:@"relationship"] enumerateNodesReachableFromKey:@"start"
+		                                                     inCollection:nil
+		                                                    withEdgeNames:nil
+		                                                        direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                            order:YapDatabaseRelationshipTraversalBreadthFirst
+		                                                         maxDepth:3
+		                                                       usingBlock:
+		    ^(NSString *collection, NSString *key, NSUInteger depth, BOOL *stop)
+		{
+			[keys addObject:key];
+		}];
+		
+		XCTAssertTrue([keys count] == [expected count], @"Bad count: %lu", (unsigned long)[keys count]);
+		XCTAssertEqualObjects([NSSet setWithArray:keys], expected, @"Oops");
+		
+		NSUInteger count;
+		
+		count = [[transaction ext:@"relationship"] nodeCountReachableFromKey:@"start"
+		                                                        inCollection:nil
+		                                                       withEdgeNames:nil
+		                                                           direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                            maxDepth:0];
+		XCTAssertTrue(count == (layerCount * 2), @"Bad count: %lu", (unsigned long)count);
+		
+		count = [[transaction ext:@"relationship"] nodeCountReachableFromKey:@"start"
+		                                                        inCollection:nil
+		                                                       withEdgeNames:nil
+		                                                           direction:YapDatabaseRelationshipTraversalOutgoing
+		                                                            maxDepth:3];
+		XCTAssertTrue(count == [expected count], @"Bad count: %lu", (unsigned long)count);
+		
+		count = [[transaction ext:@"relationship"] nodeCountReachableFromKey:@"30b"
+		                                                        inCollection:nil
+		                                                       withEdgeNames:nil
+		                                                           direction:YapDatabaseRelationshipTraversalIncoming
+		                                                            maxDepth:0];
+		XCTAssertTrue(count == ((layerCount - 1) * 2 + 1), @"Bad count: %lu", (unsigned long)count);
+	};
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"start" forKey:@"start" inCollection:nil];
+		
+		NSArray *previousLayer = @[ @"start" ];
+		
+		for (NSUInteger layer = 1; layer <= layerCount; layer++)
+		{
+			NSArray *currentLayer = @[ [NSString stringWithFormat:@"%lua", (unsigned long)layer],
+			                           [NSString stringWithFormat:@"%lub", (unsigned long)layer] ];
+			
+			for (NSString *key in currentLayer)
+			{
+				[transaction setObject:key forKey:key inCollection:nil];
+			}
+			
+			for (NSString *srcKey in previousLayer)
+			{
+				for (NSString *dstKey in currentLayer)
+				{
+					[[transaction ext:@"relationship"] addEdge:
+					  [YapDatabaseRelationshipEdge edgeWithName:@"child"
+					                                  sourceKey:srcKey
+					                                 collection:nil
+					                             destinationKey:dstKey
+					                                 collection:nil
+					                            nodeDeleteRules:0]];
+				}
+			}
+			
+			previousLayer = currentLayer;
+		}
+		
+		[[transaction ext:@"relationship"] addEdge:
+		  [YapDatabaseRelationshipEdge edgeWithName:@"shortcut"
+		                                  sourceKey:@"start"
+		                                 collection:nil
+		                             destinationKey:@"2a"
+		                                 collection:nil
+		                            nodeDeleteRules:0]];
+		
+		// Edges are still in memory (hop by hop traversal)
+		verify(transaction);
+		
+		// Edges are in the database table
+		[[transaction ext:@"relationship"] flush];
+		verify(transaction);
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		verify(transaction);
+	}];
+}
+
+- (void)testAdjacencyCache
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection1 = [database newConnection];
+	YapDatabaseConnection *connection2 = [database newConnection];
+	
+	YapDatabaseRelationship *relationship = [[YapDatabaseRelationship alloc] init];
+	
+	BOOL registered = [database registerExtension:relationship withName:@"relationship"];
+	
+	XCTAssertTrue(registered, @"Error registering extension");
+	
+	YapDatabaseRelationshipConnection *relationshipConnection2 = [connection2 ext:@"relationship"];
+	relationshipConnection2.adjacencyCacheEnabled = YES;
+	
+	XCTAssertTrue(relationshipConnection2.adjacencyCacheEnabled, @"Oops");
+	
+	NSString *parent = @"parent";
+	NSString *child1 = @"child1";
+	NSString *child2 = @"child2";
+	
+	void (^addChild)(YapDatabaseReadWriteTransaction *, NSString *) = ^(YapDatabaseReadWriteTransaction *transaction,
+	                                                                     NSString *child){
+		YapDatabaseRelationshipEdge *edge =
+		  [YapDatabaseRelationshipEdge edgeWithName:@"child"
+		                                  sourceKey:parent
+		                                 collection:nil
+		                             destinationKey:child
+		                                 collection:nil
+		                            nodeDeleteRules:0];
+		
+		[[transaction ext:@"relationship"] addEdge:edge];
+	};
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:parent forKey:parent inCollection:nil];
+		[transaction setObject:child1 forKey:child1 inCollection:nil];
+		[transaction setObject:child2 forKey:child2 inCollection:nil];
+		
+		addChild(transaction, child1);
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSUInteger count;
+		
+		// Twice, so the second call is answered from the cache
+		
+		count = [[transaction ext:@"relationship"] edgeCountWithName:@"child" sourceKey:parent collection:nil];
+		XCTAssertTrue(count == 1, @"Oops");
+		
+		count = [[transaction ext:@"relationship"] edgeCountWithName:@"child" sourceKey:parent collection:nil];
+		XCTAssertTrue(count == 1, @"Oops");
+		
+		count = [[transaction ext:@"relationship"] edgeCountWithName:@"other" sourceKey:parent collection:nil];
+		XCTAssertTrue(count == 0, @"Oops");
+		
+		count = [[transaction ext:@"relationship"] edgeCountWithName:nil destinationKey:child1 collection:nil];
+		XCTAssertTrue(count == 1, @"Oops");
+		
+		__block NSUInteger enumCount = 0;
+		[[transaction ext:@"relationship"] enumerateEdgesWithName:@"child"
+		                                                sourceKey:parent
+		                                               collection:nil
+		                                               usingBlock:^(YapDatabaseRelationshipEdge *edge, BOOL *stop)
+		{
+			XCTAssertEqualObjects(edge.sourceKey, parent, @"Oops");
+			XCTAssertEqualObjects(edge.destinationKey, child1, @"Oops");
+			enumCount++;
+		}];
+		XCTAssertTrue(enumCount == 1, @"Oops");
+	}];
+	
+	// Changes made by another connection must invalidate the cache
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		addChild(transaction, child2);
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSUInteger count = [[transaction ext:@"relationship"] edgeCountWithName:@"child" sourceKey:parent collection:nil];
+		XCTAssertTrue(count == 2, @"Oops");
+		
+		count = [[transaction ext:@"relationship"] edgeCountWithName:@"child" destinationKey:child2 collection:nil];
+		XCTAssertTrue(count == 1, @"Oops");
+	}];
+	
+	// Including the deletion of a node at the other end of the edge
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction removeObjectForKey:child1 inCollection:nil];
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSUInteger count = [[transaction ext:@"relationship"] edgeCountWithName:@"child" sourceKey:parent collection:nil];
+		XCTAssertTrue(count == 1, @"Oops");
+		
+		[[transaction ext:@"relationship"] enumerateEdgesWithName:nil
+		                                           destinationKey:child2
+		                                               collection:nil
+		                                               usingBlock:^(YapDatabaseRelationshipEdge *edge, BOOL *stop)
+		{
+			XCTAssertEqualObjects(edge.sourceKey, parent, @"Oops");
+		}];
+	}];
+	
+	// And the deletion of the node itself
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction removeObjectForKey:parent inCollection:nil];
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSUInteger count = [[transaction ext:@"relationship"] edgeCountWithName:@"child" destinationKey:child2 collection:nil];
+		XCTAssertTrue(count == 0, @"Oops");
+	}];
+}
+
+- (void)testBatchCascade
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection1 = [database newConnection];
+	YapDatabaseConnection *connection2 = [database newConnection];
+	
+	YapDatabaseRelationship *relationship = [[YapDatabaseRelationship alloc] init];
+	
+	BOOL registered = [database registerExtension:relationship withName:@"relationship"];
+	
+	XCTAssertTrue(registered, @"Error registering extension");
+	
+	// root -> folder[0..63] -> item[0..4]
+	//
+	// Each folder also retains "orphan" & "shared" (DeleteDestinationIfAllSourcesDeleted).
+	// But "shared" is also retained by "survivor", so it must survive the cascade.
+	//
+	// Deleting the root cascades into enough nodes that the flush processes them in (set-based) rounds.
+	
+	NSUInteger folderCount = 64;
+	NSUInteger itemsPerFolder = 5;
+	
+	YapDatabaseRelationshipEdge* (^makeEdge)(NSString *, NSString *, NSString *, YDB_NodeDeleteRules) =
+	  ^YapDatabaseRelationshipEdge* (NSString *name, NSString *src, NSString *dst, YDB_NodeDeleteRules rules){
+		
+		return [YapDatabaseRelationshipEdge edgeWithName:name
+		                                       sourceKey:src
+		                                      collection:@"nodes"
+		                                  destinationKey:dst
+		                                      collection:@"nodes"
+		                                 nodeDeleteRules:rules];
+	};
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (NSString *key in @[ @"root", @"orphan", @"shared", @"survivor" ])
+		{
+			[transaction setObject:key forKey:key inCollection:@"nodes"];
+		}
+		
+		[[transaction ext:@"relationship"] addEdge:
+		  makeEdge(@"retained", @"survivor", @"shared", YDB_DeleteDestinationIfAllSourcesDeleted)];
+		
+		for (NSUInteger f = 0; f < folderCount; f++)
+		{
+			NSString *folder = [NSString stringWithFormat:@"folder-%lu", (unsigned long)f];
+			[transaction setObject:folder forKey:folder inCollection:@"nodes"];
+			
+			[[transaction ext:@"relationship"] addEdge:
+			  makeEdge(@"child", @"root", folder, YDB_DeleteDestinationIfSourceDeleted)];
+			
+			[[transaction ext:@"relationship"] addEdge:
+			  makeEdge(@"retained", folder, @"orphan", YDB_DeleteDestinationIfAllSourcesDeleted)];
+			
+			[[transaction ext:@"relationship"] addEdge:
+			  makeEdge(@"retained", folder, @"shared", YDB_DeleteDestinationIfAllSourcesDeleted)];
+			
+			for (NSUInteger i = 0; i < itemsPerFolder; i++)
+			{
+				NSString *item = [NSString stringWithFormat:@"item-%lu-%lu", (unsigned long)f, (unsigned long)i];
+				[transaction setObject:item forKey:item inCollection:@"nodes"];
+				
+				[[transaction ext:@"relationship"] addEdge:
+				  makeEdge(@"child", folder, item, YDB_DeleteDestinationIfSourceDeleted)];
+			}
+		}
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSUInteger expected = 4 + folderCount + (folderCount * itemsPerFolder);
+		XCTAssertTrue([transaction numberOfKeysInCollection:@"nodes"] == expected, @"Oops");
+		
+		NSUInteger edgeCount = [[transaction ext:@"relationship"] edgeCountWithName:@"child"];
+		XCTAssertTrue(edgeCount == (folderCount + (folderCount * itemsPerFolder)), @"Oops");
+	}];
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction removeObjectForKey:@"root" inCollection:@"nodes"];
+	}];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertTrue([transaction numberOfKeysInCollection:@"nodes"] == 2, @"Oops");
+		
+		XCTAssertNotNil([transaction objectForKey:@"shared" inCollection:@"nodes"], @"Oops");
+		XCTAssertNotNil([transaction objectForKey:@"survivor" inCollection:@"nodes"], @"Oops");
+		XCTAssertNil([transaction objectForKey:@"orphan" inCollection:@"nodes"], @"Oops");
+		
+		NSUInteger edgeCount;
+		
+		edgeCount = [[transaction ext:@"relationship"] edgeCountWithName:@"child"];
+		XCTAssertTrue(edgeCount == 0, @"Bad edgeCount. expected(0) != %d", (int)edgeCount);
+		
+		edgeCount = [[transaction ext:@"relationship"] edgeCountWithName:@"retained"];
+		XCTAssertTrue(edgeCount == 1, @"Bad edgeCount. expected(1) != %d", (int)edgeCount);
+	}];
+}
+
+- (void)testFileDeletionQueue
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	YapDatabaseRelationshipOptions *options = [[YapDatabaseRelationshipOptions alloc] init];
+	options.fileDeletionMaxConcurrentOperations = 2;
+	options.fileDeletionMaxBytesPerSecond = 1024 * 1024;
+	
+	YapDatabaseRelationship *relationship = [[YapDatabaseRelationship alloc] initWithVersionTag:@"1" options:options];
+	
+	BOOL registered = [database registerExtension:relationship withName:@"relationship"];
+	
+	XCTAssertTrue(registered, @"Error registering extension");
+	
+	NSUInteger fileCount = 10;
+	NSMutableArray *filePaths = [NSMutableArray arrayWithCapacity:fileCount];
+	
+	for (NSUInteger i = 0; i < fileCount; i++)
+	{
+		[filePaths addObject:[self randomFilePath]];
+	}
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"node" forKey:@"node" inCollection:nil];
+		
+		for (NSString *filePath in filePaths)
+		{
+			YapDatabaseRelationshipEdge *edge =
+			  [YapDatabaseRelationshipEdge edgeWithName:@"attachment"
+			                                  sourceKey:@"node"
+			                                 collection:nil
+			                        destinationFilePath:filePath
+			                            nodeDeleteRules:YDB_DeleteDestinationIfSourceDeleted];
+			
+			[[transaction ext:@"relationship"] addEdge:edge];
+		}
+	}];
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction removeObjectForKey:@"node" inCollection:nil];
+	}];
+	
+	// The files are deleted in the background
+	
+	NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5.0];
+	while ((relationship.pendingFileDeletionCount > 0) && ([timeout timeIntervalSinceNow] > 0))
+	{
+		[NSThread sleepForTimeInterval:0.05];
+	}
+	
+	XCTAssertTrue(relationship.pendingFileDeletionCount == 0, @"Oops");
+	XCTAssertTrue(relationship.deletedFileCount == fileCount, @"Oops");
+	XCTAssertTrue(relationship.failedFileDeletionCount == 0, @"Oops");
+	
+	for (NSString *filePath in filePaths)
+	{
+		XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:filePath], @"Oops");
+	}
+}
+
+- (void)testFileDeletionQueue_Throttle
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	YapDatabaseRelationshipOptions *options = [[YapDatabaseRelationshipOptions alloc] init];
+	options.fileDeletionMaxBytesPerSecond = 1000;
+	
+	YapDatabaseRelationship *relationship = [[YapDatabaseRelationship alloc] initWithVersionTag:@"1" options:options];
+	
+	BOOL registered = [database registerExtension:relationship withName:@"relationship"];
+	
+	XCTAssertTrue(registered, @"Error registering extension");
+	
+	// 4 files of 1000 bytes each, so the budget only allows 1 file per second.
+	
+	NSUInteger fileCount = 4;
+	NSUInteger fileSize = 1000;
+	NSMutableArray *filePaths = [NSMutableArray arrayWithCapacity:fileCount];
+	
+	for (NSUInteger i = 0; i < fileCount; i++)
+	{
+		NSString *filePath = [self randomFilePath];
+		[[NSMutableData dataWithLength:fileSize] writeToFile:filePath atomically:NO];
+		
+		[filePaths addObject:filePath];
+	}
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (NSUInteger i = 0; i < fileCount; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"node%lu", (unsigned long)(i / 2)];
+			[transaction setObject:key forKey:key inCollection:nil];
+			
+			YapDatabaseRelationshipEdge *edge =
+			  [YapDatabaseRelationshipEdge edgeWithName:@"attachment"
+			                                  sourceKey:key
+			                                 collection:nil
+			                        destinationFilePath:[filePaths objectAtIndex:i]
+			                            nodeDeleteRules:YDB_DeleteDestinationIfSourceDeleted];
+			
+			[[transaction ext:@"relationship"] addEdge:edge];
+		}
+	}];
+	
+	// Delete the files in 2 separate commits (i.e. 2 separate batches).
+	// The throttle applies across batches, so the second batch has to wait for the first one's window.
+	
+	CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction removeObjectForKey:@"node0" inCollection:nil];
+	}];
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction removeObjectForKey:@"node1" inCollection:nil];
+	}];
+	
+	NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+	while ((relationship.pendingFileDeletionCount > 0) && ([timeout timeIntervalSinceNow] > 0))
+	{
+		[NSThread sleepForTimeInterval:0.05];
+	}
+	
+	CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+	
+	XCTAssertTrue(relationship.pendingFileDeletionCount == 0, @"Oops");
+	XCTAssertTrue(relationship.deletedFileCount == fileCount, @"Oops");
+	XCTAssertTrue(relationship.deletedFileBytes == (fileCount * fileSize),
+	              @"Bad deletedFileBytes: %llu", relationship.deletedFileBytes);
+	
+	// One file per second: t=0, t>=1, t>=2, t>=3
+	XCTAssertTrue(elapsed >= 2.9, @"Deletion wasn't throttled across batches (elapsed: %.2f)", elapsed);
+	
+	for (NSString *filePath in filePaths)
+	{
+		XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:filePath], @"Oops");
+	}
+}
+
+- (void)testFileDeletionQueue_Resume
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	
+	NSUInteger fileCount = 3;
+	NSMutableArray *filePaths = [NSMutableArray arrayWithCapacity:fileCount];
+	
+	for (NSUInteger i = 0; i < fileCount; i++)
+	{
+		NSString *filePath = [self randomFilePath];
+		[[NSMutableData dataWithLength:100] writeToFile:filePath atomically:NO];
+		
+		[filePaths addObject:filePath];
+	}
+	
+	__block __weak YapDatabase *weakDatabase = nil;
+	
+	void (^waitForDatabaseToClose)(void) = ^{
+		
+		NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5.0];
+		while (weakDatabase && ([timeout timeIntervalSinceNow] > 0))
+		{
+			[NSThread sleepForTimeInterval:0.05];
+		}
+		
+		XCTAssertNil(weakDatabase, @"Database wasn't closed");
+	};
+	
+	// Launch 1: The files are deleted slowly (one per second, as each file exceeds the budget on its own),
+	// so the batch is still pending when the database is closed (as if the app was terminated).
+	
+	@autoreleasepool {
+		
+		YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+		YapDatabaseConnection *connection = [database newConnection];
+		
+		YapDatabaseRelationshipOptions *options = [[YapDatabaseRelationshipOptions alloc] init];
+		options.fileDeletionMaxBytesPerSecond = 10;
+		
+		YapDatabaseRelationship *relationship =
+		  [[YapDatabaseRelationship alloc] initWithVersionTag:@"1" options:options];
+		
+		BOOL registered = [database registerExtension:relationship withName:@"relationship"];
+		XCTAssertTrue(registered, @"Error registering extension");
+		
+		[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+			
+			[transaction setObject:@"node" forKey:@"node" inCollection:nil];
+			
+			for (NSString *filePath in filePaths)
+			{
+				YapDatabaseRelationshipEdge *edge =
+				  [YapDatabaseRelationshipEdge edgeWithName:@"attachment"
+				                                  sourceKey:@"node"
+				                                 collection:nil
+				                        destinationFilePath:filePath
+				                            nodeDeleteRules:YDB_DeleteDestinationIfSourceDeleted];
+				
+				[[transaction ext:@"relationship"] addEdge:edge];
+			}
+		}];
+		
+		[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+			
+			[transaction removeObjectForKey:@"node" inCollection:nil];
+		}];
+		
+		XCTAssertTrue(relationship.pendingFileDeletionCount > 0, @"Expected pending deletions");
+		
+		weakDatabase = database;
+	}
+	
+	waitForDatabaseToClose();
+	
+	// Launch 2: Re-registering the extension resumes the pending batch.
+	
+	@autoreleasepool {
+		
+		YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+		YapDatabaseRelationship *relationship = [[YapDatabaseRelationship alloc] initWithVersionTag:@"1"];
+		
+		BOOL registered = [database registerExtension:relationship withName:@"relationship"];
+		XCTAssertTrue(registered, @"Error registering extension");
+		
+		NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5.0];
+		while ((relationship.pendingFileDeletionCount > 0) && ([timeout timeIntervalSinceNow] > 0))
+		{
+			[NSThread sleepForTimeInterval:0.05];
+		}
+		
+		XCTAssertTrue(relationship.pendingFileDeletionCount == 0, @"Oops");
+		XCTAssertTrue(relationship.deletedFileCount == fileCount, @"Oops");
+		XCTAssertTrue(relationship.failedFileDeletionCount == 0, @"Oops");
+		
+		for (NSString *filePath in filePaths)
+		{
+			XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:filePath], @"Oops");
+		}
+		
+		// The completed batch is removed from the database as part of the next readwrite transaction.
+		// (The pendingFileDeletionCount reaches zero slightly before the batch is marked complete.)
+		
+		[NSThread sleepForTimeInterval:0.1];
+		
+		YapDatabaseConnection *connection = [database newConnection];
+		[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+			
+			[transaction setObject:@"unrelated" forKey:@"unrelated" inCollection:nil];
+		}];
+		
+		weakDatabase = database;
+	}
+	
+	waitForDatabaseToClose();
+	
+	// Launch 3: Nothing left to resume.
+	
+	@autoreleasepool {
+		
+		YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+		YapDatabaseRelationship *relationship = [[YapDatabaseRelationship alloc] initWithVersionTag:@"1"];
+		
+		BOOL registered = [database registerExtension:relationship withName:@"relationship"];
+		XCTAssertTrue(registered, @"Error registering extension");
+		
+		XCTAssertTrue(relationship.pendingFileDeletionCount == 0, @"Completed batch wasn't removed");
+	}
+}
+
+- (void)testPopulate
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	// Add the nodes before registering the extension,
+	// so the edges are inserted while populating (in chunks, with multi-row inserts).
+	
+	NSUInteger parentCount = 2000;
+	NSUInteger childrenPerParent = 3;
+	
+	NSMutableArray *parents = [NSMutableArray arrayWithCapacity:parentCount];
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (NSUInteger p = 0; p < parentCount; p++)
+		{
+			Node_Standard *parent = [[Node_Standard alloc] init];
+			NSMutableArray *childKeys = [NSMutableArray arrayWithCapacity:childrenPerParent];
+			
+			for (NSUInteger c = 0; c < childrenPerParent; c++)
+			{
+				Node_Standard *child = [[Node_Standard alloc] init];
+				[transaction setObject:child forKey:child.key inCollection:nil];
+				
+				[childKeys addObject:child.key];
+			}
+			
+			parent.childKeys = childKeys;
+			[transaction setObject:parent forKey:parent.key inCollection:nil];
+			
+			[parents addObject:parent];
+		}
+		
+		// And a parent with a child that doesn't exist
+		
+		Node_Standard *badParent = [[Node_Standard alloc] init];
+		badParent.childKeys = @[ @"missing" ];
+		
+		[transaction setObject:badParent forKey:badParent.key inCollection:nil];
+	}];
+	
+	YapDatabaseRelationship *relationship = [[YapDatabaseRelationship alloc] init];
+	
+	BOOL registered = [database registerExtension:relationship withName:@"relationship"];
+	
+	XCTAssertTrue(registered, @"Error registering extension");
+	
+	Node_Standard *parent = [parents objectAtIndex:0];
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSUInteger edgeCount;
+		
+		edgeCount = [[transaction ext:@"relationship"] edgeCountWithName:@"child"];
+		XCTAssertTrue(edgeCount == (parentCount * childrenPerParent),
+		              @"Bad edgeCount. expected(%d) != %d", (int)(parentCount * childrenPerParent), (int)edgeCount);
+		
+		edgeCount = [[transaction ext:@"relationship"] edgeCountWithName:@"child" sourceKey:parent.key collection:nil];
+		XCTAssertTrue(edgeCount == childrenPerParent, @"Bad edgeCount");
+		
+		NSString *childKey = [parent.childKeys objectAtIndex:0];
+		
+		edgeCount = [[transaction ext:@"relationship"] edgeCountWithName:@"child" destinationKey:childKey collection:nil];
+		XCTAssertTrue(edgeCount == 1, @"Bad edgeCount");
+	}];
+	
+	// The populated edges must work like any other
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction removeObjectForKey:parent.key inCollection:nil];
+	}];
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		for (NSString *childKey in parent.childKeys)
+		{
+			XCTAssertNil([transaction objectForKey:childKey inCollection:nil], @"Oops");
+		}
+		
+		NSUInteger edgeCount = [[transaction ext:@"relationship"] edgeCountWithName:@"child"];
+		XCTAssertTrue(edgeCount == ((parentCount - 1) * childrenPerParent), @"Bad edgeCount");
+	}];
+}
+
 @end
@@ -277,6 +277,37 @@
 		NSString *connectionQuery = [[transaction ext:@"searchResults"] query];
 		XCTAssertTrue([connectionQuery isEqualToString:query], @"Oops");
 	}];
+	
+	// Refine the search (as if the user were typing)
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[[transaction ext:@"searchResults"] performSearchFor:@"the d*"];
+		
+		NSUInteger count = [[transaction ext:@"searchResults"] numberOfItemsInGroup:@""];
+		XCTAssertTrue(count == 2, @"Bad count: %lu", (unsigned long)count);
+	}];
+	
+	[connection2 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[[transaction ext:@"searchResults"] performSearchFor:@"the du*"];
+		
+		NSUInteger count = [[transaction ext:@"searchResults"] numberOfItemsInGroup:@""];
+		XCTAssertTrue(count == 1, @"Bad count: %lu", (unsigned long)count);
+		
+		NSString *object = [[transaction ext:@"searchResults"] objectAtIndex:0 inGroup:@""];
+		XCTAssertTrue([object isEqualToString:@"The duck quacks at midnight"], @"Oops");
+	}];
+	
+	// And a search that isn't a refinement
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[[transaction ext:@"searchResults"] performSearchFor:@"you"];
+		
+		NSUInteger count = [[transaction ext:@"searchResults"] numberOfItemsInGroup:@""];
+		XCTAssertTrue(count == 2, @"Bad count: %lu", (unsigned long)count);
+	}];
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -469,4 +500,348 @@
 	}];
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Time Sliced
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (void)test2_slices_parentView_memory
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	YapDatabaseSearchResultsViewOptions *searchViewOptions = [[YapDatabaseSearchResultsViewOptions alloc] init];
+	searchViewOptions.isPersistent = NO;
+	
+	[self _test2_slices_withPath:databasePath options:searchViewOptions useParentView:YES];
+}
+
+- (void)test2_slices_parentView_persistent
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	YapDatabaseSearchResultsViewOptions *searchViewOptions = [[YapDatabaseSearchResultsViewOptions alloc] init];
+	searchViewOptions.isPersistent = YES;
+	
+	[self _test2_slices_withPath:databasePath options:searchViewOptions useParentView:YES];
+}
+
+- (void)test2_slices_blocks_memory
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	YapDatabaseSearchResultsViewOptions *searchViewOptions = [[YapDatabaseSearchResultsViewOptions alloc] init];
+	searchViewOptions.isPersistent = NO;
+	
+	[self _test2_slices_withPath:databasePath options:searchViewOptions useParentView:NO];
+}
+
+- (void)test2_slices_blocks_persistent
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	YapDatabaseSearchResultsViewOptions *searchViewOptions = [[YapDatabaseSearchResultsViewOptions alloc] init];
+	searchViewOptions.isPersistent = YES;
+	
+	[self _test2_slices_withPath:databasePath options:searchViewOptions useParentView:NO];
+}
+
+- (void)test2_slices_unregisterDuringSearch
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseViewGrouping *grouping = [YapDatabaseViewGrouping withKeyBlock:
+	    ^NSString *(NSString *collection, NSString *key)
+	{
+		return @"";
+	}];
+	
+	YapDatabaseViewSorting *sorting = [YapDatabaseViewSorting withKeyBlock:
+	    ^(NSString *group, NSString *collection1, NSString *key1, NSString *collection2, NSString *key2)
+	{
+		return [key1 compare:key2 options:NSNumericSearch];
+	}];
+	
+	YapDatabaseFullTextSearchHandler *handler = [YapDatabaseFullTextSearchHandler withObjectBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object){
+		
+		[dict setObject:object forKey:@"content"];
+	}];
+	
+	YapDatabaseFullTextSearch *fts =
+	  [[YapDatabaseFullTextSearch alloc] initWithColumnNames:@[@"content"]
+	                                                 handler:handler
+	                                              versionTag:@"1"];
+	
+	BOOL registerResult1 = [database registerExtension:fts withName:@"fts"];
+	XCTAssertTrue(registerResult1, @"Failure registering fts extension");
+	
+	YapDatabaseSearchResultsView *searchResultsView =
+	  [[YapDatabaseSearchResultsView alloc] initWithFullTextSearchName:@"fts"
+	                                                          grouping:grouping
+	                                                           sorting:sorting
+	                                                        versionTag:@"1"
+	                                                           options:nil];
+	
+	BOOL registerResult2 = [database registerExtension:searchResultsView withName:@"searchResults"];
+	XCTAssertTrue(registerResult2, @"Failure registering searchResults extension");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (int i = 0; i < 1000; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"%d", i];
+			[transaction setObject:@"item" forKey:key inCollection:nil];
+		}
+	}];
+	
+	YapDatabaseSearchQueue *searchQueue = [[YapDatabaseSearchQueue alloc] init];
+	[searchQueue enqueueQuery:@"item"];
+	
+	YapDatabaseSearchResultsViewConnection *viewConnection = [connection ext:@"searchResults"];
+	
+	dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+	
+	[viewConnection asyncPerformSearchWithQueue:searchQueue
+	                            maxRowsPerSlice:10
+	                            completionQueue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0)
+	                            completionBlock:^{
+		
+		dispatch_semaphore_signal(semaphore);
+	}];
+	
+	// Unregister the view while the search is (most likely) still in progress.
+	// The remaining slices find no extension, and the search must complete (rather than rescheduling forever).
+	
+	[database unregisterExtensionWithName:@"searchResults"];
+	
+	long timedOut = dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(10 * NSEC_PER_SEC)));
+	XCTAssertTrue(timedOut == 0, @"Search never completed after the view was unregistered");
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		XCTAssertNil([transaction ext:@"searchResults"], @"Oops");
+	}];
+}
+
+- (void)_test2_slices_withPath:(NSString *)databasePath
+                       options:(YapDatabaseSearchResultsViewOptions *)searchViewOptions
+                 useParentView:(BOOL)useParentView
+{
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseViewGrouping *grouping = [YapDatabaseViewGrouping withKeyBlock:
+	    ^NSString *(NSString *collection, NSString *key)
+	{
+		return @"";
+	}];
+	
+	YapDatabaseViewSorting *sorting = [YapDatabaseViewSorting withObjectBlock:
+	    ^(NSString *group, NSString *collection1, NSString *key1, id obj1,
+	                       NSString *collection2, NSString *key2, id obj2)
+	{
+		__unsafe_unretained NSString *str1 = (NSString *)obj1;
+		__unsafe_unretained NSString *str2 = (NSString *)obj2;
+		
+		return [str1 compare:str2 options:NSLiteralSearch];
+	}];
+	
+	if (useParentView)
+	{
+		YapDatabaseViewOptions *viewOptions = [[YapDatabaseViewOptions alloc] init];
+		viewOptions.isPersistent = NO;
+		
+		YapDatabaseView *view =
+		  [[YapDatabaseView alloc] initWithGrouping:grouping
+		                                    sorting:sorting
+		                                 versionTag:@"1"
+		                                    options:viewOptions];
+		
+		BOOL registerResult = [database registerExtension:view withName:@"order"];
+		XCTAssertTrue(registerResult, @"Failure registering view extension");
+	}
+	
+	YapDatabaseFullTextSearchHandler *handler = [YapDatabaseFullTextSearchHandler withObjectBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object){
+		
+		[dict setObject:object forKey:@"content"];
+	}];
+	
+	YapDatabaseFullTextSearch *fts =
+	  [[YapDatabaseFullTextSearch alloc] initWithColumnNames:@[@"content"]
+	                                                 handler:handler
+	                                              versionTag:@"1"];
+	
+	BOOL registerResult1 = [database registerExtension:fts withName:@"fts"];
+	XCTAssertTrue(registerResult1, @"Failure registering fts extension");
+	
+	YapDatabaseSearchResultsView *searchResultsView = nil;
+	if (useParentView)
+	{
+		searchResultsView =
+		  [[YapDatabaseSearchResultsView alloc] initWithFullTextSearchName:@"fts"
+		                                                    parentViewName:@"order"
+		                                                        versionTag:@"1"
+		                                                           options:searchViewOptions];
+	}
+	else
+	{
+		searchResultsView =
+		  [[YapDatabaseSearchResultsView alloc] initWithFullTextSearchName:@"fts"
+		                                                          grouping:grouping
+		                                                           sorting:sorting
+		                                                        versionTag:@"1"
+		                                                           options:searchViewOptions];
+	}
+	
+	BOOL registerResult2 = [database registerExtension:searchResultsView withName:@"searchResults"];
+	XCTAssertTrue(registerResult2, @"Failure registering searchResults extension");
+	
+	YapDatabaseConnection *connection1 = [database newConnection];
+	YapDatabaseConnection *connection2 = [database newConnection];
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (int i = 0; i < 1000; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"%d", i];
+			NSString *phrase = [NSString stringWithFormat:@"item %04d is %@", i, ((i % 2) ? @"odd" : @"even")];
+			
+			[transaction setObject:phrase forKey:key inCollection:nil];
+		}
+	}];
+	
+	YapDatabaseSearchQueue *searchQueue = [[YapDatabaseSearchQueue alloc] init];
+	
+	__block BOOL done = NO;
+	__block NSUInteger count = 0;
+	__block NSUInteger slices = 0;
+	
+	// Perform the first slice, and check for partial results
+	
+	[searchQueue enqueueQuery:@"even"];
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		done = [[transaction ext:@"searchResults"] performSearchSliceWithQueue:searchQueue maxRows:100];
+		count = [[transaction ext:@"searchResults"] numberOfItemsInGroup:@""];
+	}];
+	
+	XCTAssertFalse(done, @"Expected more slices");
+	XCTAssertTrue(count > 0 && count < 500, @"Bad count: %lu", (unsigned long)count);
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSUInteger connection2Count = [[transaction ext:@"searchResults"] numberOfItemsInGroup:@""];
+		XCTAssertTrue(connection2Count == count, @"Partial results not published: %lu", (unsigned long)connection2Count);
+	}];
+	
+	// Modify the database (on another connection) in-between slices
+	
+	[connection2 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"item 0000 is now odd" forKey:@"0" inCollection:nil];
+		[transaction setObject:@"item 1000 is even" forKey:@"1000" inCollection:nil];
+	}];
+	
+	while (!done)
+	{
+		[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+			
+			done = [[transaction ext:@"searchResults"] performSearchSliceWithQueue:searchQueue maxRows:100];
+			count = [[transaction ext:@"searchResults"] numberOfItemsInGroup:@""];
+		}];
+		
+		XCTAssertTrue(++slices < 50, @"Search not making progress");
+		if (slices >= 50) break;
+	}
+	
+	XCTAssertTrue(count == 500, @"Bad count: %lu", (unsigned long)count);
+	
+	[connection1 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		BOOL containsKey0 = [[transaction ext:@"searchResults"] getGroup:NULL index:NULL forKey:@"0" inCollection:nil];
+		XCTAssertFalse(containsKey0, @"Stale search result");
+		
+		BOOL containsKey1000 = [[transaction ext:@"searchResults"] getGroup:NULL index:NULL forKey:@"1000" inCollection:nil];
+		XCTAssertTrue(containsKey1000, @"Missing search result");
+	}];
+	
+	// Enqueue queries in-between slices. Only the most recent one should be completed.
+	
+	done = NO;
+	slices = 0;
+	
+	[searchQueue enqueueQuery:@"odd"];
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		done = [[transaction ext:@"searchResults"] performSearchSliceWithQueue:searchQueue maxRows:100];
+	}];
+	
+	XCTAssertFalse(done, @"Expected more slices");
+	
+	[searchQueue enqueueQuery:@"item"];
+	[searchQueue enqueueQuery:@"now"];
+	
+	while (!done)
+	{
+		[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+			
+			done = [[transaction ext:@"searchResults"] performSearchSliceWithQueue:searchQueue maxRows:100];
+			count = [[transaction ext:@"searchResults"] numberOfItemsInGroup:@""];
+		}];
+		
+		XCTAssertTrue(++slices < 50, @"Search not making progress");
+		if (slices >= 50) break;
+	}
+	
+	XCTAssertTrue(count == 1, @"Bad count: %lu", (unsigned long)count);
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSString *connectionQuery = [[transaction ext:@"searchResults"] query];
+		XCTAssertTrue([connectionQuery isEqualToString:@"now"], @"Oops");
+	}];
+	
+	// A non-sliced search (on the same connection) supersedes a time-sliced search in progress.
+	
+	[searchQueue enqueueQuery:@"odd"];
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		done = [[transaction ext:@"searchResults"] performSearchSliceWithQueue:searchQueue maxRows:100];
+	}];
+	
+	XCTAssertFalse(done, @"Expected more slices");
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[[transaction ext:@"searchResults"] performSearchFor:@"even"];
+	}];
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		done = [[transaction ext:@"searchResults"] performSearchSliceWithQueue:searchQueue maxRows:100];
+		count = [[transaction ext:@"searchResults"] numberOfItemsInGroup:@""];
+	}];
+	
+	XCTAssertTrue(done, @"Superseded slice was resumed");
+	XCTAssertTrue(count == 500, @"Bad count: %lu", (unsigned long)count);
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSString *connectionQuery = [[transaction ext:@"searchResults"] query];
+		XCTAssertTrue([connectionQuery isEqualToString:@"even"], @"Query reverted by superseded slice");
+	}];
+}
+
 @end
@@ -1,7 +1,9 @@
 #import <XCTest/XCTest.h>
+#import <libkern/OSAtomic.h>
 
 #import "YapDatabase.h"
 #import "YapDatabaseSecondaryIndex.h"
+#import "YapDatabaseFullTextSearch.h"
 
 #import "TestObject.h"
 
@@ -358,4 +360,982 @@
 	}];
 }
 
+- (void)testEnumerateRows
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection1 = [database newConnection];
+	YapDatabaseConnection *connection2 = [database newConnection];
+	
+	YapDatabaseSecondaryIndexSetup *setup = [[YapDatabaseSecondaryIndexSetup alloc] init];
+	[setup addColumn:@"someInt" withType:YapDatabaseSecondaryIndexTypeInteger];
+	
+	YapDatabaseSecondaryIndexHandler *handler = [YapDatabaseSecondaryIndexHandler withObjectBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object){
+		
+		if ([object isKindOfClass:[TestObject class]])
+		{
+			__unsafe_unretained TestObject *testObject = (TestObject *)object;
+			
+			[dict setObject:@(testObject.someInt) forKey:@"someInt"];
+		}
+	}];
+	
+	YapDatabaseSecondaryIndex *secondaryIndex =
+	  [[YapDatabaseSecondaryIndex alloc] initWithSetup:setup handler:handler];
+	
+	[database registerExtension:secondaryIndex withName:@"idx"];
+	
+	[connection1 readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (int i = 0; i < 100; i++)
+		{
+			TestObject *object = [TestObject generateTestObjectWithSomeDate:[NSDate date] someInt:i];
+			
+			NSString *key = [NSString stringWithFormat:@"key%d", i];
+			NSString *metadata = (i % 2 == 0) ? [NSString stringWithFormat:@"meta%d", i] : nil;
+			
+			[transaction setObject:object forKey:key inCollection:@"test" withMetadata:metadata];
+		}
+	}];
+	
+	// Use connection2, which has cold caches,
+	// so the objects & metadata come from the query itself.
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		__block int expectedInt = 49;
+		
+		YapDatabaseQuery *query = [YapDatabaseQuery queryWithFormat:@"WHERE someInt < ? ORDER BY someInt DESC", @(50)];
+		[[transaction ext:@"idx"] enumerateRowsMatchingQuery:query usingBlock:
+		    ^(NSString *collection, NSString *key, id object, id metadata, BOOL *stop)
+		{
+			XCTAssertEqualObjects(collection, @"test", @"Bad collection");
+			XCTAssertEqualObjects(key, ([NSString stringWithFormat:@"key%d", expectedInt]), @"Bad key");
+			XCTAssertTrue([(TestObject *)object someInt] == expectedInt, @"Bad object");
+			
+			if (expectedInt % 2 == 0)
+				XCTAssertEqualObjects(metadata, ([NSString stringWithFormat:@"meta%d", expectedInt]), @"Bad metadata");
+			else
+				XCTAssertNil(metadata, @"Bad metadata");
+			
+			expectedInt--;
+		}];
+		
+		XCTAssertTrue(expectedInt == -1, @"Incorrect count: %d", (49 - expectedInt));
+		
+		// Second pass is served from the caches
+		
+		__block NSUInteger count = 0;
+		[[transaction ext:@"idx"] enumerateKeysAndObjectsMatchingQuery:query usingBlock:
+		    ^(NSString *collection, NSString *key, id object, BOOL *stop)
+		{
+			XCTAssertEqualObjects(key, ([NSString stringWithFormat:@"key%d", [(TestObject *)object someInt]]), @"");
+			count++;
+		}];
+		
+		XCTAssertTrue(count == 50, @"Incorrect count: %lu", (unsigned long)count);
+		
+		// Queries that reference the rowid can't be joined with the database table (ambiguous column name).
+		// These should still work.
+		
+		count = 0;
+		query = [YapDatabaseQuery queryWithFormat:@"WHERE rowid > 0 AND someInt >= ?", @(90)];
+		[[transaction ext:@"idx"] enumerateKeysAndMetadataMatchingQuery:query usingBlock:
+		    ^(NSString *collection, NSString *key, id metadata, BOOL *stop)
+		{
+			XCTAssertNotNil(key, @"Bad key");
+			count++;
+		}];
+		
+		XCTAssertTrue(count == 10, @"Incorrect count: %lu", (unsigned long)count);
+		
+		// And again, now that the failed join is cached.
+		
+		count = 0;
+		[[transaction ext:@"idx"] enumerateKeysAndMetadataMatchingQuery:query usingBlock:
+		    ^(NSString *collection, NSString *key, id metadata, BOOL *stop)
+		{
+			XCTAssertNotNil(key, @"Bad key");
+			count++;
+		}];
+		
+		XCTAssertTrue(count == 10, @"Incorrect count: %lu", (unsigned long)count);
+	}];
+}
+
+- (void)testCustomIndexes
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	YapDatabaseSecondaryIndexSetup *setup = [[YapDatabaseSecondaryIndexSetup alloc] init];
+	[setup addColumn:@"conversation" withType:YapDatabaseSecondaryIndexTypeText indexed:NO];
+	[setup addColumn:@"timestamp" withType:YapDatabaseSecondaryIndexTypeReal indexed:NO];
+	[setup addColumn:@"isUnread" withType:YapDatabaseSecondaryIndexTypeInteger indexed:NO];
+	
+	[setup addIndexWithName:@"conversation_timestamp" columns:@[ @"conversation", @"timestamp DESC" ]];
+	[setup addIndexWithName:@"unread"
+	                columns:@[ @"conversation" ]
+	       includingColumns:@[ @"timestamp" ]
+	                  where:@"isUnread = 1"];
+	
+	XCTAssertTrue([[setup customIndexes] count] == 2, @"Bad setup");
+	XCTAssertFalse([[setup columnAtIndex:0] isIndexed], @"Bad setup");
+	
+	YapDatabaseSecondaryIndexCustomIndex *customIndex = [[setup customIndexes] objectAtIndex:0];
+	XCTAssertEqualObjects(customIndex.columns, (@[ @"conversation", @"timestamp" ]), @"Bad custom index");
+	XCTAssertEqualObjects(customIndex.descending, (@[ @(NO), @(YES) ]), @"Bad custom index");
+	
+	YapDatabaseSecondaryIndexHandler *handler = [YapDatabaseSecondaryIndexHandler withObjectBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object){
+		
+		__unsafe_unretained NSDictionary *message = (NSDictionary *)object;
+		
+		[dict setObject:message[@"conversation"] forKey:@"conversation"];
+		[dict setObject:message[@"timestamp"] forKey:@"timestamp"];
+		[dict setObject:message[@"isUnread"] forKey:@"isUnread"];
+	}];
+	
+	YapDatabaseSecondaryIndex *secondaryIndex =
+	  [[YapDatabaseSecondaryIndex alloc] initWithSetup:setup handler:handler];
+	
+	BOOL registered = [database registerExtension:secondaryIndex withName:@"idx"];
+	XCTAssertTrue(registered, @"Error registering extension");
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (int i = 0; i < 200; i++)
+		{
+			NSDictionary *message = @{
+			  @"conversation" : (i % 2 == 0) ? @"even" : @"odd",
+			  @"timestamp"    : @(i),
+			  @"isUnread"     : @(i >= 190)
+			};
+			
+			NSString *key = [NSString stringWithFormat:@"%d", i];
+			[transaction setObject:message forKey:key inCollection:@"messages"];
+		}
+	}];
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		__block int expectedTimestamp = 198;
+		__block NSUInteger count = 0;
+		
+		YapDatabaseQuery *query =
+		  [YapDatabaseQuery queryWithFormat:@"WHERE conversation = ? ORDER BY timestamp DESC LIMIT 50", @"even"];
+		
+		[[transaction ext:@"idx"] enumerateKeysMatchingQuery:query
+		                                          usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			
+			XCTAssertTrue([key intValue] == expectedTimestamp, @"Bad order: %@", key);
+			
+			expectedTimestamp -= 2;
+			count++;
+		}];
+		
+		XCTAssertTrue(count == 50, @"Incorrect count: %lu", (unsigned long)count);
+		
+		count = 0;
+		query = [YapDatabaseQuery queryWithFormat:@"WHERE isUnread = 1 AND conversation = ?", @"odd"];
+		
+		[[transaction ext:@"idx"] enumerateKeysMatchingQuery:query
+		                                          usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			count++;
+		}];
+		
+		XCTAssertTrue(count == 5, @"Incorrect count: %lu", (unsigned long)count);
+	}];
+}
+
+- (void)testAggregates
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	YapDatabaseSecondaryIndexSetup *setup = [[YapDatabaseSecondaryIndexSetup alloc] init];
+	[setup addColumn:@"folder" withType:YapDatabaseSecondaryIndexTypeText];
+	[setup addColumn:@"timestamp" withType:YapDatabaseSecondaryIndexTypeReal];
+	[setup addColumn:@"isUnread" withType:YapDatabaseSecondaryIndexTypeInteger];
+	
+	YapDatabaseSecondaryIndexHandler *handler = [YapDatabaseSecondaryIndexHandler withObjectBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object){
+		
+		__unsafe_unretained NSDictionary *message = (NSDictionary *)object;
+		
+		[dict setObject:message[@"folder"] forKey:@"folder"];
+		[dict setObject:message[@"timestamp"] forKey:@"timestamp"];
+		[dict setObject:message[@"isUnread"] forKey:@"isUnread"];
+	}];
+	
+	YapDatabaseSecondaryIndex *secondaryIndex =
+	  [[YapDatabaseSecondaryIndex alloc] initWithSetup:setup handler:handler];
+	
+	BOOL registered = [database registerExtension:secondaryIndex withName:@"idx"];
+	XCTAssertTrue(registered, @"Error registering extension");
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		// inbox : 0, 3, 6, ... 99 (34 messages)
+		// sent  : 1, 4, 7, ... 97 (33 messages)
+		// spam  : 2, 5, 8, ... 98 (33 messages)
+		
+		NSArray *folders = @[ @"inbox", @"sent", @"spam" ];
+		
+		for (int i = 0; i < 100; i++)
+		{
+			NSDictionary *message = @{
+			  @"folder"    : folders[i % 3],
+			  @"timestamp" : @(i + 0.5),
+			  @"isUnread"  : @(i % 2 == 0)
+			};
+			
+			NSString *key = [NSString stringWithFormat:@"%d", i];
+			[transaction setObject:message forKey:key inCollection:@"messages"];
+		}
+	}];
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		YapDatabaseQuery *query = [YapDatabaseQuery queryWithFormat:@"WHERE isUnread = ?", @(YES)];
+		
+		id count = [[transaction ext:@"idx"] aggregate:@"COUNT(*)" matchingQuery:query];
+		XCTAssertEqualObjects(count, @(50), @"Bad count: %@", count);
+		
+		query = [YapDatabaseQuery queryWithFormat:@"WHERE folder = ?", @"inbox"];
+		
+		id max = [[transaction ext:@"idx"] aggregate:@"MAX(timestamp)" matchingQuery:query];
+		XCTAssertEqualObjects(max, @(99.5), @"Bad max: %@", max);
+		
+		query = [YapDatabaseQuery queryWithFormat:@"WHERE folder = ?", @"trash"];
+		
+		max = [[transaction ext:@"idx"] aggregate:@"MAX(timestamp)" matchingQuery:query];
+		XCTAssertNil(max, @"Expected nil for MAX over zero rows: %@", max);
+		
+		query = [YapDatabaseQuery queryWithFormat:@"WHERE isUnread = ? GROUP BY folder ORDER BY folder", @(YES)];
+		
+		NSMutableArray *results = [NSMutableArray array];
+		
+		BOOL result =
+		[[transaction ext:@"idx"] enumerateAggregates:@[ @"folder", @"COUNT(*)", @"MAX(timestamp)" ]
+		                                matchingQuery:query
+		                                   usingBlock:^(NSArray *values, BOOL *stop) {
+			
+			[results addObject:values];
+		}];
+		
+		XCTAssertTrue(result, @"Error enumerating aggregates");
+		
+		NSArray *expected = @[
+		  @[ @"inbox", @(17), @(96.5) ],
+		  @[ @"sent",  @(16), @(94.5) ],
+		  @[ @"spam",  @(17), @(98.5) ]
+		];
+		XCTAssertEqualObjects(results, expected, @"Bad grouped aggregates: %@", results);
+		
+		query = [YapDatabaseQuery queryWithFormat:@"WHERE nonExistentColumn = ?", @(YES)];
+		
+		result = [[transaction ext:@"idx"] enumerateAggregates:@[ @"COUNT(*)" ]
+		                                         matchingQuery:query
+		                                            usingBlock:^(NSArray *values, BOOL *stop) {}];
+		
+		XCTAssertFalse(result, @"Expected failure for bad query");
+	}];
+}
+
+- (void)testDeferredIndexUpdates
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	YapDatabaseSecondaryIndexSetup *setup = [[YapDatabaseSecondaryIndexSetup alloc] init];
+	[setup addColumn:@"someNumber" withType:YapDatabaseSecondaryIndexTypeInteger];
+	
+	__block int32_t blockInvocationCount = 0;
+	
+	YapDatabaseSecondaryIndexHandler *handler = [YapDatabaseSecondaryIndexHandler withRowBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object, id metadata){
+		
+		OSAtomicIncrement32(&blockInvocationCount);
+		
+		if (metadata) {
+			[dict setObject:metadata forKey:@"someNumber"];
+		}
+	}];
+	
+	YapDatabaseSecondaryIndexOptions *options = [[YapDatabaseSecondaryIndexOptions alloc] init];
+	options.deferIndexUpdates = YES;
+	options.concurrentIndexExtraction = YES;
+	
+	YapDatabaseSecondaryIndex *secondaryIndex =
+	  [[YapDatabaseSecondaryIndex alloc] initWithSetup:setup handler:handler versionTag:@"1" options:options];
+	
+	BOOL registered = [database registerExtension:secondaryIndex withName:@"idx"];
+	XCTAssertTrue(registered, @"Error registering extension");
+	
+	blockInvocationCount = 0;
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		// Bulk insert (more than a single batch)
+		
+		for (int i = 0; i < 1000; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"%d", i];
+			[transaction setObject:@"object" forKey:key inCollection:nil withMetadata:@(i)];
+		}
+		
+		// Modify the same rows several times
+		
+		for (int i = 0; i < 100; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"%d", i];
+			
+			[transaction replaceMetadata:@(i + 5000) forKey:key inCollection:nil];
+			[transaction replaceObject:@"object2" forKey:key inCollection:nil];
+			[transaction replaceMetadata:@(i + 10000) forKey:key inCollection:nil];
+		}
+		
+		// Insert and then remove
+		
+		for (int i = 1000; i < 1100; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"%d", i];
+			
+			[transaction setObject:@"object" forKey:key inCollection:nil withMetadata:@(i)];
+			[transaction removeObjectForKey:key inCollection:nil];
+		}
+		
+		// Remove the index values for some rows
+		
+		for (int i = 900; i < 1000; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"%d", i];
+			[transaction replaceMetadata:nil forKey:key inCollection:nil];
+		}
+	}];
+	
+	XCTAssertTrue(blockInvocationCount == 1000, @"Unexpected block invocation count: %d", blockInvocationCount);
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSUInteger count = 0;
+		YapDatabaseQuery *query = [YapDatabaseQuery queryWithFormat:@"WHERE someNumber >= ?", @(0)];
+		
+		[[transaction ext:@"idx"] getNumberOfRows:&count matchingQuery:query];
+		XCTAssertTrue(count == 900, @"Incorrect count: %lu", (unsigned long)count);
+		
+		query = [YapDatabaseQuery queryWithFormat:@"WHERE someNumber >= ?", @(10000)];
+		
+		[[transaction ext:@"idx"] getNumberOfRows:&count matchingQuery:query];
+		XCTAssertTrue(count == 100, @"Incorrect count: %lu", (unsigned long)count);
+	}];
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		// Queries within the transaction should see the pending changes
+		
+		[transaction setObject:@"object" forKey:@"new" inCollection:nil withMetadata:@(-1)];
+		[transaction removeObjectForKey:@"0" inCollection:nil];
+		
+		NSUInteger count = 0;
+		YapDatabaseQuery *query = [YapDatabaseQuery queryWithFormat:@"WHERE someNumber < ?", @(0)];
+		
+		[[transaction ext:@"idx"] getNumberOfRows:&count matchingQuery:query];
+		XCTAssertTrue(count == 1, @"Incorrect count: %lu", (unsigned long)count);
+		
+		query = [YapDatabaseQuery queryWithFormat:@"WHERE someNumber >= ?", @(10000)];
+		
+		[[transaction ext:@"idx"] getNumberOfRows:&count matchingQuery:query];
+		XCTAssertTrue(count == 99, @"Incorrect count: %lu", (unsigned long)count);
+		
+		// Modify a row again after the flush
+		
+		[transaction replaceMetadata:@(-2) forKey:@"new" inCollection:nil];
+		
+		query = [YapDatabaseQuery queryWithFormat:@"WHERE someNumber = ?", @(-2)];
+		
+		[[transaction ext:@"idx"] getNumberOfRows:&count matchingQuery:query];
+		XCTAssertTrue(count == 1, @"Incorrect count: %lu", (unsigned long)count);
+	}];
+}
+
+- (void)testCompiledQuery
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	YapDatabaseSecondaryIndexSetup *setup = [[YapDatabaseSecondaryIndexSetup alloc] init];
+	[setup addColumn:@"someNumber" withType:YapDatabaseSecondaryIndexTypeInteger];
+	[setup addColumn:@"someString" withType:YapDatabaseSecondaryIndexTypeText];
+	
+	YapDatabaseSecondaryIndexHandler *handler = [YapDatabaseSecondaryIndexHandler withObjectBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object){
+		
+		[dict setObject:@([key intValue]) forKey:@"someNumber"];
+		[dict setObject:object forKey:@"someString"];
+	}];
+	
+	YapDatabaseSecondaryIndex *secondaryIndex =
+	  [[YapDatabaseSecondaryIndex alloc] initWithSetup:setup handler:handler];
+	
+	BOOL registered = [database registerExtension:secondaryIndex withName:@"idx"];
+	XCTAssertTrue(registered, @"Error registering extension");
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (int i = 0; i < 100; i++)
+		{
+			NSString *key = [NSString stringWithFormat:@"%d", i];
+			NSString *object = (i % 2 == 0) ? @"even" : @"odd";
+			
+			[transaction setObject:object forKey:key inCollection:nil];
+		}
+	}];
+	
+	YapDatabaseCompiledQuery *query =
+	  [YapDatabaseCompiledQuery compiledQueryWithString:@"WHERE someNumber >= ? AND someNumber < ? AND someString = ?"];
+	
+	XCTAssertTrue(query.parameterCount == 3, @"Bad parameterCount");
+	
+	[query bindInt64:10 atIndex:0];
+	[query bindDouble:20.0 atIndex:1];
+	[query bindText:@"even" atIndex:2];
+	
+	XCTAssertEqualObjects(query.queryParameters, (@[ @(10), @(20.0), @"even" ]), @"Bad queryParameters");
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSUInteger count = 0;
+		[[transaction ext:@"idx"] getNumberOfRows:&count matchingQuery:query];
+		
+		XCTAssertTrue(count == 5, @"Incorrect count: %lu", (unsigned long)count);
+		
+		__block NSUInteger enumCount = 0;
+		[[transaction ext:@"idx"] enumerateKeysAndObjectsMatchingQuery:query
+		                                                    usingBlock:^(NSString *collection, NSString *key, id object, BOOL *stop) {
+			
+			XCTAssertEqualObjects(object, @"even", @"Bad object");
+			enumCount++;
+		}];
+		
+		XCTAssertTrue(enumCount == 5, @"Incorrect count: %lu", (unsigned long)enumCount);
+	}];
+	
+	// Re-bind, and reuse in another transaction (on the same connection)
+	
+	[query bindInt64:0 atIndex:0];
+	[query bindInt64:100 atIndex:1];
+	[query bindText:[NSString stringWithFormat:@"%@%@", @"o", @"dd"] atIndex:2];
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSUInteger count = 0;
+		[[transaction ext:@"idx"] getNumberOfRows:&count matchingQuery:query];
+		
+		XCTAssertTrue(count == 50, @"Incorrect count: %lu", (unsigned long)count);
+	}];
+	
+	// And on another connection
+	
+	YapDatabaseConnection *connection2 = [database newConnection];
+	
+	[query bindNullAtIndex:2];
+	
+	[connection2 readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		NSUInteger count = 0;
+		[[transaction ext:@"idx"] getNumberOfRows:&count matchingQuery:query];
+		
+		XCTAssertTrue(count == 0, @"Incorrect count: %lu", (unsigned long)count);
+		
+		NSString *plan = [[transaction ext:@"idx"] queryPlanForQuery:query];
+		
+		XCTAssertNotNil(plan, @"Expected query plan");
+		XCTAssertTrue([plan rangeOfString:@"INDEX"].location != NSNotFound, @"Expected index to be used: %@", plan);
+		
+		YapDatabaseQuery *badQuery = [YapDatabaseQuery queryWithFormat:@"WHERE nonExistentColumn = ?", @(1)];
+		
+		XCTAssertNil([[transaction ext:@"idx"] queryPlanForQuery:badQuery], @"Expected nil for bad query");
+	}];
+	
+	// Non-ASCII text (the string's internal buffer isn't UTF-8, so it's converted when bound).
+	// Re-enabling the query cache shouldn't affect the compiled query either.
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		[transaction setObject:@"na\u00efve \u2603" forKey:@"100" inCollection:nil];
+	}];
+	
+	[[connection ext:@"idx"] setQueryCacheEnabled:YES];
+	
+	YapDatabaseCompiledQuery *textQuery = [YapDatabaseCompiledQuery compiledQueryWithString:@"WHERE someString = ?"];
+	
+	@autoreleasepool {
+		
+		[textQuery bindText:[NSString stringWithFormat:@"na\u00efve %C", (unichar)0x2603] atIndex:0];
+	}
+	
+	for (int i = 0; i < 2; i++)
+	{
+		[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+			
+			NSUInteger count = 0;
+			[[transaction ext:@"idx"] getNumberOfRows:&count matchingQuery:textQuery];
+			
+			XCTAssertTrue(count == 1, @"Incorrect count: %lu", (unsigned long)count);
+		}];
+	}
+	
+	// More compiled queries than the connection keeps statements for.
+	// The least recently used statements are finalized, and prepared again if the query is used again.
+	
+	NSMutableArray *compiledQueries = [NSMutableArray array];
+	
+	for (int i = 0; i < 50; i++)
+	{
+		YapDatabaseCompiledQuery *numberQuery =
+		  [YapDatabaseCompiledQuery compiledQueryWithString:@"WHERE someNumber = ?"];
+		[numberQuery bindInt64:i atIndex:0];
+		
+		[compiledQueries addObject:numberQuery];
+	}
+	
+	for (int pass = 0; pass < 2; pass++)
+	{
+		[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+			
+			for (YapDatabaseCompiledQuery *numberQuery in compiledQueries)
+			{
+				NSUInteger count = 0;
+				[[transaction ext:@"idx"] getNumberOfRows:&count matchingQuery:numberQuery];
+				
+				XCTAssertTrue(count == 1, @"Incorrect count: %lu", (unsigned long)count);
+			}
+		}];
+	}
+}
+
+- (void)testPagination
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	YapDatabaseSecondaryIndexSetup *setup = [[YapDatabaseSecondaryIndexSetup alloc] init];
+	[setup addColumn:@"folder" withType:YapDatabaseSecondaryIndexTypeText];
+	[setup addColumn:@"timestamp" withType:YapDatabaseSecondaryIndexTypeInteger];
+	
+	YapDatabaseSecondaryIndexHandler *handler = [YapDatabaseSecondaryIndexHandler withObjectBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object){
+		
+		__unsafe_unretained NSDictionary *message = (NSDictionary *)object;
+		
+		[dict setObject:message[@"folder"] forKey:@"folder"];
+		[dict setObject:message[@"timestamp"] forKey:@"timestamp"];
+	}];
+	
+	YapDatabaseSecondaryIndex *secondaryIndex =
+	  [[YapDatabaseSecondaryIndex alloc] initWithSetup:setup handler:handler];
+	
+	BOOL registered = [database registerExtension:secondaryIndex withName:@"idx"];
+	XCTAssertTrue(registered, @"Error registering extension");
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		// Several messages share each timestamp (i / 3), so the pages have to break ties by rowid.
+		
+		for (int i = 0; i < 300; i++)
+		{
+			NSDictionary *message = @{
+			  @"folder"    : (i % 2 == 0) ? @"inbox" : @"sent",
+			  @"timestamp" : @(i / 3)
+			};
+			
+			NSString *key = [NSString stringWithFormat:@"%d", i];
+			[transaction setObject:message forKey:key inCollection:@"messages"];
+		}
+	}];
+	
+	YapDatabaseQuery *query = [YapDatabaseQuery queryWithFormat:@"WHERE folder = ?", @"inbox"];
+	
+	NSMutableArray *keys = [NSMutableArray array];
+	__block YapDatabaseSecondaryIndexCursor *cursor = nil;
+	__block NSUInteger pageCount = 0;
+	
+	do
+	{
+		[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+			
+			cursor = [[transaction ext:@"idx"] enumerateKeysAndObjectsMatchingQuery:query
+			                                                              orderedBy:@"timestamp"
+			                                                              ascending:NO
+			                                                                  limit:40
+			                                                            afterCursor:cursor
+			                                                             usingBlock:
+			    ^(NSString *collection, NSString *key, id object, BOOL *stop) {
+				
+				XCTAssertEqualObjects(object[@"folder"], @"inbox", @"Bad object");
+				[keys addObject:key];
+			}];
+		}];
+		
+		if (cursor)
+		{
+			// Cursors can be persisted
+			
+			NSData *data = [NSKeyedArchiver archivedDataWithRootObject:cursor];
+			cursor = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+			
+			XCTAssertEqualObjects(cursor.column, @"timestamp", @"Bad cursor");
+		}
+		
+		pageCount++;
+		
+	} while (cursor && (pageCount < 100));
+	
+	XCTAssertTrue(pageCount == 4, @"Unexpected page count: %lu", (unsigned long)pageCount);
+	XCTAssertTrue([keys count] == 150, @"Unexpected count: %lu", (unsigned long)[keys count]);
+	XCTAssertTrue([[NSSet setWithArray:keys] count] == 150, @"Duplicate keys across pages");
+	
+	for (NSUInteger i = 1; i < [keys count]; i++)
+	{
+		int prevTimestamp = [keys[i-1] intValue] / 3;
+		int timestamp = [keys[i] intValue] / 3;
+		
+		XCTAssertTrue(prevTimestamp >= timestamp, @"Bad order at index %lu", (unsigned long)i);
+	}
+	
+	// A compiled query's parameters (including blobs) carry over to each page
+	
+	YapDatabaseCompiledQuery *compiledQuery =
+	  [YapDatabaseCompiledQuery compiledQueryWithString:@"WHERE folder = CAST(? AS TEXT)"];
+	[compiledQuery bindBlob:[@"inbox" dataUsingEncoding:NSUTF8StringEncoding] atIndex:0];
+	
+	NSMutableArray *compiledKeys = [NSMutableArray array];
+	cursor = nil;
+	pageCount = 0;
+	
+	do
+	{
+		[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+			
+			cursor = [[transaction ext:@"idx"] enumerateKeysMatchingQuery:compiledQuery
+			                                                    orderedBy:@"timestamp"
+			                                                    ascending:NO
+			                                                        limit:40
+			                                                  afterCursor:cursor
+			                                                   usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+				
+				[compiledKeys addObject:key];
+			}];
+		}];
+		
+		pageCount++;
+		
+	} while (cursor && (pageCount < 100));
+	
+	XCTAssertTrue(pageCount == 4, @"Unexpected page count: %lu", (unsigned long)pageCount);
+	XCTAssertEqualObjects(compiledKeys, keys, @"Compiled query doesn't match regular query");
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		// Stopping early returns a cursor for the last row we were given
+		
+		YapDatabaseSecondaryIndexCursor *stopCursor =
+		  [[transaction ext:@"idx"] enumerateKeysMatchingQuery:[YapDatabaseQuery queryMatchingAll]
+		                                             orderedBy:@"timestamp"
+		                                             ascending:YES
+		                                                 limit:10
+		                                           afterCursor:nil
+		                                            usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			
+			if ([key isEqualToString:@"2"]) *stop = YES;
+		}];
+		
+		XCTAssertNotNil(stopCursor, @"Expected cursor");
+		XCTAssertEqualObjects(stopCursor.value, @(0), @"Bad cursor value");
+		
+		__block NSString *nextKey = nil;
+		
+		[[transaction ext:@"idx"] enumerateKeysMatchingQuery:[YapDatabaseQuery queryMatchingAll]
+		                                           orderedBy:@"timestamp"
+		                                           ascending:YES
+		                                               limit:1
+		                                         afterCursor:stopCursor
+		                                          usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			
+			nextKey = key;
+		}];
+		
+		XCTAssertEqualObjects(nextKey, @"3", @"Bad next key");
+		
+		// Invalid input
+		
+		YapDatabaseQuery *badQuery = [YapDatabaseQuery queryWithFormat:@"ORDER BY folder"];
+		
+		XCTAssertNil([[transaction ext:@"idx"] enumerateKeysMatchingQuery:badQuery
+		                                                        orderedBy:@"timestamp"
+		                                                        ascending:YES
+		                                                            limit:10
+		                                                      afterCursor:nil
+		                                                       usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {}]);
+		
+		NSArray *badQueries = @[
+		  [YapDatabaseQuery queryWithFormat:@"WHERE folder = ? ORDER BY folder", @"inbox"],
+		  [YapDatabaseQuery queryWithFormat:@"WHERE folder = ? LIMIT 5", @"inbox"],
+		  [YapDatabaseQuery queryWithFormat:@"where folder = ? group by timestamp", @"inbox"]
+		];
+		
+		for (YapDatabaseQuery *trailingQuery in badQueries)
+		{
+			__block NSUInteger count = 0;
+			
+			[[transaction ext:@"idx"] enumerateKeysMatchingQuery:trailingQuery
+			                                           orderedBy:@"timestamp"
+			                                           ascending:YES
+			                                               limit:10
+			                                         afterCursor:nil
+			                                          usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+				count++;
+			}];
+			
+			XCTAssertTrue(count == 0, @"Expected query to be rejected: %@", trailingQuery.queryString);
+		}
+		
+		// Keywords within string literals & subqueries are fine
+		
+		YapDatabaseQuery *okQuery =
+		  [YapDatabaseQuery queryWithFormat:@"WHERE folder != 'order by' AND timestamp IN "
+		                                    @"(SELECT timestamp FROM (SELECT 0 AS timestamp) LIMIT 1)"];
+		
+		__block NSUInteger okCount = 0;
+		
+		[[transaction ext:@"idx"] enumerateKeysMatchingQuery:okQuery
+		                                           orderedBy:@"timestamp"
+		                                           ascending:YES
+		                                               limit:10
+		                                         afterCursor:nil
+		                                          usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			okCount++;
+		}];
+		
+		XCTAssertTrue(okCount == 3, @"Bad count: %lu", (unsigned long)okCount);
+		
+		XCTAssertNil([[transaction ext:@"idx"] enumerateKeysMatchingQuery:query
+		                                                        orderedBy:@"nonExistentColumn"
+		                                                        ascending:YES
+		                                                            limit:10
+		                                                      afterCursor:nil
+		                                                       usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {}]);
+		
+		XCTAssertNil([[transaction ext:@"idx"] enumerateKeysMatchingQuery:query
+		                                                        orderedBy:@"timestamp"
+		                                                        ascending:NO
+		                                                            limit:10
+		                                                      afterCursor:stopCursor
+		                                                       usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {}]);
+	}];
+}
+
+- (void)testFullTextSearchQuery
+{
+	NSString *databasePath = [self databasePath:NSStringFromSelector(_cmd)];
+	
+	[[NSFileManager defaultManager] removeItemAtPath:databasePath error:NULL];
+	YapDatabase *database = [[YapDatabase alloc] initWithPath:databasePath];
+	
+	XCTAssertNotNil(database, @"Oops");
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	
+	YapDatabaseSecondaryIndexSetup *setup = [[YapDatabaseSecondaryIndexSetup alloc] init];
+	[setup addColumn:@"folder" withType:YapDatabaseSecondaryIndexTypeText];
+	[setup addColumn:@"timestamp" withType:YapDatabaseSecondaryIndexTypeInteger];
+	
+	YapDatabaseSecondaryIndexHandler *handler = [YapDatabaseSecondaryIndexHandler withObjectBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object){
+		
+		__unsafe_unretained NSDictionary *message = (NSDictionary *)object;
+		
+		[dict setObject:message[@"folder"] forKey:@"folder"];
+		[dict setObject:message[@"timestamp"] forKey:@"timestamp"];
+	}];
+	
+	YapDatabaseSecondaryIndex *secondaryIndex =
+	  [[YapDatabaseSecondaryIndex alloc] initWithSetup:setup handler:handler];
+	
+	XCTAssertTrue([database registerExtension:secondaryIndex withName:@"idx"], @"Error registering extension");
+	
+	YapDatabaseFullTextSearchHandler *ftsHandler = [YapDatabaseFullTextSearchHandler withObjectBlock:
+	    ^(NSMutableDictionary *dict, NSString *collection, NSString *key, id object){
+		
+		__unsafe_unretained NSDictionary *message = (NSDictionary *)object;
+		
+		[dict setObject:message[@"body"] forKey:@"body"];
+	}];
+	
+	YapDatabaseFullTextSearch *fts =
+	  [[YapDatabaseFullTextSearch alloc] initWithColumnNames:@[@"body"] handler:ftsHandler];
+	
+	XCTAssertTrue([database registerExtension:fts withName:@"fts"], @"Error registering extension");
+	
+	[connection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		for (int i = 0; i < 100; i++)
+		{
+			NSDictionary *message = @{
+			  @"folder"    : (i % 2 == 0) ? @"inbox" : @"sent",
+			  @"timestamp" : @(i),
+			  @"body"      : (i % 5 == 0) ? @"lunch at noon" : @"meeting at noon"
+			};
+			
+			NSString *key = [NSString stringWithFormat:@"%d", i];
+			[transaction setObject:message forKey:key inCollection:@"messages"];
+		}
+	}];
+	
+	[connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		YapDatabaseQuery *query = [YapDatabaseQuery queryWithFormat:@"WHERE folder = ?", @"inbox"];
+		
+		NSMutableArray *keys = [NSMutableArray array];
+		BOOL result;
+		
+		// Inbox messages mentioning lunch: 0, 10, 20 ... 90
+		
+		result = [[transaction ext:@"idx"] enumerateKeysMatchingQuery:query
+		                                               fullTextSearch:@"fts"
+		                                                     matching:@"lunch"
+		                                                    orderedBy:@"timestamp"
+		                                                    ascending:NO
+		                                                        limit:3
+		                                                   usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			[keys addObject:key];
+		}];
+		
+		XCTAssertTrue(result, @"Query failed");
+		XCTAssertEqualObjects(keys, (@[@"90", @"80", @"70"]), @"Bad results");
+		
+		[keys removeAllObjects];
+		result = [[transaction ext:@"idx"] enumerateKeysAndObjectsMatchingQuery:query
+		                                                         fullTextSearch:@"fts"
+		                                                               matching:@"lunch"
+		                                                              orderedBy:@"timestamp"
+		                                                              ascending:YES
+		                                                                  limit:0
+		                                                             usingBlock:
+		    ^(NSString *collection, NSString *key, id object, BOOL *stop) {
+			
+			XCTAssertEqualObjects(object[@"folder"], @"inbox", @"Bad object");
+			[keys addObject:key];
+		}];
+		
+		XCTAssertTrue(result, @"Query failed");
+		XCTAssertTrue([keys count] == 10, @"Bad count: %lu", (unsigned long)[keys count]);
+		XCTAssertEqualObjects([keys firstObject], @"0", @"Bad order");
+		XCTAssertEqualObjects([keys lastObject], @"90", @"Bad order");
+		
+		// A compiled query with a blob parameter
+		
+		YapDatabaseCompiledQuery *compiledQuery =
+		  [YapDatabaseCompiledQuery compiledQueryWithString:@"WHERE folder = CAST(? AS TEXT)"];
+		[compiledQuery bindBlob:[@"inbox" dataUsingEncoding:NSUTF8StringEncoding] atIndex:0];
+		
+		[keys removeAllObjects];
+		result = [[transaction ext:@"idx"] enumerateKeysMatchingQuery:compiledQuery
+		                                               fullTextSearch:@"fts"
+		                                                     matching:@"lunch"
+		                                                    orderedBy:@"timestamp"
+		                                                    ascending:NO
+		                                                        limit:3
+		                                                   usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			[keys addObject:key];
+		}];
+		
+		XCTAssertTrue(result, @"Query failed");
+		XCTAssertEqualObjects(keys, (@[@"90", @"80", @"70"]), @"Bad results");
+		
+		// Without an ordering, the rowids from each side are intersected (in rowid order)
+		
+		[keys removeAllObjects];
+		result = [[transaction ext:@"idx"] enumerateKeysMatchingQuery:query
+		                                               fullTextSearch:@"fts"
+		                                                     matching:@"lunch"
+		                                                    orderedBy:nil
+		                                                    ascending:YES
+		                                                        limit:0
+		                                                   usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+			[keys addObject:key];
+		}];
+		
+		XCTAssertTrue(result, @"Query failed");
+		XCTAssertEqualObjects(keys, (@[@"0", @"10", @"20", @"30", @"40", @"50", @"60", @"70", @"80", @"90"]),
+		                      @"Bad results");
+		
+		[keys removeAllObjects];
+		result = [[transaction ext:@"idx"] enumerateKeysAndMetadataMatchingQuery:[YapDatabaseQuery queryMatchingAll]
+		                                                          fullTextSearch:@"fts"
+		                                                                matching:@"lunch"
+		                                                               orderedBy:nil
+		                                                               ascending:YES
+		                                                                   limit:3
+		                                                              usingBlock:
+		    ^(NSString *collection, NSString *key, id metadata, BOOL *stop) {
+			
+			[keys addObject:key];
+		}];
+		
+		XCTAssertTrue(result, @"Query failed");
+		XCTAssertEqualObjects(keys, (@[@"0", @"5", @"10"]), @"Bad results");
+		
+		// Unknown extension
+		
+		result = [[transaction ext:@"idx"] enumerateKeysMatchingQuery:query
+		                                               fullTextSearch:@"nope"
+		                                                     matching:@"lunch"
+		                                                    orderedBy:nil
+		                                                    ascending:YES
+		                                                        limit:0
+		                                                   usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {}];
+		
+		XCTAssertFalse(result, @"Expected failure for unknown extension");
+	}];
+}
+
 @end
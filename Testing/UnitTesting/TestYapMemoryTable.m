@@ -0,0 +1,436 @@
+#import <XCTest/XCTest.h>
+
+#import "YapMemoryTable.h"
+
+#import <libkern/OSAtomic.h>
+
+
+@interface TestYapMemoryTable : XCTestCase
+@end
+
+@implementation TestYapMemoryTable
+
+/**
+ * Pruning happens asynchronously (on the table's internal queue).
+ * Modifications are synchronous on the same queue, so a modification acts as a barrier.
+**/
+- (void)waitForCheckpoint:(YapMemoryTable *)table
+{
+	YapMemoryTableTransaction *transaction = [table newReadWriteTransactionWithSnapshot:UINT64_MAX];
+	[transaction modifyWithBlock:^{}];
+}
+
+- (void)testSnapshotVisibility
+{
+	YapMemoryTable *table = [[YapMemoryTable alloc] initWithKeyClass:[NSString class]];
+	YapMemoryTableTransaction *transaction;
+	
+	// snapshot 1: a = 1, b = 1
+	
+	transaction = [table newReadWriteTransactionWithSnapshot:1];
+	[transaction setObject:@"a1" forKey:@"a"];
+	[transaction setObject:@"b1" forKey:@"b"];
+	
+	XCTAssertEqualObjects([transaction objectForKey:@"a"], @"a1", @"Writer should see its own changes");
+	[transaction commit];
+	
+	// snapshot 2: a = 2, b removed, c = 2
+	
+	transaction = [table newReadWriteTransactionWithSnapshot:2];
+	[transaction setObject:@"a2" forKey:@"a"];
+	[transaction removeObjectForKey:@"b"];
+	[transaction setObject:@"c2" forKey:@"c"];
+	[transaction commit];
+	
+	// snapshot 3: a set twice within the same transaction
+	
+	transaction = [table newReadWriteTransactionWithSnapshot:3];
+	[transaction setObject:@"a3-first" forKey:@"a"];
+	[transaction setObject:@"a3" forKey:@"a"];
+	[transaction commit];
+	
+	YapMemoryTableTransaction *reader0 = [table newReadTransactionWithSnapshot:0];
+	YapMemoryTableTransaction *reader1 = [table newReadTransactionWithSnapshot:1];
+	YapMemoryTableTransaction *reader2 = [table newReadTransactionWithSnapshot:2];
+	YapMemoryTableTransaction *reader3 = [table newReadTransactionWithSnapshot:3];
+	
+	XCTAssertNil([reader0 objectForKey:@"a"], @"Oops");
+	
+	XCTAssertEqualObjects([reader1 objectForKey:@"a"], @"a1", @"Oops");
+	XCTAssertEqualObjects([reader1 objectForKey:@"b"], @"b1", @"Oops");
+	XCTAssertNil([reader1 objectForKey:@"c"], @"Oops");
+	
+	XCTAssertEqualObjects([reader2 objectForKey:@"a"], @"a2", @"Oops");
+	XCTAssertNil([reader2 objectForKey:@"b"], @"Oops");
+	XCTAssertEqualObjects([reader2 objectForKey:@"c"], @"c2", @"Oops");
+	
+	XCTAssertEqualObjects([reader3 objectForKey:@"a"], @"a3", @"Oops");
+	
+	NSMutableDictionary *contents = [NSMutableDictionary dictionary];
+	[reader2 enumerateKeysAndObjectsWithBlock:^(id key, id obj, BOOL *stop) {
+		
+		[contents setObject:obj forKey:key];
+	}];
+	
+	XCTAssertEqualObjects(contents, (@{ @"a": @"a2", @"c": @"c2" }), @"Oops");
+	
+	[contents removeAllObjects];
+	[reader1 accessWithBlock:^{
+		
+		[reader1 enumerateKeysAndObjectsWithBlock:^(id key, id obj, BOOL *stop) {
+			
+			[contents setObject:obj forKey:key];
+		}];
+	}];
+	
+	XCTAssertEqualObjects(contents, (@{ @"a": @"a1", @"b": @"b1" }), @"Oops");
+}
+
+- (void)testRollbackWithReusedSnapshot
+{
+	YapMemoryTable *table = [[YapMemoryTable alloc] initWithKeyClass:[NSString class]];
+	YapMemoryTableTransaction *transaction;
+	
+	transaction = [table newReadWriteTransactionWithSnapshot:1];
+	[transaction setObject:@"a1" forKey:@"a"];
+	[transaction commit];
+	
+	// A transaction for snapshot 2 is rolled back.
+	// It modified an existing key (a), added a new key (b), and removed an existing key (a) in the same transaction.
+	
+	transaction = [table newReadWriteTransactionWithSnapshot:2];
+	[transaction setObject:@"a2-rolledBack" forKey:@"a"];
+	[transaction setObject:@"b2-rolledBack" forKey:@"b"];
+	[transaction removeObjectForKey:@"a"];
+	[transaction rollback];
+	
+	// Since the transaction was rolled back, the next read-write transaction reuses the same snapshot.
+	// Readers at that snapshot must not see anything from the rolled back transaction.
+	
+	YapMemoryTableTransaction *reader = [table newReadTransactionWithSnapshot:2];
+	
+	XCTAssertEqualObjects([reader objectForKey:@"a"], @"a1", @"Rolled back value is visible");
+	XCTAssertNil([reader objectForKey:@"b"], @"Rolled back value is visible");
+	
+	transaction = [table newReadWriteTransactionWithSnapshot:2];
+	
+	XCTAssertEqualObjects([transaction objectForKey:@"a"], @"a1", @"Rolled back value is visible");
+	XCTAssertNil([transaction objectForKey:@"b"], @"Rolled back value is visible");
+	
+	[transaction setObject:@"b2" forKey:@"b"];
+	[transaction commit];
+	
+	XCTAssertEqualObjects([reader objectForKey:@"a"], @"a1", @"Oops");
+	XCTAssertEqualObjects([reader objectForKey:@"b"], @"b2", @"Oops");
+	
+	reader = [table newReadTransactionWithSnapshot:1];
+	
+	XCTAssertEqualObjects([reader objectForKey:@"a"], @"a1", @"Oops");
+	XCTAssertNil([reader objectForKey:@"b"], @"Oops");
+}
+
+- (void)testCheckpoint
+{
+	YapMemoryTable *table = [[YapMemoryTable alloc] initWithKeyClass:[NSString class]];
+	YapMemoryTableTransaction *transaction;
+	
+	// snapshot 1: a = a1, b = b1, c = c1
+	// snapshot 2: a = a2, b removed
+	// snapshot 3: c = c3
+	
+	transaction = [table newReadWriteTransactionWithSnapshot:1];
+	[transaction setObject:@"a1" forKey:@"a"];
+	[transaction setObject:@"b1" forKey:@"b"];
+	[transaction setObject:@"c1" forKey:@"c"];
+	[transaction commit];
+	
+	transaction = [table newReadWriteTransactionWithSnapshot:2];
+	[transaction setObject:@"a2" forKey:@"a"];
+	[transaction removeObjectForKey:@"b"];
+	[transaction commit];
+	
+	transaction = [table newReadWriteTransactionWithSnapshot:3];
+	[transaction setObject:@"c3" forKey:@"c"];
+	[transaction commit];
+	
+	YapMemoryTableTransaction *reader1 = [table newReadTransactionWithSnapshot:1];
+	YapMemoryTableTransaction *reader2 = [table newReadTransactionWithSnapshot:2];
+	YapMemoryTableTransaction *reader3 = [table newReadTransactionWithSnapshot:3];
+	
+	XCTAssertEqualObjects([reader1 objectForKey:@"b"], @"b1", @"Oops");
+	
+	// No transaction is using a snapshot older than 2 anymore.
+	// The versions only visible to snapshot 1 can be pruned.
+	
+	[table asyncCheckpoint:2];
+	[self waitForCheckpoint:table];
+	
+	XCTAssertEqualObjects([reader2 objectForKey:@"a"], @"a2", @"Oops");
+	XCTAssertNil([reader2 objectForKey:@"b"], @"Oops");
+	XCTAssertEqualObjects([reader2 objectForKey:@"c"], @"c1", @"Pruned a version that's still visible");
+	XCTAssertEqualObjects([reader3 objectForKey:@"c"], @"c3", @"Oops");
+	
+	// Snapshot 1 isn't in use anymore, so it's fine for it to see the pruning.
+	// And that's how we can tell the old versions are gone.
+	
+	XCTAssertNil([reader1 objectForKey:@"a"], @"Expected a1 to be pruned");
+	XCTAssertNil([reader1 objectForKey:@"b"], @"Expected b (whose latest version is a deletion) to be pruned");
+	XCTAssertEqualObjects([reader1 objectForKey:@"c"], @"c1", @"Pruned a version that's still visible");
+	
+	__block NSUInteger count = 0;
+	[reader1 enumerateKeysWithBlock:^(id key, BOOL *stop) {
+		
+		count++;
+	}];
+	
+	XCTAssertTrue(count == 1, @"Expected only c to be visible at snapshot 1 (count: %lu)", (unsigned long)count);
+	
+	// Everything up to snapshot 3 can be pruned.
+	// Multiple checkpoint requests are coalesced into a single pass.
+	
+	[table asyncCheckpoint:3];
+	[table asyncCheckpoint:4];
+	[self waitForCheckpoint:table];
+	
+	XCTAssertNil([reader2 objectForKey:@"c"], @"Expected c1 to be pruned");
+	XCTAssertEqualObjects([reader3 objectForKey:@"a"], @"a2", @"Latest version was pruned");
+	XCTAssertEqualObjects([reader3 objectForKey:@"c"], @"c3", @"Latest version was pruned");
+	XCTAssertNil([reader3 objectForKey:@"b"], @"Oops");
+	
+	// A key that was removed, and then set again, after the checkpoint
+	
+	transaction = [table newReadWriteTransactionWithSnapshot:5];
+	[transaction setObject:@"b5" forKey:@"b"];
+	[transaction commit];
+	
+	XCTAssertEqualObjects([[table newReadTransactionWithSnapshot:5] objectForKey:@"b"], @"b5", @"Oops");
+}
+
+- (void)testGrowthWithPinnedReader
+{
+	YapMemoryTable *table = [[YapMemoryTable alloc] initWithKeyClass:[NSNumber class]];
+	YapMemoryTableTransaction *transaction;
+	
+	// The table starts out with 64 buckets
+	
+	NSUInteger initialCount = 60;
+	NSUInteger addedCount = 1000;
+	
+	transaction = [table newReadWriteTransactionWithSnapshot:1];
+	for (NSUInteger i = 0; i < initialCount; i++)
+	{
+		[transaction setObject:@(i) forKey:@(i)];
+	}
+	[transaction commit];
+	
+	// While a reader is in the middle of enumerating the table (i.e. holding onto the old buckets & entries),
+	// a writer grows the table several times over.
+	
+	YapMemoryTableTransaction *reader = [table newReadTransactionWithSnapshot:1];
+	
+	__block BOOL didGrow = NO;
+	NSMutableSet *keys = [NSMutableSet set];
+	
+	[reader enumerateKeysAndObjectsWithBlock:^(id key, id obj, BOOL *stop) {
+		
+		if (!didGrow)
+		{
+			didGrow = YES;
+			
+			dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+				
+				YapMemoryTableTransaction *writer = [table newReadWriteTransactionWithSnapshot:2];
+				for (NSUInteger i = initialCount; i < (initialCount + addedCount); i++)
+				{
+					[writer setObject:@(i) forKey:@(i)];
+				}
+				
+				[writer setObject:@"modified" forKey:@(0)];
+				[writer commit];
+			});
+		}
+		
+		XCTAssertEqualObjects(key, obj, @"Reader saw a value from a newer snapshot (or a deleted value)");
+		[keys addObject:key];
+	}];
+	
+	XCTAssertTrue(didGrow, @"Oops");
+	XCTAssertTrue([keys count] == initialCount, @"Bad count: %lu", (unsigned long)[keys count]);
+	
+	// Now that the reader is done, the old version of key 0 can be pruned.
+	
+	[table asyncCheckpoint:2];
+	[self waitForCheckpoint:table];
+	
+	reader = [table newReadTransactionWithSnapshot:2];
+	
+	__block NSUInteger count = 0;
+	[reader enumerateKeysAndObjectsWithBlock:^(id key, id obj, BOOL *stop) {
+		
+		count++;
+	}];
+	
+	XCTAssertTrue(count == (initialCount + addedCount), @"Bad count: %lu", (unsigned long)count);
+	
+	for (NSUInteger i = 1; i < (initialCount + addedCount); i++)
+	{
+		XCTAssertEqualObjects([reader objectForKey:@(i)], @(i), @"Lost key: %lu", (unsigned long)i);
+	}
+	
+	XCTAssertEqualObjects([reader objectForKey:@(0)], @"modified", @"Oops");
+}
+
+- (void)testConcurrentReadersWithWriter
+{
+	YapMemoryTable *table = [[YapMemoryTable alloc] initWithKeyClass:[NSNumber class]];
+	
+	// Every commit sets every key to the snapshot number (except that every 3rd commit removes key 0).
+	// Thus each reader can verify that it sees a consistent snapshot.
+	
+	NSUInteger keyCount = 100;
+	NSUInteger readerCount = 4;
+	int64_t commitCount = 500;
+	
+	// The writer only prunes versions older than every active reader's snapshot.
+	// Readers pick their snapshot (and publish it) under the lock, so the writer can't miss one.
+	
+	__block OSSpinLock lock = OS_SPINLOCK_INIT;
+	__block int64_t committedSnapshot = 0;
+	int64_t *activeSnapshots = calloc(readerCount, sizeof(int64_t));
+	
+	for (NSUInteger r = 0; r < readerCount; r++)
+	{
+		activeSnapshots[r] = INT64_MAX;
+	}
+	
+	__block int32_t isDone = 0;
+	__block int32_t failures = 0;
+	__block int32_t reads = 0;
+	
+	dispatch_group_t group = dispatch_group_create();
+	dispatch_queue_t concurrentQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+	
+	for (NSUInteger r = 0; r < readerCount; r++)
+	{
+		dispatch_group_async(group, concurrentQueue, ^{
+			
+			while (OSAtomicAdd32Barrier(0, &isDone) == 0)
+			{
+				@autoreleasepool {
+					
+					int64_t snapshot;
+					
+					OSSpinLockLock(&lock);
+					{
+						snapshot = committedSnapshot;
+						activeSnapshots[r] = snapshot;
+					}
+					OSSpinLockUnlock(&lock);
+					
+					if (snapshot > 0)
+					{
+						YapMemoryTableTransaction *reader = [table newReadTransactionWithSnapshot:(uint64_t)snapshot];
+						
+						[reader accessWithBlock:^{
+							
+							for (NSUInteger i = 0; i < keyCount; i++)
+							{
+								id value = [reader objectForKey:@(i)];
+								id expected = (i == 0 && (snapshot % 3) == 0) ? nil : @(snapshot);
+								
+								if (!(value == expected || [value isEqual:expected]))
+									OSAtomicIncrement32Barrier(&failures);
+							}
+						}];
+						
+						OSAtomicIncrement32Barrier(&reads);
+					}
+					
+					OSSpinLockLock(&lock);
+					{
+						activeSnapshots[r] = INT64_MAX;
+					}
+					OSSpinLockUnlock(&lock);
+				}
+			}
+		});
+	}
+	
+	for (int64_t snapshot = 1; snapshot <= commitCount; snapshot++)
+	{
+		@autoreleasepool {
+			
+			YapMemoryTableTransaction *writer = [table newReadWriteTransactionWithSnapshot:(uint64_t)snapshot];
+			
+			for (NSUInteger i = 0; i < keyCount; i++)
+			{
+				if (i == 0 && (snapshot % 3) == 0)
+					[writer removeObjectForKey:@(i)];
+				else
+					[writer setObject:@(snapshot) forKey:@(i)];
+			}
+			
+			if ((snapshot % 7) == 0)
+			{
+				// And occasionally a rolled back transaction, which reuses the snapshot
+				
+				[writer rollback];
+				
+				writer = [table newReadWriteTransactionWithSnapshot:(uint64_t)snapshot];
+				
+				for (NSUInteger i = 0; i < keyCount; i++)
+				{
+					if (i == 0 && (snapshot % 3) == 0)
+						[writer removeObjectForKey:@(i)];
+					else
+						[writer setObject:@(snapshot) forKey:@(i)];
+				}
+			}
+			
+			[writer commit];
+			
+			int64_t minSnapshot;
+			
+			OSSpinLockLock(&lock);
+			{
+				committedSnapshot = snapshot;
+				
+				minSnapshot = snapshot;
+				for (NSUInteger r = 0; r < readerCount; r++)
+				{
+					minSnapshot = MIN(minSnapshot, activeSnapshots[r]);
+				}
+			}
+			OSSpinLockUnlock(&lock);
+			
+			[table asyncCheckpoint:minSnapshot];
+		}
+	}
+	
+	OSAtomicIncrement32Barrier(&isDone);
+	dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+	
+	free(activeSnapshots);
+	
+	XCTAssertTrue(failures == 0, @"Readers saw inconsistent snapshots: %d", failures);
+	XCTAssertTrue(reads > 0, @"Oops");
+	
+	// Once everything has been pruned, only the latest values remain.
+	
+	[table asyncCheckpoint:(commitCount + 1)];
+	[self waitForCheckpoint:table];
+	
+	YapMemoryTableTransaction *reader = [table newReadTransactionWithSnapshot:(uint64_t)commitCount];
+	
+	__block NSUInteger count = 0;
+	[reader enumerateKeysAndObjectsWithBlock:^(id key, id obj, BOOL *stop) {
+		
+		XCTAssertEqualObjects(obj, @(commitCount), @"Oops");
+		count++;
+	}];
+	
+	NSUInteger expectedCount = ((commitCount % 3) == 0) ? (keyCount - 1) : keyCount;
+	XCTAssertTrue(count == expectedCount, @"Bad count: %lu", (unsigned long)count);
+}
+
+@end
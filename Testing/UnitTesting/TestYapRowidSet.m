@@ -0,0 +1,352 @@
+#import <XCTest/XCTest.h>
+
+#import "YapRowidSet.h"
+
+@interface TestYapRowidSet : XCTestCase
+@end
+
+@implementation TestYapRowidSet
+
+/**
+ * Returns the rowids in enumeration order.
+**/
+- (NSArray *)rowidsInSet:(YapRowidSet *)set
+{
+	NSMutableArray *rowids = [NSMutableArray arrayWithCapacity:YapRowidSetCount(set)];
+	
+	YapRowidSetEnumerate(set, ^(int64_t rowid, BOOL *stop) {
+		
+		[rowids addObject:@(rowid)];
+	});
+	
+	return rowids;
+}
+
+/**
+ * Compares the set to the expected rowids (in any order),
+ * and ensures the set enumerates them in ascending order.
+**/
+- (void)verifySet:(YapRowidSet *)set expected:(NSSet *)expected
+{
+	NSArray *sortedExpected = [[expected allObjects] sortedArrayUsingSelector:@selector(compare:)];
+	
+	XCTAssertTrue(YapRowidSetCount(set) == [expected count],
+	              @"Bad count: %lu != %lu", (unsigned long)YapRowidSetCount(set), (unsigned long)[expected count]);
+	
+	XCTAssertEqualObjects([self rowidsInSet:set], sortedExpected, @"Bad enumeration");
+	
+	for (NSNumber *rowid in expected)
+	{
+		XCTAssertTrue(YapRowidSetContains(set, [rowid longLongValue]), @"Missing rowid: %@", rowid);
+	}
+}
+
+- (void)testNegativeRowidsAndOrder
+{
+	YapRowidSet *set = YapRowidSetCreate(0);
+	NSMutableSet *expected = [NSMutableSet set];
+	
+	// Rowids on either side of the sign bit, and of the 16-bit container boundaries
+	
+	int64_t rowids[] = {
+		1, 0, -1,
+		INT64_MAX, INT64_MIN,
+		65535, 65536, -65536, -65537,
+		(1LL << 40), -(1LL << 40),
+		12345
+	};
+	
+	for (size_t i = 0; i < (sizeof(rowids) / sizeof(rowids[0])); i++)
+	{
+		YapRowidSetAdd(set, rowids[i]);
+		[expected addObject:@(rowids[i])];
+	}
+	
+	// Adding a duplicate doesn't change anything
+	
+	YapRowidSetAdd(set, -1);
+	YapRowidSetAdd(set, INT64_MIN);
+	
+	[self verifySet:set expected:expected];
+	
+	XCTAssertFalse(YapRowidSetContains(set, 2), @"Oops");
+	XCTAssertFalse(YapRowidSetContains(set, -2), @"Oops");
+	XCTAssertFalse(YapRowidSetContains(set, -65535), @"Oops");
+	
+	XCTAssertEqualObjects([[self rowidsInSet:set] firstObject], @(INT64_MIN), @"Negative rowids must come first");
+	XCTAssertEqualObjects([[self rowidsInSet:set] lastObject], @(INT64_MAX), @"Oops");
+	
+	// Removing the last rowid from a container removes the container
+	
+	YapRowidSetRemove(set, -1);
+	YapRowidSetRemove(set, -1);
+	[expected removeObject:@(-1)];
+	
+	YapRowidSetRemove(set, INT64_MIN);
+	[expected removeObject:@(INT64_MIN)];
+	
+	[self verifySet:set expected:expected];
+	
+	YapRowidSetRemoveAll(set);
+	[self verifySet:set expected:[NSSet set]];
+	
+	YapRowidSetAdd(set, -5);
+	[self verifySet:set expected:[NSSet setWithObject:@(-5)]];
+	
+	YapRowidSetRelease(set);
+}
+
+- (void)testContainerTransitions
+{
+	YapRowidSet *set = YapRowidSetCreate(0);
+	NSMutableSet *expected = [NSMutableSet set];
+	
+	// All of these rowids share the same high key (base is a multiple of 65536).
+	// An array container holds up to 4096 values.
+	
+	int64_t base = 65536 * 3;
+	
+	for (int64_t i = 0; i < 4096; i++)
+	{
+		YapRowidSetAdd(set, base + (i * 2));
+		[expected addObject:@(base + (i * 2))];
+	}
+	
+	[self verifySet:set expected:expected];
+	
+	// array -> bitmap
+	
+	YapRowidSetAdd(set, base + 1);
+	[expected addObject:@(base + 1)];
+	
+	[self verifySet:set expected:expected];
+	
+	// bitmap -> array
+	
+	YapRowidSetRemove(set, base + 1);
+	YapRowidSetRemove(set, base + 2);
+	[expected removeObject:@(base + 1)];
+	[expected removeObject:@(base + 2)];
+	
+	[self verifySet:set expected:expected];
+	
+	// Every other value doesn't compress into runs, so optimize should leave the contents alone
+	
+	YapRowidSetOptimize(set);
+	[self verifySet:set expected:expected];
+	
+	// A dense range (with a gap) in another container compresses into runs
+	
+	int64_t denseBase = 65536 * 5;
+	
+	for (int64_t i = 0; i < 10000; i++)
+	{
+		if (i == 5000) continue;
+		
+		YapRowidSetAdd(set, denseBase + i);
+		[expected addObject:@(denseBase + i)];
+	}
+	
+	YapRowidSetOptimize(set);
+	[self verifySet:set expected:expected];
+	
+	XCTAssertFalse(YapRowidSetContains(set, denseBase + 5000), @"Oops");
+	XCTAssertFalse(YapRowidSetContains(set, denseBase + 10000), @"Oops");
+	XCTAssertFalse(YapRowidSetContains(set, denseBase - 1), @"Oops");
+	
+	// Modifying a run container expands it (into a bitmap, given the cardinality)
+	
+	YapRowidSetAdd(set, denseBase + 5000);
+	[expected addObject:@(denseBase + 5000)];
+	
+	YapRowidSetRemove(set, denseBase);
+	[expected removeObject:@(denseBase)];
+	
+	[self verifySet:set expected:expected];
+	
+	// A small run container expands into an array
+	
+	int64_t smallBase = 65536 * 7;
+	
+	for (int64_t i = 100; i < 200; i++)
+	{
+		YapRowidSetAdd(set, smallBase + i);
+		[expected addObject:@(smallBase + i)];
+	}
+	
+	YapRowidSetOptimize(set);
+	[self verifySet:set expected:expected];
+	
+	YapRowidSetRemove(set, smallBase + 150);
+	[expected removeObject:@(smallBase + 150)];
+	
+	YapRowidSetAdd(set, smallBase + 50);
+	[expected addObject:@(smallBase + 50)];
+	
+	[self verifySet:set expected:expected];
+	
+	// Removing values that were never added is a no-op (for each container type)
+	
+	YapRowidSetRemove(set, base + 1);
+	YapRowidSetRemove(set, denseBase + 20000);
+	YapRowidSetRemove(set, smallBase + 300);
+	YapRowidSetRemove(set, 65536 * 100);
+	
+	[self verifySet:set expected:expected];
+	
+	// The copy is independent of the original
+	
+	YapRowidSet *copy = YapRowidSetCopy(set);
+	
+	YapRowidSetRemoveAll(set);
+	[self verifySet:set expected:[NSSet set]];
+	[self verifySet:copy expected:expected];
+	
+	YapRowidSetRelease(copy);
+	YapRowidSetRelease(set);
+}
+
+- (void)testEnumerationStop
+{
+	YapRowidSet *set = YapRowidSetCreate(0);
+	
+	for (int64_t i = -100; i < 100; i++)
+	{
+		YapRowidSetAdd(set, i * 1000);
+	}
+	
+	__block NSUInteger count = 0;
+	__block int64_t lastRowid = 0;
+	
+	YapRowidSetEnumerate(set, ^(int64_t rowid, BOOL *stop) {
+		
+		count++;
+		lastRowid = rowid;
+		
+		if (count == 150) *stop = YES;
+	});
+	
+	XCTAssertTrue(count == 150, @"Enumeration didn't stop: %lu", (unsigned long)count);
+	XCTAssertTrue(lastRowid == 49000, @"Bad order: %lld", lastRowid);
+	
+	YapRowidSetRelease(set);
+}
+
+/**
+ * Populates the set with rowids in 3 containers (one negative), using the given kind of container:
+ * 0 = array (sparse), 1 = bitmap (dense), 2 = run (consecutive, after optimize).
+ *
+ * The seed varies the contents, so that two sets of the same kind only partially overlap.
+**/
+- (void)populateSet:(YapRowidSet *)set expected:(NSMutableSet *)expected kind:(int)kind seed:(int64_t)seed
+{
+	int64_t bases[] = { -65536 * 2, 0, 65536 * 3 };
+	
+	for (int b = 0; b < 3; b++)
+	{
+		int64_t base = bases[b];
+		
+		for (int64_t i = 0; i < 65536; i++)
+		{
+			BOOL include = NO;
+			
+			if (kind == 0)
+				include = ((i * 7 + seed) % 211) == 0;             // ~300 values
+			else if (kind == 1)
+				include = ((i + seed) % 3) != 0;                   // ~43000 values
+			else
+				include = (i >= (1000 + seed)) && (i < (9000 + seed)) && ((i % 1000) != 7);
+			
+			if (include)
+			{
+				YapRowidSetAdd(set, base + i);
+				[expected addObject:@(base + i)];
+			}
+		}
+	}
+	
+	if (kind == 2)
+		YapRowidSetOptimize(set);
+}
+
+- (void)testSetAlgebra
+{
+	for (int kindA = 0; kindA < 3; kindA++)
+	{
+		for (int kindB = 0; kindB < 3; kindB++)
+		{
+			for (int op = 0; op < 3; op++)
+			{
+				YapRowidSet *setA = YapRowidSetCreate(0);
+				YapRowidSet *setB = YapRowidSetCreate(0);
+				
+				NSMutableSet *expectedA = [NSMutableSet set];
+				NSMutableSet *expectedB = [NSMutableSet set];
+				
+				[self populateSet:setA expected:expectedA kind:kindA seed:0];
+				[self populateSet:setB expected:expectedB kind:kindB seed:500];
+				
+				// A container that only exists in one of the sets
+				
+				YapRowidSetAdd(setA, (1LL << 40));
+				[expectedA addObject:@(1LL << 40)];
+				
+				YapRowidSetAdd(setB, -(1LL << 40));
+				[expectedB addObject:@(-(1LL << 40))];
+				
+				NSMutableSet *expected = [expectedA mutableCopy];
+				
+				if (op == 0)
+				{
+					YapRowidSetIntersect(setA, setB);
+					[expected intersectSet:expectedB];
+				}
+				else if (op == 1)
+				{
+					YapRowidSetUnion(setA, setB);
+					[expected unionSet:expectedB];
+				}
+				else
+				{
+					YapRowidSetMinus(setA, setB);
+					[expected minusSet:expectedB];
+				}
+				
+				[self verifySet:setA expected:expected];
+				[self verifySet:setB expected:expectedB];
+				
+				// The result is still a regular (modifiable) set
+				
+				YapRowidSetAdd(setA, 5);
+				YapRowidSetRemove(setA, 5);
+				[expected removeObject:@(5)];
+				
+				[self verifySet:setA expected:expected];
+				
+				YapRowidSetRelease(setA);
+				YapRowidSetRelease(setB);
+			}
+		}
+	}
+}
+
+- (void)testSetAlgebraWithSelf
+{
+	YapRowidSet *set = YapRowidSetCreate(0);
+	NSMutableSet *expected = [NSMutableSet set];
+	
+	[self populateSet:set expected:expected kind:0 seed:0];
+	
+	YapRowidSetIntersect(set, set);
+	[self verifySet:set expected:expected];
+	
+	YapRowidSetUnion(set, set);
+	[self verifySet:set expected:expected];
+	
+	YapRowidSetMinus(set, set);
+	[self verifySet:set expected:[NSSet set]];
+	
+	YapRowidSetRelease(set);
+}
+
+@end
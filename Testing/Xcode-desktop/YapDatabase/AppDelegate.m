@@ -2,6 +2,7 @@
 
 #import "BenchmarkYapCache.h"
 #import "BenchmarkYapDatabase.h"
+#import "BenchmarkYapDatabaseViewChange.h"
 
 #import "YapDatabase.h"
 
@@ -30,8 +31,11 @@
 		
 		[BenchmarkYapDatabase runTestsWithCompletion:^{
 			
-			databaseBenchmarksButton.enabled = YES;
-			cacheBenchmarksButton.enabled = YES;
+			[BenchmarkYapDatabaseViewChange runTestsWithCompletion:^{
+				
+				databaseBenchmarksButton.enabled = YES;
+				cacheBenchmarksButton.enabled = YES;
+			}];
 		}];
 	});
 }
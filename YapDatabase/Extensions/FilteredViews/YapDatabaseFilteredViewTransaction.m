@@ -3,6 +3,8 @@
 #import "YapDatabasePrivate.h"
 #import "YapDatabaseViewChangePrivate.h"
 #import "YapDatabaseExtensionPrivate.h"
+#import "YapCache.h"
+#import "YapNull.h"
 #import "YapCollectionKey.h"
 #import "YapDatabaseLogging.h"
 
@@ -25,6 +27,11 @@ static NSString *const ExtKey_parentViewName = @"parentViewName";
 static NSString *const ExtKey_tag_deprecated = @"tag";
 static NSString *const ExtKey_versionTag     = @"versionTag";
 
+/**
+ * The number of parentView rows that are fetched & filtered together when (re)populating the view.
+**/
+#define YAP_DATABASE_FILTERED_VIEW_CHUNK_SIZE 500
+
 @implementation YapDatabaseFilteredViewTransaction
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -217,93 +224,426 @@ static NSString *const ExtKey_versionTag     = @"versionTag";
 	if (viewConnection->state == nil)
 		viewConnection->state = [[YapDatabaseViewState alloc] init];
 	
-	// Setup the block to properly invoke the filterBlock.
-	
 	YapDatabaseViewFilteringBlock filteringBlock_generic;
 	YapDatabaseViewBlockType filteringBlockType;
 	
 	[filteredViewConnection getFilteringBlock:&filteringBlock_generic
 	                       filteringBlockType:&filteringBlockType];
 	
-	BOOL (^InvokeFilterBlock)(NSString *group, int64_t rowid, YapCollectionKey *ck);
+	// Enumerate the existing rows in the database and populate the view
 	
-	if (filteringBlockType == YapDatabaseViewBlockTypeWithKey)
+	for (NSString *group in [parentViewTransaction allGroups])
 	{
-		__unsafe_unretained YapDatabaseViewFilteringWithKeyBlock filterBlock =
-		  (YapDatabaseViewFilteringWithKeyBlock)filteringBlock_generic;
+		__block NSUInteger filteredIndex = 0;
 		
-		InvokeFilterBlock = ^(NSString *group, int64_t rowid, YapCollectionKey *ck){
-			
-			return filterBlock(group, ck.collection, ck.key);
-		};
+		[self enumerateRowidsInParentGroup:group
+		             parentViewTransaction:parentViewTransaction
+		                    filteringBlock:filteringBlock_generic
+		                filteringBlockType:filteringBlockType
+		                        usingBlock:^(int64_t rowid, YapCollectionKey *ck, BOOL passesFilter)
+		{
+			if (passesFilter)
+			{
+				if (filteredIndex == 0) {
+					[self insertRowid:rowid collectionKey:ck inNewGroup:group];
+				}
+				else {
+					[self insertRowid:rowid collectionKey:ck
+					                              inGroup:group
+					                              atIndex:filteredIndex
+					                  withExistingPageKey:nil];
+				}
+				filteredIndex++;
+			}
+		}];
 	}
-	else if (filteringBlockType == YapDatabaseViewBlockTypeWithObject)
+	
+	return YES;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Filtering
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Internal method.
+ *
+ * Enumerates the rows within the given group of the parentView (in order),
+ * and reports whether or not each row passes the given filteringBlock.
+ *
+ * Rather than processing a single row at a time, the rows are processed in chunks.
+ * For each chunk, everything required by the filteringBlock that isn't already in the cache
+ * (collection/key, and object/metadata if needed) is fetched from the database using a single query.
+ * If the options allow it, deserialization & filtering of the chunk then happens on a concurrent queue.
+ *
+ * The given block is always invoked serially, on the current thread, in parentView order.
+**/
+- (void)enumerateRowidsInParentGroup:(NSString *)group
+               parentViewTransaction:(YapDatabaseViewTransaction *)parentViewTransaction
+                      filteringBlock:(YapDatabaseViewFilteringBlock)filteringBlock
+                  filteringBlockType:(YapDatabaseViewBlockType)filteringBlockType
+                          usingBlock:(void (^)(int64_t rowid, YapCollectionKey *ck, BOOL passesFilter))block
+{
+	sqlite3 *db = databaseTransaction->connection->db;
+	
+	// Sqlite has an upper bound on the number of host parameters that may be used in a single query.
+	
+	NSUInteger maxHostParams = (NSUInteger)sqlite3_limit(db, SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+	NSUInteger chunkSize = MIN(YAP_DATABASE_FILTERED_VIEW_CHUNK_SIZE, maxHostParams);
+	
+	int64_t *rowids = malloc(sizeof(int64_t) * chunkSize);
+	__block NSUInteger count = 0;
+	
+	[parentViewTransaction enumerateRowidsInGroup:group
+	                                   usingBlock:^(int64_t rowid, NSUInteger parentIndex, BOOL *stop)
 	{
-		__unsafe_unretained YapDatabaseViewFilteringWithObjectBlock filterBlock =
-		  (YapDatabaseViewFilteringWithObjectBlock)filteringBlock_generic;
+		rowids[count] = rowid;
+		count++;
 		
-		InvokeFilterBlock = ^(NSString *group, int64_t rowid, YapCollectionKey *ck){
-			
-			id object = [databaseTransaction objectForCollectionKey:ck withRowid:rowid];
+		if (count == chunkSize)
+		{
+			[self filterRowids:rowids
+			             count:count
+			           inGroup:group
+			    filteringBlock:filteringBlock
+			filteringBlockType:filteringBlockType
+			        usingBlock:block];
 			
-			return filterBlock(group, ck.collection, ck.key, object);
-		};
+			count = 0;
+		}
+	}];
+	
+	if (count > 0)
+	{
+		[self filterRowids:rowids
+		             count:count
+		           inGroup:group
+		    filteringBlock:filteringBlock
+		filteringBlockType:filteringBlockType
+		        usingBlock:block];
 	}
-	else if (filteringBlockType == YapDatabaseViewBlockTypeWithMetadata)
+	
+	free(rowids);
+}
+
+/**
+ * Internal method.
+ *
+ * Processes a single chunk for enumerateRowidsInParentGroup:::::.
+ *
+ * Objects & metadata that are deserialized here are NOT added to the cache.
+ * Repopulating the view touches every row in the parentView,
+ * and we don't want that to evict everything the user has recently been working with.
+**/
+- (void)filterRowids:(const int64_t *)rowids
+               count:(NSUInteger)count
+             inGroup:(NSString *)group
+      filteringBlock:(YapDatabaseViewFilteringBlock)filteringBlock_generic
+  filteringBlockType:(YapDatabaseViewBlockType)filteringBlockType
+          usingBlock:(void (^)(int64_t rowid, YapCollectionKey *ck, BOOL passesFilter))block
+{
+	__unsafe_unretained YapDatabaseConnection *databaseConnection = databaseTransaction->connection;
+	
+	BOOL needsObject = (filteringBlockType == YapDatabaseViewBlockTypeWithObject ||
+	                    filteringBlockType == YapDatabaseViewBlockTypeWithRow);
+	
+	BOOL needsMetadata = (filteringBlockType == YapDatabaseViewBlockTypeWithMetadata ||
+	                      filteringBlockType == YapDatabaseViewBlockTypeWithRow);
+	
+	// Step 1 of 3:
+	//
+	// Check the caches.
+	// The caches aren't thread-safe, so this must be done on the current thread.
+	
+	id null = [NSNull null];
+	
+	NSMutableArray *cks = [NSMutableArray arrayWithCapacity:count];
+	NSMutableArray *objects = needsObject ? [NSMutableArray arrayWithCapacity:count] : nil;
+	NSMutableArray *metadatas = needsMetadata ? [NSMutableArray arrayWithCapacity:count] : nil;
+	
+	NSMutableDictionary *missingIndexes = [NSMutableDictionary dictionaryWithCapacity:count];
+	
+	for (NSUInteger i = 0; i < count; i++)
 	{
-		__unsafe_unretained YapDatabaseViewFilteringWithMetadataBlock filterBlock =
-		  (YapDatabaseViewFilteringWithMetadataBlock)filteringBlock_generic;
+		NSNumber *rowidNumber = @(rowids[i]);
+		BOOL missing = NO;
 		
-		InvokeFilterBlock = ^(NSString *group, int64_t rowid, YapCollectionKey *ck){
-			
-			id metadata = [databaseTransaction metadataForCollectionKey:ck withRowid:rowid];
-			
-			return filterBlock(group, ck.collection, ck.key, metadata);
-		};
+		YapCollectionKey *ck = [databaseConnection->keyCache objectForKey:rowidNumber];
+		if (ck == nil) missing = YES;
+		
+		id object = nil;
+		if (needsObject && ck)
+		{
+			object = [databaseConnection->objectCache objectForKey:ck];
+			if (object == nil) missing = YES;
+		}
+		
+		id metadata = nil;
+		if (needsMetadata && ck)
+		{
+			metadata = [databaseConnection->metadataCache objectForKey:ck];
+			if (metadata == nil) missing = YES;
+		}
+		
+		[cks addObject:(ck ?: null)];
+		[objects addObject:(object ?: null)];
+		[metadatas addObject:(metadata ?: null)];
+		
+		if (missing) {
+			missingIndexes[rowidNumber] = @(i);
+		}
 	}
-	else // if (filteringBlockType == YapDatabaseViewBlockTypeWithRow)
+	
+	// Step 2 of 3:
+	//
+	// Fetch everything that was missing from the cache, using a single query.
+	// Deserialization is deferred until step 3 (where it may be performed concurrently).
+	
+	NSMutableArray *objectDatas = nil;
+	NSMutableArray *metadataDatas = nil;
+	
+	if ([missingIndexes count] > 0)
 	{
-		__unsafe_unretained YapDatabaseViewFilteringWithRowBlock filterBlock =
-		  (YapDatabaseViewFilteringWithRowBlock)filteringBlock_generic;
+		if (needsObject)
+		{
+			objectDatas = [NSMutableArray arrayWithCapacity:count];
+			for (NSUInteger i = 0; i < count; i++) {
+				[objectDatas addObject:null];
+			}
+		}
+		if (needsMetadata)
+		{
+			metadataDatas = [NSMutableArray arrayWithCapacity:count];
+			for (NSUInteger i = 0; i < count; i++) {
+				[metadataDatas addObject:null];
+			}
+		}
 		
-		InvokeFilterBlock = ^(NSString *group, int64_t rowid, YapCollectionKey *ck){
+		[self fetchMissingIndexes:missingIndexes
+		                  withCks:cks
+		              objectDatas:objectDatas
+		            metadataDatas:metadataDatas];
+	}
+	
+	// Step 3 of 3:
+	//
+	// Deserialize (if needed) & invoke the filteringBlock.
+	
+	BOOL *results = calloc(count, sizeof(BOOL));
+	
+	YapDatabaseDeserializer objectDeserializer = databaseConnection->database->objectDeserializer;
+	YapDatabaseDeserializer metadataDeserializer = databaseConnection->database->metadataDeserializer;
+	
+	void (^FilterRow)(size_t i) = ^(size_t i){ @autoreleasepool {
+		
+		YapCollectionKey *ck = cks[i];
+		if ((id)ck == null)
+		{
+			results[i] = NO;
+			return;
+		}
+		
+		id object = nil;
+		if (needsObject)
+		{
+			object = objects[i];
+			if (object == null)
+			{
+				NSData *data = objectDatas ? objectDatas[i] : null;
+				object = (data == null) ? nil : objectDeserializer(ck.collection, ck.key, data);
+			}
+		}
+		
+		id metadata = nil;
+		if (needsMetadata)
+		{
+			metadata = metadatas[i];
+			if (metadata == null)
+			{
+				NSData *data = metadataDatas ? metadataDatas[i] : null;
+				metadata = (data == null) ? nil : metadataDeserializer(ck.collection, ck.key, data);
+			}
+			else if (metadata == [YapNull null])
+			{
+				metadata = nil;
+			}
+		}
+		
+		if (filteringBlockType == YapDatabaseViewBlockTypeWithKey)
+		{
+			__unsafe_unretained YapDatabaseViewFilteringWithKeyBlock filterBlock =
+			  (YapDatabaseViewFilteringWithKeyBlock)filteringBlock_generic;
 			
-			id object = nil;
-			id metadata = nil;
-			[databaseTransaction getObject:&object metadata:&metadata forCollectionKey:ck withRowid:rowid];
+			results[i] = filterBlock(group, ck.collection, ck.key);
+		}
+		else if (filteringBlockType == YapDatabaseViewBlockTypeWithObject)
+		{
+			__unsafe_unretained YapDatabaseViewFilteringWithObjectBlock filterBlock =
+			  (YapDatabaseViewFilteringWithObjectBlock)filteringBlock_generic;
 			
-			return filterBlock(group, ck.collection, ck.key, object, metadata);
-		};
+			results[i] = filterBlock(group, ck.collection, ck.key, object);
+		}
+		else if (filteringBlockType == YapDatabaseViewBlockTypeWithMetadata)
+		{
+			__unsafe_unretained YapDatabaseViewFilteringWithMetadataBlock filterBlock =
+			  (YapDatabaseViewFilteringWithMetadataBlock)filteringBlock_generic;
+			
+			results[i] = filterBlock(group, ck.collection, ck.key, metadata);
+		}
+		else // if (filteringBlockType == YapDatabaseViewBlockTypeWithRow)
+		{
+			__unsafe_unretained YapDatabaseViewFilteringWithRowBlock filterBlock =
+			  (YapDatabaseViewFilteringWithRowBlock)filteringBlock_generic;
+			
+			results[i] = filterBlock(group, ck.collection, ck.key, object, metadata);
+		}
+	}};
+	
+	if (viewConnection->view->options.allowsConcurrentFiltering && (count > 1))
+	{
+		dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), FilterRow);
+	}
+	else
+	{
+		for (size_t i = 0; i < count; i++) {
+			FilterRow(i);
+		}
 	}
 	
-	// Enumerate the existing rows in the database and populate the view
+	// Report the results, in order
 	
-	for (NSString *group in [parentViewTransaction allGroups])
+	for (NSUInteger i = 0; i < count; i++)
 	{
-		__block NSUInteger filteredIndex = 0;
+		YapCollectionKey *ck = cks[i];
+		if ((id)ck == null) ck = nil;
 		
-		[parentViewTransaction enumerateRowidsInGroup:group
-		                                   usingBlock:^(int64_t rowid, NSUInteger parentIndex, BOOL *stop)
+		block(rowids[i], ck, results[i]);
+	}
+	
+	free(results);
+}
+
+/**
+ * Internal method.
+ *
+ * Fetches the collection/key (and raw object/metadata data, if requested) for the rows in missingIndexes,
+ * using a single query. The missingIndexes dictionary maps from rowid to index (within the given arrays).
+**/
+- (void)fetchMissingIndexes:(NSDictionary *)missingIndexes
+                    withCks:(NSMutableArray *)cks
+                objectDatas:(NSMutableArray *)objectDatas
+              metadataDatas:(NSMutableArray *)metadataDatas
+{
+	__unsafe_unretained YapDatabaseConnection *databaseConnection = databaseTransaction->connection;
+	sqlite3 *db = databaseConnection->db;
+	
+	NSUInteger numParams = [missingIndexes count];
+	
+	// SELECT "rowid", "collection", "key" [, "data"] [, "metadata"] FROM "database2" WHERE "rowid" IN (?, ?, ...);
+	
+	NSUInteger capacity = 100 + (numParams * 3);
+	NSMutableString *query = [NSMutableString stringWithCapacity:capacity];
+	
+	[query appendString:@"SELECT \"rowid\", \"collection\", \"key\""];
+	
+	int dataColumnIdx = -1;
+	int metadataColumnIdx = -1;
+	
+	if (objectDatas)
+	{
+		[query appendString:@", \"data\""];
+		dataColumnIdx = 3;
+	}
+	if (metadataDatas)
+	{
+		[query appendString:@", \"metadata\""];
+		metadataColumnIdx = objectDatas ? 4 : 3;
+	}
+	
+	[query appendString:@" FROM \"database2\" WHERE \"rowid\" IN ("];
+	
+	for (NSUInteger i = 0; i < numParams; i++)
+	{
+		if (i == 0)
+			[query appendString:@"?"];
+		else
+			[query appendString:@", ?"];
+	}
+	
+	[query appendString:@");"];
+	
+	sqlite3_stmt *statement;
+	
+	int status = sqlite3_prepare_v2(db, [query UTF8String], -1, &statement, NULL);
+	if (status != SQLITE_OK)
+	{
+		YDBLogError(@"%@: Error creating statement\n"
+		            @" - status(%d): %s\n"
+		            @" - query: %@",
+		            THIS_METHOD, status, sqlite3_errmsg(db), query);
+		return;
+	}
+	
+	__block int bindIdx = 1;
+	[missingIndexes enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+		
+		sqlite3_bind_int64(statement, bindIdx, [(NSNumber *)key longLongValue]);
+		bindIdx++;
+	}];
+	
+	while ((status = sqlite3_step(statement)) == SQLITE_ROW)
+	{
+		if (databaseConnection->needsMarkSqlLevelSharedReadLock)
+			[databaseConnection markSqlLevelSharedReadLockAcquired];
+		
+		int64_t rowid = sqlite3_column_int64(statement, 0);
+		NSUInteger index = [missingIndexes[@(rowid)] unsignedIntegerValue];
+		
+		if (cks[index] == [NSNull null])
 		{
-			YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
+			const unsigned char *text1 = sqlite3_column_text(statement, 1);
+			int textSize1 = sqlite3_column_bytes(statement, 1);
 			
-			if (InvokeFilterBlock(group, rowid, ck))
-			{
-				if (filteredIndex == 0) {
-					[self insertRowid:rowid collectionKey:ck inNewGroup:group];
-				}
-				else {
-					[self insertRowid:rowid collectionKey:ck
-					                              inGroup:group
-					                              atIndex:filteredIndex
-					                  withExistingPageKey:nil];
-				}
-				filteredIndex++;
+			const unsigned char *text2 = sqlite3_column_text(statement, 2);
+			int textSize2 = sqlite3_column_bytes(statement, 2);
+			
+			NSString *collection, *key;
+			
+			collection = [[NSString alloc] initWithBytes:text1 length:textSize1 encoding:NSUTF8StringEncoding];
+			key        = [[NSString alloc] initWithBytes:text2 length:textSize2 encoding:NSUTF8StringEncoding];
+			
+			YapCollectionKey *ck = [[YapCollectionKey alloc] initWithCollection:collection key:key];
+			
+			cks[index] = ck;
+			[databaseConnection->keyCache setObject:ck forKey:@(rowid)];
+		}
+		
+		if (dataColumnIdx >= 0)
+		{
+			const void *blob = sqlite3_column_blob(statement, dataColumnIdx);
+			int blobSize = sqlite3_column_bytes(statement, dataColumnIdx);
+			
+			// The statement is reset before deserialization, so we must copy the bytes here.
+			objectDatas[index] = [NSData dataWithBytes:blob length:blobSize];
+		}
+		
+		if (metadataColumnIdx >= 0)
+		{
+			const void *mBlob = sqlite3_column_blob(statement, metadataColumnIdx);
+			int mBlobSize = sqlite3_column_bytes(statement, metadataColumnIdx);
+			
+			if (mBlobSize > 0) {
+				metadataDatas[index] = [NSData dataWithBytes:mBlob length:mBlobSize];
 			}
-		}];
+		}
 	}
 	
-	return YES;
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@: Error executing statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+	}
+	
+	sqlite3_finalize(statement);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -628,65 +968,12 @@ static NSString *const ExtKey_versionTag     = @"versionTag";
 	// - in the parentView, the items within each group are the same
 	// - in the parentView, the order of items within each group is the same
 	
-	// Setup the block to properly invoke the filterBlock.
-	
 	YapDatabaseViewFilteringBlock filteringBlock_generic;
 	YapDatabaseViewBlockType filteringBlockType;
 	
 	[filteredViewConnection getFilteringBlock:&filteringBlock_generic
 	                       filteringBlockType:&filteringBlockType];
 	
-	BOOL (^InvokeFilterBlock)(NSString *group, int64_t rowid, YapCollectionKey *ck);
-	
-	if (filteringBlockType == YapDatabaseViewBlockTypeWithKey)
-	{
-		__unsafe_unretained YapDatabaseViewFilteringWithKeyBlock filterBlock =
-		  (YapDatabaseViewFilteringWithKeyBlock)filteringBlock_generic;
-		
-		InvokeFilterBlock = ^(NSString *group, int64_t rowid, YapCollectionKey *ck){
-			
-			return filterBlock(group, ck.collection, ck.key);
-		};
-	}
-	else if (filteringBlockType == YapDatabaseViewBlockTypeWithObject)
-	{
-		__unsafe_unretained YapDatabaseViewFilteringWithObjectBlock filterBlock =
-		  (YapDatabaseViewFilteringWithObjectBlock)filteringBlock_generic;
-		
-		InvokeFilterBlock = ^(NSString *group, int64_t rowid, YapCollectionKey *ck){
-			
-			id object = [databaseTransaction objectForCollectionKey:ck withRowid:rowid];
-			
-			return filterBlock(group, ck.collection, ck.key, object);
-		};
-	}
-	else if (filteringBlockType == YapDatabaseViewBlockTypeWithMetadata)
-	{
-		__unsafe_unretained YapDatabaseViewFilteringWithMetadataBlock filterBlock =
-		  (YapDatabaseViewFilteringWithMetadataBlock)filteringBlock_generic;
-		
-		InvokeFilterBlock = ^(NSString *group, int64_t rowid, YapCollectionKey *ck){
-			
-			id metadata = [databaseTransaction metadataForCollectionKey:ck withRowid:rowid];
-			
-			return filterBlock(group, ck.collection, ck.key, metadata);
-		};
-	}
-	else // if (filteringBlockType == YapDatabaseViewBlockTypeWithRow)
-	{
-		__unsafe_unretained YapDatabaseViewFilteringWithRowBlock filterBlock =
-		  (YapDatabaseViewFilteringWithRowBlock)filteringBlock_generic;
-		
-		InvokeFilterBlock = ^(NSString *group, int64_t rowid, YapCollectionKey *ck){
-			
-			id object = nil;
-			id metadata = nil;
-			[databaseTransaction getObject:&object metadata:&metadata forCollectionKey:ck withRowid:rowid];
-			
-			return filterBlock(group, ck.collection, ck.key, object, metadata);
-		};
-	}
-	
 	// Start the algorithm.
 	
 	for (NSString *group in [parentViewTransaction allGroups])
@@ -698,12 +985,13 @@ static NSString *const ExtKey_versionTag     = @"versionTag";
 		
 		__block NSUInteger index = 0;
 		
-		[parentViewTransaction enumerateRowidsInGroup:group
-		                                   usingBlock:^(int64_t rowid, NSUInteger parentIndex, BOOL *stop)
+		[self enumerateRowidsInParentGroup:group
+		             parentViewTransaction:parentViewTransaction
+		                    filteringBlock:filteringBlock_generic
+		                filteringBlockType:filteringBlockType
+		                        usingBlock:^(int64_t rowid, YapCollectionKey *ck, BOOL passesFilter)
 		{
-			YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
-			
-			if (InvokeFilterBlock(group, rowid, ck))
+			if (passesFilter)
 			{
 				if (existing && (existingRowid == rowid))
 				{
@@ -35,15 +35,19 @@
 	
 	YapDatabaseFullTextSearchBlock block;
 	YapDatabaseFullTextSearchBlockType blockType;
+	BOOL concurrentTextExtraction;
 	
 	NSOrderedSet *columnNames;
 	NSDictionary *options;
 	NSString *versionTag;
+	NSString *ftsVersion;
+	BOOL contentless;
 	
 	id columnNamesSharedKeySet;
 }
 
 - (NSString *)tableName;
+- (BOOL)isFTS5;
 
 @end
 
@@ -58,6 +62,8 @@
 	__unsafe_unretained YapDatabaseConnection *databaseConnection;
 	
 	NSMutableDictionary *blockDict;
+	
+	BOOL didWarnRankingRequiresFTS5; // Only warn once per connection (ranked queries without fts5)
 }
 
 - (id)initWithFTS:(YapDatabaseFullTextSearch *)fts
@@ -71,6 +77,15 @@
 - (sqlite3_stmt *)querySnippetStatement;
 - (sqlite3_stmt *)rowidQueryStatement;
 - (sqlite3_stmt *)rowidQuerySnippetStatement;
+- (sqlite3_stmt *)rankedQueryStatement;
+
+- (int)batchInsertRowCount;
+- (sqlite3_stmt *)batchInsertStatement;
+
+- (BOOL)createSnippetTableIfNeeded;
+- (sqlite3_stmt *)snippetTableInsertStatement;
+- (sqlite3_stmt *)snippetTableRemoveAllStatement;
+- (sqlite3_stmt *)snippetTableQueryStatement;
 
 @end
 
@@ -98,6 +113,11 @@
                      usingBlock:
             (void (^)(NSString *snippet, int64_t rowid, BOOL *stop))block;
 
+- (void)enumerateRowidsMatching:(NSString *)query
+             withRankingWeights:(NSDictionary *)weights
+                          limit:(NSUInteger)limit
+                     usingBlock:(void (^)(int64_t rowid, BOOL *stop))block;
+
 - (BOOL)rowid:(int64_t)rowid matches:(NSString *)query;
 - (NSString *)rowid:(int64_t)rowid matches:(NSString *)query
                         withSnippetOptions:(YapDatabaseFullTextSearchSnippetOptions *)options;
@@ -16,6 +16,22 @@
  * YapDatabaseFullTextSearch is an extension for performing text based search.
  * Internally it uses sqlite's FTS module which was contributed by Google.
 **/
+
+/**
+ * The sqlite FTS module used to create the virtual table.
+ *
+ * YapDatabaseFullTextSearchFTS4Version is the default, and matches all previous versions of this extension.
+ *
+ * YapDatabaseFullTextSearchFTS5Version adds relevance ranking via the bm25() function.
+ * (See the ranked query methods in YapDatabaseFullTextSearchTransaction.)
+ * It requires a version of sqlite that was compiled with FTS5 (e.g. SQLITE_ENABLE_FTS5).
+ *
+ * If an existing FTS table was created with a different module, the extension automatically
+ * drops the table, re-creates it with the new module, and re-populates it.
+**/
+extern NSString *const YapDatabaseFullTextSearchFTS4Version;
+extern NSString *const YapDatabaseFullTextSearchFTS5Version;
+
 @interface YapDatabaseFullTextSearch : YapDatabaseExtension
 
 - (id)initWithColumnNames:(NSArray *)columnNames
@@ -30,6 +46,31 @@
                   handler:(YapDatabaseFullTextSearchHandler *)handler
                versionTag:(NSString *)versionTag;
 
+/**
+ * The options dictionary is passed to the CREATE VIRTUAL TABLE statement as a list of "key=value" arguments.
+ * See the sqlite documentation for the options supported by the chosen ftsVersion.
+ *
+ * The "prefix" option may be given as a list of prefix lengths, e.g. @{ @"prefix": @"2 3" },
+ * and is converted into the syntax expected by the FTS module (prefix="2,3" for fts4, prefix='2 3' for fts5).
+ * Prefix indexes speed up prefix queries (e.g. "hel*") at the cost of a larger index.
+ *
+ * The "content" option may be set to an empty string, e.g. @{ @"content": @"" }, to create a contentless table.
+ * A contentless table stores only the index (the tokens), and not a second copy of the indexed text,
+ * which significantly reduces the size of the database and the number of bytes written per insert.
+ * Snippets are still supported, but are generated on demand by re-running the handler's block
+ * for each matching row, and thus are more expensive.
+ * Contentless tables require YapDatabaseFullTextSearchFTS5Version, and sqlite 3.43 or later.
+ *
+ * @param ftsVersion
+ *   Either YapDatabaseFullTextSearchFTS4Version or YapDatabaseFullTextSearchFTS5Version.
+ *   If nil, defaults to YapDatabaseFullTextSearchFTS4Version.
+**/
+- (id)initWithColumnNames:(NSArray *)columnNames
+                  options:(NSDictionary *)options
+                  handler:(YapDatabaseFullTextSearchHandler *)handler
+               ftsVersion:(NSString *)ftsVersion
+               versionTag:(NSString *)versionTag;
+
 
 - (id)initWithColumnNames:(NSArray *)columnNames
                     block:(YapDatabaseFullTextSearchBlock)block
@@ -68,4 +109,10 @@ __attribute((deprecated("Use method initWithColumnNames:options:handler:versionT
 **/
 @property (nonatomic, copy, readonly) NSString *versionTag;
 
+/**
+ * The sqlite FTS module used by the extension.
+ * Either YapDatabaseFullTextSearchFTS4Version (the default) or YapDatabaseFullTextSearchFTS5Version.
+**/
+@property (nonatomic, copy, readonly) NSString *ftsVersion;
+
 @end
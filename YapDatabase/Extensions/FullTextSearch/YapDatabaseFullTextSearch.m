@@ -20,6 +20,10 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 #endif
 
+NSString *const YapDatabaseFullTextSearchFTS4Version = @"fts4";
+NSString *const YapDatabaseFullTextSearchFTS5Version = @"fts5";
+
+
 @implementation YapDatabaseFullTextSearch
 
 + (void)dropTablesForRegisteredName:(NSString *)registeredName
@@ -58,6 +62,7 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 @synthesize block = block;
 @synthesize blockType = blockType;
 @synthesize versionTag = versionTag;
+@synthesize ftsVersion = ftsVersion;
 
 - (id)initWithColumnNames:(NSArray *)inColumnNames
                   handler:(YapDatabaseFullTextSearchHandler *)inHandler
@@ -79,6 +84,19 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
                   options:(NSDictionary *)inOptions
                   handler:(YapDatabaseFullTextSearchHandler *)inHandler
                versionTag:(NSString *)inVersionTag
+{
+	return [self initWithColumnNames:inColumnNames
+	                         options:inOptions
+	                         handler:inHandler
+	                      ftsVersion:nil
+	                      versionTag:inVersionTag];
+}
+
+- (id)initWithColumnNames:(NSArray *)inColumnNames
+                  options:(NSDictionary *)inOptions
+                  handler:(YapDatabaseFullTextSearchHandler *)inHandler
+               ftsVersion:(NSString *)inFTSVersion
+               versionTag:(NSString *)inVersionTag
 {
 	if ([inColumnNames count] == 0)
 	{
@@ -104,6 +122,14 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 	
 	NSAssert(inHandler != NULL, @"Null handler");
 	
+	if (inFTSVersion &&
+	    ![inFTSVersion isEqualToString:YapDatabaseFullTextSearchFTS4Version] &&
+	    ![inFTSVersion isEqualToString:YapDatabaseFullTextSearchFTS5Version])
+	{
+		NSAssert(NO, @"Invalid ftsVersion: %@", inFTSVersion);
+		return nil;
+	}
+	
 	if ((self = [super init]))
 	{
 		columnNames = [NSOrderedSet orderedSetWithArray:inColumnNames];
@@ -111,10 +137,27 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 		
 		options = [inOptions copy];
 		
+		id content = [options objectForKey:@"content"];
+		if ([content isKindOfClass:[NSString class]])
+		{
+			NSCharacterSet *quotes = [NSCharacterSet characterSetWithCharactersInString:@"'\""];
+			contentless = ([[(NSString *)content stringByTrimmingCharactersInSet:quotes] length] == 0);
+		}
+		
 		block = inHandler.block;
 		blockType = inHandler.blockType;
+		concurrentTextExtraction = inHandler.concurrentTextExtraction;
 		
 		versionTag = inVersionTag ? [inVersionTag copy] : @"";
+		ftsVersion = inFTSVersion ? [inFTSVersion copy] : YapDatabaseFullTextSearchFTS4Version;
+		
+		if (contentless && ![self isFTS5])
+		{
+			// The fts4 module doesn't support updating or deleting rows in a contentless table.
+			
+			NSAssert(NO, @"Contentless tables require YapDatabaseFullTextSearchFTS5Version");
+			return nil;
+		}
 	}
 	return self;
 }
@@ -170,6 +213,14 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 **/
 - (BOOL)supportsDatabase:(YapDatabase *)database withRegisteredExtensions:(NSDictionary *)registeredExtensions
 {
+	if (contentless && (sqlite3_libversion_number() < 3043000))
+	{
+		// Deleting rows from a contentless fts5 table requires the contentless_delete option (sqlite 3.43).
+		
+		YDBLogWarn(@"Contentless FTS tables require sqlite 3.43 or later (found %s)", sqlite3_libversion());
+		return NO;
+	}
+	
 	return YES;
 }
 
@@ -183,4 +234,9 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 	return [[self class] tableNameForRegisteredName:self.registeredName];
 }
 
+- (BOOL)isFTS5
+{
+	return [ftsVersion isEqualToString:YapDatabaseFullTextSearchFTS5Version];
+}
+
 @end
@@ -33,6 +33,12 @@
 	sqlite3_stmt *querySnippetStatement;
 	sqlite3_stmt *rowidQueryStatement;
 	sqlite3_stmt *rowidQuerySnippetStatement;
+	sqlite3_stmt *rankedQueryStatement;
+	sqlite3_stmt *batchInsertStatement;
+	
+	sqlite3_stmt *snippetTableInsertStatement;
+	sqlite3_stmt *snippetTableRemoveAllStatement;
+	sqlite3_stmt *snippetTableQueryStatement;
 }
 
 @synthesize fullTextSearch = fts;
@@ -63,6 +69,11 @@
 	sqlite_finalize_null(&querySnippetStatement);
 	sqlite_finalize_null(&rowidQueryStatement);
 	sqlite_finalize_null(&rowidQuerySnippetStatement);
+	sqlite_finalize_null(&rankedQueryStatement);
+	sqlite_finalize_null(&batchInsertStatement);
+	sqlite_finalize_null(&snippetTableInsertStatement);
+	sqlite_finalize_null(&snippetTableRemoveAllStatement);
+	sqlite_finalize_null(&snippetTableQueryStatement);
 }
 
 /**
@@ -290,8 +301,22 @@
 	{
 		NSString *tableName = [fts tableName];
 		
-		NSString *string = [NSString stringWithFormat:
-		    @"SELECT \"rowid\", snippet(\"%1$@\", ?, ?, ?, ?, ?) FROM \"%1$@\" WHERE \"%1$@\" MATCH ?;", tableName];
+		NSString *string;
+		if ([fts isFTS5])
+		{
+			// The fts5 snippet function takes the column index first, and requires a positive number of tokens.
+			// Numbered parameters keep the bind indexes the same as the fts4 statement.
+			
+			string = [NSString stringWithFormat:
+			  @"SELECT \"rowid\", snippet(\"%1$@\", ?4, ?1, ?2, ?3, abs(?5)) FROM \"%1$@\" WHERE \"%1$@\" MATCH ?6;",
+			  tableName];
+		}
+		else
+		{
+			string = [NSString stringWithFormat:
+			  @"SELECT \"rowid\", snippet(\"%1$@\", ?, ?, ?, ?, ?) FROM \"%1$@\" WHERE \"%1$@\" MATCH ?;",
+			  tableName];
+		}
 		
 		sqlite3 *db = databaseConnection->db;
 		
@@ -334,8 +359,267 @@
 	{
 		NSString *tableName = [fts tableName];
 		
+		NSString *string;
+		if ([fts isFTS5])
+		{
+			string = [NSString stringWithFormat:
+			  @"SELECT \"rowid\", snippet(\"%1$@\", ?4, ?1, ?2, ?3, abs(?5)) FROM \"%1$@\""
+			  @" WHERE \"rowid\" = ?6 AND \"%1$@\" MATCH ?7;",
+			  tableName];
+		}
+		else
+		{
+			string = [NSString stringWithFormat:
+			  @"SELECT \"rowid\", snippet(\"%1$@\", ?, ?, ?, ?, ?) FROM \"%1$@\" WHERE \"rowid\" = ? AND \"%1$@\" MATCH ?;",
+			  tableName];
+		}
+		
+		sqlite3 *db = databaseConnection->db;
+		
+		int status = sqlite3_prepare_v2(db, [string UTF8String], -1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+	}
+	
+	return *statement;
+}
+
+- (sqlite3_stmt *)rankedQueryStatement
+{
+	sqlite3_stmt **statement = &rankedQueryStatement;
+	if (*statement == NULL)
+	{
+		NSString *tableName = [fts tableName];
+		NSUInteger count = [fts->columnNames count];
+		
+		// fts5 : SELECT "rowid" FROM "tableName" WHERE "tableName" MATCH ?1
+		//          ORDER BY bm25("tableName", ?2, ?3, ...) LIMIT ?N;
+		//
+		// fts4 : SELECT "rowid" FROM "tableName" WHERE "tableName" MATCH ?1 LIMIT ?N;
+		//
+		// The column weights are bound as parameters, so a single statement serves every set of weights.
+		// The LIMIT allows sqlite to keep only the top-k rows while sorting, rather than sorting every match.
+		
+		NSMutableString *string = [NSMutableString stringWithCapacity:100];
+		[string appendFormat:@"SELECT \"rowid\" FROM \"%1$@\" WHERE \"%1$@\" MATCH ?1", tableName];
+		
+		if ([fts isFTS5])
+		{
+			[string appendFormat:@" ORDER BY bm25(\"%@\"", tableName];
+			
+			NSUInteger i;
+			for (i = 0; i < count; i++)
+			{
+				[string appendFormat:@", ?%lu", (unsigned long)(i + 2)];
+			}
+			
+			[string appendString:@")"];
+		}
+		
+		[string appendFormat:@" LIMIT ?%lu;", (unsigned long)(count + 2)];
+		
+		sqlite3 *db = databaseConnection->db;
+		
+		int status = sqlite3_prepare_v2(db, [string UTF8String], -1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+	}
+	
+	return *statement;
+}
+
+/**
+ * The number of rows written by a single execution of the batchInsertStatement.
+ * Sized to stay within sqlite's (default) limit of 999 host parameters per statement.
+**/
+- (int)batchInsertRowCount
+{
+	int paramsPerRow = (int)[fts->columnNames count] + 1;
+	
+	return MAX(1, MIN(50, (999 / paramsPerRow)));
+}
+
+- (sqlite3_stmt *)batchInsertStatement
+{
+	sqlite3_stmt **statement = &batchInsertStatement;
+	if (*statement == NULL)
+	{
+		NSMutableString *string = [NSMutableString stringWithCapacity:1000];
+		[string appendFormat:@"INSERT INTO \"%@\" (\"rowid\"", [fts tableName]];
+		
+		for (NSString *columnName in fts->columnNames)
+		{
+			[string appendFormat:@", \"%@\"", columnName];
+		}
+		
+		[string appendString:@") VALUES "];
+		
+		NSUInteger count = [fts->columnNames count];
+		int rowCount = [self batchInsertRowCount];
+		
+		for (int row = 0; row < rowCount; row++)
+		{
+			if (row == 0)
+				[string appendString:@"(?"];
+			else
+				[string appendString:@", (?"];
+			
+			NSUInteger i;
+			for (i = 0; i < count; i++)
+			{
+				[string appendString:@", ?"];
+			}
+			
+			[string appendString:@")"];
+		}
+		
+		[string appendString:@";"];
+		
+		sqlite3 *db = databaseConnection->db;
+		
+		int status = sqlite3_prepare_v2(db, [string UTF8String], -1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+	}
+	
+	return *statement;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Snippet Table
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A contentless FTS table doesn't store the indexed text, so the snippet function has nothing to work with.
+ * Instead, we re-create the text for a single matching row (by re-running the block),
+ * insert it into a temporary FTS table (private to this connection), and run the snippet function there.
+ * This way the snippets are identical to those produced by a regular table (same tokenizer, same query syntax).
+**/
+- (NSString *)snippetTableName
+{
+	return [NSString stringWithFormat:@"%@_snippet", [fts tableName]];
+}
+
+/**
+ * Note: This method is invoked (once) before every enumeration that needs on-demand snippets.
+ * We don't remember whether the table was created, because the creation of a temp table is undone
+ * if the encompassing transaction is rolled back.
+**/
+- (BOOL)createSnippetTableIfNeeded
+{
+	// CREATE VIRTUAL TABLE IF NOT EXISTS temp."tableName_snippet" USING fts5("column1", "column2", ...);
+	
+	NSMutableString *string = [NSMutableString stringWithCapacity:100];
+	[string appendFormat:@"CREATE VIRTUAL TABLE IF NOT EXISTS temp.\"%@\" USING %@(",
+	                       [self snippetTableName], fts->ftsVersion];
+	
+	NSUInteger i = 0;
+	for (NSString *columnName in fts->columnNames)
+	{
+		if (i == 0)
+			[string appendFormat:@"\"%@\"", columnName];
+		else
+			[string appendFormat:@", \"%@\"", columnName];
+		
+		i++;
+	}
+	
+	// Only the tokenizer affects the snippets.
+	// Everything else (content, prefix indexes, etc) only affects how the persistent index is stored.
+	
+	id tokenize = [fts->options objectForKey:@"tokenize"];
+	if (tokenize)
+	{
+		[string appendFormat:@", tokenize=%@", tokenize];
+	}
+	
+	[string appendString:@");"];
+	
+	sqlite3 *db = databaseConnection->db;
+	
+	int status = sqlite3_exec(db, [string UTF8String], NULL, NULL, NULL);
+	if (status != SQLITE_OK)
+	{
+		YDBLogError(@"%@ - Failed creating snippet table (%@): %d %s",
+		            THIS_METHOD, [self snippetTableName], status, sqlite3_errmsg(db));
+		return NO;
+	}
+	
+	return YES;
+}
+
+- (sqlite3_stmt *)snippetTableInsertStatement
+{
+	sqlite3_stmt **statement = &snippetTableInsertStatement;
+	if (*statement == NULL)
+	{
+		NSMutableString *string = [NSMutableString stringWithCapacity:100];
+		[string appendFormat:@"INSERT INTO temp.\"%@\" (\"rowid\"", [self snippetTableName]];
+		
+		for (NSString *columnName in fts->columnNames)
+		{
+			[string appendFormat:@", \"%@\"", columnName];
+		}
+		
+		[string appendString:@") VALUES (?"];
+		
+		NSUInteger count = [fts->columnNames count];
+		NSUInteger i;
+		for (i = 0; i < count; i++)
+		{
+			[string appendString:@", ?"];
+		}
+		
+		[string appendString:@");"];
+		
+		sqlite3 *db = databaseConnection->db;
+		
+		int status = sqlite3_prepare_v2(db, [string UTF8String], -1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+	}
+	
+	return *statement;
+}
+
+- (sqlite3_stmt *)snippetTableRemoveAllStatement
+{
+	sqlite3_stmt **statement = &snippetTableRemoveAllStatement;
+	if (*statement == NULL)
+	{
+		NSString *string = [NSString stringWithFormat:@"DELETE FROM temp.\"%@\";", [self snippetTableName]];
+		
+		sqlite3 *db = databaseConnection->db;
+		
+		int status = sqlite3_prepare_v2(db, [string UTF8String], -1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+	}
+	
+	return *statement;
+}
+
+- (sqlite3_stmt *)snippetTableQueryStatement
+{
+	sqlite3_stmt **statement = &snippetTableQueryStatement;
+	if (*statement == NULL)
+	{
+		NSString *tableName = [self snippetTableName];
+		
+		// Same bind indexes as the querySnippetStatement (fts5 flavor).
+		
 		NSString *string = [NSString stringWithFormat:
-		  @"SELECT \"rowid\", snippet(\"%1$@\", ?, ?, ?, ?, ?) FROM \"%1$@\" WHERE \"rowid\" = ? AND \"%1$@\" MATCH ?;",
+		  @"SELECT \"rowid\", snippet(\"%1$@\", ?4, ?1, ?2, ?3, abs(?5)) FROM temp.\"%1$@\" WHERE \"%1$@\" MATCH ?6;",
 		  tableName];
 		
 		sqlite3 *db = databaseConnection->db;
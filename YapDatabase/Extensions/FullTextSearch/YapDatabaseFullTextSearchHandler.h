@@ -46,4 +46,18 @@ typedef void (^YapDatabaseFullTextSearchWithRowBlock)      \
 @property (nonatomic, strong, readonly) YapDatabaseFullTextSearchBlock block;
 @property (nonatomic, assign, readonly) YapDatabaseFullTextSearchBlockType blockType;
 
+/**
+ * When the FTS table is built from scratch (e.g. when the extension is first registered, or the versionTag changes),
+ * the existing rows are processed in chunks. This option allows the block to be invoked concurrently
+ * for the rows within a chunk (on a concurrent queue), which can significantly speed up the initial build.
+ *
+ * Only enable this option if your block is thread-safe.
+ * Regular inserts & updates always invoke the block on the transaction's thread.
+ *
+ * This option must be set before the extension is created (initWithColumnNames:...).
+ *
+ * The default value is NO.
+**/
+@property (nonatomic, assign, readwrite) BOOL concurrentTextExtraction;
+
 @end
@@ -5,6 +5,7 @@
 
 @synthesize block = block;
 @synthesize blockType = blockType;
+@synthesize concurrentTextExtraction = concurrentTextExtraction;
 
 + (instancetype)withKeyBlock:(YapDatabaseFullTextSearchWithKeyBlock)block
 {
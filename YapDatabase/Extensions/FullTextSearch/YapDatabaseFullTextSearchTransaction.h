@@ -43,6 +43,41 @@
 - (void)enumerateRowsMatching:(NSString *)query
                    usingBlock:(void (^)(NSString *collection, NSString *key, id object, id metadata, BOOL *stop))block;
 
+// Ranked query matching
+//
+// Matches are enumerated in order of relevance (most relevant first), as computed by the FTS5 bm25() function.
+//
+// The weights dictionary maps column names to a weight (NSNumber) for matches within that column.
+// For example, @{ @"title": @(10.0) } makes a match in the title ten times as important as a match elsewhere.
+// Columns missing from the dictionary (or a nil dictionary) have a weight of 1.0.
+//
+// If limit is non-zero, only the top 'limit' matches are enumerated.
+// This is much faster than stopping the enumeration manually,
+// as sqlite only needs to keep the top matches while sorting, rather than sorting every match.
+//
+// Ranking requires the extension to use YapDatabaseFullTextSearchFTS5Version.
+// With fts4, the weights are ignored and matches are enumerated in rowid order (limit is still honored).
+
+- (void)enumerateKeysMatching:(NSString *)query
+           withRankingWeights:(NSDictionary *)weights
+                        limit:(NSUInteger)limit
+                   usingBlock:(void (^)(NSString *collection, NSString *key, BOOL *stop))block;
+
+- (void)enumerateKeysAndMetadataMatching:(NSString *)query
+                      withRankingWeights:(NSDictionary *)weights
+                                   limit:(NSUInteger)limit
+                              usingBlock:(void (^)(NSString *collection, NSString *key, id metadata, BOOL *stop))block;
+
+- (void)enumerateKeysAndObjectsMatching:(NSString *)query
+                     withRankingWeights:(NSDictionary *)weights
+                                  limit:(NSUInteger)limit
+                             usingBlock:(void (^)(NSString *collection, NSString *key, id object, BOOL *stop))block;
+
+- (void)enumerateRowsMatching:(NSString *)query
+           withRankingWeights:(NSDictionary *)weights
+                        limit:(NSUInteger)limit
+                   usingBlock:(void (^)(NSString *collection, NSString *key, id object, id metadata, BOOL *stop))block;
+
 // Query matching + Snippets
 
 - (void)enumerateKeysMatching:(NSString *)query
@@ -21,8 +21,37 @@
 
 static NSString *const ExtKey_classVersion       = @"classVersion";
 static NSString *const ExtKey_versionTag         = @"versionTag";
+static NSString *const ExtKey_ftsVersion         = @"ftsVersion";
+static NSString *const ExtKey_contentless        = @"contentless";
 static NSString *const ExtKey_version_deprecated = @"version";
 
+/**
+ * The number of rows processed at a time while populating the FTS table.
+**/
+static NSUInteger const YDBFullTextSearchPopulateChunkSize = 1000;
+
+/**
+ * Represents a single row while populating the FTS table.
+**/
+@interface YDBFullTextSearchPopulateRow : NSObject {
+@public
+	
+	int64_t rowid;
+	NSString *collection;
+	NSString *key;
+	id object;
+	id metadata;
+	
+	NSMutableDictionary *values;
+}
+@end
+
+@implementation YDBFullTextSearchPopulateRow
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 @implementation YapDatabaseFullTextSearchTransaction
 
@@ -68,11 +97,55 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		
 		NSString *versionTag = ftsConnection->fts->versionTag;
 		[self setStringValue:versionTag forExtensionKey:ExtKey_versionTag persistent:YES];
+		
+		NSString *ftsVersion = ftsConnection->fts->ftsVersion;
+		[self setStringValue:ftsVersion forExtensionKey:ExtKey_ftsVersion persistent:YES];
+		
+		BOOL contentless = ftsConnection->fts->contentless;
+		[self setIntValue:(contentless ? 1 : 0) forExtensionKey:ExtKey_contentless persistent:YES];
 	}
 	else
 	{
 		// Check user-supplied config version.
 		// We may need to re-populate the database if the groupingBlock or sortingBlock changed.
+		//
+		// We also need to re-create the table if the FTS module changed (e.g. migrating from fts4 to fts5),
+		// or if the table switched to/from storing its content.
+		// Tables created before these values were stored are always fts4 (with content).
+		
+		NSString *ftsVersion = ftsConnection->fts->ftsVersion;
+		NSString *oldFTSVersion = [self stringValueForExtensionKey:ExtKey_ftsVersion persistent:YES];
+		
+		if (oldFTSVersion == nil)
+			oldFTSVersion = YapDatabaseFullTextSearchFTS4Version;
+		
+		BOOL contentless = ftsConnection->fts->contentless;
+		int oldContentless = 0;
+		[self getIntValue:&oldContentless forExtensionKey:ExtKey_contentless persistent:YES];
+		
+		if (![oldFTSVersion isEqualToString:ftsVersion] || ((oldContentless != 0) != contentless))
+		{
+			YDBLogVerbose(@"Migrating FTS table for registeredName(%@) from %@%@ to %@%@",
+			              [self registeredName],
+			              oldFTSVersion, (oldContentless ? @" (contentless)" : @""),
+			              ftsVersion,    (contentless    ? @" (contentless)" : @""));
+			
+			if (![self dropTable]) return NO;
+			if (![self createTable]) return NO;
+			if (![self populate]) return NO;
+			
+			[self setStringValue:ftsVersion forExtensionKey:ExtKey_ftsVersion persistent:YES];
+			[self setIntValue:(contentless ? 1 : 0) forExtensionKey:ExtKey_contentless persistent:YES];
+			
+			// The table was rebuilt using the current configuration,
+			// so there's no need to check the versionTag as well.
+			
+			NSString *versionTag = ftsConnection->fts->versionTag;
+			[self setStringValue:versionTag forExtensionKey:ExtKey_versionTag persistent:YES];
+			
+			[self removeValueForExtensionKey:ExtKey_version_deprecated persistent:YES];
+			return YES;
+		}
 		
 		NSString *versionTag = ftsConnection->fts->versionTag;
 		
@@ -166,9 +239,17 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	YDBLogVerbose(@"Creating FTS table for registeredName(%@): %@", [self registeredName], tableName);
 	
 	// CREATE VIRTUAL TABLE pages USING fts4(column1, column2, column3);
+	// CREATE VIRTUAL TABLE pages USING fts5(column1, column2, column3);
+	//
+	// Contentless:
+	// CREATE VIRTUAL TABLE pages USING fts5(column1, column2, column3, content='', contentless_delete=1);
+	
+	BOOL isFTS5 = [ftsConnection->fts isFTS5];
+	BOOL contentless = ftsConnection->fts->contentless;
 	
 	NSMutableString *createTable = [NSMutableString stringWithCapacity:100];
-	[createTable appendFormat:@"CREATE VIRTUAL TABLE IF NOT EXISTS \"%@\" USING fts4(", tableName];
+	[createTable appendFormat:@"CREATE VIRTUAL TABLE IF NOT EXISTS \"%@\" USING %@(",
+	                            tableName, ftsConnection->fts->ftsVersion];
 	
 	__block NSUInteger i = 0;
 	
@@ -189,6 +270,15 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		NSString *option = (NSString *)key;
 		NSString *value = (NSString *)obj;
 		
+		if ([option isEqualToString:@"prefix"])
+		{
+			value = [self prefixOptionValue:value isFTS5:isFTS5];
+		}
+		else if ([option isEqualToString:@"content"] && contentless)
+		{
+			value = @"''";
+		}
+		
 		if (i == 0)
 			[createTable appendFormat:@"%@=%@", option, value];
 		else
@@ -197,6 +287,12 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		i++;
 	}];
 	
+	if (contentless)
+	{
+		// Without this option, rows cannot be deleted from (or replaced in) a contentless fts5 table.
+		[createTable appendString:@", contentless_delete=1"];
+	}
+	
 	[createTable appendString:@");"];
 	
 	int status = sqlite3_exec(db, [createTable UTF8String], NULL, NULL, NULL);
@@ -210,11 +306,42 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	return YES;
 }
 
+/**
+ * Internal method.
+ *
+ * The prefix option is a list of prefix lengths (e.g. @"2 3"), for which the FTS module maintains extra indexes.
+ * The fts4 module expects a comma separated list in double quotes (prefix="2,3"),
+ * while the fts5 module expects a space separated list in single quotes (prefix='2 3').
+ * So we accept either form, and convert it to whatever the table's module expects.
+**/
+- (NSString *)prefixOptionValue:(id)value isFTS5:(BOOL)isFTS5
+{
+	NSString *string = [value isKindOfClass:[NSString class]] ? (NSString *)value : [value description];
+	
+	NSCharacterSet *separators = [NSCharacterSet characterSetWithCharactersInString:@" ,'\""];
+	
+	NSMutableArray *lengths = [NSMutableArray arrayWithCapacity:2];
+	for (NSString *component in [string componentsSeparatedByCharactersInSet:separators])
+	{
+		if ([component length] > 0)
+			[lengths addObject:component];
+	}
+	
+	if (isFTS5)
+		return [NSString stringWithFormat:@"'%@'", [lengths componentsJoinedByString:@" "]];
+	else
+		return [NSString stringWithFormat:@"\"%@\"", [lengths componentsJoinedByString:@","]];
+}
+
 /**
  * Internal method.
  *
  * This method is called, if needed, to populate the FTS indexes.
  * It does so by enumerating the rows in the database, and invoking the usual blocks and insertion methods.
+ *
+ * Since the table starts out empty, the rows are processed in chunks:
+ * the text is extracted for every row in the chunk (concurrently if the handler allows it),
+ * and then the chunk is written to the table using multi-row inserts.
 **/
 - (BOOL)populate
 {
@@ -222,6 +349,8 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	
 	[self removeAllRowids];
 	
+	NSDictionary *mergeSettings = [self beginBulkInsert];
+	
 	// Enumerate the existing rows in the database and populate the indexes
 	
 	__unsafe_unretained YapDatabaseFullTextSearch *fts = ftsConnection->fts;
@@ -232,76 +361,317 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	BOOL needsMetadata = fts->blockType == YapDatabaseFullTextSearchBlockTypeWithMetadata ||
 	                     fts->blockType == YapDatabaseFullTextSearchBlockTypeWithRow;
 	
-	if (needsObject && needsMetadata)
+	NSMutableArray *chunk = [NSMutableArray arrayWithCapacity:YDBFullTextSearchPopulateChunkSize];
+	
+	void (^addToChunk)(int64_t, NSString *, NSString *, id, id) =
+	    ^(int64_t rowid, NSString *collection, NSString *key, id object, id metadata)
 	{
-		__unsafe_unretained YapDatabaseFullTextSearchWithRowBlock block =
-		    (YapDatabaseFullTextSearchWithRowBlock)fts->block;
+		YDBFullTextSearchPopulateRow *row = [[YDBFullTextSearchPopulateRow alloc] init];
+		row->rowid = rowid;
+		row->collection = collection;
+		row->key = key;
+		row->object = object;
+		row->metadata = metadata;
+		
+		[chunk addObject:row];
 		
+		if ([chunk count] >= YDBFullTextSearchPopulateChunkSize)
+		{
+			[self populateChunk:chunk];
+			[chunk removeAllObjects];
+		}
+	};
+	
+	if (needsObject && needsMetadata)
+	{
 		[databaseTransaction _enumerateRowsInAllCollectionsUsingBlock:
 		    ^(int64_t rowid, NSString *collection, NSString *key, id object, id metadata, BOOL *stop) {
 			
-			block(ftsConnection->blockDict, collection, key, object, metadata);
-			
-			if ([ftsConnection->blockDict count] > 0)
-			{
-				[self addRowid:rowid isNew:YES];
-				[ftsConnection->blockDict removeAllObjects];
-			}
+			addToChunk(rowid, collection, key, object, metadata);
 		}];
 	}
 	else if (needsObject && !needsMetadata)
 	{
-		__unsafe_unretained YapDatabaseFullTextSearchWithObjectBlock block =
-		    (YapDatabaseFullTextSearchWithObjectBlock)fts->block;
-		
 		[databaseTransaction _enumerateKeysAndObjectsInAllCollectionsUsingBlock:
 		    ^(int64_t rowid, NSString *collection, NSString *key, id object, BOOL *stop) {
 			
-			block(ftsConnection->blockDict, collection, key, object);
-			
-			if ([ftsConnection->blockDict count] > 0)
-			{
-				[self addRowid:rowid isNew:YES];
-				[ftsConnection->blockDict removeAllObjects];
-			}
+			addToChunk(rowid, collection, key, object, nil);
 		}];
 	}
 	else if (!needsObject && needsMetadata)
 	{
-		__unsafe_unretained YapDatabaseFullTextSearchWithMetadataBlock block =
-		    (YapDatabaseFullTextSearchWithMetadataBlock)fts->block;
-		
 		[databaseTransaction _enumerateKeysAndMetadataInAllCollectionsUsingBlock:
 		    ^(int64_t rowid, NSString *collection, NSString *key, id metadata, BOOL *stop) {
 			
-			block(ftsConnection->blockDict, collection, key, metadata);
-			
-			if ([ftsConnection->blockDict count] > 0)
-			{
-				[self addRowid:rowid isNew:YES];
-				[ftsConnection->blockDict removeAllObjects];
-			}
+			addToChunk(rowid, collection, key, nil, metadata);
 		}];
 	}
 	else // if (!needsObject && !needsMetadata)
 	{
-		__unsafe_unretained YapDatabaseFullTextSearchWithKeyBlock block =
-		    (YapDatabaseFullTextSearchWithKeyBlock)fts->block;
-		
 		[databaseTransaction _enumerateKeysInAllCollectionsUsingBlock:
 		    ^(int64_t rowid, NSString *collection, NSString *key, BOOL *stop) {
 			
-			block(ftsConnection->blockDict, collection, key);
+			addToChunk(rowid, collection, key, nil, nil);
+		}];
+	}
+	
+	if ([chunk count] > 0)
+	{
+		[self populateChunk:chunk];
+	}
+	
+	[self endBulkInsert:mergeSettings];
+	
+	return YES;
+}
+
+/**
+ * Internal method.
+ *
+ * Extracts the text for each row in the chunk, and writes the rows with text to the FTS table.
+**/
+- (void)populateChunk:(NSArray *)chunk
+{
+	__unsafe_unretained YapDatabaseFullTextSearch *fts = ftsConnection->fts;
+	
+	// Step 1:
+	//
+	// Invoke the block for every row.
+	// Each row gets its own dictionary, so rows may be processed concurrently (if allowed).
+	
+	__unsafe_unretained id block = fts->block;
+	YapDatabaseFullTextSearchBlockType blockType = fts->blockType;
+	id sharedKeySet = fts->columnNamesSharedKeySet;
+	
+	void (^extractBlock)(size_t) = ^(size_t index){ @autoreleasepool {
+		
+		YDBFullTextSearchPopulateRow *row = [chunk objectAtIndex:index];
+		
+		NSMutableDictionary *values = [NSMutableDictionary dictionaryWithSharedKeySet:sharedKeySet];
+		
+		if (blockType == YapDatabaseFullTextSearchBlockTypeWithKey)
+		{
+			__unsafe_unretained YapDatabaseFullTextSearchWithKeyBlock keyBlock =
+			    (YapDatabaseFullTextSearchWithKeyBlock)block;
+			
+			keyBlock(values, row->collection, row->key);
+		}
+		else if (blockType == YapDatabaseFullTextSearchBlockTypeWithObject)
+		{
+			__unsafe_unretained YapDatabaseFullTextSearchWithObjectBlock objectBlock =
+			    (YapDatabaseFullTextSearchWithObjectBlock)block;
+			
+			objectBlock(values, row->collection, row->key, row->object);
+		}
+		else if (blockType == YapDatabaseFullTextSearchBlockTypeWithMetadata)
+		{
+			__unsafe_unretained YapDatabaseFullTextSearchWithMetadataBlock metadataBlock =
+			    (YapDatabaseFullTextSearchWithMetadataBlock)block;
+			
+			metadataBlock(values, row->collection, row->key, row->metadata);
+		}
+		else
+		{
+			__unsafe_unretained YapDatabaseFullTextSearchWithRowBlock rowBlock =
+			    (YapDatabaseFullTextSearchWithRowBlock)block;
 			
-			if ([ftsConnection->blockDict count] > 0)
+			rowBlock(values, row->collection, row->key, row->object, row->metadata);
+		}
+		
+		row->values = values;
+		
+		// We no longer need these, so release them as we go.
+		row->object = nil;
+		row->metadata = nil;
+	}};
+	
+	NSUInteger count = [chunk count];
+	
+	if (fts->concurrentTextExtraction && (count > 1))
+	{
+		dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), extractBlock);
+	}
+	else
+	{
+		for (size_t index = 0; index < count; index++)
+		{
+			extractBlock(index);
+		}
+	}
+	
+	// Step 2:
+	//
+	// Write the rows with text to the FTS table, using a multi-row statement:
+	//
+	// INSERT INTO "tableName" ("rowid", "column1", ...) VALUES (?, ?, ...), (?, ?, ...), ...;
+	//
+	// Any remaining rows (less than a full batch) are written using the regular insert statement.
+	
+	NSMutableArray *rowsToAdd = [NSMutableArray arrayWithCapacity:count];
+	
+	for (YDBFullTextSearchPopulateRow *row in chunk)
+	{
+		if ([row->values count] > 0)
+			[rowsToAdd addObject:row];
+	}
+	
+	NSUInteger addCount = [rowsToAdd count];
+	NSUInteger addOffset = 0;
+	
+	int batchRowCount = [ftsConnection batchInsertRowCount];
+	
+	if (addCount >= (NSUInteger)batchRowCount)
+	{
+		sqlite3_stmt *statement = [ftsConnection batchInsertStatement];
+		if (statement)
+		{
+			while ((addCount - addOffset) >= (NSUInteger)batchRowCount)
 			{
-				[self addRowid:rowid isNew:YES];
-				[ftsConnection->blockDict removeAllObjects];
+				int bindIndex = 1;
+				for (int i = 0; i < batchRowCount; i++)
+				{
+					YDBFullTextSearchPopulateRow *row = [rowsToAdd objectAtIndex:(addOffset + i)];
+					
+					bindIndex = [self bindRowid:row->rowid withValues:row->values toStatement:statement atIndex:bindIndex];
+				}
+				
+				int status = sqlite3_step(statement);
+				if (status != SQLITE_DONE)
+				{
+					YDBLogError(@"Error executing 'batchInsertStatement': %d %s",
+					            status, sqlite3_errmsg(databaseTransaction->connection->db));
+				}
+				
+				sqlite3_clear_bindings(statement);
+				sqlite3_reset(statement);
+				
+				addOffset += batchRowCount;
 			}
-		}];
+		}
 	}
 	
-	return YES;
+	for (NSUInteger i = addOffset; i < addCount; i++)
+	{
+		YDBFullTextSearchPopulateRow *row = [rowsToAdd objectAtIndex:i];
+		
+		[self addRowid:row->rowid withValues:row->values isNew:YES];
+	}
+	
+	isMutated = YES;
+}
+
+/**
+ * Internal method.
+ *
+ * Invoked before populating the (empty) FTS table.
+ *
+ * By default, fts5 incrementally merges the b-tree segments as rows are inserted (automerge),
+ * and forces a merge once too many segments accumulate (crisismerge).
+ * This work is wasted when building the entire index at once, as we're going to merge everything at the end.
+ * So we disable automerge, and raise crisismerge, for the duration of the build.
+ *
+ * Returns the previous settings (to be passed to endBulkInsert:), or nil if nothing was changed.
+ * The fts4 module doesn't automatically merge by default, so there's nothing to do for it.
+**/
+- (NSDictionary *)beginBulkInsert
+{
+	if (![ftsConnection->fts isFTS5]) return nil;
+	
+	NSString *tableName = [self tableName];
+	
+	NSDictionary *mergeSettings = @{
+	  @"automerge"   : @([self fts5ConfigValueForKey:@"automerge" defaultValue:4]),
+	  @"crisismerge" : @([self fts5ConfigValueForKey:@"crisismerge" defaultValue:16])
+	};
+	
+	[self executeFTSCommand:[NSString stringWithFormat:
+	  @"INSERT INTO \"%1$@\" (\"%1$@\", rank) VALUES ('automerge', 0);", tableName]];
+	
+	[self executeFTSCommand:[NSString stringWithFormat:
+	  @"INSERT INTO \"%1$@\" (\"%1$@\", rank) VALUES ('crisismerge', 64);", tableName]];
+	
+	return mergeSettings;
+}
+
+/**
+ * Internal method.
+ *
+ * Invoked after populating the FTS table, with the result of beginBulkInsert.
+ * Restores the previous merge settings (fts5), and merges all the b-tree segments into one (optimize),
+ * since automerge didn't do it along the way. This gives the smallest index, and the fastest queries.
+ *
+ * For fts4 there's nothing to do, as the segments were merged as usual during the build.
+ * (An fts4 'optimize' would rewrite the entire index in one go, which isn't something to do unasked.)
+**/
+- (void)endBulkInsert:(NSDictionary *)mergeSettings
+{
+	if (mergeSettings == nil) return;
+	
+	NSString *tableName = [self tableName];
+	
+	[self executeFTSCommand:[NSString stringWithFormat:
+	  @"INSERT INTO \"%1$@\" (\"%1$@\", rank) VALUES ('automerge', %2$d);",
+	  tableName, [mergeSettings[@"automerge"] intValue]]];
+	
+	[self executeFTSCommand:[NSString stringWithFormat:
+	  @"INSERT INTO \"%1$@\" (\"%1$@\", rank) VALUES ('crisismerge', %2$d);",
+	  tableName, [mergeSettings[@"crisismerge"] intValue]]];
+	
+	[self executeFTSCommand:[NSString stringWithFormat:
+	  @"INSERT INTO \"%1$@\" (\"%1$@\") VALUES ('optimize');", tableName]];
+}
+
+/**
+ * Internal method.
+ *
+ * Returns the value of the given fts5 configuration option,
+ * as stored in the table's config shadow table ("<tableName>_config"),
+ * or the given default value if the option was never set.
+**/
+- (int)fts5ConfigValueForKey:(NSString *)key defaultValue:(int)defaultValue
+{
+	sqlite3 *db = databaseTransaction->connection->db;
+	
+	NSString *query = [NSString stringWithFormat:@"SELECT \"v\" FROM \"%@_config\" WHERE \"k\" = ?;", [self tableName]];
+	
+	sqlite3_stmt *statement;
+	
+	int status = sqlite3_prepare_v2(db, [query UTF8String], -1, &statement, NULL);
+	if (status != SQLITE_OK)
+	{
+		YDBLogError(@"%@ - Error creating statement (%@): %d %s", THIS_METHOD, query, status, sqlite3_errmsg(db));
+		return defaultValue;
+	}
+	
+	int result = defaultValue;
+	
+	sqlite3_bind_text(statement, 1, [key UTF8String], -1, SQLITE_TRANSIENT);
+	
+	status = sqlite3_step(statement);
+	if (status == SQLITE_ROW)
+	{
+		result = sqlite3_column_int(statement, 0);
+	}
+	else if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - Error executing statement (%@): %d %s", THIS_METHOD, query, status, sqlite3_errmsg(db));
+	}
+	
+	sqlite3_finalize(statement);
+	
+	return result;
+}
+
+- (void)executeFTSCommand:(NSString *)command
+{
+	sqlite3 *db = databaseTransaction->connection->db;
+	
+	int status = sqlite3_exec(db, [command UTF8String], NULL, NULL, NULL);
+	if (status != SQLITE_OK)
+	{
+		YDBLogError(@"%@ - Failed executing FTS command (%@): %d %s",
+		            THIS_METHOD, command, status, sqlite3_errmsg(db));
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -339,6 +709,11 @@ static NSString *const ExtKey_version_deprecated = @"version";
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 - (void)addRowid:(int64_t)rowid isNew:(BOOL)isNew
+{
+	[self addRowid:rowid withValues:ftsConnection->blockDict isNew:isNew];
+}
+
+- (void)addRowid:(int64_t)rowid withValues:(NSDictionary *)values isNew:(BOOL)isNew
 {
 	YDBLogAutoTrace();
 	
@@ -354,19 +729,7 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	//  isNew : INSERT INTO "tableName" ("rowid", "column1", "column2", ...) VALUES (?, ?, ? ...)
 	// !isNew : INSERT OR REPLACE INTO "tableName" ("rowid", "column1", "column2", ...) VALUES (?, ?, ? ...)
 	
-	sqlite3_bind_int64(statement, 1, rowid);
-	
-	int i = 2;
-	for (NSString *columnName in ftsConnection->fts->columnNames)
-	{
-		NSString *columnValue = [ftsConnection->blockDict objectForKey:columnName];
-		if (columnValue)
-		{
-			sqlite3_bind_text(statement, i, [columnValue UTF8String], -1, SQLITE_TRANSIENT);
-		}
-		
-		i++;
-	}
+	[self bindRowid:rowid withValues:values toStatement:statement atIndex:1];
 	
 	int status = sqlite3_step(statement);
 	if (status != SQLITE_DONE)
@@ -382,6 +745,32 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	isMutated = YES;
 }
 
+/**
+ * Binds the rowid, followed by a value for each column (in columnNames order), starting at the given index.
+ * Returns the next unused bind index.
+**/
+- (int)bindRowid:(int64_t)rowid
+      withValues:(NSDictionary *)values
+     toStatement:(sqlite3_stmt *)statement
+         atIndex:(int)index
+{
+	sqlite3_bind_int64(statement, index, rowid);
+	index++;
+	
+	for (NSString *columnName in ftsConnection->fts->columnNames)
+	{
+		NSString *columnValue = [values objectForKey:columnName];
+		if (columnValue)
+		{
+			sqlite3_bind_text(statement, index, [columnValue UTF8String], -1, SQLITE_TRANSIENT);
+		}
+		
+		index++;
+	}
+	
+	return index;
+}
+
 - (void)removeRowid:(int64_t)rowid
 {
 	YDBLogAutoTrace();
@@ -941,19 +1330,185 @@ static NSString *const ExtKey_version_deprecated = @"version";
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-#pragma mark Queries with Snippets
+#pragma mark Ranked Queries
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 - (void)enumerateRowidsMatching:(NSString *)query
-             withSnippetOptions:(YapDatabaseFullTextSearchSnippetOptions *)inOptions
-                     usingBlock:
-            (void (^)(NSString *snippet, int64_t rowid, BOOL *stop))block
+             withRankingWeights:(NSDictionary *)weights
+                          limit:(NSUInteger)limit
+                     usingBlock:(void (^)(int64_t rowid, BOOL *stop))block
 {
 	if (block == nil) return;
 	if ([query length] == 0) return;
 	
-	sqlite3_stmt *statement = [ftsConnection querySnippetStatement];
-	if (statement == NULL) return;
+	__unsafe_unretained YapDatabaseFullTextSearch *fts = ftsConnection->fts;
+	
+	BOOL isFTS5 = [fts isFTS5];
+	if (!isFTS5 && !ftsConnection->didWarnRankingRequiresFTS5)
+	{
+		// Ranked queries still work, so this is only logged once per connection (rather than for every query).
+		
+		YDBLogWarn(@"%@ - Relevance ranking requires YapDatabaseFullTextSearchFTS5Version."
+		           @" Results for registeredName(%@) will be in rowid order.", THIS_METHOD, [self registeredName]);
+		
+		ftsConnection->didWarnRankingRequiresFTS5 = YES;
+	}
+	
+	sqlite3_stmt *statement = [ftsConnection rankedQueryStatement];
+	if (statement == NULL) return;
+	
+	BOOL stop = NO;
+	isMutated = NO; // mutation during enumeration protection
+	
+	// SELECT "rowid" FROM "tableName" WHERE "tableName" MATCH ?1 ORDER BY bm25("tableName", ?2, ?3, ...) LIMIT ?N;
+	
+	YapDatabaseString _query; MakeYapDatabaseString(&_query, query);
+	sqlite3_bind_text(statement, 1, _query.str, _query.length, SQLITE_STATIC);
+	
+	int i = 2;
+	for (NSString *columnName in fts->columnNames)
+	{
+		if (isFTS5)
+		{
+			NSNumber *weight = [weights objectForKey:columnName];
+			sqlite3_bind_double(statement, i, weight ? [weight doubleValue] : 1.0);
+		}
+		
+		i++;
+	}
+	
+	for (NSString *columnName in weights)
+	{
+		if (![fts->columnNames containsObject:columnName])
+		{
+			YDBLogWarn(@"%@ - Ignoring ranking weight for unknown column(%@)", THIS_METHOD, columnName);
+		}
+	}
+	
+	// A negative limit means no limit
+	sqlite3_bind_int64(statement, i, (limit > 0) ? (int64_t)limit : -1);
+	
+	int status = sqlite3_step(statement);
+	if (status == SQLITE_ROW)
+	{
+		do
+		{
+			int64_t rowid = sqlite3_column_int64(statement, 0);
+			
+			block(rowid, &stop);
+			
+			if (stop || isMutated) break;
+			
+		} while ((status = sqlite3_step(statement)) == SQLITE_ROW);
+	}
+	
+	if ((status != SQLITE_DONE) && !stop && !isMutated)
+	{
+		YDBLogError(@"%@ - sqlite_step error: %d %s", THIS_METHOD,
+		            status, sqlite3_errmsg(databaseTransaction->connection->db));
+	}
+	
+	sqlite3_clear_bindings(statement);
+	sqlite3_reset(statement);
+	FreeYapDatabaseString(&_query);
+	
+	if (isMutated && !stop)
+	{
+		@throw [databaseTransaction mutationDuringEnumerationException];
+	}
+}
+
+- (void)enumerateKeysMatching:(NSString *)query
+           withRankingWeights:(NSDictionary *)weights
+                        limit:(NSUInteger)limit
+                   usingBlock:(void (^)(NSString *collection, NSString *key, BOOL *stop))block
+{
+	[self enumerateRowidsMatching:query
+	           withRankingWeights:weights
+	                        limit:limit
+	                   usingBlock:^(int64_t rowid, BOOL *stop)
+	{
+		YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
+		
+		block(ck.collection, ck.key, stop);
+	}];
+}
+
+- (void)enumerateKeysAndMetadataMatching:(NSString *)query
+                      withRankingWeights:(NSDictionary *)weights
+                                   limit:(NSUInteger)limit
+                              usingBlock:(void (^)(NSString *collection, NSString *key, id metadata, BOOL *stop))block
+{
+	[self enumerateRowidsMatching:query
+	           withRankingWeights:weights
+	                        limit:limit
+	                   usingBlock:^(int64_t rowid, BOOL *stop)
+	{
+		YapCollectionKey *ck = nil;
+		id metadata = nil;
+		[databaseTransaction getCollectionKey:&ck metadata:&metadata forRowid:rowid];
+		
+		block(ck.collection, ck.key, metadata, stop);
+	}];
+}
+
+- (void)enumerateKeysAndObjectsMatching:(NSString *)query
+                     withRankingWeights:(NSDictionary *)weights
+                                  limit:(NSUInteger)limit
+                             usingBlock:(void (^)(NSString *collection, NSString *key, id object, BOOL *stop))block
+{
+	[self enumerateRowidsMatching:query
+	           withRankingWeights:weights
+	                        limit:limit
+	                   usingBlock:^(int64_t rowid, BOOL *stop)
+	{
+		YapCollectionKey *ck = nil;
+		id object = nil;
+		[databaseTransaction getCollectionKey:&ck object:&object forRowid:rowid];
+		
+		block(ck.collection, ck.key, object, stop);
+	}];
+}
+
+- (void)enumerateRowsMatching:(NSString *)query
+           withRankingWeights:(NSDictionary *)weights
+                        limit:(NSUInteger)limit
+                   usingBlock:(void (^)(NSString *collection, NSString *key, id object, id metadata, BOOL *stop))block
+{
+	[self enumerateRowidsMatching:query
+	           withRankingWeights:weights
+	                        limit:limit
+	                   usingBlock:^(int64_t rowid, BOOL *stop)
+	{
+		YapCollectionKey *ck = nil;
+		id object = nil;
+		id metadata = nil;
+		[databaseTransaction getCollectionKey:&ck object:&object metadata:&metadata forRowid:rowid];
+		
+		block(ck.collection, ck.key, object, metadata, stop);
+	}];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Queries with Snippets
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (void)enumerateRowidsMatching:(NSString *)query
+             withSnippetOptions:(YapDatabaseFullTextSearchSnippetOptions *)inOptions
+                     usingBlock:
+            (void (^)(NSString *snippet, int64_t rowid, BOOL *stop))block
+{
+	if (block == nil) return;
+	if ([query length] == 0) return;
+	
+	if (ftsConnection->fts->contentless)
+	{
+		[self enumerateContentlessRowidsMatching:query withSnippetOptions:inOptions usingBlock:block];
+		return;
+	}
+	
+	sqlite3_stmt *statement = [ftsConnection querySnippetStatement];
+	if (statement == NULL) return;
 	
 	YapDatabaseFullTextSearchSnippetOptions *options;
 	if (inOptions)
@@ -1100,6 +1655,228 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	}];
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Contentless Snippets
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A contentless table doesn't store the indexed text, so sqlite can't generate snippets from it.
+ * Instead we re-run the block for each matching row to re-create the text,
+ * and generate the snippet from a temporary single-row table. (See YapDatabaseFullTextSearchConnection.)
+ *
+ * This method binds the snippet options & query to the snippet table's query statement.
+ * The bindings are kept (across sqlite3_reset) for every row, until endContentlessSnippets is invoked.
+**/
+- (sqlite3_stmt *)beginContentlessSnippetsForQuery:(NSString *)query
+                                       withOptions:(YapDatabaseFullTextSearchSnippetOptions *)inOptions
+{
+	if (![ftsConnection createSnippetTableIfNeeded]) return NULL;
+	
+	sqlite3_stmt *statement = [ftsConnection snippetTableQueryStatement];
+	if (statement == NULL) return NULL;
+	
+	YapDatabaseFullTextSearchSnippetOptions *options;
+	if (inOptions)
+		options = [inOptions copy];
+	else
+		options = [[YapDatabaseFullTextSearchSnippetOptions alloc] init]; // default snippet options
+	
+	// SELECT "rowid", snippet("tableName_snippet", ?4, ?1, ?2, ?3, abs(?5))
+	//   FROM temp."tableName_snippet" WHERE "tableName_snippet" MATCH ?6;
+	
+	sqlite3_bind_text(statement, 1, [options.startMatchText UTF8String], -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text(statement, 2, [options.endMatchText UTF8String], -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text(statement, 3, [options.ellipsesText UTF8String], -1, SQLITE_TRANSIENT);
+	
+	int columnIndex = -1;
+	if (options.columnName)
+	{
+		NSUInteger index = [ftsConnection->fts->columnNames indexOfObject:options.columnName];
+		if (index == NSNotFound)
+		{
+			YDBLogWarn(@"Invalid snippet option: columnName(%@) not found", options.columnName);
+		}
+		else
+		{
+			columnIndex = (int)index;
+		}
+	}
+	sqlite3_bind_int(statement, 4, columnIndex);
+	sqlite3_bind_int(statement, 5, options.numberOfTokens);
+	
+	sqlite3_bind_text(statement, 6, [query UTF8String], -1, SQLITE_TRANSIENT);
+	
+	return statement;
+}
+
+- (void)endContentlessSnippets:(sqlite3_stmt *)statement
+{
+	sqlite3_clear_bindings(statement);
+	sqlite3_reset(statement);
+	
+	sqlite3_stmt *removeAllStatement = [ftsConnection snippetTableRemoveAllStatement];
+	if (removeAllStatement)
+	{
+		sqlite3_step(removeAllStatement);
+		sqlite3_reset(removeAllStatement);
+	}
+}
+
+/**
+ * Re-runs the block for the given row, and generates the snippet via the (prepared) snippet table statement.
+ * The given blockDict is used as scratch space, and is empty when this method returns.
+**/
+- (NSString *)contentlessSnippetForRowid:(int64_t)rowid
+                               statement:(sqlite3_stmt *)queryStatement
+                               blockDict:(NSMutableDictionary *)blockDict
+{
+	__unsafe_unretained YapDatabaseFullTextSearch *fts = ftsConnection->fts;
+	sqlite3 *db = databaseTransaction->connection->db;
+	
+	// Re-create the indexed text
+	
+	YapCollectionKey *ck = nil;
+	id object = nil;
+	id metadata = nil;
+	
+	if (fts->blockType == YapDatabaseFullTextSearchBlockTypeWithKey)
+	{
+		__unsafe_unretained YapDatabaseFullTextSearchWithKeyBlock block =
+		    (YapDatabaseFullTextSearchWithKeyBlock)fts->block;
+		
+		ck = [databaseTransaction collectionKeyForRowid:rowid];
+		if (ck) block(blockDict, ck.collection, ck.key);
+	}
+	else if (fts->blockType == YapDatabaseFullTextSearchBlockTypeWithObject)
+	{
+		__unsafe_unretained YapDatabaseFullTextSearchWithObjectBlock block =
+		    (YapDatabaseFullTextSearchWithObjectBlock)fts->block;
+		
+		if ([databaseTransaction getCollectionKey:&ck object:&object forRowid:rowid])
+			block(blockDict, ck.collection, ck.key, object);
+	}
+	else if (fts->blockType == YapDatabaseFullTextSearchBlockTypeWithMetadata)
+	{
+		__unsafe_unretained YapDatabaseFullTextSearchWithMetadataBlock block =
+		    (YapDatabaseFullTextSearchWithMetadataBlock)fts->block;
+		
+		if ([databaseTransaction getCollectionKey:&ck metadata:&metadata forRowid:rowid])
+			block(blockDict, ck.collection, ck.key, metadata);
+	}
+	else
+	{
+		__unsafe_unretained YapDatabaseFullTextSearchWithRowBlock block =
+		    (YapDatabaseFullTextSearchWithRowBlock)fts->block;
+		
+		if ([databaseTransaction getCollectionKey:&ck object:&object metadata:&metadata forRowid:rowid])
+			block(blockDict, ck.collection, ck.key, object, metadata);
+	}
+	
+	if ([blockDict count] == 0) return nil;
+	
+	// DELETE FROM temp."tableName_snippet";
+	// INSERT INTO temp."tableName_snippet" ("rowid", "column1", "column2", ...) VALUES (?, ?, ? ...);
+	
+	sqlite3_stmt *removeAllStatement = [ftsConnection snippetTableRemoveAllStatement];
+	sqlite3_stmt *insertStatement = [ftsConnection snippetTableInsertStatement];
+	
+	if (removeAllStatement == NULL || insertStatement == NULL)
+	{
+		[blockDict removeAllObjects];
+		return nil;
+	}
+	
+	sqlite3_step(removeAllStatement);
+	sqlite3_reset(removeAllStatement);
+	
+	sqlite3_bind_int64(insertStatement, 1, rowid);
+	
+	int i = 2;
+	for (NSString *columnName in fts->columnNames)
+	{
+		NSString *columnValue = [blockDict objectForKey:columnName];
+		if (columnValue)
+		{
+			sqlite3_bind_text(insertStatement, i, [columnValue UTF8String], -1, SQLITE_TRANSIENT);
+		}
+		
+		i++;
+	}
+	
+	int status = sqlite3_step(insertStatement);
+	
+	sqlite3_clear_bindings(insertStatement);
+	sqlite3_reset(insertStatement);
+	[blockDict removeAllObjects];
+	
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - Error executing 'snippetTableInsertStatement': %d %s", THIS_METHOD,
+		            status, sqlite3_errmsg(db));
+		return nil;
+	}
+	
+	// Generate the snippet
+	
+	NSString *snippet = nil;
+	
+	status = sqlite3_step(queryStatement);
+	if (status == SQLITE_ROW)
+	{
+		const unsigned char *text = sqlite3_column_text(queryStatement, 1);
+		int textSize = sqlite3_column_bytes(queryStatement, 1);
+		
+		snippet = [[NSString alloc] initWithBytes:text length:textSize encoding:NSUTF8StringEncoding];
+	}
+	else if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - sqlite_step error: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+	}
+	
+	sqlite3_reset(queryStatement); // keep bindings for the next row
+	
+	return snippet;
+}
+
+- (void)enumerateContentlessRowidsMatching:(NSString *)query
+                        withSnippetOptions:(YapDatabaseFullTextSearchSnippetOptions *)options
+                                usingBlock:(void (^)(NSString *snippet, int64_t rowid, BOOL *stop))block
+{
+	// Note: The temporary table must be created before we start stepping the query statement.
+	
+	sqlite3_stmt *snippetStatement = [self beginContentlessSnippetsForQuery:query withOptions:options];
+	if (snippetStatement == NULL) return;
+	
+	NSMutableDictionary *blockDict =
+	  [NSMutableDictionary dictionaryWithSharedKeySet:ftsConnection->fts->columnNamesSharedKeySet];
+	
+	[self enumerateRowidsMatching:query usingBlock:^(int64_t rowid, BOOL *stop) {
+		
+		NSString *snippet = [self contentlessSnippetForRowid:rowid statement:snippetStatement blockDict:blockDict];
+		
+		block(snippet, rowid, stop);
+	}];
+	
+	[self endContentlessSnippets:snippetStatement];
+}
+
+- (NSString *)contentlessRowid:(int64_t)rowid matches:(NSString *)query
+                                   withSnippetOptions:(YapDatabaseFullTextSearchSnippetOptions *)options
+{
+	if (![self rowid:rowid matches:query]) return nil;
+	
+	sqlite3_stmt *snippetStatement = [self beginContentlessSnippetsForQuery:query withOptions:options];
+	if (snippetStatement == NULL) return nil;
+	
+	NSMutableDictionary *blockDict =
+	  [NSMutableDictionary dictionaryWithSharedKeySet:ftsConnection->fts->columnNamesSharedKeySet];
+	
+	NSString *snippet = [self contentlessSnippetForRowid:rowid statement:snippetStatement blockDict:blockDict];
+	
+	[self endContentlessSnippets:snippetStatement];
+	return snippet;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Individual Query
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1143,6 +1920,11 @@ static NSString *const ExtKey_version_deprecated = @"version";
 {
 	if ([query length] == 0) return nil;
 	
+	if (ftsConnection->fts->contentless)
+	{
+		return [self contentlessRowid:rowid matches:query withSnippetOptions:inOptions];
+	}
+	
 	sqlite3_stmt *statement = [ftsConnection rowidQuerySnippetStatement];
 	if (statement == NULL) return nil;
 	
@@ -1184,9 +1966,6 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	YapDatabaseString _query; MakeYapDatabaseString(&_query, query);
 	sqlite3_bind_text(statement, 7, _query.str, _query.length, SQLITE_STATIC);
 	
-	sqlite3_clear_bindings(statement);
-	sqlite3_reset(statement);
-	
 	NSString *snippet = nil;
 	
 	int status = sqlite3_step(statement);
@@ -1205,6 +1984,9 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		            status, sqlite3_errmsg(databaseTransaction->connection->db));
 	}
 	
+	sqlite3_clear_bindings(statement);
+	sqlite3_reset(statement);
+	
 	FreeYapDatabaseString(&_startMatchText);
 	FreeYapDatabaseString(&_endMatchText);
 	FreeYapDatabaseString(&_ellipsesText);
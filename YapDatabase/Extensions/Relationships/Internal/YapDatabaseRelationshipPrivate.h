@@ -38,6 +38,24 @@
 **/
 - (dispatch_queue_t)fileManagerQueue;
 
+/**
+ * Hands a batch of files to the background deletion queue.
+ * The batch must have already been recorded in the database (see YapDatabaseRelationshipTransaction).
+ *
+ * Batches are processed in order. After each batch, the completed batches are removed from the database
+ * (by the next readwrite transaction, or by a transaction of our own if there isn't one soon).
+**/
+- (void)enqueueFileDeletionBatch:(int)batchNumber filePaths:(NSArray *)filePaths;
+
+/**
+ * If any batches have completed since the last invocation, returns YES,
+ * and sets batchNumberPtr to the last completed batch.
+ * The caller is then responsible for removing the completed batches from the database.
+ *
+ * This method is thread-safe.
+**/
+- (BOOL)getCompletedFileDeletionBatch:(int *)batchNumberPtr;
+
 @end
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -49,6 +67,9 @@
 	
 	BOOL disableYapDatabaseRelationshipNodeProtocol;
 	YapWhitelistBlacklist *allowedCollections;
+	
+	NSUInteger fileDeletionMaxConcurrentOperations;
+	uint64_t fileDeletionMaxBytesPerSecond;
 }
 
 @end
@@ -57,6 +78,56 @@
 #pragma mark -
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+typedef struct {
+	int64_t edgeRowid;
+	int64_t nodeRowid;    // rowid of the node at the other end of the edge, or index into filePaths
+	NSUInteger nameIndex; // index into names
+	int rules;
+	BOOL manual;
+	BOOL isFilePath;
+} YapDatabaseRelationshipAdjacencyItem;
+
+/**
+ * The edges attached to a single node (in a single direction), as stored on disk.
+ * That is, either every edge with the node as its source, or every edge with the node as its destination.
+ *
+ * These are stored in the connection's adjacencyCache.
+ * Edge names & file paths are stored once per adjacency (not once per edge),
+ * and the edges themselves are stored in a plain C array.
+**/
+@interface YapDatabaseRelationshipAdjacency : NSObject {
+@public
+	
+	NSUInteger count;
+	YapDatabaseRelationshipAdjacencyItem *items;
+	
+	NSMutableArray *names;
+	NSMutableArray *filePaths;
+}
+
+- (void)addEdgeWithRowid:(int64_t)edgeRowid
+                    name:(NSString *)name
+               nodeRowid:(int64_t)nodeRowid
+                filePath:(NSString *)filePath
+                   rules:(int)rules
+                  manual:(BOOL)manual;
+
+/**
+ * Returns NSNotFound if there are no edges with the given name.
+**/
+- (NSUInteger)indexOfName:(NSString *)name;
+
+/**
+ * Pass nil to count every edge.
+**/
+- (NSUInteger)countWithName:(NSString *)name;
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 @interface YapDatabaseRelationshipConnection () {
 @public
 	
@@ -73,6 +144,15 @@
 	
 	NSMutableSet *filesToDelete;
 	
+	YapCache *sourceAdjacencyCache;      // key:(NSNumber *)srcRowid, value:(YapDatabaseRelationshipAdjacency *)
+	YapCache *destinationAdjacencyCache; // key:(NSNumber *)dstRowid, value:(YapDatabaseRelationshipAdjacency *)
+	NSUInteger adjacencyCacheLimit;
+	
+	NSMutableSet *adjacencyChanges; // contains:(NSNumber *)rowidNumber (src or dst of a modified edge)
+	BOOL adjacencyReset;
+	
+	BOOL traversalTableInUse; // A breadth first traversal (via the traversal table) is in progress
+	
 //	NSMutableSet *mutatedSomething;
 }
 
@@ -83,6 +163,7 @@
 
 - (sqlite3_stmt *)findManualEdgeStatement;
 - (sqlite3_stmt *)insertEdgeStatement;
+- (sqlite3_stmt *)insertEdgesStatement:(NSUInteger *)edgeCountPtr;
 - (sqlite3_stmt *)updateEdgeStatement;
 - (sqlite3_stmt *)deleteEdgeStatement;
 - (sqlite3_stmt *)deleteEdgesWithNodeStatement;
@@ -106,6 +187,22 @@
 - (sqlite3_stmt *)removeAllStatement;
 - (sqlite3_stmt *)removeAllProtocolStatement;
 
+- (BOOL)createCascadeTableIfNeeded;
+- (sqlite3_stmt *)cascadeTableInsertStatement;
+- (sqlite3_stmt *)cascadeTableRemoveAllStatement;
+- (sqlite3_stmt *)cascadeAllSourcesDeletedStatement;
+- (sqlite3_stmt *)cascadeAllDestinationsDeletedStatement;
+- (sqlite3_stmt *)cascadeEnumerateForSrcStatement;
+- (sqlite3_stmt *)cascadeEnumerateForDstStatement;
+- (sqlite3_stmt *)cascadeDeleteEdgesStatement;
+
+- (BOOL)createTraversalTableIfNeeded;
+- (sqlite3_stmt *)traversalTableInsertStatement;
+- (sqlite3_stmt *)traversalTableRemoveAllStatement;
+- (sqlite3_stmt *)traversalTableEnumerateDepthStatement;
+- (sqlite3_stmt *)traversalExpandStatementWithEdgeNameCount:(NSUInteger)edgeNameCount incoming:(BOOL)incoming;
+- (sqlite3_stmt *)traversalNeighborsStatementWithEdgeNameCount:(NSUInteger)edgeNameCount incoming:(BOOL)incoming;
+
 @end
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -122,4 +219,10 @@
 - (id)initWithRelationshipConnection:(YapDatabaseRelationshipConnection *)relationshipConnection
                  databaseTransaction:(YapDatabaseReadTransaction *)databaseTransaction;
 
+/**
+ * Removes the batches that YapDatabaseRelationship's background deletion queue has completed from the database.
+ * Invoked from commitTransaction, and by YapDatabaseRelationship if no readwrite transaction comes along.
+**/
+- (void)removeCompletedFileDeletionBatches;
+
 @end
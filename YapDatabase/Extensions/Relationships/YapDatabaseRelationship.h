@@ -49,4 +49,20 @@
 **/
 @property (nonatomic, copy, readonly) YapDatabaseRelationshipOptions *options;
 
+/**
+ * Progress of the background file deletion queue.
+ * (See fileDeletionMaxConcurrentOperations & fileDeletionMaxBytesPerSecond in YapDatabaseRelationshipOptions.)
+ *
+ * pendingFileDeletionCount - the number of files waiting to be deleted (including those from a previous app launch)
+ * deletedFileCount         - the number of files deleted since the extension was registered
+ * failedFileDeletionCount  - the number of files that couldn't be deleted (these are not retried)
+ * deletedFileBytes         - the total size of the deleted files
+ *
+ * A file that no longer exists (e.g. deleted before the app was terminated) is counted as deleted.
+**/
+@property (atomic, readonly) NSUInteger pendingFileDeletionCount;
+@property (atomic, readonly) NSUInteger deletedFileCount;
+@property (atomic, readonly) NSUInteger failedFileDeletionCount;
+@property (atomic, readonly) uint64_t deletedFileBytes;
+
 @end
@@ -6,6 +6,8 @@
 
 #import "YapDatabaseLogging.h"
 
+#import <libkern/OSAtomic.h>
+
 #if ! __has_feature(objc_arc)
 #warning This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
 #endif
@@ -20,10 +22,56 @@
   static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 #endif
 
+/**
+ * How long to wait (after a file deletion batch completes) before removing the completed batches
+ * from the database in a transaction of their own.
+ *
+ * Usually the next readwrite transaction gets there first, and removes them as part of its commit.
+**/
+static NSTimeInterval const YDBRelationshipFileDeletionPruneDelay = 10.0;
+
+/**
+ * A batch of files (from a single commit) that's being processed by the fileManagerQueue.
+**/
+@interface YDBRelationshipFileDeletionBatch : NSObject {
+@public
+	
+	int batchNumber;
+	NSArray *filePaths;
+	NSUInteger nextIndex; // The next file to be handed to the deletion queue
+}
+@end
+
+@implementation YDBRelationshipFileDeletionBatch
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 
 @implementation YapDatabaseRelationship
 {
 	dispatch_queue_t fileManagerQueue;
+	
+	OSSpinLock fileDeletionLock;
+	NSUInteger pendingFileDeletionCount;
+	NSUInteger deletedFileCount;
+	NSUInteger failedFileDeletionCount;
+	uint64_t deletedFileBytes;
+	int completedFileDeletionBatch;
+	BOOL fileDeletionPruneNeeded;  // A batch completed, and hasn't been removed from the database yet
+	BOOL fileDeletionPruneTimerSet; // The fallback prune (YDBRelationshipFileDeletionPruneDelay) is scheduled
+	
+	// Only accessed from the fileManagerQueue.
+	NSMutableArray *fileDeletionBatches; // Pending batches, in order
+	NSUInteger fileDeletionsInFlight;
+	BOOL fileDeletionResumeScheduled;
+	
+	// Throttling state (fileDeletionMaxBytesPerSecond).
+	// Only accessed from the fileManagerQueue, so it carries over from one batch to the next.
+	CFAbsoluteTime fileDeletionWindowStart;
+	uint64_t fileDeletionWindowBytes;
 }
 
 /**
@@ -76,6 +124,9 @@
 	{
 		versionTag = inVersionTag ? [inVersionTag copy] : @"";
 		options = inOptions ? [inOptions copy] : [[YapDatabaseRelationshipOptions alloc] init];
+		
+		fileDeletionLock = OS_SPINLOCK_INIT;
+		fileDeletionBatches = [[NSMutableArray alloc] init];
 	}
 	return self;
 }
@@ -134,4 +185,295 @@
 	return fileManagerQueue;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark File Deletion
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (NSUInteger)pendingFileDeletionCount
+{
+	NSUInteger result = 0;
+	
+	OSSpinLockLock(&fileDeletionLock);
+	{
+		result = pendingFileDeletionCount;
+	}
+	OSSpinLockUnlock(&fileDeletionLock);
+	
+	return result;
+}
+
+- (NSUInteger)deletedFileCount
+{
+	NSUInteger result = 0;
+	
+	OSSpinLockLock(&fileDeletionLock);
+	{
+		result = deletedFileCount;
+	}
+	OSSpinLockUnlock(&fileDeletionLock);
+	
+	return result;
+}
+
+- (NSUInteger)failedFileDeletionCount
+{
+	NSUInteger result = 0;
+	
+	OSSpinLockLock(&fileDeletionLock);
+	{
+		result = failedFileDeletionCount;
+	}
+	OSSpinLockUnlock(&fileDeletionLock);
+	
+	return result;
+}
+
+- (uint64_t)deletedFileBytes
+{
+	uint64_t result = 0;
+	
+	OSSpinLockLock(&fileDeletionLock);
+	{
+		result = deletedFileBytes;
+	}
+	OSSpinLockUnlock(&fileDeletionLock);
+	
+	return result;
+}
+
+/**
+ * See header file for description.
+**/
+- (void)enqueueFileDeletionBatch:(int)batchNumber filePaths:(NSArray *)filePaths
+{
+	OSSpinLockLock(&fileDeletionLock);
+	{
+		pendingFileDeletionCount += [filePaths count];
+	}
+	OSSpinLockUnlock(&fileDeletionLock);
+	
+	YDBRelationshipFileDeletionBatch *batch = [[YDBRelationshipFileDeletionBatch alloc] init];
+	batch->batchNumber = batchNumber;
+	batch->filePaths = [filePaths copy];
+	
+	dispatch_async([self fileManagerQueue], ^{ @autoreleasepool {
+		
+		[fileDeletionBatches addObject:batch];
+		[self continueFileDeletions];
+	}});
+}
+
+/**
+ * Invoked on the fileManagerQueue.
+ *
+ * Hands files (from the oldest pending batch) to a background queue for deletion,
+ * up to fileDeletionMaxConcurrentOperations at a time, and within the fileDeletionMaxBytesPerSecond budget.
+ *
+ * This method never blocks the fileManagerQueue. When it can't go any further, it simply returns,
+ * and is invoked again when a deletion finishes, or when the throttle allows the next file.
+**/
+- (void)continueFileDeletions
+{
+	if (fileDeletionResumeScheduled) return;
+	
+	NSUInteger maxConcurrentOperations = MAX(options->fileDeletionMaxConcurrentOperations, (NSUInteger)1);
+	uint64_t maxBytesPerSecond = options->fileDeletionMaxBytesPerSecond;
+	
+	dispatch_queue_t deleteQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0);
+	
+	NSFileManager *fileManager = [NSFileManager defaultManager];
+	
+	YDBRelationshipFileDeletionBatch *batch = nil;
+	while ((batch = [fileDeletionBatches firstObject]))
+	{
+		if (batch->nextIndex >= [batch->filePaths count])
+		{
+			// Batches are processed in order,
+			// so the batch isn't complete until all of its deletions have finished.
+			
+			if (fileDeletionsInFlight > 0) return;
+			
+			[fileDeletionBatches removeObjectAtIndex:0];
+			[self didCompleteFileDeletionBatch:batch->batchNumber];
+			
+			continue;
+		}
+		
+		if (fileDeletionsInFlight >= maxConcurrentOperations) return;
+		
+		NSString *filePath = [batch->filePaths objectAtIndex:batch->nextIndex];
+		uint64_t fileSize = [[fileManager attributesOfItemAtPath:filePath error:NULL] fileSize];
+		
+		if (maxBytesPerSecond > 0)
+		{
+			// The window persists across batches,
+			// so many small commits can't add up to more than the budget in any one second.
+			
+			CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - fileDeletionWindowStart;
+			if (elapsed >= 1.0 || elapsed < 0.0)
+			{
+				fileDeletionWindowStart = CFAbsoluteTimeGetCurrent();
+				fileDeletionWindowBytes = 0;
+			}
+			else if (fileDeletionWindowBytes > 0 && (fileDeletionWindowBytes + fileSize) > maxBytesPerSecond)
+			{
+				// We've used up the budget for the current second.
+				// Note: A single file that's larger than the budget is still deleted (in a window of its own).
+				
+				fileDeletionResumeScheduled = YES;
+				
+				dispatch_time_t when = dispatch_time(DISPATCH_TIME_NOW, (int64_t)((1.0 - elapsed) * NSEC_PER_SEC));
+				dispatch_after(when, [self fileManagerQueue], ^{ @autoreleasepool {
+					
+					fileDeletionResumeScheduled = NO;
+					
+					fileDeletionWindowStart = CFAbsoluteTimeGetCurrent();
+					fileDeletionWindowBytes = 0;
+					
+					[self continueFileDeletions];
+				}});
+				
+				return;
+			}
+			
+			fileDeletionWindowBytes += fileSize;
+		}
+		
+		batch->nextIndex++;
+		fileDeletionsInFlight++;
+		
+		dispatch_async(deleteQueue, ^{ @autoreleasepool {
+			
+			NSError *error = nil;
+			BOOL deleted = [[NSFileManager defaultManager] removeItemAtPath:filePath error:&error];
+			
+			if (!deleted && [error.domain isEqualToString:NSCocoaErrorDomain] && error.code == NSFileNoSuchFileError)
+			{
+				// Already deleted (e.g. right before the app was terminated during a previous launch)
+				deleted = YES;
+			}
+			
+			if (!deleted)
+			{
+				YDBLogWarn(@"Error removing file at path(%@): %@", filePath, error);
+			}
+			
+			OSSpinLockLock(&fileDeletionLock);
+			{
+				pendingFileDeletionCount--;
+				
+				if (deleted)
+				{
+					deletedFileCount++;
+					deletedFileBytes += fileSize;
+				}
+				else
+				{
+					failedFileDeletionCount++;
+				}
+			}
+			OSSpinLockUnlock(&fileDeletionLock);
+			
+			dispatch_async([self fileManagerQueue], ^{ @autoreleasepool {
+				
+				fileDeletionsInFlight--;
+				[self continueFileDeletions];
+			}});
+		}});
+	}
+}
+
+/**
+ * Invoked on the fileManagerQueue, after a batch has been processed.
+ *
+ * Batches are processed in order, so every batch up to this one is now complete.
+ * The records of the completed batches are removed from the database by the next readwrite transaction
+ * (see YapDatabaseRelationshipTransaction's commitTransaction).
+ * If there isn't one within YDBRelationshipFileDeletionPruneDelay, we perform a transaction of our own.
+**/
+- (void)didCompleteFileDeletionBatch:(int)batchNumber
+{
+	BOOL needsTimer = NO;
+	
+	OSSpinLockLock(&fileDeletionLock);
+	{
+		completedFileDeletionBatch = batchNumber;
+		fileDeletionPruneNeeded = YES;
+		
+		needsTimer = !fileDeletionPruneTimerSet;
+		fileDeletionPruneTimerSet = YES;
+	}
+	OSSpinLockUnlock(&fileDeletionLock);
+	
+	if (needsTimer)
+	{
+		dispatch_time_t when =
+		  dispatch_time(DISPATCH_TIME_NOW, (int64_t)(YDBRelationshipFileDeletionPruneDelay * NSEC_PER_SEC));
+		dispatch_after(when, [self fileManagerQueue], ^{ @autoreleasepool {
+			
+			[self removeCompletedFileDeletionBatches];
+		}});
+	}
+}
+
+/**
+ * See header file for description.
+**/
+- (BOOL)getCompletedFileDeletionBatch:(int *)batchNumberPtr
+{
+	BOOL result = NO;
+	
+	OSSpinLockLock(&fileDeletionLock);
+	{
+		if (fileDeletionPruneNeeded)
+		{
+			*batchNumberPtr = completedFileDeletionBatch;
+			fileDeletionPruneNeeded = NO;
+			
+			result = YES;
+		}
+	}
+	OSSpinLockUnlock(&fileDeletionLock);
+	
+	return result;
+}
+
+/**
+ * Invoked on the fileManagerQueue, YDBRelationshipFileDeletionPruneDelay after a batch completed.
+ *
+ * If no readwrite transaction has removed the completed batches from the database in the meantime,
+ * we do it here. At most one of these is pending at a time.
+ *
+ * We use a short-lived connection, as holding onto a connection would create a retain cycle
+ * (database -> extension -> connection -> database).
+**/
+- (void)removeCompletedFileDeletionBatches
+{
+	BOOL pruneNeeded = NO;
+	
+	OSSpinLockLock(&fileDeletionLock);
+	{
+		pruneNeeded = fileDeletionPruneNeeded;
+		fileDeletionPruneTimerSet = NO;
+	}
+	OSSpinLockUnlock(&fileDeletionLock);
+	
+	if (!pruneNeeded) return;
+	
+	YapDatabase *database = self.registeredDatabase;
+	NSString *registeredName = self.registeredName;
+	
+	if (database == nil || registeredName == nil) return;
+	
+	YapDatabaseConnection *connection = [database newConnection];
+	[connection asyncReadWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		id extTransaction = [transaction ext:registeredName];
+		if ([extTransaction isKindOfClass:[YapDatabaseRelationshipTransaction class]])
+		{
+			[(YapDatabaseRelationshipTransaction *)extTransaction removeCompletedFileDeletionBatches];
+		}
+	}];
+}
+
 @end
@@ -26,4 +26,26 @@
 **/
 @property (nonatomic, strong, readonly) YapDatabaseRelationship *relationship;
 
+/**
+ * The adjacencyCache speeds up repeated lookups of the edges attached to a particular node.
+ * That is, the following transaction methods:
+ *
+ * - edgeCountWithName:sourceKey:collection:
+ * - edgeCountWithName:destinationKey:collection:
+ * - enumerateEdgesWithName:sourceKey:collection:usingBlock:
+ * - enumerateEdgesWithName:destinationKey:collection:usingBlock:
+ *
+ * The first time one of these methods is invoked for a node, all of the node's edges (in that direction)
+ * are fetched from the database, and stored in the cache. Subsequent calls are answered from memory.
+ * The cache is kept up-to-date as other connections make changes, and is only used within read-only transactions.
+ *
+ * By default the adjacencyCache is disabled.
+ * When enabled, it has a default limit of 250 (nodes per direction).
+ *
+ * To enable the cache, set adjacencyCacheEnabled to YES.
+ * To use an inifinite cache size, set the adjacencyCacheLimit to ZERO.
+**/
+@property (atomic, assign, readwrite) BOOL adjacencyCacheEnabled;
+@property (atomic, assign, readwrite) NSUInteger adjacencyCacheLimit;
+
 @end
@@ -4,6 +4,7 @@
 #import "YapDatabasePrivate.h"
 #import "YapCollectionKey.h"
 #import "YapDatabaseString.h"
+#import "YapDatabaseStatement.h"
 #import "YapDatabaseLogging.h"
 
 #if ! __has_feature(objc_arc)
@@ -20,11 +21,16 @@
   static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 #endif
 
+static NSString *const changeset_key_adjacencyChanges = @"adjacencyChanges";
+static NSString *const changeset_key_adjacencyReset   = @"adjacencyReset";
+
 
 @implementation YapDatabaseRelationshipConnection
 {
 	sqlite3_stmt *findManualEdgeStatement;
 	sqlite3_stmt *insertEdgeStatement;
+	sqlite3_stmt *insertEdgesStatement;
+	NSUInteger insertEdgesStatementEdgeCount;
 	sqlite3_stmt *updateEdgeStatement;
 	sqlite3_stmt *deleteEdgeStatement;
 	sqlite3_stmt *deleteEdgesWithNodeStatement;
@@ -47,6 +53,18 @@
 	sqlite3_stmt *countForSrcDstNameStatement;
 	sqlite3_stmt *removeAllStatement;
 	sqlite3_stmt *removeAllProtocolStatement;
+	sqlite3_stmt *cascadeTableInsertStatement;
+	sqlite3_stmt *cascadeTableRemoveAllStatement;
+	sqlite3_stmt *cascadeAllSourcesDeletedStatement;
+	sqlite3_stmt *cascadeAllDestinationsDeletedStatement;
+	sqlite3_stmt *cascadeEnumerateForSrcStatement;
+	sqlite3_stmt *cascadeEnumerateForDstStatement;
+	sqlite3_stmt *cascadeDeleteEdgesStatement;
+	sqlite3_stmt *traversalTableInsertStatement;
+	sqlite3_stmt *traversalTableRemoveAllStatement;
+	sqlite3_stmt *traversalTableEnumerateDepthStatement;
+	
+	YapCache *traversalStatementCache; // key:(NSString *)queryString, value:(YapDatabaseStatement *)statement
 }
 
 @synthesize relationship = relationship;
@@ -57,6 +75,8 @@
 	{
 		relationship = inRelationship;
 		databaseConnection = inDbC;
+		
+		adjacencyCacheLimit = 250;
 	}
 	return self;
 }
@@ -70,6 +90,7 @@
 {
 	sqlite_finalize_null(&findManualEdgeStatement);
 	sqlite_finalize_null(&insertEdgeStatement);
+	sqlite_finalize_null(&insertEdgesStatement);
 	sqlite_finalize_null(&updateEdgeStatement);
 	sqlite_finalize_null(&deleteEdgeStatement);
 	sqlite_finalize_null(&deleteEdgesWithNodeStatement);
@@ -92,6 +113,18 @@
 	sqlite_finalize_null(&countForSrcDstNameStatement);
 	sqlite_finalize_null(&removeAllStatement);
 	sqlite_finalize_null(&removeAllProtocolStatement);
+	sqlite_finalize_null(&cascadeTableInsertStatement);
+	sqlite_finalize_null(&cascadeTableRemoveAllStatement);
+	sqlite_finalize_null(&cascadeAllSourcesDeletedStatement);
+	sqlite_finalize_null(&cascadeAllDestinationsDeletedStatement);
+	sqlite_finalize_null(&cascadeEnumerateForSrcStatement);
+	sqlite_finalize_null(&cascadeEnumerateForDstStatement);
+	sqlite_finalize_null(&cascadeDeleteEdgesStatement);
+	sqlite_finalize_null(&traversalTableInsertStatement);
+	sqlite_finalize_null(&traversalTableRemoveAllStatement);
+	sqlite_finalize_null(&traversalTableEnumerateDepthStatement);
+	
+	[traversalStatementCache removeAllObjects];
 }
 
 /**
@@ -99,6 +132,12 @@
 **/
 - (void)_flushMemoryWithFlags:(YapDatabaseConnectionFlushMemoryFlags)flags
 {
+	if (flags & YapDatabaseConnectionFlushMemoryFlags_Caches)
+	{
+		[sourceAdjacencyCache removeAllObjects];
+		[destinationAdjacencyCache removeAllObjects];
+	}
+	
 	if (flags & YapDatabaseConnectionFlushMemoryFlags_Statements)
 	{
 		[self _flushStatements];
@@ -117,6 +156,86 @@
 	return relationship;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Configuration
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (BOOL)adjacencyCacheEnabled
+{
+	__block BOOL result = NO;
+	
+	dispatch_block_t block = ^{
+		
+		result = (sourceAdjacencyCache == nil) ? NO : YES;
+	};
+	
+	if (dispatch_get_specific(databaseConnection->IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_sync(databaseConnection->connectionQueue, block);
+	
+	return result;
+}
+
+- (void)setAdjacencyCacheEnabled:(BOOL)adjacencyCacheEnabled
+{
+	dispatch_block_t block = ^{
+		
+		if (adjacencyCacheEnabled)
+		{
+			if (sourceAdjacencyCache == nil)
+				sourceAdjacencyCache =
+				  [[YapCache alloc] initWithKeyClass:[NSNumber class] countLimit:adjacencyCacheLimit];
+			
+			if (destinationAdjacencyCache == nil)
+				destinationAdjacencyCache =
+				  [[YapCache alloc] initWithKeyClass:[NSNumber class] countLimit:adjacencyCacheLimit];
+		}
+		else
+		{
+			sourceAdjacencyCache = nil;
+			destinationAdjacencyCache = nil;
+		}
+	};
+	
+	if (dispatch_get_specific(databaseConnection->IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_async(databaseConnection->connectionQueue, block);
+}
+
+- (NSUInteger)adjacencyCacheLimit
+{
+	__block NSUInteger result = 0;
+	
+	dispatch_block_t block = ^{
+		
+		result = adjacencyCacheLimit;
+	};
+	
+	if (dispatch_get_specific(databaseConnection->IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_sync(databaseConnection->connectionQueue, block);
+	
+	return result;
+}
+
+- (void)setAdjacencyCacheLimit:(NSUInteger)newAdjacencyCacheLimit
+{
+	dispatch_block_t block = ^{
+		
+		adjacencyCacheLimit = newAdjacencyCacheLimit;
+		sourceAdjacencyCache.countLimit = adjacencyCacheLimit;
+		destinationAdjacencyCache.countLimit = adjacencyCacheLimit;
+	};
+	
+	if (dispatch_get_specific(databaseConnection->IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_async(databaseConnection->connectionQueue, block);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Transactions
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -167,6 +286,8 @@
 		deletedInfo = [[NSMutableDictionary alloc] init];
 	if (filesToDelete == nil)
 		filesToDelete = [[NSMutableSet alloc] init];
+	if (adjacencyChanges == nil)
+		adjacencyChanges = [[NSMutableSet alloc] init];
 }
 
 /**
@@ -186,6 +307,16 @@
 	// we can avoid a copy of this object.
 	if ([filesToDelete count] > 0)
 		filesToDelete = nil;
+	
+	// Our own adjacencyCache needs the same treatment as everyone else's.
+	// Note: adjacencyChanges was handed to the internalChangeset, so we need a completely new version of it.
+	
+	[self removeAdjacencyForRowids:adjacencyChanges reset:adjacencyReset];
+	
+	if ([adjacencyChanges count] > 0)
+		adjacencyChanges = nil;
+	
+	adjacencyReset = NO;
 }
 
 /**
@@ -201,6 +332,9 @@
 	[deletedOrder removeAllObjects];
 	[deletedInfo removeAllObjects];
 	[filesToDelete removeAllObjects];
+	[adjacencyChanges removeAllObjects];
+	
+	adjacencyReset = NO;
 }
 
 - (void)getInternalChangeset:(NSMutableDictionary **)internalChangesetPtr
@@ -214,6 +348,24 @@
 	BOOL hasDiskChanges = NO;
 	
 	// In the future we may want to store a changeset that specifies which edges were added & removed.
+	// For now we only broadcast which nodes had their edges modified,
+	// so other connections can update their adjacencyCache.
+	
+	if ([adjacencyChanges count] > 0 || adjacencyReset)
+	{
+		internalChangeset = [NSMutableDictionary dictionaryWithCapacity:2];
+		
+		if ([adjacencyChanges count] > 0)
+		{
+			internalChangeset[changeset_key_adjacencyChanges] = adjacencyChanges;
+		}
+		if (adjacencyReset)
+		{
+			internalChangeset[changeset_key_adjacencyReset] = @(adjacencyReset);
+		}
+		
+		hasDiskChanges = YES;
+	}
 	
 	*internalChangesetPtr = internalChangeset;
 	*externalChangesetPtr = externalChangeset;
@@ -222,8 +374,55 @@
 
 - (void)processChangeset:(NSDictionary *)changeset
 {
-	// Nothing to do here.
-	// This method is required to be overriden by YapDatabaseExtensionConnection.
+	YDBLogAutoTrace();
+	
+	NSSet *changeset_adjacencyChanges = changeset[changeset_key_adjacencyChanges];
+	BOOL changeset_adjacencyReset = [changeset[changeset_key_adjacencyReset] boolValue];
+	
+	[self removeAdjacencyForRowids:changeset_adjacencyChanges reset:changeset_adjacencyReset];
+}
+
+/**
+ * Removes the cached adjacency (in both directions) for each of the given nodes.
+ * If reset is YES, the adjacencyCache is cleared entirely.
+**/
+- (void)removeAdjacencyForRowids:(NSSet *)rowids reset:(BOOL)reset
+{
+	if (reset)
+	{
+		[sourceAdjacencyCache removeAllObjects];
+		[destinationAdjacencyCache removeAllObjects];
+		return;
+	}
+	
+	[self removeAdjacencyForRowids:rowids fromCache:sourceAdjacencyCache];
+	[self removeAdjacencyForRowids:rowids fromCache:destinationAdjacencyCache];
+}
+
+- (void)removeAdjacencyForRowids:(NSSet *)rowids fromCache:(YapCache *)cache
+{
+	if ([rowids count] == 0) return;
+	if ([cache count] == 0) return;
+	
+	if ([rowids count] <= [cache count])
+	{
+		[cache removeObjectsForKeys:[rowids allObjects]];
+	}
+	else
+	{
+		// The changeset is bigger than the cache.
+		// So it's faster to check each cached key against the changeset.
+		
+		NSMutableArray *keysToRemove = [NSMutableArray arrayWithCapacity:[cache count]];
+		
+		[cache enumerateKeysWithBlock:^(id key, BOOL *stop) {
+			
+			if ([rowids containsObject:key])
+				[keysToRemove addObject:key];
+		}];
+		
+		[cache removeObjectsForKeys:keysToRemove];
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -281,6 +480,57 @@
 	return *statement;
 }
 
+/**
+ * Multi-row variant of the insertEdgeStatement (used when populating the table).
+ *
+ * The number of rows is fixed (so the statement can be cached),
+ * and is capped by the max number of host parameters allowed by sqlite (5 parameters per row).
+ *
+ * INSERT INTO "tableName" ("name", "src", "dst", "rules", "manual") VALUES (?, ?, ?, ?, ?), (?, ?, ?, ?, ?), ...;
+**/
+- (sqlite3_stmt *)insertEdgesStatement:(NSUInteger *)edgeCountPtr
+{
+	sqlite3_stmt **statement = &insertEdgesStatement;
+	if (*statement == NULL)
+	{
+		sqlite3 *db = databaseConnection->db;
+		
+		NSUInteger maxHostParams = (NSUInteger) sqlite3_limit(db, SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+		NSUInteger edgeCount = MIN((NSUInteger)100, (maxHostParams / 5));
+		
+		NSMutableString *string = [NSMutableString stringWithCapacity:(100 + (edgeCount * 17))];
+		[string appendFormat:
+		  @"INSERT INTO \"%@\" (\"name\", \"src\", \"dst\", \"rules\", \"manual\") VALUES", [relationship tableName]];
+		
+		for (NSUInteger i = 0; i < edgeCount; i++)
+		{
+			if (i == 0)
+				[string appendString:@" (?, ?, ?, ?, ?)"];
+			else
+				[string appendString:@", (?, ?, ?, ?, ?)"];
+		}
+		
+		[string appendString:@";"];
+		
+		YapDatabaseString stmt; MakeYapDatabaseString(&stmt, string);
+		
+		int status = sqlite3_prepare_v2(db, stmt.str, stmt.length+1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+		else
+		{
+			insertEdgesStatementEdgeCount = edgeCount;
+		}
+		
+		FreeYapDatabaseString(&stmt);
+	}
+	
+	if (edgeCountPtr) *edgeCountPtr = insertEdgesStatementEdgeCount;
+	return *statement;
+}
+
 - (sqlite3_stmt *)updateEdgeStatement
 {
 	sqlite3_stmt **statement = &updateEdgeStatement;
@@ -823,4 +1073,552 @@
 	return *statement;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Cascade Table
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * When a large number of nodes are deleted (e.g. a folder with all its children),
+ * the flush processes them in rounds rather than one at a time.
+ * The rowids of the nodes in the current round are inserted into a temporary table (private to this connection),
+ * and the edge table is then queried against the whole round at once (see the statements below).
+**/
+- (NSString *)cascadeTableName
+{
+	return [NSString stringWithFormat:@"%@_cascade", [relationship tableName]];
+}
+
+/**
+ * Note: This method is invoked (once) before every round of batch cascade processing.
+ * We don't remember whether the table was created, because the creation of a temp table is undone
+ * if the encompassing transaction is rolled back.
+**/
+- (BOOL)createCascadeTableIfNeeded
+{
+	// CREATE TEMP TABLE IF NOT EXISTS "tableName_cascade" ("rowid" INTEGER PRIMARY KEY);
+	
+	NSString *string = [NSString stringWithFormat:
+	  @"CREATE TEMP TABLE IF NOT EXISTS \"%@\" (\"rowid\" INTEGER PRIMARY KEY);", [self cascadeTableName]];
+	
+	sqlite3 *db = databaseConnection->db;
+	
+	int status = sqlite3_exec(db, [string UTF8String], NULL, NULL, NULL);
+	if (status != SQLITE_OK)
+	{
+		YDBLogError(@"%@ - Failed creating cascade table (%@): %d %s",
+		            THIS_METHOD, [self cascadeTableName], status, sqlite3_errmsg(db));
+		return NO;
+	}
+	
+	return YES;
+}
+
+- (sqlite3_stmt *)cascadeTableInsertStatement
+{
+	sqlite3_stmt **statement = &cascadeTableInsertStatement;
+	if (*statement == NULL)
+	{
+		NSString *string = [NSString stringWithFormat:
+		  @"INSERT OR IGNORE INTO temp.\"%@\" (\"rowid\") VALUES (?);", [self cascadeTableName]];
+		
+		sqlite3 *db = databaseConnection->db;
+		YapDatabaseString stmt; MakeYapDatabaseString(&stmt, string);
+		
+		int status = sqlite3_prepare_v2(db, stmt.str, stmt.length+1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+		
+		FreeYapDatabaseString(&stmt);
+	}
+	
+	return *statement;
+}
+
+- (sqlite3_stmt *)cascadeTableRemoveAllStatement
+{
+	sqlite3_stmt **statement = &cascadeTableRemoveAllStatement;
+	if (*statement == NULL)
+	{
+		NSString *string = [NSString stringWithFormat:@"DELETE FROM temp.\"%@\";", [self cascadeTableName]];
+		
+		sqlite3 *db = databaseConnection->db;
+		YapDatabaseString stmt; MakeYapDatabaseString(&stmt, string);
+		
+		int status = sqlite3_prepare_v2(db, stmt.str, stmt.length+1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+		
+		FreeYapDatabaseString(&stmt);
+	}
+	
+	return *statement;
+}
+
+/**
+ * Returns every (dst, name) group that has lost all of its sources in this round,
+ * where at least one of the deleted sources had the given rule (?1) set.
+ * That is, the destination has no remaining edges with the same name pointing to it.
+**/
+- (sqlite3_stmt *)cascadeAllSourcesDeletedStatement
+{
+	sqlite3_stmt **statement = &cascadeAllSourcesDeletedStatement;
+	if (*statement == NULL)
+	{
+		NSString *string = [NSString stringWithFormat:
+		  @"SELECT \"dst\", \"name\" FROM \"%1$@\" WHERE \"dst\" IN"
+		  @" (SELECT \"dst\" FROM \"%1$@\" WHERE \"src\" IN (SELECT \"rowid\" FROM temp.\"%2$@\") AND (\"rules\" & ?1) != 0)"
+		  @" GROUP BY \"dst\", \"name\""
+		  @" HAVING SUM(\"src\" NOT IN (SELECT \"rowid\" FROM temp.\"%2$@\")) = 0"
+		  @" AND SUM(\"src\" IN (SELECT \"rowid\" FROM temp.\"%2$@\") AND (\"rules\" & ?1) != 0) > 0;",
+		  [relationship tableName], [self cascadeTableName]];
+		
+		sqlite3 *db = databaseConnection->db;
+		YapDatabaseString stmt; MakeYapDatabaseString(&stmt, string);
+		
+		int status = sqlite3_prepare_v2(db, stmt.str, stmt.length+1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+		
+		FreeYapDatabaseString(&stmt);
+	}
+	
+	return *statement;
+}
+
+/**
+ * Returns every (src, name) group that has lost all of its destinations in this round,
+ * where at least one of the deleted destinations had the given rule (?1) set.
+**/
+- (sqlite3_stmt *)cascadeAllDestinationsDeletedStatement
+{
+	sqlite3_stmt **statement = &cascadeAllDestinationsDeletedStatement;
+	if (*statement == NULL)
+	{
+		NSString *string = [NSString stringWithFormat:
+		  @"SELECT \"src\", \"name\" FROM \"%1$@\" WHERE \"src\" IN"
+		  @" (SELECT \"src\" FROM \"%1$@\" WHERE \"dst\" IN (SELECT \"rowid\" FROM temp.\"%2$@\") AND (\"rules\" & ?1) != 0)"
+		  @" GROUP BY \"src\", \"name\""
+		  @" HAVING SUM(\"dst\" NOT IN (SELECT \"rowid\" FROM temp.\"%2$@\")) = 0"
+		  @" AND SUM(\"dst\" IN (SELECT \"rowid\" FROM temp.\"%2$@\") AND (\"rules\" & ?1) != 0) > 0;",
+		  [relationship tableName], [self cascadeTableName]];
+		
+		sqlite3 *db = databaseConnection->db;
+		YapDatabaseString stmt; MakeYapDatabaseString(&stmt, string);
+		
+		int status = sqlite3_prepare_v2(db, stmt.str, stmt.length+1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+		
+		FreeYapDatabaseString(&stmt);
+	}
+	
+	return *statement;
+}
+
+/**
+ * Enumerates the edges whose source is in this round, filtered by: ("rules" & ?1) = ?2
+**/
+- (sqlite3_stmt *)cascadeEnumerateForSrcStatement
+{
+	sqlite3_stmt **statement = &cascadeEnumerateForSrcStatement;
+	if (*statement == NULL)
+	{
+		NSString *string = [NSString stringWithFormat:
+		  @"SELECT \"name\", \"src\", \"dst\", \"rules\" FROM \"%@\""
+		  @" WHERE \"src\" IN (SELECT \"rowid\" FROM temp.\"%@\") AND (\"rules\" & ?1) = ?2;",
+		  [relationship tableName], [self cascadeTableName]];
+		
+		sqlite3 *db = databaseConnection->db;
+		YapDatabaseString stmt; MakeYapDatabaseString(&stmt, string);
+		
+		int status = sqlite3_prepare_v2(db, stmt.str, stmt.length+1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+		
+		FreeYapDatabaseString(&stmt);
+	}
+	
+	return *statement;
+}
+
+/**
+ * Enumerates the edges whose destination is in this round, filtered by: ("rules" & ?1) = ?2
+**/
+- (sqlite3_stmt *)cascadeEnumerateForDstStatement
+{
+	sqlite3_stmt **statement = &cascadeEnumerateForDstStatement;
+	if (*statement == NULL)
+	{
+		NSString *string = [NSString stringWithFormat:
+		  @"SELECT \"name\", \"src\", \"dst\", \"rules\" FROM \"%@\""
+		  @" WHERE \"dst\" IN (SELECT \"rowid\" FROM temp.\"%@\") AND (\"rules\" & ?1) = ?2;",
+		  [relationship tableName], [self cascadeTableName]];
+		
+		sqlite3 *db = databaseConnection->db;
+		YapDatabaseString stmt; MakeYapDatabaseString(&stmt, string);
+		
+		int status = sqlite3_prepare_v2(db, stmt.str, stmt.length+1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+		
+		FreeYapDatabaseString(&stmt);
+	}
+	
+	return *statement;
+}
+
+- (sqlite3_stmt *)cascadeDeleteEdgesStatement
+{
+	sqlite3_stmt **statement = &cascadeDeleteEdgesStatement;
+	if (*statement == NULL)
+	{
+		NSString *string = [NSString stringWithFormat:
+		  @"DELETE FROM \"%1$@\" WHERE \"src\" IN (SELECT \"rowid\" FROM temp.\"%2$@\")"
+		  @" OR \"dst\" IN (SELECT \"rowid\" FROM temp.\"%2$@\");",
+		  [relationship tableName], [self cascadeTableName]];
+		
+		sqlite3 *db = databaseConnection->db;
+		YapDatabaseString stmt; MakeYapDatabaseString(&stmt, string);
+		
+		int status = sqlite3_prepare_v2(db, stmt.str, stmt.length+1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+		
+		FreeYapDatabaseString(&stmt);
+	}
+	
+	return *statement;
+}
+
+/**
+ * Multi-hop traversals keep track of every node they've reached in a temporary table (private to this connection).
+ * The table maps each node to the depth at which it was first reached.
+ * 
+ * A breadth first traversal expands the graph one level at a time,
+ * with a single statement that joins the previous level against the edge table (see traversalExpandStatement).
+ * Since a node can only be inserted into the table once, each node is expanded at most once,
+ * no matter how many paths lead to it.
+**/
+- (NSString *)traversalTableName
+{
+	return [NSString stringWithFormat:@"%@_traversal", [relationship tableName]];
+}
+
+/**
+ * Note: This method is invoked (once) before every traversal.
+ * We don't remember whether the table was created, because the creation of a temp table is undone
+ * if the encompassing transaction is rolled back.
+**/
+- (BOOL)createTraversalTableIfNeeded
+{
+	// CREATE TEMP TABLE IF NOT EXISTS "tableName_traversal" ("rowid" INTEGER PRIMARY KEY, "depth" INTEGER);
+	// CREATE INDEX IF NOT EXISTS temp."tableName_traversal_depth" ON "tableName_traversal" ("depth");
+	
+	NSString *string = [NSString stringWithFormat:
+	  @"CREATE TEMP TABLE IF NOT EXISTS \"%1$@\" (\"rowid\" INTEGER PRIMARY KEY, \"depth\" INTEGER NOT NULL);"
+	  @" CREATE INDEX IF NOT EXISTS temp.\"%1$@_depth\" ON \"%1$@\" (\"depth\");", [self traversalTableName]];
+	
+	sqlite3 *db = databaseConnection->db;
+	
+	int status = sqlite3_exec(db, [string UTF8String], NULL, NULL, NULL);
+	if (status != SQLITE_OK)
+	{
+		YDBLogError(@"%@ - Failed creating traversal table (%@): %d %s",
+		            THIS_METHOD, [self traversalTableName], status, sqlite3_errmsg(db));
+		return NO;
+	}
+	
+	return YES;
+}
+
+- (sqlite3_stmt *)traversalTableInsertStatement
+{
+	sqlite3_stmt **statement = &traversalTableInsertStatement;
+	if (*statement == NULL)
+	{
+		NSString *string = [NSString stringWithFormat:
+		  @"INSERT OR IGNORE INTO temp.\"%@\" (\"rowid\", \"depth\") VALUES (?, ?);", [self traversalTableName]];
+		
+		sqlite3 *db = databaseConnection->db;
+		YapDatabaseString stmt; MakeYapDatabaseString(&stmt, string);
+		
+		int status = sqlite3_prepare_v2(db, stmt.str, stmt.length+1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+		
+		FreeYapDatabaseString(&stmt);
+	}
+	
+	return *statement;
+}
+
+- (sqlite3_stmt *)traversalTableRemoveAllStatement
+{
+	sqlite3_stmt **statement = &traversalTableRemoveAllStatement;
+	if (*statement == NULL)
+	{
+		NSString *string = [NSString stringWithFormat:@"DELETE FROM temp.\"%@\";", [self traversalTableName]];
+		
+		sqlite3 *db = databaseConnection->db;
+		YapDatabaseString stmt; MakeYapDatabaseString(&stmt, string);
+		
+		int status = sqlite3_prepare_v2(db, stmt.str, stmt.length+1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+		
+		FreeYapDatabaseString(&stmt);
+	}
+	
+	return *statement;
+}
+
+/**
+ * Returns the nodes that were first reached at the given depth (?1).
+**/
+- (sqlite3_stmt *)traversalTableEnumerateDepthStatement
+{
+	sqlite3_stmt **statement = &traversalTableEnumerateDepthStatement;
+	if (*statement == NULL)
+	{
+		NSString *string = [NSString stringWithFormat:
+		  @"SELECT \"rowid\" FROM temp.\"%@\" WHERE \"depth\" = ?;", [self traversalTableName]];
+		
+		sqlite3 *db = databaseConnection->db;
+		YapDatabaseString stmt; MakeYapDatabaseString(&stmt, string);
+		
+		int status = sqlite3_prepare_v2(db, stmt.str, stmt.length+1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+		
+		FreeYapDatabaseString(&stmt);
+	}
+	
+	return *statement;
+}
+
+/**
+ * Returns the (cached) statement for the given traversal query,
+ * preparing it if needed.
+**/
+- (sqlite3_stmt *)traversalStatementWithString:(NSString *)string
+{
+	YapDatabaseStatement *wrapper = [traversalStatementCache objectForKey:string];
+	if (wrapper)
+	{
+		return wrapper.stmt;
+	}
+	
+	sqlite3 *db = databaseConnection->db;
+	sqlite3_stmt *statement = NULL;
+	
+	YapDatabaseString stmt; MakeYapDatabaseString(&stmt, string);
+	
+	int status = sqlite3_prepare_v2(db, stmt.str, stmt.length+1, &statement, NULL);
+	if (status != SQLITE_OK)
+	{
+		YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+	}
+	
+	FreeYapDatabaseString(&stmt);
+	
+	if (statement)
+	{
+		if (traversalStatementCache == nil)
+			traversalStatementCache = [[YapCache alloc] initWithKeyClass:[NSString class] countLimit:8];
+		
+		[traversalStatementCache setObject:[[YapDatabaseStatement alloc] initWithStatement:statement] forKey:string];
+	}
+	
+	return statement;
+}
+
+- (void)appendEdgeNameCount:(NSUInteger)edgeNameCount toTraversalString:(NSMutableString *)string
+{
+	if (edgeNameCount > 0)
+	{
+		[string appendString:@" AND \"e\".\"name\" IN (?"];
+		for (NSUInteger i = 1; i < edgeNameCount; i++)
+		{
+			[string appendString:@", ?"];
+		}
+		[string appendString:@")"];
+	}
+}
+
+/**
+ * Inserts (into the traversal table) every node one hop away from the nodes at depth ?1,
+ * that hasn't already been reached. The new nodes are inserted with depth ?1 + 1.
+ * Only edges that point at a node (not a file) are followed.
+ * 
+ * The number of newly reached nodes is available via sqlite3_changes().
+ * 
+ * Binding:
+ * ?1 : depth
+ * ?2 ... ?(edgeNameCount + 1) : edge names (if edgeNameCount > 0)
+**/
+- (sqlite3_stmt *)traversalExpandStatementWithEdgeNameCount:(NSUInteger)edgeNameCount incoming:(BOOL)incoming
+{
+	NSString *near = incoming ? @"dst" : @"src";
+	NSString *far  = incoming ? @"src" : @"dst";
+	
+	NSMutableString *string = [NSMutableString stringWithCapacity:256];
+	
+	[string appendFormat:@"INSERT OR IGNORE INTO temp.\"%@\" (\"rowid\", \"depth\")", [self traversalTableName]];
+	[string appendFormat:@" SELECT \"e\".\"%@\", ?1 + 1", far];
+	[string appendFormat:@" FROM temp.\"%@\" AS \"t\" JOIN \"%@\" AS \"e\" ON \"e\".\"%@\" = \"t\".\"rowid\"",
+	                                                          [self traversalTableName], [relationship tableName], near];
+	[string appendFormat:@" WHERE \"t\".\"depth\" = ?1 AND typeof(\"e\".\"%@\") = 'integer'", far];
+	
+	[self appendEdgeNameCount:edgeNameCount toTraversalString:string];
+	[string appendString:@";"];
+	
+	return [self traversalStatementWithString:string];
+}
+
+/**
+ * Returns the nodes one hop away from the node bound to ?1.
+ * Only edges that point at a node (not a file) are followed.
+ * 
+ * This is used by depth first traversals, which expand one node at a time.
+ * 
+ * Binding:
+ * ?1 : rowid
+ * ?2 ... ?(edgeNameCount + 1) : edge names (if edgeNameCount > 0)
+**/
+- (sqlite3_stmt *)traversalNeighborsStatementWithEdgeNameCount:(NSUInteger)edgeNameCount incoming:(BOOL)incoming
+{
+	NSString *near = incoming ? @"dst" : @"src";
+	NSString *far  = incoming ? @"src" : @"dst";
+	
+	NSMutableString *string = [NSMutableString stringWithCapacity:128];
+	
+	[string appendFormat:@"SELECT \"e\".\"%@\" FROM \"%@\" AS \"e\"", far, [relationship tableName]];
+	[string appendFormat:@" WHERE \"e\".\"%@\" = ?1 AND typeof(\"e\".\"%@\") = 'integer'", near, far];
+	
+	[self appendEdgeNameCount:edgeNameCount toTraversalString:string];
+	[string appendString:@";"];
+	
+	return [self traversalStatementWithString:string];
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@implementation YapDatabaseRelationshipAdjacency
+{
+	NSUInteger capacity;
+}
+
+- (void)dealloc
+{
+	if (items) {
+		free(items);
+	}
+}
+
+- (void)addEdgeWithRowid:(int64_t)edgeRowid
+                    name:(NSString *)name
+               nodeRowid:(int64_t)nodeRowid
+                filePath:(NSString *)filePath
+                   rules:(int)rules
+                  manual:(BOOL)manual
+{
+	if (count == capacity)
+	{
+		capacity = (capacity == 0) ? 4 : (capacity * 2);
+		items = reallocf(items, capacity * sizeof(YapDatabaseRelationshipAdjacencyItem));
+	}
+	
+	NSUInteger nameIndex = [self indexOfName:name];
+	if (nameIndex == NSNotFound)
+	{
+		if (names == nil)
+			names = [[NSMutableArray alloc] initWithCapacity:1];
+		
+		nameIndex = [names count];
+		[names addObject:name];
+	}
+	
+	YapDatabaseRelationshipAdjacencyItem *item = &items[count];
+	
+	item->edgeRowid = edgeRowid;
+	item->nameIndex = nameIndex;
+	item->rules = rules;
+	item->manual = manual;
+	
+	if (filePath)
+	{
+		if (filePaths == nil)
+			filePaths = [[NSMutableArray alloc] initWithCapacity:1];
+		
+		item->nodeRowid = (int64_t)[filePaths count];
+		item->isFilePath = YES;
+		
+		[filePaths addObject:filePath];
+	}
+	else
+	{
+		item->nodeRowid = nodeRowid;
+		item->isFilePath = NO;
+	}
+	
+	count++;
+}
+
+- (NSUInteger)indexOfName:(NSString *)name
+{
+	// Most nodes only have edges with a handful of different names.
+	
+	NSUInteger index = 0;
+	for (NSString *existingName in names)
+	{
+		if ([existingName isEqualToString:name])
+			return index;
+		
+		index++;
+	}
+	
+	return NSNotFound;
+}
+
+- (NSUInteger)countWithName:(NSString *)name
+{
+	if (name == nil) return count;
+	
+	NSUInteger nameIndex = [self indexOfName:name];
+	if (nameIndex == NSNotFound) return 0;
+	
+	NSUInteger result = 0;
+	for (NSUInteger i = 0; i < count; i++)
+	{
+		if (items[i].nameIndex == nameIndex)
+			result++;
+	}
+	
+	return result;
+}
+
 @end
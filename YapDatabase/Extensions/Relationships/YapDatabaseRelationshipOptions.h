@@ -78,5 +78,32 @@ typedef id (^YapDatabaseRelationshipFilePathDecryptor)(NSData *data);
 @property (nonatomic, strong, readwrite) YapDatabaseRelationshipFilePathEncryptor destinationFilePathEncryptor;
 @property (nonatomic, strong, readwrite) YapDatabaseRelationshipFilePathDecryptor destinationFilePathDecryptor;
 
+/**
+ * When edges with a destinationFilePath cause the file to be deleted (via nodeDeleteRules),
+ * the file is deleted in the background after the transaction has been committed.
+ *
+ * The pending file paths are also recorded in the database (within the same transaction).
+ * So if the app is terminated before all the files have been deleted,
+ * the remainder are deleted the next time the extension is registered.
+ * (File paths are recorded using the destinationFilePathEncryptor, if set.)
+ *
+ * Deleting a large number of files at once can cause a burst of disk I/O,
+ * which in turn can hurt the latency of foreground database operations.
+ * The following options allow you to throttle the background deletion.
+ *
+ * fileDeletionMaxConcurrentOperations:
+ *   The maximum number of files that may be deleted simultaneously.
+ *   The default value is 1.
+ *
+ * fileDeletionMaxBytesPerSecond:
+ *   The (approximate) maximum number of bytes to delete per second.
+ *   The size of each file is checked before it's deleted, and the deletion is delayed as needed.
+ *   The default value is 0 (no limit).
+ *
+ * The progress of the background deletion can be monitored via YapDatabaseRelationship's fileDeletion properties.
+**/
+@property (nonatomic, assign, readwrite) NSUInteger fileDeletionMaxConcurrentOperations;
+@property (nonatomic, assign, readwrite) uint64_t fileDeletionMaxBytesPerSecond;
+
 
 @end
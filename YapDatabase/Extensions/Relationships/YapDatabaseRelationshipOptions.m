@@ -8,6 +8,8 @@
 @synthesize allowedCollections = allowedCollections;
 @synthesize destinationFilePathEncryptor;
 @synthesize destinationFilePathDecryptor;
+@synthesize fileDeletionMaxConcurrentOperations = fileDeletionMaxConcurrentOperations;
+@synthesize fileDeletionMaxBytesPerSecond = fileDeletionMaxBytesPerSecond;
 
 - (id)init
 {
@@ -15,6 +17,8 @@
 	{
 		disableYapDatabaseRelationshipNodeProtocol = NO;
 		allowedCollections = nil;
+		fileDeletionMaxConcurrentOperations = 1;
+		fileDeletionMaxBytesPerSecond = 0;
 	}
 	return self;
 }
@@ -24,6 +28,8 @@
 	YapDatabaseRelationshipOptions *copy = [[YapDatabaseRelationshipOptions alloc] init];
 	copy->disableYapDatabaseRelationshipNodeProtocol = disableYapDatabaseRelationshipNodeProtocol;
 	copy->allowedCollections = allowedCollections;
+	copy->fileDeletionMaxConcurrentOperations = fileDeletionMaxConcurrentOperations;
+	copy->fileDeletionMaxBytesPerSecond = fileDeletionMaxBytesPerSecond;
 	
 	if (destinationFilePathEncryptor && destinationFilePathDecryptor)
 	{
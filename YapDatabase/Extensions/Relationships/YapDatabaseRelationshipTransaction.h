@@ -20,6 +20,28 @@
  * https://github.com/yaptv/YapDatabase/wiki/Relationships
 **/
 
+/**
+ * The order in which a traversal visits the nodes it reaches.
+ *
+ * Breadth first visits every node at depth 1, then every node at depth 2, etc.
+ * Depth first follows each path as far as it goes before backing up.
+**/
+typedef NS_ENUM(NSInteger, YapDatabaseRelationshipTraversalOrder) {
+	YapDatabaseRelationshipTraversalBreadthFirst = 0,
+	YapDatabaseRelationshipTraversalDepthFirst   = 1,
+};
+
+/**
+ * The direction in which a traversal follows edges.
+ *
+ * Outgoing follows edges from their source to their destination.
+ * Incoming follows edges from their destination back to their source.
+**/
+typedef NS_ENUM(NSInteger, YapDatabaseRelationshipTraversalDirection) {
+	YapDatabaseRelationshipTraversalOutgoing = 0,
+	YapDatabaseRelationshipTraversalIncoming = 1,
+};
+
 @interface YapDatabaseRelationshipTransaction : YapDatabaseExtensionTransaction
 
 #pragma mark Node Fetch
@@ -334,6 +356,70 @@
                      collection:(NSString *)sourceCollection
             destinationFilePath:(NSString *)destinationFilePath;
 
+#pragma mark Traverse
+
+/**
+ * Enumerates every node reachable from the given node, by following edges across any number of hops.
+ * 
+ * A breadth first traversal is performed by the database one level at a time (a single query per level),
+ * rather than by issuing one query per node.
+ * 
+ * Each node is visited at most once, and the starting node itself is never visited.
+ * Cycles in the graph are detected, and are not followed.
+ * Edges with a destinationFilePath are not followed.
+ * 
+ * @param key
+ *   The key of the node to start from.
+ * 
+ * @param collection
+ *   The collection of the node to start from.
+ *   If nil, the collection is treated as the empty string, just like the rest of the YapDatabase framework.
+ * 
+ * @param edgeNames (optional)
+ *   If given, only edges with one of these names (case sensitive) are followed.
+ *   If nil, every edge is followed.
+ * 
+ * @param direction
+ *   Whether to follow edges from source to destination (outgoing), or from destination to source (incoming).
+ * 
+ * @param order
+ *   Breadth first or depth first.
+ *   With breadth first, the depth passed to the block is the length of the shortest path to the node.
+ * 
+ * @param maxDepth
+ *   The maximum number of hops to take from the starting node.
+ *   Pass zero for no limit.
+ * 
+ * Each node is expanded (its edges followed) only once, no matter how many paths lead to it.
+ * So the cost of a traversal is proportional to the number of nodes & edges it reaches.
+ * (With depth first and a maxDepth, a node may be expanded again if it's later reached along a shorter path.)
+ * 
+ * Within a read-write transaction, if there are edge changes that haven't yet been processed,
+ * the traversal is performed hop by hop (with the regular enumeration methods) so those changes are included.
+**/
+- (void)enumerateNodesReachableFromKey:(NSString *)key
+                          inCollection:(NSString *)collection
+                         withEdgeNames:(NSArray *)edgeNames
+                             direction:(YapDatabaseRelationshipTraversalDirection)direction
+                                 order:(YapDatabaseRelationshipTraversalOrder)order
+                              maxDepth:(NSUInteger)maxDepth
+                            usingBlock:(void (^)(NSString *collection, NSString *key, NSUInteger depth, BOOL *stop))block;
+
+/**
+ * Returns the number of distinct nodes reachable from the given node,
+ * by following edges across any number of hops (up to maxDepth, or unlimited if maxDepth is zero).
+ * 
+ * The starting node itself is not counted.
+ * 
+ * See enumerateNodesReachableFromKey:inCollection:withEdgeNames:direction:order:maxDepth:usingBlock:
+ * for a discussion of the parameters.
+**/
+- (NSUInteger)nodeCountReachableFromKey:(NSString *)key
+                           inCollection:(NSString *)collection
+                          withEdgeNames:(NSArray *)edgeNames
+                              direction:(YapDatabaseRelationshipTraversalDirection)direction
+                               maxDepth:(NSUInteger)maxDepth;
+
 @end
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
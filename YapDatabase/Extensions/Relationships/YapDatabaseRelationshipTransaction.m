@@ -4,6 +4,7 @@
 #import "YapDatabasePrivate.h"
 #import "YapCollectionKey.h"
 #import "YapDatabaseString.h"
+#import "YapRowidSet.h"
 #import "YapDatabaseLogging.h"
 #import "NSDictionary+YapDatabase.h"
 
@@ -25,6 +26,22 @@ static NSString *const ExtKey_classVersion       = @"classVersion";
 static NSString *const ExtKey_versionTag         = @"versionTag";
 static NSString *const ExtKey_version_deprecated = @"version";
 
+static NSString *const ExtKey_fileDeletionFirstBatch  = @"fileDeletionFirstBatch";
+static NSString *const ExtKey_fileDeletionNextBatch   = @"fileDeletionNextBatch";
+static NSString *const ExtKey_fileDeletionBatchPrefix = @"fileDeletionBatch_";
+
+/**
+ * Once the number of deleted nodes pending processing (within flush) reaches this threshold,
+ * the nodes are processed together, one set-based round at a time (see processDeletedNodesInBatch:).
+**/
+static NSUInteger const YDBRelationshipCascadeBatchThreshold = 32;
+
+/**
+ * When populating the table, the protocol edges are collected & inserted in chunks of (at least) this many edges.
+ * (See populateEdgeLists:)
+**/
+static NSUInteger const YDBRelationshipPopulateChunkSize = 5000;
+
 
 NS_INLINE BOOL EdgeMatchesType(YapDatabaseRelationshipEdge *edge, BOOL isManualEdge)
 {
@@ -159,6 +176,10 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 		}
 	}
 	
+	// Resume deleting any files that were pending when the app was last terminated
+	
+	[self resumePendingFileDeletions];
+	
 	return YES;
 }
 
@@ -284,6 +305,16 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	}
 	
 	// Enumerate the existing rows in the database and populate the view
+	//
+	// Performance tuning:
+	//
+	// The edges are collected in chunks (see YDBRelationshipPopulateChunkSize),
+	// and each chunk is inserted via populateEdgeLists:, which resolves all the destination rowids
+	// with a query per collection, and inserts the edges with a multi-row statement.
+	// This is much faster than going through flush, which processes each node individually.
+	
+	NSMutableArray *pendingEdgeLists = [NSMutableArray array];
+	__block NSUInteger pendingEdgeCount = 0;
 	
 	void (^ProcessRow)(int64_t rowid, NSString *collection, NSString *key, id object);
 	ProcessRow = ^(int64_t rowid, NSString *collection, NSString *key, id object){
@@ -308,7 +339,16 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 				[edges addObject:cleanEdge];
 			}
 			
-			[relationshipConnection->protocolChanges setObject:edges forKey:@(rowid)];
+			[pendingEdgeLists addObject:edges];
+			pendingEdgeCount += [edges count];
+			
+			if (pendingEdgeCount >= YDBRelationshipPopulateChunkSize)
+			{
+				[self populateEdgeLists:pendingEdgeLists];
+				
+				[pendingEdgeLists removeAllObjects];
+				pendingEdgeCount = 0;
+			}
 		}
 	};
 	
@@ -338,10 +378,65 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 		}];
 	}
 	
+	if ([pendingEdgeLists count] > 0)
+	{
+		[self populateEdgeLists:pendingEdgeLists];
+	}
+	
 	[self flush];
 	return YES;
 }
 
+/**
+ * Inserts a chunk of protocol edges while populating the table.
+ * Each item in the given array is the list of edges for a single source node.
+ *
+ * Since populateTables starts by removing all protocol edges, there's nothing on disk to merge with,
+ * and the edges can be inserted directly.
+ *
+ * The exception is a node with an edge whose destination doesn't exist.
+ * The nodeDeleteRules treat a missing destination as a deleted destination (which may delete the source node).
+ * So the edges of such a node are handed to flush, which takes care of all that.
+**/
+- (void)populateEdgeLists:(NSArray *)edgeLists
+{
+	NSMutableArray *allEdges = [NSMutableArray array];
+	for (NSArray *edges in edgeLists)
+	{
+		[allEdges addObjectsFromArray:edges];
+	}
+	
+	[self resolveDestinationRowidsForEdges:allEdges];
+	
+	NSMutableArray *resolvedEdges = [NSMutableArray arrayWithCapacity:[allEdges count]];
+	
+	for (NSMutableArray *edges in edgeLists)
+	{
+		BOOL resolved = YES;
+		
+		for (YapDatabaseRelationshipEdge *edge in edges)
+		{
+			if (edge->destinationFilePath == nil && !(edge->flags & YDB_FlagsHasDestinationRowid))
+			{
+				resolved = NO;
+				break;
+			}
+		}
+		
+		if (resolved)
+		{
+			[resolvedEdges addObjectsFromArray:edges];
+		}
+		else
+		{
+			YapDatabaseRelationshipEdge *firstEdge = [edges firstObject];
+			[relationshipConnection->protocolChanges setObject:edges forKey:@(firstEdge->sourceRowid)];
+		}
+	}
+	
+	[self insertEdges:resolvedEdges];
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Accessors
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -376,6 +471,132 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 #pragma mark Utilities
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Fills in the destinationRowid of the given edges (those with a destinationKey, but no destinationRowid yet).
+ *
+ * Rather than looking up each destination individually (via getRowid:forKey:inCollection:),
+ * the destinations are grouped by collection, and resolved with a single query per collection.
+ * (Or rather, per SQLITE_LIMIT_VARIABLE_NUMBER keys.)
+ *
+ * Edges whose destination doesn't exist in the database are left untouched.
+**/
+- (void)resolveDestinationRowidsForEdges:(NSArray *)edges
+{
+	// Group the edges by destination collection, and then by destination key.
+	
+	NSMutableDictionary *collections = [NSMutableDictionary dictionary];
+	
+	for (YapDatabaseRelationshipEdge *edge in edges)
+	{
+		if (edge->destinationFilePath || edge->destinationKey == nil) continue;
+		if (edge->flags & YDB_FlagsHasDestinationRowid) continue;
+		
+		NSString *collection = edge->destinationCollection ? edge->destinationCollection : @"";
+		
+		NSMutableDictionary *edgesByKey = [collections objectForKey:collection];
+		if (edgesByKey == nil)
+		{
+			edgesByKey = [NSMutableDictionary dictionary];
+			[collections setObject:edgesByKey forKey:collection];
+		}
+		
+		NSMutableArray *edgesForKey = [edgesByKey objectForKey:edge->destinationKey];
+		if (edgesForKey == nil)
+		{
+			edgesForKey = [NSMutableArray arrayWithCapacity:1];
+			[edgesByKey setObject:edgesForKey forKey:edge->destinationKey];
+		}
+		
+		[edgesForKey addObject:edge];
+	}
+	
+	if ([collections count] == 0) return;
+	
+	sqlite3 *db = databaseTransaction->connection->db;
+	
+	// Sqlite has an upper bound on the number of host parameters that may be used in a single query.
+	
+	NSUInteger maxHostParams = (NSUInteger) sqlite3_limit(db, SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+	
+	[collections enumerateKeysAndObjectsUsingBlock:^(id collectionObj, id edgesByKeyObj, BOOL *stop) {
+		
+		__unsafe_unretained NSString *collection = (NSString *)collectionObj;
+		__unsafe_unretained NSDictionary *edgesByKey = (NSDictionary *)edgesByKeyObj;
+		
+		NSArray *keys = [edgesByKey allKeys];
+		NSUInteger keysCount = [keys count];
+		NSUInteger keysIndex = 0;
+		
+		YapDatabaseString _collection; MakeYapDatabaseString(&_collection, collection);
+		
+		do
+		{
+			NSUInteger numKeyParams = MIN(keysCount - keysIndex, (maxHostParams-1)); // minus 1 for collectionParam
+			
+			// SELECT "key", "rowid" FROM "database2" WHERE "collection" = ? AND "key" IN (?, ?, ...);
+			
+			NSMutableString *query = [NSMutableString stringWithCapacity:(100 + (numKeyParams * 3))];
+			[query appendString:
+			  @"SELECT \"key\", \"rowid\" FROM \"database2\" WHERE \"collection\" = ? AND \"key\" IN ("];
+			
+			for (NSUInteger i = 0; i < numKeyParams; i++)
+			{
+				if (i == 0)
+					[query appendString:@"?"];
+				else
+					[query appendString:@", ?"];
+			}
+			
+			[query appendString:@");"];
+			
+			sqlite3_stmt *statement = NULL;
+			
+			int status = sqlite3_prepare_v2(db, [query UTF8String], -1, &statement, NULL);
+			if (status != SQLITE_OK)
+			{
+				YDBLogError(@"%@ - Error creating statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+				break;
+			}
+			
+			sqlite3_bind_text(statement, 1, _collection.str, _collection.length, SQLITE_STATIC);
+			
+			for (NSUInteger i = 0; i < numKeyParams; i++)
+			{
+				NSString *key = [keys objectAtIndex:(keysIndex + i)];
+				sqlite3_bind_text(statement, (int)(i + 2), [key UTF8String], -1, SQLITE_TRANSIENT);
+			}
+			
+			while ((status = sqlite3_step(statement)) == SQLITE_ROW)
+			{
+				const unsigned char *text = sqlite3_column_text(statement, 0);
+				int textSize = sqlite3_column_bytes(statement, 0);
+				
+				int64_t rowid = sqlite3_column_int64(statement, 1);
+				
+				NSString *key = [[NSString alloc] initWithBytes:text length:textSize encoding:NSUTF8StringEncoding];
+				
+				for (YapDatabaseRelationshipEdge *edge in [edgesByKey objectForKey:key])
+				{
+					edge->destinationRowid = rowid;
+					edge->flags |= YDB_FlagsHasDestinationRowid;
+				}
+			}
+			
+			if (status != SQLITE_DONE)
+			{
+				YDBLogError(@"%@ - Error executing statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+			}
+			
+			sqlite3_finalize(statement);
+			
+			keysIndex += numKeyParams;
+			
+		} while (keysIndex < keysCount);
+		
+		FreeYapDatabaseString(&_collection);
+	}];
+}
+
 /**
  * Extracts edges from the in-memory changes that match the given options.
  * These edges need to replace whatever is on disk.
@@ -1229,6 +1450,68 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	sqlite3_reset(statement);
 }
 
+/**
+ * Returns every edge on disk with the given source node, from the adjacencyCache if possible.
+ * 
+ * This method is only used within read-only transactions, when the adjacencyCache is enabled.
+ * Like the enumerateExistingEdges methods, it does not take into account anything in memory.
+**/
+- (YapDatabaseRelationshipAdjacency *)adjacencyForSource:(int64_t)srcRowid
+{
+	NSNumber *srcRowidNumber = @(srcRowid);
+	
+	YapDatabaseRelationshipAdjacency *adjacency =
+	  [relationshipConnection->sourceAdjacencyCache objectForKey:srcRowidNumber];
+	if (adjacency) return adjacency;
+	
+	adjacency = [[YapDatabaseRelationshipAdjacency alloc] init];
+	
+	[self enumerateExistingEdgesWithSource:srcRowid usingBlock:
+	    ^(int64_t edgeRowid, NSString *name, int64_t dstRowid, NSString *dstFilePath, int rules, BOOL manual)
+	{
+		[adjacency addEdgeWithRowid:edgeRowid
+		                       name:name
+		                  nodeRowid:dstRowid
+		                   filePath:dstFilePath
+		                      rules:rules
+		                     manual:manual];
+	}];
+	
+	[relationshipConnection->sourceAdjacencyCache setObject:adjacency forKey:srcRowidNumber];
+	return adjacency;
+}
+
+/**
+ * Returns every edge on disk with the given destination node, from the adjacencyCache if possible.
+ * 
+ * This method is only used within read-only transactions, when the adjacencyCache is enabled.
+ * Like the enumerateExistingEdges methods, it does not take into account anything in memory.
+**/
+- (YapDatabaseRelationshipAdjacency *)adjacencyForDestination:(int64_t)dstRowid
+{
+	NSNumber *dstRowidNumber = @(dstRowid);
+	
+	YapDatabaseRelationshipAdjacency *adjacency =
+	  [relationshipConnection->destinationAdjacencyCache objectForKey:dstRowidNumber];
+	if (adjacency) return adjacency;
+	
+	adjacency = [[YapDatabaseRelationshipAdjacency alloc] init];
+	
+	[self enumerateExistingEdgesWithDestination:dstRowid usingBlock:
+	    ^(int64_t edgeRowid, NSString *name, int64_t srcRowid, int rules, BOOL manual)
+	{
+		[adjacency addEdgeWithRowid:edgeRowid
+		                       name:name
+		                  nodeRowid:srcRowid
+		                   filePath:nil
+		                      rules:rules
+		                     manual:manual];
+	}];
+	
+	[relationshipConnection->destinationAdjacencyCache setObject:adjacency forKey:dstRowidNumber];
+	return adjacency;
+}
+
 /**
  * Searches the deletedInfo ivar to retrieve the associated rowid for a node that doesn't appear in the database.
  * If the node was deleted, we'll find it.
@@ -1970,6 +2253,26 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	}
 }
 
+/**
+ * Records that the edges of the given edge's source & destination nodes have changed on disk,
+ * so that every connection's adjacencyCache can be updated when we commit.
+**/
+- (void)noteAdjacencyChangeForEdge:(YapDatabaseRelationshipEdge *)edge
+{
+	if ((edge->flags & YDB_FlagsHasSourceRowid))
+		[relationshipConnection->adjacencyChanges addObject:@(edge->sourceRowid)];
+	else
+		relationshipConnection->adjacencyReset = YES;
+	
+	if (edge->destinationFilePath == nil)
+	{
+		if ((edge->flags & YDB_FlagsHasDestinationRowid))
+			[relationshipConnection->adjacencyChanges addObject:@(edge->destinationRowid)];
+		else
+			relationshipConnection->adjacencyReset = YES;
+	}
+}
+
 /**
  * Helper method for executing the sqlite statement to insert an edge into the database.
 **/
@@ -2024,6 +2327,8 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	{
 		edge->edgeRowid = sqlite3_last_insert_rowid(databaseTransaction->connection->db);
 		edge->flags |= YDB_FlagsHasEdgeRowid;
+		
+		[self noteAdjacencyChangeForEdge:edge];
 	}
 	else
 	{
@@ -2037,6 +2342,82 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	FreeYapDatabaseString(&_dstFilePath);
 }
 
+/**
+ * Helper method for inserting many edges into the database (used when populating the table).
+ *
+ * The edges are inserted using a multi-row statement (with a fixed number of rows),
+ * and any remaining edges are inserted individually.
+ *
+ * Note: The edgeRowid of the inserted edges is not filled in.
+**/
+- (void)insertEdges:(NSArray *)edges
+{
+	NSUInteger edgesCount = [edges count];
+	NSUInteger edgesIndex = 0;
+	
+	NSUInteger rowCount = 0;
+	sqlite3_stmt *statement = (edgesCount > 1) ? [relationshipConnection insertEdgesStatement:&rowCount] : NULL;
+	
+	if (statement && rowCount > 1)
+	{
+		YapDatabaseRelationshipFilePathEncryptor dstFilePathEncryptor =
+		  relationshipConnection->relationship->options.destinationFilePathEncryptor;
+		
+		sqlite3 *db = databaseTransaction->connection->db;
+		
+		while ((edgesCount - edgesIndex) >= rowCount)
+		{
+			// INSERT INTO "tableName" ("name", "src", "dst", "rules", "manual") VALUES (?, ?, ?, ?, ?), ...;
+			
+			for (NSUInteger i = 0; i < rowCount; i++)
+			{
+				YapDatabaseRelationshipEdge *edge = [edges objectAtIndex:(edgesIndex + i)];
+				int offset = (int)(i * 5);
+				
+				sqlite3_bind_text(statement, offset + 1, [edge->name UTF8String], -1, SQLITE_TRANSIENT);
+				sqlite3_bind_int64(statement, offset + 2, edge->sourceRowid);
+				
+				if (edge->destinationFilePath)
+				{
+					NSData *dstBlob = dstFilePathEncryptor ? dstFilePathEncryptor(edge->destinationFilePath) : nil;
+					if (dstBlob)
+					{
+						sqlite3_bind_blob(statement, offset + 3, dstBlob.bytes, (int)dstBlob.length, SQLITE_TRANSIENT);
+					}
+					else
+					{
+						const char *dstFilePath = [edge->destinationFilePath UTF8String];
+						sqlite3_bind_text(statement, offset + 3, dstFilePath, -1, SQLITE_TRANSIENT);
+					}
+				}
+				else
+				{
+					sqlite3_bind_int64(statement, offset + 3, edge->destinationRowid);
+				}
+				
+				sqlite3_bind_int(statement, offset + 4, edge->nodeDeleteRules);
+				sqlite3_bind_int(statement, offset + 5, (edge->isManualEdge ? 1 : 0));
+			}
+			
+			int status = sqlite3_step(statement);
+			if (status != SQLITE_DONE)
+			{
+				YDBLogError(@"%@ - Error executing statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+			}
+			
+			sqlite3_clear_bindings(statement);
+			sqlite3_reset(statement);
+			
+			edgesIndex += rowCount;
+		}
+	}
+	
+	for (; edgesIndex < edgesCount; edgesIndex++)
+	{
+		[self insertEdge:[edges objectAtIndex:edgesIndex]];
+	}
+}
+
 /**
  * Helper method for executing the sqlite statement to update an edge in the database.
 **/
@@ -2053,7 +2434,11 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	sqlite3_bind_int64(statement, 2, edge->edgeRowid);
 	
 	int status = sqlite3_step(statement);
-	if (status != SQLITE_DONE)
+	if (status == SQLITE_DONE)
+	{
+		[self noteAdjacencyChangeForEdge:edge];
+	}
+	else
 	{
 		YDBLogError(@"%@ - Error executing statement: %d %s", THIS_METHOD,
 		            status, sqlite3_errmsg(databaseTransaction->connection->db));
@@ -2078,7 +2463,11 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	sqlite3_bind_int64(statement, 1, edge->edgeRowid);
 	
 	int status = sqlite3_step(statement);
-	if (status != SQLITE_DONE)
+	if (status == SQLITE_DONE)
+	{
+		[self noteAdjacencyChangeForEdge:edge];
+	}
+	else
 	{
 		YDBLogError(@"%@ - Error executing statement (B): %d %s", THIS_METHOD,
 		            status, sqlite3_errmsg(databaseTransaction->connection->db));
@@ -2097,10 +2486,14 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	if (statement == NULL) return;
 	
 	// DELETE FROM "tableName" WHERE "src" = ? OR "dst" = ?;
+	//
+	// Note: The caller is responsible for noting the adjacency changes for the nodes on the other end of these edges.
 	
 	sqlite3_bind_int64(statement, 1, rowid);
 	sqlite3_bind_int64(statement, 2, rowid);
 	
+	[relationshipConnection->adjacencyChanges addObject:@(rowid)];
+	
 	int status = sqlite3_step(statement);
 	if (status != SQLITE_DONE)
 	{
@@ -2140,6 +2533,7 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	sqlite3_reset(statement);
 	
 	[relationshipConnection->protocolChanges removeAllObjects];
+	relationshipConnection->adjacencyReset = YES;
 }
 
 /**
@@ -2233,6 +2627,9 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	
 	// Step 3: Flush pending change lists
 	
+	relationshipConnection->adjacencyReset = YES;
+	[relationshipConnection->adjacencyChanges removeAllObjects];
+	
 	[relationshipConnection->protocolChanges removeAllObjects];
 	[relationshipConnection->manualChanges removeAllObjects];
 	[relationshipConnection->inserted removeAllObjects];
@@ -2240,54 +2637,686 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	[relationshipConnection->deletedInfo removeAllObjects];
 }
 
-- (void)flush
+/**
+ * Processes a single deleted node (STEP 4 of flush).
+ *
+ * All connected edges are enumerated, first the edges where the deleted node is the source,
+ * and then the edges where the deleted node is the destination.
+ * The nodeDeleteRules of each edge are applied, and then the edges are deleted.
+**/
+- (void)processDeletedNodeWithRowid:(int64_t)rowid collectionKey:(YapCollectionKey *)collectionKey
 {
-	YDBLogAutoTrace();
-	
-	if (!databaseTransaction->isReadWriteTransaction) return;
-	
-	isFlushing = YES;
-	
-	__block NSMutableArray *unprocessedEdges = nil;
-	
-	// STEP 0:
-	//
-	// Setup block to process a given array of edges.
-	// The array must be preprocessed using one of the proper preprocess methods.
-	// The preprocess methods will properly set the edgeAction and flags for each edge.
-	// So this block need only look at the edgeAction and flags to decide how to process each edge.
-	
-	void (^ProcessEdges)(NSArray *edges) = ^(NSArray *edges){ @autoreleasepool{
+	// Enumerate all edges where source node is this deleted node.
+	[self enumerateExistingEdgesWithSource:rowid usingBlock:
+	^(int64_t edgeRowid, NSString *name, int64_t dstRowid, NSString *dstFilePath, int nodeDeleteRules, BOOL manual)
+	{
+		if (dstFilePath == nil)
+		{
+			// This edge is about to be deleted (see deleteEdgesWithSourceOrDestination below)
+			[relationshipConnection->adjacencyChanges addObject:@(dstRowid)];
+		}
 		
-		for (YapDatabaseRelationshipEdge *edge in edges)
+		if (dstFilePath)
 		{
-			if (edge->edgeAction == YDB_EdgeActionNone)
+			if (nodeDeleteRules & YDB_DeleteDestinationIfAllSourcesDeleted)
 			{
-				// No edge processing required.
-				// Edge previously existed and didn't change.
+				// Delete the destination node IF there are no other edges pointing to it with the same name
+				
+				int64_t count = [self edgeCountWithDestinationFilePath:dstFilePath name:name excludingSource:rowid];
+				if (count == 0)
+				{
+					// Mark the file for deletion
+					
+					[relationshipConnection->filesToDelete addObject:dstFilePath];
+				}
 			}
-			else if (edge->edgeAction == YDB_EdgeActionInsert)
+			else if (nodeDeleteRules & YDB_DeleteDestinationIfSourceDeleted)
 			{
-				// New edge added.
-				// Insert into database.
+				// Mark the file for deletion
 				
-				[self insertEdge:edge];
+				[relationshipConnection->filesToDelete addObject:dstFilePath];
 			}
-			else if (edge->edgeAction == YDB_EdgeActionUpdate)
+		}
+		else // if (!dstFilePath)
+		{
+			if ([relationshipConnection->deletedInfo ydb_containsKey:@(dstRowid)])
 			{
-				// Edge modified (nodeDeleteRules changed)
-				// Update row in database.
-				
-				[self updateEdge:edge];
+				// Both source and destination node have been deleted
 			}
-			else if (edge->edgeAction == YDB_EdgeActionDelete)
+			else
 			{
-				// The edge is marked for deletion for one of the following reasons
-				//
-				// - Both source and destination deleted
-				// - Only source was deleted
-				// - Only destination was deleted
-				// - Bad edge (invalid source or destination node)
+				if (nodeDeleteRules & YDB_DeleteDestinationIfAllSourcesDeleted)
+				{
+					// Delete the destination node IF there are no other edges pointing to it with the same name
+					
+					int64_t count = [self edgeCountWithDestination:dstRowid name:name excludingSource:rowid];
+					if (count == 0)
+					{
+						YapCollectionKey *dst = [databaseTransaction collectionKeyForRowid:dstRowid];
+						
+						YDBLogVerbose(@"Deleting destination node: key(%@) collection(%@)",
+						              dst.key, dst.collection);
+						
+						__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
+						  (YapDatabaseReadWriteTransaction *)databaseTransaction;
+						
+						[databaseRwTransaction removeObjectForKey:dst.key
+						                             inCollection:dst.collection
+						                                withRowid:dstRowid];
+					}
+				}
+				else if (nodeDeleteRules & YDB_DeleteDestinationIfSourceDeleted)
+				{
+					// Delete the destination node
+					
+					YapCollectionKey *dst = [databaseTransaction collectionKeyForRowid:dstRowid];
+					
+					YDBLogVerbose(@"Deleting destination node: key(%@) collection(%@)", dst.key, dst.collection);
+					
+					__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
+					  (YapDatabaseReadWriteTransaction *)databaseTransaction;
+					
+					[databaseRwTransaction removeObjectForKey:dst.key
+					                             inCollection:dst.collection
+					                                withRowid:dstRowid];
+				}
+				else if (nodeDeleteRules & YDB_NotifyIfSourceDeleted)
+				{
+					// Notify the destination node
+					
+					YapCollectionKey *dst = nil;
+					id dstNode = nil;
+					
+					[databaseTransaction getCollectionKey:&dst
+					                               object:&dstNode
+					                             forRowid:dstRowid];
+					
+					SEL selector = @selector(yapDatabaseRelationshipEdgeDeleted:withReason:);
+					if ([dstNode respondsToSelector:selector])
+					{
+						YapDatabaseRelationshipEdge *edge = [[YapDatabaseRelationshipEdge alloc] init];
+						edge->name = name;
+						edge->sourceKey = collectionKey.key;
+						edge->sourceCollection = collectionKey.collection;
+						edge->sourceRowid = rowid;
+						edge->destinationKey = dst.key;
+						edge->destinationCollection = dst.collection;
+						edge->destinationRowid = dstRowid;
+						edge->nodeDeleteRules = nodeDeleteRules;
+						
+						id updatedDstNode =
+						  [dstNode yapDatabaseRelationshipEdgeDeleted:edge withReason:YDB_SourceNodeDeleted];
+						
+						if (updatedDstNode)
+						{
+							__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
+							  (YapDatabaseReadWriteTransaction *)databaseTransaction;
+							
+							[databaseRwTransaction replaceObject:updatedDstNode
+							                              forKey:edge->destinationKey
+							                        inCollection:edge->destinationCollection
+							                           withRowid:edge->destinationRowid
+							                    serializedObject:nil];
+						}
+					}
+				}
+			}
+		} // end else if (!dstFilePath)
+	}]; // end enumerateExistingRowsWithSrc:usingBlock:
+	
+	
+	// Enumerate all edges where destination node is this deleted node.
+	[self enumerateExistingEdgesWithDestination:rowid usingBlock:
+	    ^(int64_t edgeRowid, NSString *name, int64_t srcRowid, int nodeDeleteRules, BOOL manual)
+	{
+		// This edge is about to be deleted (see deleteEdgesWithSourceOrDestination below)
+		[relationshipConnection->adjacencyChanges addObject:@(srcRowid)];
+		
+		if ([relationshipConnection->deletedInfo ydb_containsKey:@(srcRowid)])
+		{
+			// Both source and destination node have been deleted
+		}
+		else
+		{
+			if (nodeDeleteRules & YDB_DeleteSourceIfAllDestinationsDeleted)
+			{
+				// Delete the source node IF there are no other edges pointing from it with the same name
+				
+				int64_t count = [self edgeCountWithSource:srcRowid name:name excludingDestination:rowid];
+				if (count == 0)
+				{
+					YapCollectionKey *src = [databaseTransaction collectionKeyForRowid:srcRowid];
+					
+					YDBLogVerbose(@"Deleting source node: key(%@) collection(%@)", src.key, src.collection);
+					
+					__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
+					  (YapDatabaseReadWriteTransaction *)databaseTransaction;
+					
+					[databaseRwTransaction removeObjectForKey:src.key
+					                             inCollection:src.collection
+					                                withRowid:srcRowid];
+				}
+			}
+			else if (nodeDeleteRules & YDB_DeleteSourceIfDestinationDeleted)
+			{
+				// Delete the source node
+				
+				YapCollectionKey *src = [databaseTransaction collectionKeyForRowid:srcRowid];
+				
+				YDBLogVerbose(@"Deleting source node: key(%@) collection(%@)", src.key, src.collection);
+				
+				__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
+				  (YapDatabaseReadWriteTransaction *)databaseTransaction;
+				
+				[databaseRwTransaction removeObjectForKey:src.key
+				                             inCollection:src.collection
+				                                withRowid:srcRowid];
+			}
+			else if (nodeDeleteRules & YDB_NotifyIfDestinationDeleted)
+			{
+				// Notify the source node
+				
+				YapCollectionKey *src = nil;
+				id srcNode = nil;
+				
+				[databaseTransaction getCollectionKey:&src object:&srcNode forRowid:srcRowid];
+				
+				SEL selector = @selector(yapDatabaseRelationshipEdgeDeleted:withReason:);
+				if ([srcNode respondsToSelector:selector])
+				{
+					YapDatabaseRelationshipEdge *edge = [[YapDatabaseRelationshipEdge alloc] init];
+					edge->name = name;
+					edge->sourceKey = src.key;
+					edge->sourceCollection = src.collection;
+					edge->sourceRowid = srcRowid;
+					edge->destinationKey = collectionKey.key;
+					edge->destinationCollection = collectionKey.collection;
+					edge->destinationRowid = rowid;
+					edge->nodeDeleteRules = nodeDeleteRules;
+					
+					id updatedSrcNode =
+					  [srcNode yapDatabaseRelationshipEdgeDeleted:edge withReason:YDB_DestinationNodeDeleted];
+					
+					if (updatedSrcNode)
+					{
+						__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
+						  (YapDatabaseReadWriteTransaction *)databaseTransaction;
+						
+						[databaseRwTransaction replaceObject:updatedSrcNode
+						                              forKey:edge->sourceKey
+						                        inCollection:edge->sourceCollection
+						                           withRowid:edge->sourceRowid
+						                    serializedObject:nil];
+					}
+				}
+			}
+		}
+		
+	}]; // end enumerateExistingRowsWithDst:usingBlock:
+	
+	// Delete all the edges where source or destination is this deleted node.
+	[self deleteEdgesWithSourceOrDestination:rowid];
+}
+
+/**
+ * Processes a round of deleted nodes (STEP 4 of flush) with a handful of set-based queries,
+ * rather than enumerating (and counting) the edges of each node individually.
+ *
+ * The rowids of the round are inserted into a temp table, and the edge table is queried against the whole round:
+ * - the "all sources/destinations deleted" rules are evaluated with GROUP BY counts
+ * - the remaining delete & notify rules are evaluated with a single query per side
+ * - all the edges connected to the round are deleted with a single statement
+ * - the cascaded nodes are removed in bulk via removeObjectsForKeys:inCollection:
+ *
+ * The rules are applied with the same precedence as processDeletedNodeWithRowid:collectionKey:.
+ * The only difference is that a node which gets deleted within the round isn't first notified
+ * about the edges it's losing (the per-node approach may notify a node, and then delete it a moment later).
+ *
+ * The cascaded nodes are appended to deletedOrder (by the remove hook), and thus make up the next round.
+ *
+ * Returns NO if the round couldn't be setup, in which case nothing has been modified.
+**/
+- (BOOL)processDeletedNodesInBatch:(NSArray *)rowidNumbers
+{
+	if (![relationshipConnection createCascadeTableIfNeeded]) return NO;
+	
+	sqlite3_stmt *removeAllStatement   = [relationshipConnection cascadeTableRemoveAllStatement];
+	sqlite3_stmt *insertStatement      = [relationshipConnection cascadeTableInsertStatement];
+	sqlite3_stmt *allSourcesStatement  = [relationshipConnection cascadeAllSourcesDeletedStatement];
+	sqlite3_stmt *allDstsStatement     = [relationshipConnection cascadeAllDestinationsDeletedStatement];
+	sqlite3_stmt *forSrcStatement      = [relationshipConnection cascadeEnumerateForSrcStatement];
+	sqlite3_stmt *forDstStatement      = [relationshipConnection cascadeEnumerateForDstStatement];
+	sqlite3_stmt *deleteEdgesStatement = [relationshipConnection cascadeDeleteEdgesStatement];
+	
+	if (!removeAllStatement || !insertStatement || !allSourcesStatement || !allDstsStatement ||
+	    !forSrcStatement || !forDstStatement || !deleteEdgesStatement)
+	{
+		return NO;
+	}
+	
+	sqlite3 *db = databaseTransaction->connection->db;
+	int status;
+	
+	// Step 1:
+	//
+	// Fill the cascade table with the rowids of this round.
+	//
+	// DELETE FROM temp."tableName_cascade";
+	// INSERT OR IGNORE INTO temp."tableName_cascade" ("rowid") VALUES (?);
+	
+	status = sqlite3_step(removeAllStatement);
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - Error executing statement (A): %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+	}
+	
+	sqlite3_reset(removeAllStatement);
+	if (status != SQLITE_DONE) return NO;
+	
+	for (NSNumber *rowidNumber in rowidNumbers)
+	{
+		sqlite3_bind_int64(insertStatement, 1, [rowidNumber longLongValue]);
+		
+		status = sqlite3_step(insertStatement);
+		if (status != SQLITE_DONE)
+		{
+			YDBLogError(@"%@ - Error executing statement (B): %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+		
+		sqlite3_clear_bindings(insertStatement);
+		sqlite3_reset(insertStatement);
+		
+		if (status != SQLITE_DONE) return NO;
+	}
+	
+	YapDatabaseRelationshipFilePathDecryptor dstFilePathDecryptor =
+	  relationshipConnection->relationship->options.destinationFilePathDecryptor;
+	
+	NSString* (^DstFilePathFromColumn)(sqlite3_stmt*, int) = ^NSString* (sqlite3_stmt *statement, int column){
+		
+		int column_type = sqlite3_column_type(statement, column);
+		if (column_type == SQLITE_TEXT)
+		{
+			const unsigned char *text = sqlite3_column_text(statement, column);
+			int textSize = sqlite3_column_bytes(statement, column);
+			
+			return [[NSString alloc] initWithBytes:text length:textSize encoding:NSUTF8StringEncoding];
+		}
+		else if (column_type == SQLITE_BLOB && dstFilePathDecryptor)
+		{
+			const void *blob = sqlite3_column_blob(statement, column);
+			int blobSize = sqlite3_column_bytes(statement, column);
+			
+			NSData *data = [NSData dataWithBytesNoCopy:(void *)blob length:blobSize freeWhenDone:NO];
+			
+			return dstFilePathDecryptor(data);
+		}
+		
+		return nil;
+	};
+	
+	__unsafe_unretained NSMutableDictionary *deletedInfo = relationshipConnection->deletedInfo;
+	__unsafe_unretained NSMutableSet *filesToDelete = relationshipConnection->filesToDelete;
+	
+	NSMutableSet *cascadedRowids = [NSMutableSet set];
+	
+	void (^CascadeDelete)(int64_t) = ^(int64_t nodeRowid){
+		
+		NSNumber *nodeRowidNumber = @(nodeRowid);
+		if (![deletedInfo ydb_containsKey:nodeRowidNumber])
+		{
+			[cascadedRowids addObject:nodeRowidNumber];
+		}
+	};
+	
+	// Step 2:
+	//
+	// YDB_DeleteDestinationIfAllSourcesDeleted
+	//
+	// Delete each destination node (or file) that no longer has any edges (with the same name) pointing to it.
+	
+	sqlite3_bind_int(allSourcesStatement, 1, YDB_DeleteDestinationIfAllSourcesDeleted);
+	
+	while ((status = sqlite3_step(allSourcesStatement)) == SQLITE_ROW)
+	{
+		if (sqlite3_column_type(allSourcesStatement, 0) == SQLITE_INTEGER)
+		{
+			CascadeDelete(sqlite3_column_int64(allSourcesStatement, 0));
+		}
+		else
+		{
+			NSString *dstFilePath = DstFilePathFromColumn(allSourcesStatement, 0);
+			if (dstFilePath)
+			{
+				[filesToDelete addObject:dstFilePath];
+			}
+		}
+	}
+	
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - Error executing statement (C): %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+	}
+	
+	sqlite3_clear_bindings(allSourcesStatement);
+	sqlite3_reset(allSourcesStatement);
+	
+	// Step 3:
+	//
+	// YDB_DeleteSourceIfAllDestinationsDeleted
+	//
+	// Delete each source node that no longer has any edges (with the same name) pointing from it.
+	
+	sqlite3_bind_int(allDstsStatement, 1, YDB_DeleteSourceIfAllDestinationsDeleted);
+	
+	while ((status = sqlite3_step(allDstsStatement)) == SQLITE_ROW)
+	{
+		CascadeDelete(sqlite3_column_int64(allDstsStatement, 0));
+	}
+	
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - Error executing statement (D): %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+	}
+	
+	sqlite3_clear_bindings(allDstsStatement);
+	sqlite3_reset(allDstsStatement);
+	
+	// Step 4:
+	//
+	// YDB_DeleteDestinationIfSourceDeleted (unless overriden by YDB_DeleteDestinationIfAllSourcesDeleted)
+	//
+	// SELECT "name", "src", "dst", "rules" FROM "tableName" WHERE "src" IN (cascade) AND ("rules" & ?1) = ?2;
+	
+	sqlite3_bind_int(forSrcStatement, 1, YDB_DeleteDestinationIfSourceDeleted | YDB_DeleteDestinationIfAllSourcesDeleted);
+	sqlite3_bind_int(forSrcStatement, 2, YDB_DeleteDestinationIfSourceDeleted);
+	
+	while ((status = sqlite3_step(forSrcStatement)) == SQLITE_ROW)
+	{
+		if (sqlite3_column_type(forSrcStatement, 2) == SQLITE_INTEGER)
+		{
+			CascadeDelete(sqlite3_column_int64(forSrcStatement, 2));
+		}
+		else
+		{
+			NSString *dstFilePath = DstFilePathFromColumn(forSrcStatement, 2);
+			if (dstFilePath)
+			{
+				[filesToDelete addObject:dstFilePath];
+			}
+		}
+	}
+	
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - Error executing statement (E): %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+	}
+	
+	sqlite3_clear_bindings(forSrcStatement);
+	sqlite3_reset(forSrcStatement);
+	
+	// Step 5:
+	//
+	// YDB_DeleteSourceIfDestinationDeleted (unless overriden by YDB_DeleteSourceIfAllDestinationsDeleted)
+	//
+	// SELECT "name", "src", "dst", "rules" FROM "tableName" WHERE "dst" IN (cascade) AND ("rules" & ?1) = ?2;
+	
+	sqlite3_bind_int(forDstStatement, 1, YDB_DeleteSourceIfDestinationDeleted | YDB_DeleteSourceIfAllDestinationsDeleted);
+	sqlite3_bind_int(forDstStatement, 2, YDB_DeleteSourceIfDestinationDeleted);
+	
+	while ((status = sqlite3_step(forDstStatement)) == SQLITE_ROW)
+	{
+		CascadeDelete(sqlite3_column_int64(forDstStatement, 1));
+	}
+	
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - Error executing statement (F): %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+	}
+	
+	sqlite3_clear_bindings(forDstStatement);
+	sqlite3_reset(forDstStatement);
+	
+	// Step 6:
+	//
+	// YDB_NotifyIfSourceDeleted & YDB_NotifyIfDestinationDeleted (unless overriden by a delete rule)
+	//
+	// We gather the edges first, and invoke the nodes afterwards,
+	// as the nodes are free to do whatever they want from within their callback.
+	
+	NSMutableArray *notifyDstEdges = [NSMutableArray array];
+	NSMutableArray *notifySrcEdges = [NSMutableArray array];
+	
+	sqlite3_bind_int(forSrcStatement, 1, YDB_NotifyIfSourceDeleted |
+	                                     YDB_DeleteDestinationIfSourceDeleted |
+	                                     YDB_DeleteDestinationIfAllSourcesDeleted);
+	sqlite3_bind_int(forSrcStatement, 2, YDB_NotifyIfSourceDeleted);
+	
+	while ((status = sqlite3_step(forSrcStatement)) == SQLITE_ROW)
+	{
+		if (sqlite3_column_type(forSrcStatement, 2) != SQLITE_INTEGER) continue;
+		
+		int64_t dstRowid = sqlite3_column_int64(forSrcStatement, 2);
+		
+		if ([deletedInfo ydb_containsKey:@(dstRowid)] || [cascadedRowids containsObject:@(dstRowid)]) continue;
+		
+		const unsigned char *text = sqlite3_column_text(forSrcStatement, 0);
+		int textSize = sqlite3_column_bytes(forSrcStatement, 0);
+		
+		YapDatabaseRelationshipEdge *edge = [[YapDatabaseRelationshipEdge alloc] init];
+		edge->name = [[NSString alloc] initWithBytes:text length:textSize encoding:NSUTF8StringEncoding];
+		edge->sourceRowid = sqlite3_column_int64(forSrcStatement, 1);
+		edge->destinationRowid = dstRowid;
+		edge->nodeDeleteRules = sqlite3_column_int(forSrcStatement, 3);
+		
+		[notifyDstEdges addObject:edge];
+	}
+	
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - Error executing statement (G): %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+	}
+	
+	sqlite3_clear_bindings(forSrcStatement);
+	sqlite3_reset(forSrcStatement);
+	
+	sqlite3_bind_int(forDstStatement, 1, YDB_NotifyIfDestinationDeleted |
+	                                     YDB_DeleteSourceIfDestinationDeleted |
+	                                     YDB_DeleteSourceIfAllDestinationsDeleted);
+	sqlite3_bind_int(forDstStatement, 2, YDB_NotifyIfDestinationDeleted);
+	
+	while ((status = sqlite3_step(forDstStatement)) == SQLITE_ROW)
+	{
+		int64_t srcRowid = sqlite3_column_int64(forDstStatement, 1);
+		
+		if ([deletedInfo ydb_containsKey:@(srcRowid)] || [cascadedRowids containsObject:@(srcRowid)]) continue;
+		
+		const unsigned char *text = sqlite3_column_text(forDstStatement, 0);
+		int textSize = sqlite3_column_bytes(forDstStatement, 0);
+		
+		YapDatabaseRelationshipEdge *edge = [[YapDatabaseRelationshipEdge alloc] init];
+		edge->name = [[NSString alloc] initWithBytes:text length:textSize encoding:NSUTF8StringEncoding];
+		edge->sourceRowid = srcRowid;
+		edge->destinationRowid = sqlite3_column_int64(forDstStatement, 2);
+		edge->nodeDeleteRules = sqlite3_column_int(forDstStatement, 3);
+		
+		[notifySrcEdges addObject:edge];
+	}
+	
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - Error executing statement (H): %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+	}
+	
+	sqlite3_clear_bindings(forDstStatement);
+	sqlite3_reset(forDstStatement);
+	
+	__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
+	  (YapDatabaseReadWriteTransaction *)databaseTransaction;
+	
+	SEL selector = @selector(yapDatabaseRelationshipEdgeDeleted:withReason:);
+	
+	for (YapDatabaseRelationshipEdge *edge in notifyDstEdges)
+	{
+		YapCollectionKey *src = [deletedInfo objectForKey:@(edge->sourceRowid)];
+		YapCollectionKey *dst = nil;
+		id dstNode = nil;
+		
+		[databaseTransaction getCollectionKey:&dst object:&dstNode forRowid:edge->destinationRowid];
+		
+		if ([dstNode respondsToSelector:selector])
+		{
+			edge->sourceKey = src.key;
+			edge->sourceCollection = src.collection;
+			edge->destinationKey = dst.key;
+			edge->destinationCollection = dst.collection;
+			
+			id updatedDstNode = [dstNode yapDatabaseRelationshipEdgeDeleted:edge withReason:YDB_SourceNodeDeleted];
+			
+			if (updatedDstNode)
+			{
+				[databaseRwTransaction replaceObject:updatedDstNode
+				                              forKey:edge->destinationKey
+				                        inCollection:edge->destinationCollection
+				                           withRowid:edge->destinationRowid
+				                    serializedObject:nil];
+			}
+		}
+	}
+	
+	for (YapDatabaseRelationshipEdge *edge in notifySrcEdges)
+	{
+		YapCollectionKey *src = nil;
+		YapCollectionKey *dst = [deletedInfo objectForKey:@(edge->destinationRowid)];
+		id srcNode = nil;
+		
+		[databaseTransaction getCollectionKey:&src object:&srcNode forRowid:edge->sourceRowid];
+		
+		if ([srcNode respondsToSelector:selector])
+		{
+			edge->sourceKey = src.key;
+			edge->sourceCollection = src.collection;
+			edge->destinationKey = dst.key;
+			edge->destinationCollection = dst.collection;
+			
+			id updatedSrcNode = [srcNode yapDatabaseRelationshipEdgeDeleted:edge withReason:YDB_DestinationNodeDeleted];
+			
+			if (updatedSrcNode)
+			{
+				[databaseRwTransaction replaceObject:updatedSrcNode
+				                              forKey:edge->sourceKey
+				                        inCollection:edge->sourceCollection
+				                           withRowid:edge->sourceRowid
+				                    serializedObject:nil];
+			}
+		}
+	}
+	
+	// Step 7:
+	//
+	// Delete all the edges where the source or destination is in this round.
+	//
+	// A round may touch an arbitrary number of nodes,
+	// so rather than tracking each far end, we ask the other connections to reset their adjacency caches.
+	
+	status = sqlite3_step(deleteEdgesStatement);
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - Error executing statement (I): %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+	}
+	
+	sqlite3_reset(deleteEdgesStatement);
+	
+	relationshipConnection->adjacencyReset = YES;
+	
+	status = sqlite3_step(removeAllStatement);
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - Error executing statement (J): %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+	}
+	
+	sqlite3_reset(removeAllStatement);
+	
+	// Step 8:
+	//
+	// Remove the cascaded nodes, in bulk (grouped by collection).
+	// The remove hook appends them to deletedOrder, so they'll be processed in the next round.
+	
+	NSMutableDictionary *keysByCollection = [NSMutableDictionary dictionary];
+	
+	for (NSNumber *nodeRowidNumber in cascadedRowids)
+	{
+		YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:[nodeRowidNumber longLongValue]];
+		if (ck == nil) continue;
+		
+		NSMutableArray *keys = [keysByCollection objectForKey:ck.collection];
+		if (keys == nil)
+		{
+			keys = [NSMutableArray array];
+			[keysByCollection setObject:keys forKey:ck.collection];
+		}
+		
+		[keys addObject:ck.key];
+	}
+	
+	[keysByCollection enumerateKeysAndObjectsUsingBlock:^(NSString *collection, NSArray *keys, BOOL *stop) {
+		
+		YDBLogVerbose(@"Deleting %lu cascaded nodes in collection(%@)", (unsigned long)[keys count], collection);
+		
+		[databaseRwTransaction removeObjectsForKeys:keys inCollection:collection];
+	}];
+	
+	return YES;
+}
+
+- (void)flush
+{
+	YDBLogAutoTrace();
+	
+	if (!databaseTransaction->isReadWriteTransaction) return;
+	
+	isFlushing = YES;
+	
+	__block NSMutableArray *unprocessedEdges = nil;
+	
+	// STEP 0:
+	//
+	// Setup block to process a given array of edges.
+	// The array must be preprocessed using one of the proper preprocess methods.
+	// The preprocess methods will properly set the edgeAction and flags for each edge.
+	// So this block need only look at the edgeAction and flags to decide how to process each edge.
+	
+	void (^ProcessEdges)(NSArray *edges) = ^(NSArray *edges){ @autoreleasepool{
+		
+		for (YapDatabaseRelationshipEdge *edge in edges)
+		{
+			if (edge->edgeAction == YDB_EdgeActionNone)
+			{
+				// No edge processing required.
+				// Edge previously existed and didn't change.
+			}
+			else if (edge->edgeAction == YDB_EdgeActionInsert)
+			{
+				// New edge added.
+				// Insert into database.
+				
+				[self insertEdge:edge];
+			}
+			else if (edge->edgeAction == YDB_EdgeActionUpdate)
+			{
+				// Edge modified (nodeDeleteRules changed)
+				// Update row in database.
+				
+				[self updateEdge:edge];
+			}
+			else if (edge->edgeAction == YDB_EdgeActionDelete)
+			{
+				// The edge is marked for deletion for one of the following reasons
+				//
+				// - Both source and destination deleted
+				// - Only source was deleted
+				// - Only destination was deleted
+				// - Bad edge (invalid source or destination node)
 				// - Edge manually deleted via source object (same as source deleted)
 				
 				BOOL edgeProcessed = YES;
@@ -2488,6 +3517,28 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	// - writing new edges to the database
 	// - writing modified edges to the database (changed nodeDeleteRules)
 	// - deleting edges that were manually removed from the list
+	//
+	// Performance tuning:
+	// The destinations of the edges from new nodes are resolved up front, with a query per collection,
+	// rather than with a lookup per edge (within preprocessProtocolEdges:forInsertedSource:).
+	
+	if ([relationshipConnection->inserted count] > 1)
+	{
+		NSMutableArray *insertedSourceEdges = [NSMutableArray array];
+		
+		[relationshipConnection->protocolChanges enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop){
+			
+			if ([relationshipConnection->inserted containsObject:key])
+			{
+				[insertedSourceEdges addObjectsFromArray:(NSArray *)obj];
+			}
+		}];
+		
+		if ([insertedSourceEdges count] > 1)
+		{
+			[self resolveDestinationRowidsForEdges:insertedSourceEdges];
+		}
+	}
 	
 	[relationshipConnection->protocolChanges enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop){
 		
@@ -2537,322 +3588,134 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 		// The edges list has now been preprocessed,
 		// and all the various flags for each edge have been set.
 		//
-		// We're ready for normal edge processing.
-		
-		ProcessEdges(manualEdges);
-	}];
-	
-	[relationshipConnection->manualChanges removeAllObjects];
-	
-	// STEP 3:
-	//
-	// Revisit the unprocessed edges from steps 1 & 2.
-	// That is, those edges that were deleted, but had nodeDeleteRules of either
-	// - YDB_DeleteDestinationIfAllSourcesDeleted
-	// - YDB_DeleteSourceIfAllDestinationsDeleted
-	//
-	// We were unable to fetch the remaining edge count earlier.
-	// But we're ready to do so now.
-	
-	for (YapDatabaseRelationshipEdge *edge in unprocessedEdges)
-	{
-		if (edge->destinationFilePath)
-		{
-			if (edge->nodeDeleteRules & YDB_DeleteDestinationIfAllSourcesDeleted)
-			{
-				// Delete destination node IF there are no other edges pointing to it with the same name
-				
-				int64_t count = [self edgeCountWithDestinationFilePath:edge->destinationFilePath
-				                                                  name:edge->name
-				                                       excludingSource:edge->sourceRowid];
-				if (count == 0)
-				{
-					// Mark the file for deletion
-					
-					[relationshipConnection->filesToDelete addObject:edge->destinationFilePath];
-				}
-			}
-		}
-		else // if (!edge->destinationFilePath)
-		{
-			if (edge->nodeDeleteRules & YDB_DeleteDestinationIfAllSourcesDeleted)
-			{
-				if ([relationshipConnection->deletedInfo ydb_containsKey:@(edge->destinationRowid)])
-				{
-					// Destination node already deleted
-				}
-				else
-				{
-					// Delete destination node IF there are no other edges pointing to it with the same name
-					
-					int64_t count = [self edgeCountWithDestination:edge->destinationRowid
-					                                          name:edge->name
-					                               excludingSource:edge->sourceRowid];
-					if (count == 0)
-					{
-						YDBLogVerbose(@"Deleting destination node: key(%@) collection(%@)",
-						              edge->destinationKey, edge->destinationCollection);
-						
-						__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
-						  (YapDatabaseReadWriteTransaction *)databaseTransaction;
-						
-						[databaseRwTransaction removeObjectForKey:edge->destinationKey
-						                             inCollection:edge->destinationCollection
-						                                withRowid:edge->destinationRowid];
-					}
-				}
-			}
-			else if (edge->nodeDeleteRules & YDB_DeleteSourceIfAllDestinationsDeleted)
-			{
-				if ([relationshipConnection->deletedInfo ydb_containsKey:@(edge->sourceRowid)])
-				{
-					// Source node already deleted
-				}
-				else
-				{
-					// Delete source node IF there are no other edges pointing from it with the same name
-					
-					int64_t count = [self edgeCountWithSource:edge->sourceRowid
-					                                     name:edge->name
-					                     excludingDestination:edge->destinationRowid];
-					if (count == 0)
-					{
-						YDBLogVerbose(@"Deleting source node: key(%@) collection(%@)",
-						              edge->sourceKey, edge->sourceCollection);
-						
-						__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
-						  (YapDatabaseReadWriteTransaction *)databaseTransaction;
-						
-						[databaseRwTransaction removeObjectForKey:edge->sourceKey
-						                             inCollection:edge->sourceCollection
-						                                withRowid:edge->sourceRowid];
-					}
-				}
-			}
-		}
-	}
-	
-	unprocessedEdges = nil;
-	
-	// STEP 4:
-	//
-	// Process all the deleted nodes.
-	// For each deleted node we're going to enumerate all connected edges.
-	// First the edges where the deleted node is the source.
-	// Then the edges where the deleted node is the destination.
-	//
-	// Note that at this point, the database is up-to-date (we've written all changes).
-	// So we can simply enumerate and query the database without any fuss.
-	
-	NSUInteger i = 0;
-	while (i < [relationshipConnection->deletedOrder count])
-	{
-		NSNumber *rowidNumber = [relationshipConnection->deletedOrder objectAtIndex:i];
-		int64_t rowid = [rowidNumber longLongValue];
-		
-		YapCollectionKey *collectionKey = [relationshipConnection->deletedInfo objectForKey:rowidNumber];
-		
-		// Enumerate all edges where source node is this deleted node.
-		[self enumerateExistingEdgesWithSource:rowid usingBlock:
-		^(int64_t edgeRowid, NSString *name, int64_t dstRowid, NSString *dstFilePath, int nodeDeleteRules, BOOL manual)
-		{
-			if (dstFilePath)
-			{
-				if (nodeDeleteRules & YDB_DeleteDestinationIfAllSourcesDeleted)
-				{
-					// Delete the destination node IF there are no other edges pointing to it with the same name
-					
-					int64_t count = [self edgeCountWithDestinationFilePath:dstFilePath name:name excludingSource:rowid];
-					if (count == 0)
-					{
-						// Mark the file for deletion
-						
-						[relationshipConnection->filesToDelete addObject:dstFilePath];
-					}
-				}
-				else if (nodeDeleteRules & YDB_DeleteDestinationIfSourceDeleted)
-				{
-					// Mark the file for deletion
-					
-					[relationshipConnection->filesToDelete addObject:dstFilePath];
-				}
-			}
-			else // if (!dstFilePath)
-			{
-				if ([relationshipConnection->deletedInfo ydb_containsKey:@(dstRowid)])
-				{
-					// Both source and destination node have been deleted
-				}
-				else
-				{
-					if (nodeDeleteRules & YDB_DeleteDestinationIfAllSourcesDeleted)
-					{
-						// Delete the destination node IF there are no other edges pointing to it with the same name
-						
-						int64_t count = [self edgeCountWithDestination:dstRowid name:name excludingSource:rowid];
-						if (count == 0)
-						{
-							YapCollectionKey *dst = [databaseTransaction collectionKeyForRowid:dstRowid];
-							
-							YDBLogVerbose(@"Deleting destination node: key(%@) collection(%@)",
-							              dst.key, dst.collection);
-							
-							__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
-							  (YapDatabaseReadWriteTransaction *)databaseTransaction;
-							
-							[databaseRwTransaction removeObjectForKey:dst.key
-							                             inCollection:dst.collection
-							                                withRowid:dstRowid];
-						}
-					}
-					else if (nodeDeleteRules & YDB_DeleteDestinationIfSourceDeleted)
-					{
-						// Delete the destination node
-						
-						YapCollectionKey *dst = [databaseTransaction collectionKeyForRowid:dstRowid];
-						
-						YDBLogVerbose(@"Deleting destination node: key(%@) collection(%@)", dst.key, dst.collection);
-						
-						__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
-						  (YapDatabaseReadWriteTransaction *)databaseTransaction;
-						
-						[databaseRwTransaction removeObjectForKey:dst.key
-						                             inCollection:dst.collection
-						                                withRowid:dstRowid];
-					}
-					else if (nodeDeleteRules & YDB_NotifyIfSourceDeleted)
-					{
-						// Notify the destination node
-						
-						YapCollectionKey *dst = nil;
-						id dstNode = nil;
-						
-						[databaseTransaction getCollectionKey:&dst
-						                               object:&dstNode
-						                             forRowid:dstRowid];
-						
-						SEL selector = @selector(yapDatabaseRelationshipEdgeDeleted:withReason:);
-						if ([dstNode respondsToSelector:selector])
-						{
-							YapDatabaseRelationshipEdge *edge = [[YapDatabaseRelationshipEdge alloc] init];
-							edge->name = name;
-							edge->sourceKey = collectionKey.key;
-							edge->sourceCollection = collectionKey.collection;
-							edge->sourceRowid = rowid;
-							edge->destinationKey = dst.key;
-							edge->destinationCollection = dst.collection;
-							edge->destinationRowid = dstRowid;
-							edge->nodeDeleteRules = nodeDeleteRules;
-							
-							id updatedDstNode =
-							  [dstNode yapDatabaseRelationshipEdgeDeleted:edge withReason:YDB_SourceNodeDeleted];
-							
-							if (updatedDstNode)
-							{
-								__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
-								  (YapDatabaseReadWriteTransaction *)databaseTransaction;
-								
-								[databaseRwTransaction replaceObject:updatedDstNode
-								                              forKey:edge->destinationKey
-								                        inCollection:edge->destinationCollection
-								                           withRowid:edge->destinationRowid
-								                    serializedObject:nil];
-							}
-						}
-					}
-				}
-			} // end else if (!dstFilePath)
-		}]; // end enumerateExistingRowsWithSrc:usingBlock:
-		
+		// We're ready for normal edge processing.
 		
-		// Enumerate all edges where destination node is this deleted node.
-		[self enumerateExistingEdgesWithDestination:rowid usingBlock:
-		    ^(int64_t edgeRowid, NSString *name, int64_t srcRowid, int nodeDeleteRules, BOOL manual)
+		ProcessEdges(manualEdges);
+	}];
+	
+	[relationshipConnection->manualChanges removeAllObjects];
+	
+	// STEP 3:
+	//
+	// Revisit the unprocessed edges from steps 1 & 2.
+	// That is, those edges that were deleted, but had nodeDeleteRules of either
+	// - YDB_DeleteDestinationIfAllSourcesDeleted
+	// - YDB_DeleteSourceIfAllDestinationsDeleted
+	//
+	// We were unable to fetch the remaining edge count earlier.
+	// But we're ready to do so now.
+	
+	for (YapDatabaseRelationshipEdge *edge in unprocessedEdges)
+	{
+		if (edge->destinationFilePath)
 		{
-			if ([relationshipConnection->deletedInfo ydb_containsKey:@(srcRowid)])
+			if (edge->nodeDeleteRules & YDB_DeleteDestinationIfAllSourcesDeleted)
 			{
-				// Both source and destination node have been deleted
+				// Delete destination node IF there are no other edges pointing to it with the same name
+				
+				int64_t count = [self edgeCountWithDestinationFilePath:edge->destinationFilePath
+				                                                  name:edge->name
+				                                       excludingSource:edge->sourceRowid];
+				if (count == 0)
+				{
+					// Mark the file for deletion
+					
+					[relationshipConnection->filesToDelete addObject:edge->destinationFilePath];
+				}
 			}
-			else
+		}
+		else // if (!edge->destinationFilePath)
+		{
+			if (edge->nodeDeleteRules & YDB_DeleteDestinationIfAllSourcesDeleted)
 			{
-				if (nodeDeleteRules & YDB_DeleteSourceIfAllDestinationsDeleted)
+				if ([relationshipConnection->deletedInfo ydb_containsKey:@(edge->destinationRowid)])
+				{
+					// Destination node already deleted
+				}
+				else
 				{
-					// Delete the source node IF there are no other edges pointing from it with the same name
+					// Delete destination node IF there are no other edges pointing to it with the same name
 					
-					int64_t count = [self edgeCountWithSource:srcRowid name:name excludingDestination:rowid];
+					int64_t count = [self edgeCountWithDestination:edge->destinationRowid
+					                                          name:edge->name
+					                               excludingSource:edge->sourceRowid];
 					if (count == 0)
 					{
-						YapCollectionKey *src = [databaseTransaction collectionKeyForRowid:srcRowid];
-						
-						YDBLogVerbose(@"Deleting source node: key(%@) collection(%@)", src.key, src.collection);
+						YDBLogVerbose(@"Deleting destination node: key(%@) collection(%@)",
+						              edge->destinationKey, edge->destinationCollection);
 						
 						__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
 						  (YapDatabaseReadWriteTransaction *)databaseTransaction;
 						
-						[databaseRwTransaction removeObjectForKey:src.key
-						                             inCollection:src.collection
-						                                withRowid:srcRowid];
+						[databaseRwTransaction removeObjectForKey:edge->destinationKey
+						                             inCollection:edge->destinationCollection
+						                                withRowid:edge->destinationRowid];
 					}
 				}
-				else if (nodeDeleteRules & YDB_DeleteSourceIfDestinationDeleted)
+			}
+			else if (edge->nodeDeleteRules & YDB_DeleteSourceIfAllDestinationsDeleted)
+			{
+				if ([relationshipConnection->deletedInfo ydb_containsKey:@(edge->sourceRowid)])
 				{
-					// Delete the source node
-					
-					YapCollectionKey *src = [databaseTransaction collectionKeyForRowid:srcRowid];
-					
-					YDBLogVerbose(@"Deleting source node: key(%@) collection(%@)", src.key, src.collection);
-					
-					__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
-					  (YapDatabaseReadWriteTransaction *)databaseTransaction;
-					
-					[databaseRwTransaction removeObjectForKey:src.key
-					                             inCollection:src.collection
-					                                withRowid:srcRowid];
+					// Source node already deleted
 				}
-				else if (nodeDeleteRules & YDB_NotifyIfDestinationDeleted)
+				else
 				{
-					// Notify the source node
-					
-					YapCollectionKey *src = nil;
-					id srcNode = nil;
-					
-					[databaseTransaction getCollectionKey:&src object:&srcNode forRowid:srcRowid];
+					// Delete source node IF there are no other edges pointing from it with the same name
 					
-					SEL selector = @selector(yapDatabaseRelationshipEdgeDeleted:withReason:);
-					if ([srcNode respondsToSelector:selector])
+					int64_t count = [self edgeCountWithSource:edge->sourceRowid
+					                                     name:edge->name
+					                     excludingDestination:edge->destinationRowid];
+					if (count == 0)
 					{
-						YapDatabaseRelationshipEdge *edge = [[YapDatabaseRelationshipEdge alloc] init];
-						edge->name = name;
-						edge->sourceKey = src.key;
-						edge->sourceCollection = src.collection;
-						edge->sourceRowid = srcRowid;
-						edge->destinationKey = collectionKey.key;
-						edge->destinationCollection = collectionKey.collection;
-						edge->destinationRowid = rowid;
-						edge->nodeDeleteRules = nodeDeleteRules;
+						YDBLogVerbose(@"Deleting source node: key(%@) collection(%@)",
+						              edge->sourceKey, edge->sourceCollection);
 						
-						id updatedSrcNode =
-						  [srcNode yapDatabaseRelationshipEdgeDeleted:edge withReason:YDB_DestinationNodeDeleted];
+						__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
+						  (YapDatabaseReadWriteTransaction *)databaseTransaction;
 						
-						if (updatedSrcNode)
-						{
-							__unsafe_unretained YapDatabaseReadWriteTransaction *databaseRwTransaction =
-							  (YapDatabaseReadWriteTransaction *)databaseTransaction;
-							
-							[databaseRwTransaction replaceObject:updatedSrcNode
-							                              forKey:edge->sourceKey
-							                        inCollection:edge->sourceCollection
-							                           withRowid:edge->sourceRowid
-							                    serializedObject:nil];
-						}
+						[databaseRwTransaction removeObjectForKey:edge->sourceKey
+						                             inCollection:edge->sourceCollection
+						                                withRowid:edge->sourceRowid];
 					}
 				}
 			}
+		}
+	}
+	
+	unprocessedEdges = nil;
+	
+	// STEP 4:
+	//
+	// Process all the deleted nodes.
+	// A handful of deleted nodes are processed one at a time (see processDeletedNodeWithRowid:collectionKey:),
+	// while larger numbers are processed together in rounds (see processDeletedNodesInBatch:).
+	//
+	// Note that at this point, the database is up-to-date (we've written all changes).
+	// So we can simply enumerate and query the database without any fuss.
+	
+	NSUInteger i = 0;
+	while (i < [relationshipConnection->deletedOrder count])
+	{
+		// Once a deletion cascades into a larger number of nodes,
+		// it's much faster to process all the pending nodes together (one set-based round at a time).
+		
+		NSUInteger pendingCount = [relationshipConnection->deletedOrder count] - i;
+		if (pendingCount >= YDBRelationshipCascadeBatchThreshold)
+		{
+			NSArray *round = [relationshipConnection->deletedOrder subarrayWithRange:NSMakeRange(i, pendingCount)];
 			
-		}]; // end enumerateExistingRowsWithDst:usingBlock:
+			if ([self processDeletedNodesInBatch:round])
+			{
+				i += pendingCount;
+				continue;
+			}
+		}
+		
+		NSNumber *rowidNumber = [relationshipConnection->deletedOrder objectAtIndex:i];
+		YapCollectionKey *collectionKey = [relationshipConnection->deletedInfo objectForKey:rowidNumber];
 		
-		// Delete all the edges where source or destination is this deleted node.
-		[self deleteEdgesWithSourceOrDestination:rowid];
+		[self processDeletedNodeWithRowid:[rowidNumber longLongValue] collectionKey:collectionKey];
 		
 		i++;
 	}
@@ -2911,29 +3774,17 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	
 	if ([relationshipConnection->filesToDelete count] > 0)
 	{
-		// Note: No need to make a copy.
-		// We will set relationshipConnection->filesToDelete to nil instead.
-		//
-		// See: [relationshipConnection postCommitCleanup];
+		// The files are recorded in the database (as part of this transaction),
+		// and then deleted in the background by the extension's file deletion queue.
 		
-		NSSet *filesToDelete = relationshipConnection->filesToDelete;
-		
-		dispatch_queue_t fileManagerQueue = [relationshipConnection->relationship fileManagerQueue];
-		dispatch_async(fileManagerQueue, ^{ @autoreleasepool {
-			
-			NSFileManager *fileManager = [NSFileManager defaultManager];
-			
-			for (NSString *filePath in filesToDelete)
-			{
-				NSError *error = nil;
-				if (![fileManager removeItemAtPath:filePath error:&error])
-				{
-					YDBLogWarn(@"Error removing file at path(filePath): %@", error);
-				}
-			}
-		}});
+		[self enqueueFilesToDelete:relationshipConnection->filesToDelete];
 	}
 	
+	// Remove the records of any batches the background deletion queue has finished since the last commit.
+	// Doing it here saves the deletion queue from having to perform a readwrite transaction of its own.
+	
+	[self removeCompletedFileDeletionBatches];
+	
 	// Commit is complete.
 	// Cleanup time.
 	
@@ -2966,6 +3817,152 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	databaseTransaction = nil;    // Do not remove !
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark File Deletion
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Files are deleted in batches (one batch per commit), by YapDatabaseRelationship's background deletion queue.
+ *
+ * Each batch is recorded in the yap2 table (within the same transaction that deleted the edges),
+ * and is only removed from the yap2 table once it's been processed.
+ * The pending batches are numbered [fileDeletionFirstBatch, fileDeletionNextBatch).
+**/
+- (NSString *)extensionKeyForFileDeletionBatch:(int)batchNumber
+{
+	return [NSString stringWithFormat:@"%@%d", ExtKey_fileDeletionBatchPrefix, batchNumber];
+}
+
+/**
+ * Records the given files in the database, and hands them to the background deletion queue.
+ * This method is invoked from commitTransaction (i.e. before the sqlite commit).
+**/
+- (void)enqueueFilesToDelete:(NSSet *)filesToDelete
+{
+	YapDatabaseRelationshipFilePathEncryptor dstFilePathEncryptor =
+	  relationshipConnection->relationship->options.destinationFilePathEncryptor;
+	
+	NSMutableArray *filePaths = [NSMutableArray arrayWithCapacity:[filesToDelete count]];
+	NSMutableArray *records = [NSMutableArray arrayWithCapacity:[filesToDelete count]];
+	
+	for (NSString *filePath in filesToDelete)
+	{
+		[filePaths addObject:filePath];
+		
+		NSData *encryptedFilePath = dstFilePathEncryptor ? dstFilePathEncryptor(filePath) : nil;
+		if (encryptedFilePath)
+			[records addObject:encryptedFilePath];
+		else
+			[records addObject:filePath];
+	}
+	
+	NSError *error = nil;
+	NSData *data = [NSPropertyListSerialization dataWithPropertyList:records
+	                                                          format:NSPropertyListBinaryFormat_v1_0
+	                                                         options:0
+	                                                           error:&error];
+	
+	int batchNumber = 0;
+	[self getIntValue:&batchNumber forExtensionKey:ExtKey_fileDeletionNextBatch persistent:YES];
+	
+	if (data)
+	{
+		[self setDataValue:data forExtensionKey:[self extensionKeyForFileDeletionBatch:batchNumber] persistent:YES];
+		[self setIntValue:(batchNumber + 1) forExtensionKey:ExtKey_fileDeletionNextBatch persistent:YES];
+	}
+	else
+	{
+		YDBLogWarn(@"%@ - Unable to record file deletion batch: %@", THIS_METHOD, error);
+	}
+	
+	[relationshipConnection->relationship enqueueFileDeletionBatch:batchNumber filePaths:filePaths];
+}
+
+/**
+ * Hands any batches left over from a previous app launch to the background deletion queue.
+ * This method is invoked from createIfNeeded (i.e. once, when the extension is registered).
+**/
+- (void)resumePendingFileDeletions
+{
+	int firstBatch = 0;
+	int nextBatch = 0;
+	
+	[self getIntValue:&firstBatch forExtensionKey:ExtKey_fileDeletionFirstBatch persistent:YES];
+	[self getIntValue:&nextBatch forExtensionKey:ExtKey_fileDeletionNextBatch persistent:YES];
+	
+	if (firstBatch >= nextBatch) return;
+	
+	YapDatabaseRelationshipFilePathDecryptor dstFilePathDecryptor =
+	  relationshipConnection->relationship->options.destinationFilePathDecryptor;
+	
+	for (int batchNumber = firstBatch; batchNumber < nextBatch; batchNumber++)
+	{
+		NSData *data = [self dataValueForExtensionKey:[self extensionKeyForFileDeletionBatch:batchNumber] persistent:YES];
+		if (data == nil) continue;
+		
+		NSArray *records = [NSPropertyListSerialization propertyListWithData:data
+		                                                             options:NSPropertyListImmutable
+		                                                              format:NULL
+		                                                               error:NULL];
+		
+		NSMutableArray *filePaths = [NSMutableArray arrayWithCapacity:[records count]];
+		
+		for (id record in records)
+		{
+			if ([record isKindOfClass:[NSString class]])
+			{
+				[filePaths addObject:record];
+			}
+			else if ([record isKindOfClass:[NSData class]] && dstFilePathDecryptor)
+			{
+				NSString *filePath = dstFilePathDecryptor((NSData *)record);
+				if (filePath)
+				{
+					[filePaths addObject:filePath];
+				}
+			}
+		}
+		
+		YDBLogVerbose(@"Resuming deletion of %lu file(s) from batch %d", (unsigned long)[filePaths count], batchNumber);
+		
+		[relationshipConnection->relationship enqueueFileDeletionBatch:batchNumber filePaths:filePaths];
+	}
+}
+
+/**
+ * See header file for description.
+**/
+- (void)removeCompletedFileDeletionBatches
+{
+	int batchNumber = 0;
+	if ([relationshipConnection->relationship getCompletedFileDeletionBatch:&batchNumber])
+	{
+		[self removeFileDeletionBatchesThrough:batchNumber];
+	}
+}
+
+/**
+ * Removes the file deletion batches (up to and including the given batch number) from the database.
+**/
+- (void)removeFileDeletionBatchesThrough:(int)batchNumber
+{
+	int firstBatch = 0;
+	int nextBatch = 0;
+	
+	[self getIntValue:&firstBatch forExtensionKey:ExtKey_fileDeletionFirstBatch persistent:YES];
+	[self getIntValue:&nextBatch forExtensionKey:ExtKey_fileDeletionNextBatch persistent:YES];
+	
+	int endBatch = MIN(batchNumber + 1, nextBatch);
+	if (firstBatch >= endBatch) return;
+	
+	for (int i = firstBatch; i < endBatch; i++)
+	{
+		[self removeValueForExtensionKey:[self extensionKeyForFileDeletionBatch:i] persistent:YES];
+	}
+	
+	[self setIntValue:endBatch forExtensionKey:ExtKey_fileDeletionFirstBatch persistent:YES];
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Transaction Hooks
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -3248,11 +4245,7 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 {
 	YDBLogAutoTrace();
 	
-	if (isFlushing)
-	{
-		YDBLogError(@"Unable to handle multi-remove hook during flush processing");
-		return;
-	}
+	// Note: This method may be called during flush processing due to an edge's nodeDeleteRules.
 	
 	NSUInteger i = 0;
 	for (NSNumber *srcNumber in rowids)
@@ -3583,6 +4576,52 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	
 	BOOL stop = NO;
 	
+	if (!databaseTransaction->isReadWriteTransaction && relationshipConnection->sourceAdjacencyCache)
+	{
+		// Read-only transaction, so there aren't any changes in memory.
+		// We can enumerate straight from the adjacencyCache.
+		
+		YapDatabaseRelationshipAdjacency *adjacency = [self adjacencyForSource:srcRowid];
+		
+		NSUInteger nameIndex = name ? [adjacency indexOfName:name] : NSNotFound;
+		if (name && nameIndex == NSNotFound) return;
+		
+		for (NSUInteger i = 0; i < adjacency->count; i++)
+		{
+			YapDatabaseRelationshipAdjacencyItem *item = &adjacency->items[i];
+			
+			if (name && item->nameIndex != nameIndex) continue;
+			
+			NSString *dstFilePath = item->isFilePath ? adjacency->filePaths[(NSUInteger)item->nodeRowid] : nil;
+			int64_t dstRowid = item->isFilePath ? 0 : item->nodeRowid;
+			
+			YapDatabaseRelationshipEdge *edge =
+			  [[YapDatabaseRelationshipEdge alloc] initWithRowid:item->edgeRowid
+			                                                name:adjacency->names[item->nameIndex]
+			                                                 src:srcRowid
+			                                                 dst:dstRowid
+			                                         dstFilePath:dstFilePath
+			                                               rules:item->rules
+			                                              manual:item->manual];
+			
+			edge->sourceKey = srcKey;
+			edge->sourceCollection = srcCollection;
+			
+			if (dstFilePath == nil)
+			{
+				YapCollectionKey *dst = [databaseTransaction collectionKeyForRowid:dstRowid];
+				
+				edge->destinationKey = dst.key;
+				edge->destinationCollection = dst.collection;
+			}
+			
+			block(edge, &stop);
+			if (stop) break;
+		}
+		
+		return;
+	}
+	
 	// There may be edges in memory that haven't yet been written to disk.
 	// We need to find these edges, and ensure they override their corresponding counterparts from disk.
 	
@@ -3863,8 +4902,48 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 		return;
 	}
 	
-	BOOL stop = NO;
-	
+	BOOL stop = NO;
+	
+	if (!databaseTransaction->isReadWriteTransaction && relationshipConnection->destinationAdjacencyCache)
+	{
+		// Read-only transaction, so there aren't any changes in memory.
+		// We can enumerate straight from the adjacencyCache.
+		
+		YapDatabaseRelationshipAdjacency *adjacency = [self adjacencyForDestination:dstRowid];
+		
+		NSUInteger nameIndex = name ? [adjacency indexOfName:name] : NSNotFound;
+		if (name && nameIndex == NSNotFound) return;
+		
+		for (NSUInteger i = 0; i < adjacency->count; i++)
+		{
+			YapDatabaseRelationshipAdjacencyItem *item = &adjacency->items[i];
+			
+			if (name && item->nameIndex != nameIndex) continue;
+			
+			YapDatabaseRelationshipEdge *edge =
+			  [[YapDatabaseRelationshipEdge alloc] initWithRowid:item->edgeRowid
+			                                                name:adjacency->names[item->nameIndex]
+			                                                 src:item->nodeRowid
+			                                                 dst:dstRowid
+			                                         dstFilePath:nil
+			                                               rules:item->rules
+			                                              manual:item->manual];
+			
+			YapCollectionKey *src = [databaseTransaction collectionKeyForRowid:item->nodeRowid];
+			
+			edge->sourceKey = src.key;
+			edge->sourceCollection = src.collection;
+			
+			edge->destinationKey = dstKey;
+			edge->destinationCollection = dstCollection;
+			
+			block(edge, &stop);
+			if (stop) break;
+		}
+		
+		return;
+	}
+	
 	// There may be edges in memory that haven't yet been written to disk.
 	// We need to find these edges, and ensure they override their corresponding counterparts from disk.
 	
@@ -4886,6 +5965,11 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 		return 0;
 	}
 	
+	if (relationshipConnection->sourceAdjacencyCache)
+	{
+		return [[self adjacencyForSource:srcRowid] countWithName:name];
+	}
+	
 	sqlite3_stmt *statement = NULL;
 	YapDatabaseString _name;
 	
@@ -4987,6 +6071,11 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 		return 0;
 	}
 	
+	if (relationshipConnection->destinationAdjacencyCache)
+	{
+		return [[self adjacencyForDestination:dstRowid] countWithName:name];
+	}
+	
 	sqlite3_stmt *statement = NULL;
 	YapDatabaseString _name;
 	
@@ -5258,173 +6347,605 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 		statement = [relationshipConnection countForSrcDstStatement];
 		if (statement == NULL) return 0;
 		
-		// SELECT COUNT(*) AS NumberOfRows FROM "tableName" WHERE "src" = ? AND "dst" = ?;
+		// SELECT COUNT(*) AS NumberOfRows FROM "tableName" WHERE "src" = ? AND "dst" = ?;
+		
+		sqlite3_bind_int64(statement, 1, srcRowid);
+		sqlite3_bind_int64(statement, 2, dstRowid);
+	}
+	
+	int64_t count = 0;
+	
+	
+	int status = sqlite3_step(statement);
+	if (status == SQLITE_ROW)
+	{
+		count = sqlite3_column_int64(statement, 0);
+	}
+	else if (status == SQLITE_ERROR)
+	{
+		YDBLogError(@"%@ - Error executing statement: %d %s", THIS_METHOD,
+		            status, sqlite3_errmsg(databaseTransaction->connection->db));
+	}
+	
+	sqlite3_clear_bindings(statement);
+	sqlite3_reset(statement);
+	if (name) {
+		FreeYapDatabaseString(&_name);
+	}
+	
+	return (NSUInteger)count;
+}
+
+/**
+ * Returns a count of every edge that matches any parameters you specify.
+ * You can specify any combination of the following:
+ *
+ * - name only
+ * - sourceKey & sourceCollection only
+ * - destinationFilePath
+ * - name + sourceKey & sourceCollection
+ * - name + destinationFilePath
+ * - name + sourceKey & sourceCollection + destinationFilePath
+ *
+ * @param name (optional)
+ *   The name of the edge (case sensitive).
+ *
+ * @param sourceKey (optional)
+ *   The edge.sourceKey to match.
+ *
+ * @param sourceCollection (optional)
+ *   The edge.sourceCollection to match.
+ * 
+ * @param destinationFilePath (optional)
+ *   The edge.destinationFilePath to match.
+ *
+ * If you pass a non-nil sourceKey, and sourceCollection is nil,
+ * then the sourceCollection is treated as the empty string, just like the rest of the YapDatabase framework.
+**/
+- (NSUInteger)edgeCountWithName:(NSString *)name
+                      sourceKey:(NSString *)srcKey
+                     collection:(NSString *)srcCollection
+            destinationFilePath:(NSString *)dstFilePath
+{
+	if (srcKey == nil)
+	{
+		if (dstFilePath == nil)
+			return [self edgeCountWithName:name];
+		else
+			return [self edgeCountWithName:name destinationFilePath:dstFilePath];
+	}
+	if (dstFilePath == nil)
+	{
+		return [self edgeCountWithName:name sourceKey:srcKey collection:srcCollection];
+	}
+	
+	if (databaseTransaction->isReadWriteTransaction)
+	{
+		__block NSUInteger count = 0;
+		[self enumerateEdgesWithName:name
+		                   sourceKey:srcKey
+		                  collection:srcCollection
+		         destinationFilePath:dstFilePath
+		                  usingBlock:^(YapDatabaseRelationshipEdge *edge, BOOL *stop) {
+			
+			count++;
+		}];
+		
+		return count;
+	}
+	
+	if (srcCollection == nil)
+		srcCollection = @"";
+	
+	BOOL found;
+	
+	int64_t srcRowid = 0;
+	found = [databaseTransaction getRowid:&srcRowid forKey:srcKey inCollection:srcCollection];
+	if (!found)
+	{
+		// The item doesn't exist in the database.
+		return 0;
+	}
+	
+	sqlite3_stmt *statement = NULL;
+	YapDatabaseString _name;
+	YapDatabaseString _dstFilePath;
+	__attribute__((objc_precise_lifetime)) NSData *dstBlob = nil;
+	
+	YapDatabaseRelationshipFilePathEncryptor dstFilePathEncryptor =
+	  relationshipConnection->relationship->options.destinationFilePathEncryptor;
+	
+	if (name)
+	{
+		statement = [relationshipConnection countForSrcDstNameStatement];
+		if (statement == NULL) return 0;
+		
+		// SELECT COUNT(*) AS NumberOfRows FROM "tableName" WHERE "src" = ? AND "dst" = ? AND "name" = ?;
+		
+		sqlite3_bind_int64(statement, 1, srcRowid);
+		
+		if (dstFilePathEncryptor) {
+			dstBlob = dstFilePathEncryptor(dstFilePath);
+		}
+		
+		if (dstBlob)
+		{
+			sqlite3_bind_blob(statement, 2, dstBlob.bytes, (int)dstBlob.length, SQLITE_STATIC);
+		}
+		else
+		{
+			MakeYapDatabaseString(&_dstFilePath, dstFilePath);
+			sqlite3_bind_text(statement, 2, _dstFilePath.str, _dstFilePath.length, SQLITE_STATIC);
+		}
+		
+		MakeYapDatabaseString(&_name, name);
+		sqlite3_bind_text(statement, 3, _name.str, _name.length, SQLITE_STATIC);
+	}
+	else
+	{
+		statement = [relationshipConnection countForSrcDstStatement];
+		if (statement == NULL) return 0;
+		
+		// SELECT COUNT(*) AS NumberOfRows FROM "tableName" WHERE "src" = ? AND "dst" = ?;
+		
+		sqlite3_bind_int64(statement, 1, srcRowid);
+		
+		if (dstFilePathEncryptor) {
+			dstBlob = dstFilePathEncryptor(dstFilePath);
+		}
+		
+		if (dstBlob)
+		{
+			sqlite3_bind_blob(statement, 2, dstBlob.bytes, (int)dstBlob.length, SQLITE_STATIC);
+		}
+		else
+		{
+			MakeYapDatabaseString(&_dstFilePath, dstFilePath);
+			sqlite3_bind_text(statement, 2, _dstFilePath.str, _dstFilePath.length, SQLITE_STATIC);
+		}
+	}
+	
+	int64_t count = 0;
+	
+	
+	int status = sqlite3_step(statement);
+	if (status == SQLITE_ROW)
+	{
+		count = sqlite3_column_int64(statement, 0);
+	}
+	else if (status == SQLITE_ERROR)
+	{
+		YDBLogError(@"%@ - Error executing statement: %d %s", THIS_METHOD,
+		            status, sqlite3_errmsg(databaseTransaction->connection->db));
+	}
+	
+	sqlite3_clear_bindings(statement);
+	sqlite3_reset(statement);
+	if (name) {
+		FreeYapDatabaseString(&_name);
+	}
+	if (!dstBlob) {
+		FreeYapDatabaseString(&_dstFilePath);
+	}
+	
+	return (NSUInteger)count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Public API - Traverse
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The traversal queries only see edges that have been written to the database table.
+ * Within a read-write transaction, there may be edge changes (or deleted nodes) sitting in memory,
+ * which haven't been flushed to the table yet.
+**/
+- (BOOL)hasUnflushedChanges
+{
+	if (!databaseTransaction->isReadWriteTransaction) return NO;
+	
+	return ([relationshipConnection->protocolChanges count] > 0 ||
+	        [relationshipConnection->manualChanges   count] > 0 ||
+	        [relationshipConnection->deletedInfo     count] > 0 ||
+	        [relationshipConnection->deletedOrder    count] > 0  );
+}
+
+/**
+ * Returns the rowids of the nodes one hop away from the given node (as NSNumbers).
+ * 
+ * This goes through the regular enumeration methods,
+ * so it includes edge changes that haven't been flushed to the database table yet.
+**/
+- (NSArray *)neighborRowidsForRowid:(int64_t)rowid edgeNames:(NSArray *)edgeNames incoming:(BOOL)incoming
+{
+	YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
+	if (ck == nil) return nil;
+	
+	NSString *name = ([edgeNames count] == 1) ? [edgeNames objectAtIndex:0] : nil;
+	BOOL filterNames = ([edgeNames count] > 1);
+	
+	NSMutableArray *neighbors = [NSMutableArray array];
+	
+	void (^enumBlock)(YapDatabaseRelationshipEdge *edge, BOOL *stop);
+	enumBlock = ^(YapDatabaseRelationshipEdge *edge, BOOL *stop) {
+		
+		if (filterNames && ![edgeNames containsObject:edge->name]) return;
+		
+		int64_t neighborRowid = 0;
+		BOOL found = NO;
+		
+		if (incoming)
+		{
+			if ((edge->flags & YDB_FlagsHasSourceRowid)) {
+				neighborRowid = edge->sourceRowid;
+				found = YES;
+			}
+			else {
+				found = [databaseTransaction getRowid:&neighborRowid
+				                               forKey:edge->sourceKey
+				                         inCollection:edge->sourceCollection];
+			}
+		}
+		else
+		{
+			if (edge->destinationFilePath) return;
+			
+			if ((edge->flags & YDB_FlagsHasDestinationRowid)) {
+				neighborRowid = edge->destinationRowid;
+				found = YES;
+			}
+			else {
+				found = [databaseTransaction getRowid:&neighborRowid
+				                               forKey:edge->destinationKey
+				                         inCollection:edge->destinationCollection];
+			}
+		}
+		
+		if (found) {
+			[neighbors addObject:@(neighborRowid)];
+		}
+	};
+	
+	if (incoming)
+		[self enumerateEdgesWithName:name destinationKey:ck.key collection:ck.collection usingBlock:enumBlock];
+	else
+		[self enumerateEdgesWithName:name sourceKey:ck.key collection:ck.collection usingBlock:enumBlock];
+	
+	return neighbors;
+}
+
+/**
+ * Depth first traversal, expanding one node at a time.
+ * The neighbors block returns the rowids of the nodes one hop away from the given node (as NSNumbers).
+ * 
+ * Each node is reported once (on its first visit), and is normally expanded only once too.
+ * That's what keeps a graph with many alternate paths to the same nodes from blowing up.
+ * 
+ * The exception is a maxDepth, since a node first reached along a long path would have its children cut off,
+ * even though they're within maxDepth along a shorter path. So we remember the depth at which each node was expanded,
+ * and expand it again only if it's later reached at a smaller depth.
+ * Thus each node is expanded at most maxDepth times.
+ * Cycles are never followed, as a node on the current path has already been expanded at a smaller depth.
+**/
+- (void)_depthFirstEnumerateRowidsReachableFromRowid:(int64_t)startRowid
+                                            maxDepth:(NSUInteger)maxDepth
+                                           neighbors:(NSArray* (^)(int64_t rowid))neighborsBlock
+                                          usingBlock:(void (^)(int64_t rowid, NSUInteger depth, BOOL *stop))block
+{
+	// key:(NSNumber *)rowid, value:(NSNumber *)depth at which the node was (last) expanded
+	NSMutableDictionary *expandedDepths = [NSMutableDictionary dictionary];
+	[expandedDepths setObject:@(0) forKey:@(startRowid)];
+	
+	// Each stack frame is an array of rowids (still to be visited) at depth == frame index + 1.
+	
+	NSMutableArray *stack = [NSMutableArray array];
+	
+	NSArray *neighbors = neighborsBlock(startRowid);
+	[stack addObject:[neighbors mutableCopy] ?: [NSMutableArray array]];
+	
+	BOOL stop = NO;
+	
+	while (([stack count] > 0) && !stop)
+	{
+		NSMutableArray *frame = [stack lastObject];
+		if ([frame count] == 0)
+		{
+			[stack removeLastObject];
+			continue;
+		}
+		
+		NSNumber *number = [frame objectAtIndex:0];
+		[frame removeObjectAtIndex:0];
+		
+		NSUInteger depth = [stack count];
+		
+		NSNumber *expandedDepth = [expandedDepths objectForKey:number];
+		if (expandedDepth)
+		{
+			if (maxDepth == 0) continue;
+			if ([expandedDepth unsignedIntegerValue] <= depth) continue;
+		}
+		else
+		{
+			block([number longLongValue], depth, &stop);
+			if (stop) break;
+		}
+		
+		[expandedDepths setObject:@(depth) forKey:number];
 		
-		sqlite3_bind_int64(statement, 1, srcRowid);
-		sqlite3_bind_int64(statement, 2, dstRowid);
+		if (maxDepth == 0 || depth < maxDepth)
+		{
+			neighbors = neighborsBlock([number longLongValue]);
+			[stack addObject:[neighbors mutableCopy] ?: [NSMutableArray array]];
+		}
 	}
+}
+
+/**
+ * Breadth first traversal, expanding one level at a time (in memory).
+ * The neighbors block returns the rowids of the nodes one hop away from the given node (as NSNumbers).
+ * 
+ * Uses a visited set (the first visit to a node is always along a shortest path).
+**/
+- (void)_breadthFirstEnumerateRowidsReachableFromRowid:(int64_t)startRowid
+                                              maxDepth:(NSUInteger)maxDepth
+                                             neighbors:(NSArray* (^)(int64_t rowid))neighborsBlock
+                                            usingBlock:(void (^)(int64_t rowid, NSUInteger depth, BOOL *stop))block
+{
+	YapRowidSet *visited = YapRowidSetCreate(0);
+	YapRowidSetAdd(visited, startRowid);
 	
-	int64_t count = 0;
-	
+	NSArray *frontier = @[ @(startRowid) ];
+	NSUInteger depth = 0;
+	BOOL stop = NO;
 	
-	int status = sqlite3_step(statement);
-	if (status == SQLITE_ROW)
-	{
-		count = sqlite3_column_int64(statement, 0);
-	}
-	else if (status == SQLITE_ERROR)
+	while (([frontier count] > 0) && (maxDepth == 0 || depth < maxDepth) && !stop)
 	{
-		YDBLogError(@"%@ - Error executing statement: %d %s", THIS_METHOD,
-		            status, sqlite3_errmsg(databaseTransaction->connection->db));
-	}
-	
-	sqlite3_clear_bindings(statement);
-	sqlite3_reset(statement);
-	if (name) {
-		FreeYapDatabaseString(&_name);
+		depth++;
+		NSMutableArray *nextFrontier = [NSMutableArray array];
+		
+		for (NSNumber *number in frontier)
+		{
+			NSArray *neighbors = neighborsBlock([number longLongValue]);
+			
+			for (NSNumber *neighbor in neighbors)
+			{
+				int64_t rowid = [neighbor longLongValue];
+				if (YapRowidSetContains(visited, rowid)) continue;
+				
+				YapRowidSetAdd(visited, rowid);
+				[nextFrontier addObject:neighbor];
+				
+				block(rowid, depth, &stop);
+				if (stop) break;
+			}
+			
+			if (stop) break;
+		}
+		
+		frontier = nextFrontier;
 	}
 	
-	return (NSUInteger)count;
+	YapRowidSetRelease(visited);
 }
 
 /**
- * Returns a count of every edge that matches any parameters you specify.
- * You can specify any combination of the following:
- *
- * - name only
- * - sourceKey & sourceCollection only
- * - destinationFilePath
- * - name + sourceKey & sourceCollection
- * - name + destinationFilePath
- * - name + sourceKey & sourceCollection + destinationFilePath
- *
- * @param name (optional)
- *   The name of the edge (case sensitive).
- *
- * @param sourceKey (optional)
- *   The edge.sourceKey to match.
- *
- * @param sourceCollection (optional)
- *   The edge.sourceCollection to match.
- * 
- * @param destinationFilePath (optional)
- *   The edge.destinationFilePath to match.
- *
- * If you pass a non-nil sourceKey, and sourceCollection is nil,
- * then the sourceCollection is treated as the empty string, just like the rest of the YapDatabase framework.
+ * Hop by hop traversal, used when there are unflushed changes.
 **/
-- (NSUInteger)edgeCountWithName:(NSString *)name
-                      sourceKey:(NSString *)srcKey
-                     collection:(NSString *)srcCollection
-            destinationFilePath:(NSString *)dstFilePath
+- (void)_hopByHopEnumerateRowidsReachableFromRowid:(int64_t)startRowid
+                                         edgeNames:(NSArray *)edgeNames
+                                          incoming:(BOOL)incoming
+                                        depthFirst:(BOOL)depthFirst
+                                          maxDepth:(NSUInteger)maxDepth
+                                        usingBlock:(void (^)(int64_t rowid, NSUInteger depth, BOOL *stop))block
 {
-	if (srcKey == nil)
+	NSArray* (^neighborsBlock)(int64_t rowid) = ^NSArray *(int64_t rowid) {
+		
+		return [self neighborRowidsForRowid:rowid edgeNames:edgeNames incoming:incoming];
+	};
+	
+	if (depthFirst)
 	{
-		if (dstFilePath == nil)
-			return [self edgeCountWithName:name];
-		else
-			return [self edgeCountWithName:name destinationFilePath:dstFilePath];
+		[self _depthFirstEnumerateRowidsReachableFromRowid:startRowid
+		                                          maxDepth:maxDepth
+		                                         neighbors:neighborsBlock
+		                                        usingBlock:block];
 	}
-	if (dstFilePath == nil)
+	else
 	{
-		return [self edgeCountWithName:name sourceKey:srcKey collection:srcCollection];
+		[self _breadthFirstEnumerateRowidsReachableFromRowid:startRowid
+		                                            maxDepth:maxDepth
+		                                           neighbors:neighborsBlock
+		                                          usingBlock:block];
 	}
-	
-	if (databaseTransaction->isReadWriteTransaction)
+}
+
+/**
+ * Breadth first traversal of the edge table, performed by the database one level at a time.
+ * 
+ * The nodes reached so far (and the depth at which each was first reached) are kept in the traversal table.
+ * Each level is a single statement that inserts the neighbors of the previous level, skipping nodes already reached.
+ * So each node is expanded once, and the work is proportional to the number of nodes & edges reached,
+ * regardless of how many paths lead to each node.
+ * 
+ * The block is optional. If NULL, the nodes are only counted.
+ * 
+ * The traversal table belongs to the connection, so only one of these traversals can use it at a time.
+ * A traversal started from within the block (i.e. a nested traversal) is instead performed in memory,
+ * one node at a time.
+ * 
+ * @return The number of nodes reached (not counting the starting node).
+**/
+- (NSUInteger)_breadthFirstEnumerateRowidsReachableFromRowid:(int64_t)startRowid
+                                                   edgeNames:(NSArray *)edgeNames
+                                                    incoming:(BOOL)incoming
+                                                    maxDepth:(NSUInteger)maxDepth
+                                                  usingBlock:(void (^)(int64_t rowid, NSUInteger depth, BOOL *stop))block
+{
+	if (relationshipConnection->traversalTableInUse)
 	{
 		__block NSUInteger count = 0;
-		[self enumerateEdgesWithName:name
-		                   sourceKey:srcKey
-		                  collection:srcCollection
-		         destinationFilePath:dstFilePath
-		                  usingBlock:^(YapDatabaseRelationshipEdge *edge, BOOL *stop) {
+		
+		[self _breadthFirstEnumerateRowidsReachableFromRowid:startRowid
+		                                            maxDepth:maxDepth
+		                                           neighbors:^NSArray *(int64_t rowid)
+		{
+			return [self flushedNeighborRowidsForRowid:rowid edgeNames:edgeNames incoming:incoming];
+			
+		} usingBlock:^(int64_t rowid, NSUInteger depth, BOOL *stop) {
 			
 			count++;
+			if (block) block(rowid, depth, stop);
 		}];
 		
 		return count;
 	}
 	
-	if (srcCollection == nil)
-		srcCollection = @"";
+	if (![relationshipConnection createTraversalTableIfNeeded]) return 0;
 	
-	BOOL found;
+	sqlite3_stmt *insertStatement    = [relationshipConnection traversalTableInsertStatement];
+	sqlite3_stmt *removeAllStatement = [relationshipConnection traversalTableRemoveAllStatement];
+	sqlite3_stmt *depthStatement     = [relationshipConnection traversalTableEnumerateDepthStatement];
+	sqlite3_stmt *expandStatement    = [relationshipConnection traversalExpandStatementWithEdgeNameCount:[edgeNames count]
+	                                                                                            incoming:incoming];
 	
-	int64_t srcRowid = 0;
-	found = [databaseTransaction getRowid:&srcRowid forKey:srcKey inCollection:srcCollection];
-	if (!found)
+	if (!insertStatement || !removeAllStatement || !depthStatement || !expandStatement) return 0;
+	
+	relationshipConnection->traversalTableInUse = YES;
+	
+	sqlite3 *db = databaseTransaction->connection->db;
+	int status;
+	
+	// INSERT OR IGNORE INTO temp."tableName_traversal" ("rowid", "depth") VALUES (?, ?);
+	
+	sqlite3_bind_int64(insertStatement, 1, startRowid);
+	sqlite3_bind_int64(insertStatement, 2, 0);
+	
+	status = sqlite3_step(insertStatement);
+	if (status != SQLITE_DONE)
 	{
-		// The item doesn't exist in the database.
-		return 0;
+		YDBLogError(@"%@ - Error executing 'traversalTableInsertStatement': %d %s", THIS_METHOD,
+		            status, sqlite3_errmsg(db));
 	}
 	
-	sqlite3_stmt *statement = NULL;
-	YapDatabaseString _name;
-	YapDatabaseString _dstFilePath;
-	__attribute__((objc_precise_lifetime)) NSData *dstBlob = nil;
+	sqlite3_clear_bindings(insertStatement);
+	sqlite3_reset(insertStatement);
 	
-	YapDatabaseRelationshipFilePathEncryptor dstFilePathEncryptor =
-	  relationshipConnection->relationship->options.destinationFilePathEncryptor;
+	NSUInteger count = 0;
+	NSUInteger depth = 0;
+	BOOL stop = NO;
 	
-	if (name)
+	while ((status == SQLITE_DONE) && (maxDepth == 0 || depth < maxDepth) && !stop)
 	{
-		statement = [relationshipConnection countForSrcDstNameStatement];
-		if (statement == NULL) return 0;
-		
-		// SELECT COUNT(*) AS NumberOfRows FROM "tableName" WHERE "src" = ? AND "dst" = ? AND "name" = ?;
+		// INSERT OR IGNORE INTO temp."tableName_traversal" ("rowid", "depth")
+		//   SELECT "e"."dst", ?1 + 1 FROM temp."tableName_traversal" AS "t" JOIN "tableName" AS "e" ON ...
+		//   WHERE "t"."depth" = ?1 ...;
+		//
+		// The expand statement lives in the connection's statement cache,
+		// which a nested traversal (from within the block) may have evicted it from. So we fetch it for each level.
 		
-		sqlite3_bind_int64(statement, 1, srcRowid);
+		expandStatement = [relationshipConnection traversalExpandStatementWithEdgeNameCount:[edgeNames count]
+		                                                                            incoming:incoming];
+		if (expandStatement == NULL) break;
 		
-		if (dstFilePathEncryptor) {
-			dstBlob = dstFilePathEncryptor(dstFilePath);
-		}
+		sqlite3_bind_int64(expandStatement, 1, (int64_t)depth);
 		
-		if (dstBlob)
+		int bindIdx = 2;
+		for (NSString *edgeName in edgeNames)
 		{
-			sqlite3_bind_blob(statement, 2, dstBlob.bytes, (int)dstBlob.length, SQLITE_STATIC);
+			sqlite3_bind_text(expandStatement, bindIdx, [edgeName UTF8String], -1, SQLITE_TRANSIENT);
+			bindIdx++;
 		}
-		else
+		
+		status = sqlite3_step(expandStatement);
+		if (status != SQLITE_DONE)
 		{
-			MakeYapDatabaseString(&_dstFilePath, dstFilePath);
-			sqlite3_bind_text(statement, 2, _dstFilePath.str, _dstFilePath.length, SQLITE_STATIC);
+			YDBLogError(@"%@ - Error executing 'traversalExpandStatement': %d %s", THIS_METHOD,
+			            status, sqlite3_errmsg(db));
 		}
 		
-		MakeYapDatabaseString(&_name, name);
-		sqlite3_bind_text(statement, 3, _name.str, _name.length, SQLITE_STATIC);
-	}
-	else
-	{
-		statement = [relationshipConnection countForSrcDstStatement];
-		if (statement == NULL) return 0;
+		int changes = sqlite3_changes(db);
 		
-		// SELECT COUNT(*) AS NumberOfRows FROM "tableName" WHERE "src" = ? AND "dst" = ?;
+		sqlite3_clear_bindings(expandStatement);
+		sqlite3_reset(expandStatement);
 		
-		sqlite3_bind_int64(statement, 1, srcRowid);
+		if ((status != SQLITE_DONE) || (changes <= 0)) break;
 		
-		if (dstFilePathEncryptor) {
-			dstBlob = dstFilePathEncryptor(dstFilePath);
-		}
+		depth++;
+		count += (NSUInteger)changes;
 		
-		if (dstBlob)
+		if (block == NULL) continue;
+		
+		// SELECT "rowid" FROM temp."tableName_traversal" WHERE "depth" = ?;
+		
+		sqlite3_bind_int64(depthStatement, 1, (int64_t)depth);
+		
+		while ((status = sqlite3_step(depthStatement)) == SQLITE_ROW)
 		{
-			sqlite3_bind_blob(statement, 2, dstBlob.bytes, (int)dstBlob.length, SQLITE_STATIC);
+			int64_t rowid = sqlite3_column_int64(depthStatement, 0);
+			
+			block(rowid, depth, &stop);
+			if (stop) break;
 		}
-		else
+		
+		if (status != SQLITE_DONE && !stop)
 		{
-			MakeYapDatabaseString(&_dstFilePath, dstFilePath);
-			sqlite3_bind_text(statement, 2, _dstFilePath.str, _dstFilePath.length, SQLITE_STATIC);
+			YDBLogError(@"%@ - Error executing 'traversalTableEnumerateDepthStatement': %d %s", THIS_METHOD,
+			            status, sqlite3_errmsg(db));
 		}
+		
+		sqlite3_clear_bindings(depthStatement);
+		sqlite3_reset(depthStatement);
+		
+		if (stop) status = SQLITE_DONE;
 	}
 	
-	int64_t count = 0;
+	// DELETE FROM temp."tableName_traversal";
+	
+	status = sqlite3_step(removeAllStatement);
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - Error executing 'traversalTableRemoveAllStatement': %d %s", THIS_METHOD,
+		            status, sqlite3_errmsg(db));
+	}
 	
+	sqlite3_reset(removeAllStatement);
 	
-	int status = sqlite3_step(statement);
-	if (status == SQLITE_ROW)
+	relationshipConnection->traversalTableInUse = NO;
+	
+	return count;
+}
+
+/**
+ * Returns the rowids of the nodes one hop away from the given node (as NSNumbers),
+ * using only the edges in the database table.
+**/
+- (NSArray *)flushedNeighborRowidsForRowid:(int64_t)rowid edgeNames:(NSArray *)edgeNames incoming:(BOOL)incoming
+{
+	sqlite3_stmt *statement = [relationshipConnection traversalNeighborsStatementWithEdgeNameCount:[edgeNames count]
+	                                                                                      incoming:incoming];
+	if (statement == NULL) return nil;
+	
+	// SELECT "e"."dst" FROM "tableName" AS "e" WHERE "e"."src" = ?1 AND ...;
+	
+	sqlite3_bind_int64(statement, 1, rowid);
+	
+	int bindIdx = 2;
+	for (NSString *edgeName in edgeNames)
 	{
-		count = sqlite3_column_int64(statement, 0);
+		sqlite3_bind_text(statement, bindIdx, [edgeName UTF8String], -1, SQLITE_TRANSIENT);
+		bindIdx++;
 	}
-	else if (status == SQLITE_ERROR)
+	
+	NSMutableArray *neighbors = [NSMutableArray array];
+	
+	int status;
+	while ((status = sqlite3_step(statement)) == SQLITE_ROW)
+	{
+		[neighbors addObject:@(sqlite3_column_int64(statement, 0))];
+	}
+	
+	if (status != SQLITE_DONE)
 	{
 		YDBLogError(@"%@ - Error executing statement: %d %s", THIS_METHOD,
 		            status, sqlite3_errmsg(databaseTransaction->connection->db));
@@ -5432,14 +6953,150 @@ NS_INLINE BOOL EdgeMatchesDestination(YapDatabaseRelationshipEdge *edge, int64_t
 	
 	sqlite3_clear_bindings(statement);
 	sqlite3_reset(statement);
-	if (name) {
-		FreeYapDatabaseString(&_name);
+	
+	return neighbors;
+}
+
+/**
+ * Enumerates the rowids of the nodes reachable from the given node, in visit order.
+ * Each node is reported once (on its first visit).
+**/
+- (void)_enumerateRowidsReachableFromRowid:(int64_t)startRowid
+                                 edgeNames:(NSArray *)edgeNames
+                                  incoming:(BOOL)incoming
+                                depthFirst:(BOOL)depthFirst
+                                  maxDepth:(NSUInteger)maxDepth
+                                usingBlock:(void (^)(int64_t rowid, NSUInteger depth, BOOL *stop))block
+{
+	if ([self hasUnflushedChanges])
+	{
+		[self _hopByHopEnumerateRowidsReachableFromRowid:startRowid
+		                                       edgeNames:edgeNames
+		                                        incoming:incoming
+		                                      depthFirst:depthFirst
+		                                        maxDepth:maxDepth
+		                                      usingBlock:block];
 	}
-	if (!dstBlob) {
-		FreeYapDatabaseString(&_dstFilePath);
+	else if (depthFirst)
+	{
+		[self _depthFirstEnumerateRowidsReachableFromRowid:startRowid
+		                                          maxDepth:maxDepth
+		                                         neighbors:^NSArray *(int64_t rowid)
+		{
+			return [self flushedNeighborRowidsForRowid:rowid edgeNames:edgeNames incoming:incoming];
+			
+		} usingBlock:block];
 	}
+	else
+	{
+		[self _breadthFirstEnumerateRowidsReachableFromRowid:startRowid
+		                                           edgeNames:edgeNames
+		                                            incoming:incoming
+		                                            maxDepth:maxDepth
+		                                          usingBlock:block];
+	}
+}
+
+/**
+ * Enumerates every node reachable from the given node, by following edges across any number of hops.
+ * 
+ * Each node is visited at most once, and the starting node itself is never visited.
+ * Cycles in the graph are detected, and are not followed.
+ * Edges with a destinationFilePath are not followed.
+ * 
+ * @param edgeNames (optional)
+ *   If given, only edges with one of these names (case sensitive) are followed.
+ *   If nil, every edge is followed.
+ * 
+ * @param maxDepth
+ *   The maximum number of hops to take from the starting node.
+ *   Pass zero for no limit.
+**/
+- (void)enumerateNodesReachableFromKey:(NSString *)key
+                          inCollection:(NSString *)collection
+                         withEdgeNames:(NSArray *)edgeNames
+                             direction:(YapDatabaseRelationshipTraversalDirection)direction
+                                 order:(YapDatabaseRelationshipTraversalOrder)order
+                              maxDepth:(NSUInteger)maxDepth
+                            usingBlock:(void (^)(NSString *collection, NSString *key, NSUInteger depth, BOOL *stop))block
+{
+	if (key == nil) return;
+	if (block == NULL) return;
 	
-	return (NSUInteger)count;
+	if (collection == nil)
+		collection = @"";
+	
+	int64_t startRowid = 0;
+	BOOL found = [databaseTransaction getRowid:&startRowid forKey:key inCollection:collection];
+	if (!found)
+	{
+		// The item doesn't exist in the database.
+		return;
+	}
+	
+	[self _enumerateRowidsReachableFromRowid:startRowid
+	                               edgeNames:edgeNames
+	                                incoming:(direction == YapDatabaseRelationshipTraversalIncoming)
+	                              depthFirst:(order == YapDatabaseRelationshipTraversalDepthFirst)
+	                                maxDepth:maxDepth
+	                              usingBlock:^(int64_t rowid, NSUInteger depth, BOOL *stop)
+	{
+		YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
+		if (ck)
+		{
+			block(ck.collection, ck.key, depth, stop);
+		}
+	}];
+}
+
+/**
+ * Returns the number of distinct nodes reachable from the given node,
+ * by following edges across any number of hops (up to maxDepth, or unlimited if maxDepth is zero).
+ * 
+ * The starting node itself is not counted.
+**/
+- (NSUInteger)nodeCountReachableFromKey:(NSString *)key
+                           inCollection:(NSString *)collection
+                          withEdgeNames:(NSArray *)edgeNames
+                              direction:(YapDatabaseRelationshipTraversalDirection)direction
+                               maxDepth:(NSUInteger)maxDepth
+{
+	if (key == nil) return 0;
+	
+	if (collection == nil)
+		collection = @"";
+	
+	int64_t startRowid = 0;
+	BOOL found = [databaseTransaction getRowid:&startRowid forKey:key inCollection:collection];
+	if (!found)
+	{
+		// The item doesn't exist in the database.
+		return 0;
+	}
+	
+	BOOL incoming = (direction == YapDatabaseRelationshipTraversalIncoming);
+	
+	if ([self hasUnflushedChanges])
+	{
+		__block NSUInteger count = 0;
+		[self _hopByHopEnumerateRowidsReachableFromRowid:startRowid
+		                                       edgeNames:edgeNames
+		                                        incoming:incoming
+		                                      depthFirst:NO
+		                                        maxDepth:maxDepth
+		                                      usingBlock:^(int64_t rowid, NSUInteger depth, BOOL *stop)
+		{
+			count++;
+		}];
+		
+		return count;
+	}
+	
+	return [self _breadthFirstEnumerateRowidsReachableFromRowid:startRowid
+	                                                  edgeNames:edgeNames
+	                                                   incoming:incoming
+	                                                   maxDepth:maxDepth
+	                                                 usingBlock:NULL];
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -3,6 +3,7 @@
 #import "YapDatabaseSearchResultsViewTransaction.h"
 
 #import "YapDatabaseViewPrivate.h"
+#import "YapRowidSet.h"
 
 /**
  * This version number is stored in the yap2 table.
@@ -32,6 +33,36 @@ static NSString *const changeset_key_query = @"query";
 #pragma mark -
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Stores the progress of a time-sliced search (performSearchSliceWithQueue:maxRows:).
+ *
+ * The search is spread across multiple readWrite transactions,
+ * so this state is kept by the connection in-between slices.
+**/
+@interface YapDatabaseSearchResultsViewSearchSlice : NSObject {
+@public
+	
+	NSString *query;
+	
+	YapRowidSet *ftsRowids;       // Results of the FTS query (owned by the slice in-between transactions)
+	NSMutableDictionary *snippets;
+	
+	NSMutableArray *groups;       // Remaining groups to process. The first group is the one in-progress.
+	NSUInteger parentIndex;       // Position within first group of parentView (parentView mode)
+	NSUInteger viewIndex;         // Position within first group of our view
+	BOOL restartedGroup;          // Whether the slice (or its first group) was restarted due to an external change
+	
+	YapRowidSet *ftsRowidsLeft;   // Rowids not yet in the view (groupingBlock mode)
+	
+	uint64_t snapshot;            // Connection snapshot at the start of the last slice
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 @interface YapDatabaseSearchResultsViewConnection () {
 @private
 	
@@ -43,6 +74,8 @@ static NSString *const changeset_key_query = @"query";
 - (void)setQuery:(NSString *)newQuery isChange:(BOOL)isChange;
 - (void)getQuery:(NSString **)queryPtr wasChanged:(BOOL *)wasChangedPtr;
 
+@property (nonatomic, strong, readwrite) YapDatabaseSearchResultsViewSearchSlice *searchSlice;
+
 - (sqlite3_stmt *)snippetTable_getForRowidStatement;
 - (sqlite3_stmt *)snippetTable_setForRowidStatement;
 - (sqlite3_stmt *)snippetTable_removeForRowidStatement;
@@ -1,5 +1,6 @@
 #import <Foundation/Foundation.h>
 #import "YapDatabaseViewConnection.h"
+#import "YapDatabaseSearchQueue.h"
 
 @class YapDatabaseSearchResultsView;
 
@@ -9,4 +10,39 @@
 // Returns properly typed parent instance
 @property (nonatomic, strong, readonly) YapDatabaseSearchResultsView *searchResultsView;
 
+/**
+ * Performs a time-sliced search, using the given search queue.
+ *
+ * Rather than performing the entire search within a single readWrite transaction,
+ * the search is broken into slices, and each slice is performed in its own readWrite transaction.
+ * Thus other readWrite transactions (on any connection) can run in-between slices,
+ * and the partial search results are published (via the normal changeset mechanism) as each slice commits.
+ *
+ * Before each slice, the search queue is checked.
+ * If a new query has been enqueued, then the search in progress is dropped,
+ * and the remaining slices are used to perform the most recent query.
+ * The search can also be aborted at any time via [YapDatabaseSearchQueue abortSearchInProgressAndRollback:].
+ *
+ * @param searchQueue
+ *   The search queue from which to fetch the query (via the same rules as performSearchWithQueue:).
+ *
+ * @param maxRows
+ *   The maximum number of rows to process within a single slice.
+ *   That is, the number of rows (of the parentView, or of the FTS results) that are processed
+ *   before the readWrite transaction is committed, and the next slice is scheduled.
+ *
+ * @param completionQueue
+ *   The dispatch queue to invoke the completionBlock on.
+ *   If NULL, dispatch_get_main_queue() is automatically used.
+ *
+ * @param completionBlock
+ *   An optional block to invoke once the last slice has committed.
+ *
+ * @see [YapDatabaseSearchResultsViewTransaction performSearchSliceWithQueue:maxRows:]
+**/
+- (void)asyncPerformSearchWithQueue:(YapDatabaseSearchQueue *)searchQueue
+                    maxRowsPerSlice:(NSUInteger)maxRows
+                    completionQueue:(dispatch_queue_t)completionQueue
+                    completionBlock:(dispatch_block_t)completionBlock;
+
 @end
@@ -21,6 +21,26 @@
 #pragma unused(ydbLogLevel)
 
 
+@implementation YapDatabaseSearchResultsViewSearchSlice
+
+- (void)dealloc
+{
+	if (ftsRowids) {
+		YapRowidSetRelease(ftsRowids);
+		ftsRowids = NULL;
+	}
+	if (ftsRowidsLeft) {
+		YapRowidSetRelease(ftsRowidsLeft);
+		ftsRowidsLeft = NULL;
+	}
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 @implementation YapDatabaseSearchResultsViewConnection
 {
 	sqlite3_stmt *snippetTable_getForRowidStatement;
@@ -29,6 +49,8 @@
 	sqlite3_stmt *snippetTable_removeAllStatement;
 }
 
+@synthesize searchSlice = searchSlice;
+
 - (void)_flushStatements
 {
 	[super _flushStatements];
@@ -73,6 +95,61 @@
 	return transaction;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Searching
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Performs a time-sliced search using a series of asyncReadWrite transactions.
+ *
+ * Each transaction invokes performSearchSliceWithQueue:maxRows:,
+ * and the next transaction is only scheduled after the previous one has committed.
+ * This allows other readWrite transactions to interleave with the search,
+ * and allows the partial search results to be published via the normal changeset mechanism.
+**/
+- (void)asyncPerformSearchWithQueue:(YapDatabaseSearchQueue *)searchQueue
+                    maxRowsPerSlice:(NSUInteger)maxRows
+                    completionQueue:(dispatch_queue_t)completionQueue
+                    completionBlock:(dispatch_block_t)completionBlock
+{
+	YDBLogAutoTrace();
+	
+	if (completionQueue == NULL && completionBlock != NULL)
+		completionQueue = dispatch_get_main_queue();
+	
+	NSString *extName = [view registeredName];
+	YapDatabaseConnection *dbConnection = databaseConnection;
+	
+	__block BOOL isComplete = YES;
+	
+	[dbConnection asyncReadWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+		
+		// If the view was unregistered in the meantime, there's nothing left to search.
+		// So we treat that as complete (rather than scheduling another slice, forever).
+		
+		YapDatabaseSearchResultsViewTransaction *viewTransaction = [transaction ext:extName];
+		if (viewTransaction)
+		{
+			isComplete = [viewTransaction performSearchSliceWithQueue:searchQueue maxRows:maxRows];
+		}
+		
+	} completionQueue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0) completionBlock:^{
+		
+		if (isComplete)
+		{
+			if (completionBlock)
+				dispatch_async(completionQueue, completionBlock);
+		}
+		else
+		{
+			[self asyncPerformSearchWithQueue:searchQueue
+			                  maxRowsPerSlice:maxRows
+			                  completionQueue:completionQueue
+			                  completionBlock:completionBlock];
+		}
+	}];
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Changeset Architecture
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -87,6 +164,9 @@
 	
 	query = nil;
 	queryChanged = NO;
+	
+	// The view changes made by the slice were discarded, so the saved progress is no longer valid.
+	searchSlice = nil;
 }
 
 /**
@@ -144,6 +224,9 @@
 	if (changeset_query)
 	{
 		query = [changeset_query copy];
+		
+		// Another connection has performed a search, which supersedes any time-sliced search in progress.
+		searchSlice = nil;
 	}
 }
 
@@ -47,4 +47,26 @@
 **/
 - (void)performSearchWithQueue:(YapDatabaseSearchQueue *)queue;
 
+/**
+ * Performs a single slice of a time-sliced search.
+ *
+ * Rather than processing the entire search (which may take a long time for large views),
+ * this method processes at most maxRows rows, and then returns.
+ * The progress is stored by the extension connection,
+ * and the next invocation (generally in the next readWrite transaction) continues where this one left off.
+ * The view reflects partial search results in-between slices.
+ *
+ * If a new query has been enqueued since the previous slice,
+ * the search in progress is dropped, and the most recent query is started.
+ *
+ * If another connection modifies the database in-between slices,
+ * then the FTS query is re-run, and the group in progress is restarted.
+ *
+ * Returns YES if the search is complete (or there's nothing left to do).
+ * Returns NO if more slices are required.
+ *
+ * @see [YapDatabaseSearchResultsViewConnection asyncPerformSearchWithQueue:maxRowsPerSlice:completionQueue:completionBlock:]
+**/
+- (BOOL)performSearchSliceWithQueue:(YapDatabaseSearchQueue *)queue maxRows:(NSUInteger)maxRows;
+
 @end
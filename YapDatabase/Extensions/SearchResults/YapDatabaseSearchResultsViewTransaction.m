@@ -29,6 +29,7 @@ static NSString *const ExtKey_superclassVersion = @"viewClassVersion";
 static NSString *const ExtKey_subclassVersion   = @"searchResultViewClassVersion";
 static NSString *const ExtKey_versionTag        = @"versionTag";
 static NSString *const ExtKey_query             = @"query";
+static NSString *const ExtKey_queryIsPartial    = @"queryIsPartial";
 
 
 @implementation YapDatabaseSearchResultsViewTransaction
@@ -408,6 +409,11 @@ static NSString *const ExtKey_query             = @"query";
 			}
 		}];
 	}
+	
+	// FTS results are mostly clustered rowids, and are only read from here on out.
+	// So we compress them (run-length encoding) to speed up lookups & copies.
+	
+	YapRowidSetOptimize(ftsRowids);
 }
 
 /**
@@ -1949,39 +1955,18 @@ static NSString *const ExtKey_query             = @"query";
 }
 
 /**
- * This method updates the view by using the updated ftsRowids set.
- * Only use this method if parentViewName is non-nil.
- * 
- * Note: You must update ftsRowids before invoking this method.
+ * Returns the groups of the parentView that we should process (i.e. those allowed by options.allowedGroups).
 **/
-- (void)updateViewFromParent
+- (NSMutableArray *)groupsToEnumerateInParentViewTransaction:(YapDatabaseViewTransaction *)parentViewTransaction
 {
-	YDBLogAutoTrace();
-	
-	NSAssert(((YapDatabaseSearchResultsView *)viewConnection->view)->parentViewName != nil,
-	         @"Logic error: method requires parentView");
-	
-	if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
-		return;
-	}
-	
-	__unsafe_unretained YapDatabaseSearchResultsView *searchResultsView =
-	  (YapDatabaseSearchResultsView *)viewConnection->view;
-	
 	__unsafe_unretained YapDatabaseSearchResultsViewOptions *searchResultsOptions =
-	  (YapDatabaseSearchResultsViewOptions *)searchResultsView->options;
-	
-	__unsafe_unretained YapDatabaseViewTransaction *parentViewTransaction =
-	  (YapDatabaseViewTransaction *)[databaseTransaction ext:searchResultsView->parentViewName];
-	
-	BOOL wasEmpty = [self isEmpty];
+	  (YapDatabaseSearchResultsViewOptions *)viewConnection->view->options;
 	
-	id <NSFastEnumeration> groupsToEnumerate = nil;
+	NSArray *allGroups = [parentViewTransaction allGroups];
 	
 	__unsafe_unretained YapWhitelistBlacklist *allowedGroups = searchResultsOptions.allowedGroups;
 	if (allowedGroups)
 	{
-		NSArray *allGroups = [parentViewTransaction allGroups];
 		NSMutableArray *groups = [NSMutableArray arrayWithCapacity:[allGroups count]];
 		
 		for (NSString *group in allGroups)
@@ -1991,87 +1976,151 @@ static NSString *const ExtKey_query             = @"query";
 			}
 		}
 		
-		groupsToEnumerate = groups;
+		return groups;
 	}
 	else
 	{
-		groupsToEnumerate = [parentViewTransaction allGroups];
+		return [allGroups mutableCopy];
+	}
+}
+
+/**
+ * Updates a single group of the view (using the updated ftsRowids set) by walking the same group in the parentView.
+ *
+ * Processing starts at the given parentIndex (within the parentView's group) & viewIndex (within our group),
+ * and stops after maxRows rows of the parentView's group have been processed.
+ * Upon return, both indexes are updated to reflect where processing stopped,
+ * so a subsequent invocation can continue where this one left off.
+ *
+ * Returns YES if the end of the parentView's group was reached.
+**/
+- (BOOL)updateGroup:(NSString *)group
+         fromParent:(YapDatabaseViewTransaction *)parentViewTransaction
+        parentIndex:(NSUInteger *)parentIndexPtr
+          viewIndex:(NSUInteger *)viewIndexPtr
+            maxRows:(NSUInteger)maxRows
+{
+	NSUInteger parentCount = [parentViewTransaction numberOfItemsInGroup:group];
+	NSUInteger startIndex = *parentIndexPtr;
+	
+	if (startIndex >= parentCount) {
+		return YES;
 	}
 	
-	for (NSString *group in groupsToEnumerate)
+	NSRange range = NSMakeRange(startIndex, MIN(maxRows, parentCount - startIndex));
+	
+	__block int64_t existingRowid = 0;
+	__block BOOL existing = [self getRowid:&existingRowid atIndex:*viewIndexPtr inGroup:group];
+	
+	__block NSUInteger index = *viewIndexPtr;
+	__block NSUInteger nextParentIndex = startIndex;
+	
+	[parentViewTransaction enumerateRowidsInGroup:group
+	                                  withOptions:0
+	                                        range:range
+	                                   usingBlock:^(int64_t rowid, NSUInteger parentIndex, BOOL *stop)
 	{
-		__block BOOL existing = NO;
-		__block int64_t existingRowid = 0;
-		
-		if (wasEmpty)
-			existing = NO;
-		else
-			existing = [self getRowid:&existingRowid atIndex:0 inGroup:group];
-		
-		__block NSUInteger index = 0;
-		
-		[parentViewTransaction enumerateRowidsInGroup:group
-		                                   usingBlock:^(int64_t rowid, NSUInteger parentIndex, BOOL *stop)
+		if (YapRowidSetContains(ftsRowids, rowid))
 		{
-			if (YapRowidSetContains(ftsRowids, rowid))
+			// The item matches the FTS query (should be in view)
+			
+			if (existing && (existingRowid == rowid))
 			{
-				// The item matches the FTS query (should be in view)
+				// The row was previously in the view (in old search results),
+				// and is still in the view (in new search results).
 				
-				if (existing && (existingRowid == rowid))
-				{
-					// The row was previously in the view (in old search results),
-					// and is still in the view (in new search results).
-					
-					index++;
-					existing = [self getRowid:&existingRowid atIndex:index inGroup:group];
-				}
-				else
-				{
-					// The row was not previously in the view (not in old search results),
-					// but is now in the view (in new search results).
-					
-					YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
-					
-					if (index == 0 && ([viewConnection->state pagesMetadataForGroup:group] == nil)) {
-						[self insertRowid:rowid collectionKey:ck inNewGroup:group];
-					}
-					else {
-						[self insertRowid:rowid collectionKey:ck
-						                              inGroup:group
-						                              atIndex:index
-						                  withExistingPageKey:nil];
-					}
-					index++;
-				}
+				index++;
+				existing = [self getRowid:&existingRowid atIndex:index inGroup:group];
 			}
 			else
 			{
-				// The item does not match the FTS query (should not be in view)
+				// The row was not previously in the view (not in old search results),
+				// but is now in the view (in new search results).
 				
-				if (existing && (existingRowid == rowid))
-				{
-					// The row was previously in the view (in old search results),
-					// but is no longer in the view (not in new search results).
-					
-					YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
-					
-					[self removeRowid:rowid collectionKey:ck atIndex:index inGroup:group];
-					existing = [self getRowid:&existingRowid atIndex:index inGroup:group];
+				YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
+				
+				if (index == 0 && ([viewConnection->state pagesMetadataForGroup:group] == nil)) {
+					[self insertRowid:rowid collectionKey:ck inNewGroup:group];
 				}
-				else
-				{
-					// The row was not previously in the view (not in old search results),
-					// and is still not in the view (not in new search results).
+				else {
+					[self insertRowid:rowid collectionKey:ck
+					                              inGroup:group
+					                              atIndex:index
+					                  withExistingPageKey:nil];
 				}
+				index++;
 			}
+		}
+		else
+		{
+			// The item does not match the FTS query (should not be in view)
 			
-			if ((parentIndex % 500) == 0)
+			if (existing && (existingRowid == rowid))
 			{
-				if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
-					*stop = YES;
-				}
+				// The row was previously in the view (in old search results),
+				// but is no longer in the view (not in new search results).
+				
+				YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
+				
+				[self removeRowid:rowid collectionKey:ck atIndex:index inGroup:group];
+				existing = [self getRowid:&existingRowid atIndex:index inGroup:group];
 			}
-		}];
+			else
+			{
+				// The row was not previously in the view (not in old search results),
+				// and is still not in the view (not in new search results).
+			}
+		}
+		
+		nextParentIndex = parentIndex + 1;
+		
+		if ((parentIndex % 500) == 0)
+		{
+			if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
+				*stop = YES;
+			}
+		}
+	}];
+	
+	*parentIndexPtr = nextParentIndex;
+	*viewIndexPtr = index;
+	
+	return (nextParentIndex >= parentCount);
+}
+
+/**
+ * This method updates the view by using the updated ftsRowids set.
+ * Only use this method if parentViewName is non-nil.
+ * 
+ * Note: You must update ftsRowids before invoking this method.
+**/
+- (void)updateViewFromParent
+{
+	YDBLogAutoTrace();
+	
+	NSAssert(((YapDatabaseSearchResultsView *)viewConnection->view)->parentViewName != nil,
+	         @"Logic error: method requires parentView");
+	
+	if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
+		return;
+	}
+	
+	__unsafe_unretained YapDatabaseSearchResultsView *searchResultsView =
+	  (YapDatabaseSearchResultsView *)viewConnection->view;
+	
+	__unsafe_unretained YapDatabaseViewTransaction *parentViewTransaction =
+	  (YapDatabaseViewTransaction *)[databaseTransaction ext:searchResultsView->parentViewName];
+	
+	for (NSString *group in [self groupsToEnumerateInParentViewTransaction:parentViewTransaction])
+	{
+		NSUInteger parentIndex = 0;
+		NSUInteger viewIndex = 0;
+		
+		[self updateGroup:group
+		       fromParent:parentViewTransaction
+		      parentIndex:&parentIndex
+		        viewIndex:&viewIndex
+		          maxRows:NSUIntegerMax];
 		
 		if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
 			return;
@@ -2079,6 +2128,101 @@ static NSString *const ExtKey_query             = @"query";
 	}
 }
 
+/**
+ * Invokes the groupingBlock for the given (matching) rowid,
+ * and inserts it into the view if the groupingBlock returns a group.
+ * 
+ * Only use this method if parentViewName is nil.
+**/
+- (void)insertRowid:(int64_t)rowid withGroupingBlock:(YapDatabaseViewGroupingBlock)groupingBlock_generic
+                                    groupingBlockType:(YapDatabaseViewBlockType)groupingBlockType
+                                     sortingBlockType:(YapDatabaseViewBlockType)sortingBlockType
+{
+	YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
+	
+	id object = nil;
+	id metadata = nil;
+	
+	// Invoke the grouping block to find out if the object should be included in the view.
+	
+	NSString *group = nil;
+	YapWhitelistBlacklist *allowedCollections = viewConnection->view->options.allowedCollections;
+	
+	if (!allowedCollections || [allowedCollections isAllowed:ck.collection])
+	{
+		if (groupingBlockType == YapDatabaseViewBlockTypeWithKey)
+		{
+			__unsafe_unretained YapDatabaseViewGroupingWithKeyBlock groupingBlock =
+		      (YapDatabaseViewGroupingWithKeyBlock)groupingBlock_generic;
+			
+			group = groupingBlock(ck.collection, ck.key);
+		}
+		else if (groupingBlockType == YapDatabaseViewBlockTypeWithObject)
+		{
+			__unsafe_unretained YapDatabaseViewGroupingWithObjectBlock groupingBlock =
+		      (YapDatabaseViewGroupingWithObjectBlock)groupingBlock_generic;
+			
+			object = [databaseTransaction objectForCollectionKey:ck withRowid:rowid];
+			
+			group = groupingBlock(ck.collection, ck.key, object);
+		}
+		else if (groupingBlockType == YapDatabaseViewBlockTypeWithMetadata)
+		{
+			__unsafe_unretained YapDatabaseViewGroupingWithMetadataBlock groupingBlock =
+		      (YapDatabaseViewGroupingWithMetadataBlock)groupingBlock_generic;
+			
+			metadata = [databaseTransaction metadataForCollectionKey:ck withRowid:rowid];
+			
+			group = groupingBlock(ck.collection, ck.key, metadata);
+		}
+		else
+		{
+			__unsafe_unretained YapDatabaseViewGroupingWithRowBlock groupingBlock =
+		      (YapDatabaseViewGroupingWithRowBlock)groupingBlock_generic;
+			
+			[databaseTransaction getObject:&object metadata:&metadata forCollectionKey:ck withRowid:rowid];
+			
+			group = groupingBlock(ck.collection, ck.key, object, metadata);
+		}
+	}
+	
+	if (group)
+	{
+		// Add to view.
+		
+		YapDatabaseViewChangesBitMask flags = (YapDatabaseViewChangedObject | YapDatabaseViewChangedMetadata);
+		
+		if (sortingBlockType == YapDatabaseViewBlockTypeWithObject)
+		{
+			if (object == nil)
+				object = [databaseTransaction objectForCollectionKey:ck withRowid:rowid];
+		}
+		else if (sortingBlockType == YapDatabaseViewBlockTypeWithMetadata)
+		{
+			if (metadata == nil)
+				metadata = [databaseTransaction metadataForCollectionKey:ck withRowid:rowid];
+		}
+		else if (sortingBlockType == YapDatabaseViewBlockTypeWithRow)
+		{
+			if (object == nil) {
+				if (metadata == nil)
+					[databaseTransaction getObject:&object metadata:&metadata forCollectionKey:ck withRowid:rowid];
+				else
+					object = [databaseTransaction objectForCollectionKey:ck withRowid:rowid];
+			}
+			else if (metadata == nil) {
+				metadata = [databaseTransaction metadataForCollectionKey:ck withRowid:rowid];
+			}
+		}
+		
+		[self insertRowid:rowid
+		    collectionKey:ck
+		           object:object
+		         metadata:metadata
+		          inGroup:group withChanges:flags isNew:YES];
+	}
+}
+
 /**
  * This method updates the view by using the updated ftsRowids set.
  * Only use this method if parentViewName is nil.
@@ -2175,102 +2319,196 @@ static NSString *const ExtKey_query             = @"query";
 	
 	YapRowidSetEnumerate(ftsRowidsLeft, ^(int64_t rowid, BOOL *stop) { @autoreleasepool {
 		
-		YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
+		[self insertRowid:rowid withGroupingBlock:groupingBlock_generic
+		                        groupingBlockType:groupingBlockType
+		                         sortingBlockType:sortingBlockType];
 		
-		id object = nil;
-		id metadata = nil;
-		
-		// Invoke the grouping block to find out if the object should be included in the view.
+		if (++processed == 500)
+		{
+			processed = 0;
+			if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
+				*stop = YES;
+			}
+		}
+	}});
+	
+	// Dealloc the temporary c++ set
+	if (ftsRowidsLeft) {
+		YapRowidSetRelease(ftsRowidsLeft);
+	}
+}
+
+/**
+ * Returns YES if the results of newQuery are guaranteed to be a subset of the results of oldQuery.
+ *
+ * This is the case when each term in the oldQuery has a matching term (at the same position) in the newQuery,
+ * where matching means either:
+ *
+ * - the terms are the same (e.g. "yap" -> "yap")
+ * - both are prefix queries, and the new prefix extends the old prefix (e.g. "yap*" -> "yapd*")
+ *
+ * Additional terms at the end of the newQuery are allowed, as fts implicitly ANDs terms together.
+ *
+ * This method is conservative. Only queries composed of simple terms are considered.
+ * Anything else (phrases, column filters, OR, NOT, NEAR, parentheses, etc) returns NO.
+**/
+- (BOOL)isQuery:(NSString *)newQuery refinementOfQuery:(NSString *)oldQuery
+{
+	if (newQuery == nil || oldQuery == nil) return NO;
+	
+	NSCharacterSet *whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+	NSCharacterSet *invalidTermChars = [[NSCharacterSet alphanumericCharacterSet] invertedSet];
+	
+	NSArray* (^ParseTerms)(NSString *) = ^NSArray* (NSString *query){
 		
-		NSString *group = nil;
-		YapWhitelistBlacklist *allowedCollections = viewConnection->view->options.allowedCollections;
+		NSMutableArray *terms = [NSMutableArray array];
 		
-		if (!allowedCollections || [allowedCollections isAllowed:ck.collection])
+		for (NSString *component in [query componentsSeparatedByCharactersInSet:whitespace])
 		{
-			if (groupingBlockType == YapDatabaseViewBlockTypeWithKey)
-			{
-				__unsafe_unretained YapDatabaseViewGroupingWithKeyBlock groupingBlock =
-			      (YapDatabaseViewGroupingWithKeyBlock)groupingBlock_generic;
-				
-				group = groupingBlock(ck.collection, ck.key);
-			}
-			else if (groupingBlockType == YapDatabaseViewBlockTypeWithObject)
-			{
-				__unsafe_unretained YapDatabaseViewGroupingWithObjectBlock groupingBlock =
-			      (YapDatabaseViewGroupingWithObjectBlock)groupingBlock_generic;
-				
-				object = [databaseTransaction objectForCollectionKey:ck withRowid:rowid];
-				
-				group = groupingBlock(ck.collection, ck.key, object);
-			}
-			else if (groupingBlockType == YapDatabaseViewBlockTypeWithMetadata)
+			if ([component length] == 0) continue;
+			
+			if ([component isEqualToString:@"OR"]  ||
+			    [component isEqualToString:@"AND"] ||
+			    [component isEqualToString:@"NOT"] ||
+			    [component hasPrefix:@"NEAR"])
 			{
-				__unsafe_unretained YapDatabaseViewGroupingWithMetadataBlock groupingBlock =
-			      (YapDatabaseViewGroupingWithMetadataBlock)groupingBlock_generic;
-				
-				metadata = [databaseTransaction metadataForCollectionKey:ck withRowid:rowid];
-				
-				group = groupingBlock(ck.collection, ck.key, metadata);
+				return nil;
 			}
-			else
-			{
-				__unsafe_unretained YapDatabaseViewGroupingWithRowBlock groupingBlock =
-			      (YapDatabaseViewGroupingWithRowBlock)groupingBlock_generic;
-				
-				[databaseTransaction getObject:&object metadata:&metadata forCollectionKey:ck withRowid:rowid];
-				
-				group = groupingBlock(ck.collection, ck.key, object, metadata);
+			
+			NSString *term = component;
+			if ([term hasSuffix:@"*"]) {
+				term = [term substringToIndex:([term length] - 1)];
 			}
+			
+			if ([term length] == 0) return nil;
+			if ([term rangeOfCharacterFromSet:invalidTermChars].location != NSNotFound) return nil;
+			
+			[terms addObject:[component lowercaseString]];
 		}
 		
-		if (group)
+		return terms;
+	};
+	
+	NSArray *oldTerms = ParseTerms(oldQuery);
+	NSArray *newTerms = ParseTerms(newQuery);
+	
+	if ([oldTerms count] == 0) return NO;
+	if ([newTerms count] < [oldTerms count]) return NO;
+	
+	NSUInteger i = 0;
+	for (NSString *oldTerm in oldTerms)
+	{
+		NSString *newTerm = newTerms[i];
+		i++;
+		
+		if ([newTerm isEqualToString:oldTerm]) continue;
+		
+		if ([oldTerm hasSuffix:@"*"] && [newTerm hasSuffix:@"*"])
 		{
-			// Add to view.
+			NSString *oldPrefix = [oldTerm substringToIndex:([oldTerm length] - 1)];
 			
-			YapDatabaseViewChangesBitMask flags = (YapDatabaseViewChangedObject | YapDatabaseViewChangedMetadata);
+			if ([newTerm hasPrefix:oldPrefix]) continue;
+		}
+		
+		return NO;
+	}
+	
+	return YES;
+}
+
+/**
+ * This method updates the view by using the updated ftsRowids set.
+ * Only use this method if the new query is a refinement of the previous query (see isQuery:refinementOfQuery:).
+ *
+ * In this case the new search results are a subset of the previous search results.
+ * So rather than walking the parentView (or invoking the groupingBlock for every match),
+ * we only need to re-test the items that are already in our view, and remove those that no longer match.
+ *
+ * Note: You must update ftsRowids before invoking this method.
+**/
+- (void)updateViewForRefinement
+{
+	YDBLogAutoTrace();
+	
+	if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
+		return;
+	}
+	
+	BOOL updateSnippets = (snippets != nil);
+	__block int processed = 0;
+	
+	for (NSString *group in [self allGroups])
+	{
+		// Find the items in the group that no longer match.
+		
+		NSMutableArray *removedIndexes = [NSMutableArray array];
+		NSMutableArray *removedRowids = [NSMutableArray array];
+		__block BOOL abort = NO;
+		
+		[self enumerateRowidsInGroup:group usingBlock:^(int64_t rowid, NSUInteger index, BOOL *stop) {
 			
-			if (sortingBlockType == YapDatabaseViewBlockTypeWithObject)
+			if (YapRowidSetContains(ftsRowids, rowid))
 			{
-				if (object == nil)
-					object = [databaseTransaction objectForCollectionKey:ck withRowid:rowid];
+				// The row was previously in the view (in old search results),
+				// and is still in the view (in new search results).
+				//
+				// The snippet may have changed though.
+				
+				if (updateSnippets) {
+					[self didInsertRowid:rowid collectionKey:nil];
+				}
 			}
-			else if (sortingBlockType == YapDatabaseViewBlockTypeWithMetadata)
+			else
 			{
-				if (metadata == nil)
-					metadata = [databaseTransaction metadataForCollectionKey:ck withRowid:rowid];
+				// The row was previously in the view (in old search results),
+				// but is no longer in the view (not in new search results).
+				
+				[removedIndexes addObject:@(index)];
+				[removedRowids addObject:@(rowid)];
 			}
-			else if (sortingBlockType == YapDatabaseViewBlockTypeWithRow)
+			
+			if (++processed == 500)
 			{
-				if (object == nil) {
-					if (metadata == nil)
-						[databaseTransaction getObject:&object metadata:&metadata forCollectionKey:ck withRowid:rowid];
-					else
-						object = [databaseTransaction objectForCollectionKey:ck withRowid:rowid];
-				}
-				else if (metadata == nil) {
-					metadata = [databaseTransaction metadataForCollectionKey:ck withRowid:rowid];
+				processed = 0;
+				if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
+					abort = YES;
+					*stop = YES;
 				}
 			}
-			
-			[self insertRowid:rowid
-			    collectionKey:ck
-			           object:object
-			         metadata:metadata
-			          inGroup:group withChanges:flags isNew:YES];
+		}];
+		
+		if (abort) {
+			return;
 		}
 		
-		if (++processed == 500)
+		// And remove them.
+		
+		NSUInteger removedCount = [removedIndexes count];
+		
+		if (removedCount == 0)
 		{
-			processed = 0;
-			if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
-				*stop = YES;
+			continue;
+		}
+		else if (removedCount == [self numberOfItemsInGroup:group])
+		{
+			[self removeAllRowidsInGroup:group];
+		}
+		else
+		{
+			// We must remove the items in reverse order, so the remaining indexes stay valid.
+			
+			for (NSUInteger iPlusOne = removedCount; iPlusOne > 0; iPlusOne--)
+			{
+				NSUInteger i = iPlusOne - 1;
+				
+				NSUInteger index = [removedIndexes[i] unsignedIntegerValue];
+				int64_t rowid = [removedRowids[i] longLongValue];
+				
+				YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
+				
+				[self removeRowid:rowid collectionKey:ck atIndex:index inGroup:group];
 			}
 		}
-	}});
-	
-	// Dealloc the temporary c++ set
-	if (ftsRowidsLeft) {
-		YapRowidSetRelease(ftsRowidsLeft);
 	}
 }
 
@@ -2297,8 +2535,24 @@ static NSString *const ExtKey_query             = @"query";
 	__unsafe_unretained YapDatabaseSearchResultsViewConnection *searchResultsViewConnection =
 	  (YapDatabaseSearchResultsViewConnection *)viewConnection;
 	
+	// A non-sliced search supersedes any time-sliced search in progress.
+	// (The view remains flagged as partial until this search completes.)
+	
+	searchResultsViewConnection.searchSlice = nil;
+	
+	NSString *previousQuery = [searchResultsViewConnection query];
+	
 	[searchResultsViewConnection setQuery:query isChange:YES];
 	
+	// Check to see if the new query is a refinement of the previous query.
+	// This is the common case when the user is typing (e.g. "yap*" -> "yapd*").
+	//
+	// If the previous search was aborted (without a rollback), then the view only contains partial results,
+	// and we can't take advantage of the refinement.
+	
+	BOOL queryIsPartial = [self boolValueForExtensionKey:ExtKey_queryIsPartial persistent:[self isPersistentView]];
+	BOOL isRefinement = !queryIsPartial && [self isQuery:query refinementOfQuery:previousQuery];
+	
 	// Run the query against the FTS extension, and populate the ftsRowids & snippets ivars
 	
 	[self repopulateFtsRowidsAndSnippets];
@@ -2308,10 +2562,19 @@ static NSString *const ExtKey_query             = @"query";
 	__unsafe_unretained YapDatabaseSearchResultsView *searchResultsView =
 	  (YapDatabaseSearchResultsView *)viewConnection->view;
 	
-	if (searchResultsView->parentViewName)
+	if (isRefinement)
+		[self updateViewForRefinement];
+	else if (searchResultsView->parentViewName)
 		[self updateViewFromParent];
 	else
 		[self updateViewUsingBlocks];
+	
+	if (queryIsPartial && !isRefinement && ![searchQueue shouldAbortSearchInProgressAndRollback:NULL])
+	{
+		// The view now reflects the complete search results
+		
+		[self removeValueForExtensionKey:ExtKey_queryIsPartial persistent:[self isPersistentView]];
+	}
 }
 
 /**
@@ -2346,9 +2609,431 @@ static NSString *const ExtKey_query             = @"query";
 		{
 			[databaseTransaction rollbackTransaction];
 		}
+		else if (abort)
+		{
+			// The view only contains partial search results.
+			// So a future search can't be performed as a refinement of this query.
+			
+			[self setBoolValue:YES forExtensionKey:ExtKey_queryIsPartial persistent:[self isPersistentView]];
+		}
+	}
+	
+	searchQueue = nil;
+}
+
+/**
+ * Starts a new time-sliced search for the given query.
+ *
+ * This method runs the FTS query, and prepares the progress state for the slices that follow.
+ * If the query is a refinement of the previous (complete) query, then the view is updated immediately,
+ * as refinement only requires a walk over the existing search results. In this case nil is returned.
+**/
+- (YapDatabaseSearchResultsViewSearchSlice *)beginSearchSliceFor:(NSString *)query
+{
+	YDBLogAutoTrace();
+	
+	__unsafe_unretained YapDatabaseSearchResultsViewConnection *searchResultsViewConnection =
+	  (YapDatabaseSearchResultsViewConnection *)viewConnection;
+	
+	__unsafe_unretained YapDatabaseSearchResultsView *searchResultsView =
+	  (YapDatabaseSearchResultsView *)viewConnection->view;
+	
+	NSString *previousQuery = [searchResultsViewConnection query];
+	
+	[searchResultsViewConnection setQuery:query isChange:YES];
+	
+	BOOL queryIsPartial = [self boolValueForExtensionKey:ExtKey_queryIsPartial persistent:[self isPersistentView]];
+	BOOL isRefinement = !queryIsPartial && [self isQuery:query refinementOfQuery:previousQuery];
+	
+	[self repopulateFtsRowidsAndSnippets];
+	
+	if (isRefinement)
+	{
+		[self updateViewForRefinement];
+		return nil;
+	}
+	
+	YapDatabaseSearchResultsViewSearchSlice *slice = [[YapDatabaseSearchResultsViewSearchSlice alloc] init];
+	slice->query = [query copy];
+	
+	if (searchResultsView->parentViewName)
+	{
+		__unsafe_unretained YapDatabaseViewTransaction *parentViewTransaction =
+		  (YapDatabaseViewTransaction *)[databaseTransaction ext:searchResultsView->parentViewName];
+		
+		slice->groups = [self groupsToEnumerateInParentViewTransaction:parentViewTransaction];
+	}
+	else
+	{
+		slice->groups = [[self allGroups] mutableCopy];
+		slice->ftsRowidsLeft = YapRowidSetCopy(ftsRowids);
+	}
+	
+	// The view will only contain partial search results until the last slice completes.
+	
+	[self setBoolValue:YES forExtensionKey:ExtKey_queryIsPartial persistent:[self isPersistentView]];
+	
+	return slice;
+}
+
+/**
+ * Performs (at most) maxRows worth of a time-sliced search, using a parentView.
+ * Returns YES if the search is complete.
+**/
+- (BOOL)updateViewFromParentWithSlice:(YapDatabaseSearchResultsViewSearchSlice *)slice maxRows:(NSUInteger)maxRows
+{
+	YDBLogAutoTrace();
+	
+	__unsafe_unretained YapDatabaseSearchResultsView *searchResultsView =
+	  (YapDatabaseSearchResultsView *)viewConnection->view;
+	
+	__unsafe_unretained YapDatabaseViewTransaction *parentViewTransaction =
+	  (YapDatabaseViewTransaction *)[databaseTransaction ext:searchResultsView->parentViewName];
+	
+	NSUInteger rowsLeft = maxRows;
+	
+	while (([slice->groups count] > 0) && (rowsLeft > 0))
+	{
+		NSString *group = [slice->groups objectAtIndex:0];
+		NSUInteger startIndex = slice->parentIndex;
+		
+		// If the group had to be restarted (due to changes made by another connection),
+		// then we process the entire group now, in order to guarantee forward progress.
+		
+		BOOL groupDone = [self updateGroup:group
+		                        fromParent:parentViewTransaction
+		                       parentIndex:&slice->parentIndex
+		                         viewIndex:&slice->viewIndex
+		                           maxRows:(slice->restartedGroup ? NSUIntegerMax : rowsLeft)];
+		
+		if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
+			return YES;
+		}
+		
+		NSUInteger processed = slice->parentIndex - startIndex;
+		rowsLeft = (processed < rowsLeft) ? (rowsLeft - processed) : 0;
+		
+		if (groupDone)
+		{
+			[slice->groups removeObjectAtIndex:0];
+			
+			slice->parentIndex = 0;
+			slice->viewIndex = 0;
+			slice->restartedGroup = NO;
+		}
+	}
+	
+	return ([slice->groups count] == 0);
+}
+
+/**
+ * Performs (at most) maxRows worth of a time-sliced search, using the groupingBlock & sortingBlock.
+ * Returns YES if the search is complete.
+ *
+ * This works in 2 phases, just like updateViewUsingBlocks.
+ * First, the existing rows in the view are walked (removing those that no longer match).
+ * Then the remaining matching rows (not already in the view) are inserted.
+**/
+- (BOOL)updateViewUsingBlocksWithSlice:(YapDatabaseSearchResultsViewSearchSlice *)slice maxRows:(NSUInteger)maxRows
+{
+	YDBLogAutoTrace();
+	
+	__block NSUInteger rowsLeft = maxRows;
+	__block int processed = 0;
+	
+	// If the slice had to be restarted (due to changes made by another connection),
+	// then we walk the existing rows of the view in full, in order to guarantee forward progress.
+	
+	if (slice->restartedGroup)
+	{
+		rowsLeft = NSUIntegerMax;
+		slice->restartedGroup = NO;
+	}
+	
+	while (([slice->groups count] > 0) && (rowsLeft > 0))
+	{
+		NSString *group = [slice->groups objectAtIndex:0];
+		
+		__block NSUInteger groupCount = [self numberOfItemsInGroup:group];
+		__block BOOL groupDone = (slice->viewIndex >= groupCount);
+		__block BOOL done = groupDone;
+		
+		while (!done)
+		{
+			done = YES;
+			
+			NSRange range = NSMakeRange(slice->viewIndex, MIN(rowsLeft, groupCount - slice->viewIndex));
+			
+			[self enumerateRowidsInGroup:group
+			                 withOptions:0
+			                       range:range
+			                  usingBlock:^(int64_t rowid, NSUInteger index, BOOL *stop)
+			{
+				rowsLeft--;
+				
+				if (YapRowidSetContains(slice->ftsRowidsLeft, rowid))
+				{
+					// The row was previously in the view (in old search results),
+					// and is still in the view (in new search results).
+					
+					YapRowidSetRemove(slice->ftsRowidsLeft, rowid);
+					slice->viewIndex = index + 1;
+				}
+				else
+				{
+					// The row was previously in the view (in old search results),
+					// but is no longer in the view (not in new search results).
+					
+					YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
+					
+					[self removeRowid:rowid collectionKey:ck atIndex:index inGroup:group];
+					*stop = YES;
+					
+					groupCount--;
+					slice->viewIndex = index;
+					
+					if ((rowsLeft > 0) && (slice->viewIndex < groupCount)) {
+						done = NO;
+					}
+				}
+				
+				if (++processed == 500)
+				{
+					processed = 0;
+					if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
+						*stop = YES;
+						done = YES;
+					}
+				}
+			}];
+		}
+		
+		if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
+			return YES;
+		}
+		
+		groupDone = (slice->viewIndex >= groupCount);
+		if (groupDone)
+		{
+			[slice->groups removeObjectAtIndex:0];
+			slice->viewIndex = 0;
+		}
+	}
+	
+	if ([slice->groups count] > 0) {
+		return NO;
+	}
+	
+	// Now insert (a batch of) items from ftsRowidsLeft
+	
+	if (rowsLeft > maxRows) {
+		rowsLeft = maxRows;
+	}
+	
+	if (rowsLeft == 0) {
+		return (YapRowidSetCount(slice->ftsRowidsLeft) == 0);
+	}
+	
+	NSMutableArray *batch = [NSMutableArray arrayWithCapacity:MIN(rowsLeft, YapRowidSetCount(slice->ftsRowidsLeft))];
+	
+	YapRowidSetEnumerate(slice->ftsRowidsLeft, ^(int64_t rowid, BOOL *stop) {
+		
+		[batch addObject:@(rowid)];
+		if ([batch count] >= rowsLeft) {
+			*stop = YES;
+		}
+	});
+	
+	YapDatabaseViewGroupingBlock groupingBlock_generic = NULL;
+	YapDatabaseViewBlockType groupingBlockType = 0;
+	YapDatabaseViewBlockType sortingBlockType  = 0;
+	
+	[viewConnection getGroupingBlock:&groupingBlock_generic
+	               groupingBlockType:&groupingBlockType
+	                    sortingBlock:NULL
+	                sortingBlockType:&sortingBlockType];
+	
+	for (NSNumber *number in batch) { @autoreleasepool {
+		
+		int64_t rowid = [number longLongValue];
+		YapRowidSetRemove(slice->ftsRowidsLeft, rowid);
+		
+		[self insertRowid:rowid withGroupingBlock:groupingBlock_generic
+		                        groupingBlockType:groupingBlockType
+		                         sortingBlockType:sortingBlockType];
+		
+		if (++processed == 500)
+		{
+			processed = 0;
+			if ([searchQueue shouldAbortSearchInProgressAndRollback:NULL]) {
+				return YES;
+			}
+		}
+	}}
+	
+	return (YapRowidSetCount(slice->ftsRowidsLeft) == 0);
+}
+
+/**
+ * Performs a single slice of a time-sliced search.
+ *
+ * See header file for extensive documentation for this method.
+**/
+- (BOOL)performSearchSliceWithQueue:(YapDatabaseSearchQueue *)inSearchQueue maxRows:(NSUInteger)maxRows
+{
+	YDBLogAutoTrace();
+	
+	if (!databaseTransaction->isReadWriteTransaction)
+	{
+		YDBLogWarn(@"%@ - Method only allowed in readWrite transaction", THIS_METHOD);
+		return YES;
+	}
+	
+	__unsafe_unretained YapDatabaseSearchResultsViewConnection *searchResultsViewConnection =
+	  (YapDatabaseSearchResultsViewConnection *)viewConnection;
+	
+	__unsafe_unretained YapDatabaseSearchResultsView *searchResultsView =
+	  (YapDatabaseSearchResultsView *)viewConnection->view;
+	
+	if (maxRows == 0)
+		maxRows = 1;
+	
+	searchQueue = inSearchQueue;
+	
+	YapDatabaseSearchResultsViewSearchSlice *slice = searchResultsViewConnection.searchSlice;
+	searchResultsViewConnection.searchSlice = nil;
+	
+	// If a new query has been enqueued (or the search was aborted) since the previous slice,
+	// then the search in progress is dropped, and we move on to the most recent query.
+	//
+	// Note: The view was flagged as containing partial results when the dropped search started.
+	
+	if (slice && (([searchQueue enqueuedQueryCount] > 0) || [searchQueue shouldAbortSearchInProgressAndRollback:NULL]))
+	{
+		slice = nil;
+	}
+	
+	// Likewise if the connection's query has changed since the previous slice.
+	// Resuming would revert the query, while pairing it with search results for the newer query.
+	
+	if (slice && ![slice->query isEqualToString:[searchResultsViewConnection query]])
+	{
+		slice = nil;
+	}
+	
+	BOOL done = NO;
+	
+	if (slice == nil)
+	{
+		NSString *query = [searchQueue flushQueue];
+		if (query == nil)
+		{
+			searchQueue = nil;
+			return YES;
+		}
+		
+		slice = [self beginSearchSliceFor:query];
+		if (slice == nil) {
+			done = YES;
+		}
+	}
+	else
+	{
+		// Take ownership of the FTS results (for the duration of this transaction)
+		
+		if (ftsRowids) {
+			YapRowidSetRelease(ftsRowids);
+		}
+		ftsRowids = slice->ftsRowids;
+		snippets = slice->snippets;
+		
+		slice->ftsRowids = NULL;
+		slice->snippets = nil;
+		
+		// Every slice marks the query as changed, so each slice commit increments the snapshot by exactly one.
+		// If the snapshot has moved any further, then another connection has modified the database in-between slices.
+		// Those changes may have altered the FTS results, as well as our position within the group in progress.
+		
+		if (databaseTransaction->connection->snapshot != (slice->snapshot + 1))
+		{
+			[self repopulateFtsRowidsAndSnippets];
+			
+			if (searchResultsView->parentViewName)
+			{
+				slice->parentIndex = 0;
+				slice->viewIndex = 0;
+				slice->restartedGroup = YES;
+			}
+			else
+			{
+				// Our ftsRowidsLeft set is no longer reliable.
+				// So we restart the slice from the beginning, using the new FTS results.
+				//
+				// The rows already in the view were kept in sync with the query by the other connection.
+				// So the restarted walk over the view is cheap, and we perform it in full (in this slice)
+				// in order to guarantee forward progress.
+				
+				slice->groups = [[self allGroups] mutableCopy];
+				slice->viewIndex = 0;
+				slice->restartedGroup = YES;
+				
+				if (slice->ftsRowidsLeft) {
+					YapRowidSetRelease(slice->ftsRowidsLeft);
+				}
+				slice->ftsRowidsLeft = YapRowidSetCopy(ftsRowids);
+			}
+		}
+	}
+	
+	if (!done)
+	{
+		slice->snapshot = databaseTransaction->connection->snapshot;
+		[searchResultsViewConnection setQuery:slice->query isChange:YES];
+		
+		if (searchResultsView->parentViewName)
+			done = [self updateViewFromParentWithSlice:slice maxRows:maxRows];
+		else
+			done = [self updateViewUsingBlocksWithSlice:slice maxRows:maxRows];
+	}
+	
+	BOOL rollback = NO;
+	BOOL abort = [searchQueue shouldAbortSearchInProgressAndRollback:&rollback];
+	
+	if (abort)
+	{
+		// Note: A rollback only discards the progress of the current slice.
+		// Previous slices have already been committed.
+		
+		if (rollback) {
+			[databaseTransaction rollbackTransaction];
+		}
+		else {
+			[self setBoolValue:YES forExtensionKey:ExtKey_queryIsPartial persistent:[self isPersistentView]];
+		}
+		
+		done = YES;
+	}
+	else if (done)
+	{
+		// The view now reflects the complete search results
+		
+		[self removeValueForExtensionKey:ExtKey_queryIsPartial persistent:[self isPersistentView]];
+	}
+	else
+	{
+		// Hand the FTS results back to the slice, so the next transaction can continue where we left off.
+		
+		slice->ftsRowids = ftsRowids;
+		slice->snippets = snippets;
+		
+		ftsRowids = NULL;
+		snippets = nil;
+		
+		searchResultsViewConnection.searchSlice = slice;
 	}
 	
 	searchQueue = nil;
+	return done;
 }
 
 - (NSString *)snippetForKey:(NSString *)key inCollection:(NSString *)collection
@@ -85,6 +85,8 @@
 	
 	YapCache *queryCache;
 	NSUInteger queryCacheLimit;
+	
+	YapCache *compiledQueryCache; // queryID -> NSMutableDictionary (kind -> statement)
 }
 
 - (id)initWithSecondaryIndex:(YapDatabaseSecondaryIndex *)secondaryIndex
@@ -95,6 +97,36 @@
 - (sqlite3_stmt *)removeStatement;
 - (sqlite3_stmt *)removeAllStatement;
 
+- (sqlite3_stmt *)batchUpdateStatement;
+- (int)batchUpdateRowCount;
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface YapDatabaseQuery ()
+
+- (id)initWithQueryString:(NSString *)queryString queryParameters:(NSArray *)queryParameters;
+
+@end
+
+@interface YapDatabaseCompiledQuery ()
+
+/**
+ * Uniquely identifies the compiled query (for the lifetime of the process).
+ * This is the key in the connection's compiledQueryCache.
+ * (Unlike the object pointer, it's never reused for a different query after this one is deallocated.)
+**/
+@property (nonatomic, assign, readonly) uint64_t queryID;
+
+/**
+ * Binds the current parameter values to the given statement (without copying text or blob values).
+ * The statement must be reset & cleared before the bound values are changed.
+**/
+- (void)bindToStatement:(sqlite3_stmt *)statement;
+
 @end
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -108,6 +140,8 @@
 	__unsafe_unretained YapDatabaseReadTransaction *databaseTransaction;
 	
 	BOOL isMutated;
+	
+	NSMutableDictionary *pendingRows; // Only used if options.deferIndexUpdates
 }
 
 - (id)initWithSecondaryIndexConnection:(YapDatabaseSecondaryIndexConnection *)secondaryIndexConnection
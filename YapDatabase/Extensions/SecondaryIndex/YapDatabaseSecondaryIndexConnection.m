@@ -20,12 +20,18 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 #endif
 
+/**
+ * The maximum number of compiled queries for which we keep prepared statements (per connection).
+**/
+static NSUInteger const YDBSecondaryIndexCompiledQueryCacheLimit = 20;
+
 @implementation YapDatabaseSecondaryIndexConnection
 {
 	sqlite3_stmt *insertStatement;
 	sqlite3_stmt *updateStatement;
 	sqlite3_stmt *removeStatement;
 	sqlite3_stmt *removeAllStatement;
+	sqlite3_stmt *batchUpdateStatement;
 }
 
 @synthesize secondaryIndex = secondaryIndex;
@@ -40,6 +46,12 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 		
 		queryCacheLimit = 10;
 		queryCache = [[YapCache alloc] initWithKeyClass:[NSString class] countLimit:queryCacheLimit];
+		
+		// The statements for a compiled query are finalized when it's evicted from the cache.
+		// (We can't tell when the compiled query itself is deallocated, since that may happen on any thread.)
+		
+		compiledQueryCache = [[YapCache alloc] initWithKeyClass:[NSNumber class]
+		                                             countLimit:YDBSecondaryIndexCompiledQueryCacheLimit];
 	}
 	return self;
 }
@@ -47,6 +59,7 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 - (void)dealloc
 {
 	[queryCache removeAllObjects];
+	[compiledQueryCache removeAllObjects];
 	[self _flushStatements];
 }
 
@@ -56,6 +69,7 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 	sqlite_finalize_null(&updateStatement);
 	sqlite_finalize_null(&removeStatement);
 	sqlite_finalize_null(&removeAllStatement);
+	sqlite_finalize_null(&batchUpdateStatement);
 }
 
 /**
@@ -70,6 +84,7 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 	
 	if (flags & YapDatabaseConnectionFlushMemoryFlags_Statements)
 	{
+		[compiledQueryCache removeAllObjects];
 		[self _flushStatements];
 	}
 }
@@ -335,4 +350,63 @@ static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 	return *statement;
 }
 
+/**
+ * The number of rows written by a single execution of the batchUpdateStatement.
+ * Sized to stay within sqlite's (default) limit of 999 host parameters per statement.
+**/
+- (int)batchUpdateRowCount
+{
+	int paramsPerRow = (int)[secondaryIndex->setup count] + 1;
+	
+	return MAX(1, MIN(50, (999 / paramsPerRow)));
+}
+
+- (sqlite3_stmt *)batchUpdateStatement
+{
+	sqlite3_stmt **statement = &batchUpdateStatement;
+	if (*statement == NULL)
+	{
+		NSMutableString *string = [NSMutableString stringWithCapacity:1000];
+		[string appendFormat:@"INSERT OR REPLACE INTO \"%@\" (\"rowid\"", [secondaryIndex tableName]];
+		
+		for (YapDatabaseSecondaryIndexColumn *column in secondaryIndex->setup)
+		{
+			[string appendFormat:@", \"%@\"", column.name];
+		}
+		
+		[string appendString:@") VALUES "];
+		
+		NSUInteger count = [secondaryIndex->setup count];
+		int rowCount = [self batchUpdateRowCount];
+		
+		for (int row = 0; row < rowCount; row++)
+		{
+			if (row == 0)
+				[string appendString:@"(?"];
+			else
+				[string appendString:@", (?"];
+			
+			NSUInteger i;
+			for (i = 0; i < count; i++)
+			{
+				[string appendString:@", ?"];
+			}
+			
+			[string appendString:@")"];
+		}
+		
+		[string appendString:@";"];
+		
+		sqlite3 *db = databaseConnection->db;
+		
+		int status = sqlite3_prepare_v2(db, [string UTF8String], -1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"%@: Error creating prepared statement: %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+	}
+	
+	return *statement;
+}
+
 @end
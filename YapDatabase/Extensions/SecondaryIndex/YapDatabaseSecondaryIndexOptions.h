@@ -38,4 +38,39 @@
 **/
 @property (nonatomic, strong, readwrite) YapWhitelistBlacklist *allowedCollections;
 
+/**
+ * Normally the secondaryIndexBlock is invoked, and the index table is updated,
+ * immediately after every insert / update within a read-write transaction.
+ *
+ * If you enable this option, the extension instead records which rows were modified,
+ * and updates the index table just before the transaction is committed.
+ * This means:
+ *
+ * - if a row is modified several times within the same transaction,
+ *   the secondaryIndexBlock is only invoked once (with the final values)
+ * - if a row is inserted and then removed within the same transaction,
+ *   the secondaryIndexBlock is never invoked for it
+ * - the index table is written in rowid order, using multi-row statements
+ *
+ * This is helpful for bulk imports, or for transactions that touch the same rows repeatedly.
+ * The tradeoff is that the extension holds onto each modified object (and/or metadata) until the commit.
+ *
+ * Queries made against the secondary index during the transaction still see all the changes
+ * (any pending changes are written to the index table before the query is run).
+ *
+ * The default value is NO.
+**/
+@property (nonatomic, assign, readwrite) BOOL deferIndexUpdates;
+
+/**
+ * Only applies if deferIndexUpdates is enabled.
+ *
+ * When the deferred changes are written, this option allows the secondaryIndexBlock
+ * to be invoked concurrently (for multiple rows at once, on a concurrent queue).
+ * Only enable this option if your secondaryIndexBlock is thread-safe.
+ *
+ * The default value is NO.
+**/
+@property (nonatomic, assign, readwrite) BOOL concurrentIndexExtraction;
+
 @end
@@ -15,11 +15,15 @@
 @implementation YapDatabaseSecondaryIndexOptions
 
 @synthesize allowedCollections = allowedCollections;
+@synthesize deferIndexUpdates = deferIndexUpdates;
+@synthesize concurrentIndexExtraction = concurrentIndexExtraction;
 
 - (id)copyWithZone:(NSZone *)zone
 {
 	YapDatabaseSecondaryIndexOptions *copy = [[YapDatabaseSecondaryIndexOptions alloc] init];
 	copy->allowedCollections = allowedCollections;
+	copy->deferIndexUpdates = deferIndexUpdates;
+	copy->concurrentIndexExtraction = concurrentIndexExtraction;
 	
 	return copy;
 }
@@ -1,6 +1,7 @@
 #import <Foundation/Foundation.h>
 
 @class YapDatabaseSecondaryIndexColumn;
+@class YapDatabaseSecondaryIndexCustomIndex;
 
 typedef NS_ENUM(NSInteger, YapDatabaseSecondaryIndexType) {
 	YapDatabaseSecondaryIndexTypeInteger,
@@ -13,13 +14,72 @@ typedef NS_ENUM(NSInteger, YapDatabaseSecondaryIndexType) {
 - (id)init;
 - (id)initWithCapacity:(NSUInteger)capacity;
 
+/**
+ * Adds a column to the secondary index table.
+ * By default, a single-column sqlite index is created for each column.
+**/
 - (void)addColumn:(NSString *)name withType:(YapDatabaseSecondaryIndexType)type;
 
+/**
+ * Adds a column to the secondary index table.
+ *
+ * If indexed is NO, then the column is only stored (no single-column sqlite index is created for it).
+ * This is useful for columns that are only queried as part of a custom index (see below),
+ * or that are only used for filtering after another index has narrowed down the results.
+ * Each index has a cost during every insert / update, so there's no point in maintaining unused indexes.
+**/
+- (void)addColumn:(NSString *)name withType:(YapDatabaseSecondaryIndexType)type indexed:(BOOL)indexed;
+
+/**
+ * Adds a custom sqlite index to the secondary index table.
+ * The columns must have been previously added via one of the addColumn methods.
+ *
+ * A single-column index can only help with queries on that column.
+ * Consider a query such as:
+ *
+ * WHERE conversation = ? ORDER BY timestamp DESC LIMIT 50
+ *
+ * Sqlite can use an index on "conversation" to find the matching rows,
+ * but it then has to sort all the matching rows by timestamp (in a temp b-tree) before it can apply the limit.
+ * A composite index on (conversation, timestamp DESC) allows sqlite to jump to the first matching row,
+ * and walk the next 50 rows in order.
+ *
+ * @param name
+ *   A name for the index (unique within this setup).
+ *
+ * @param columns
+ *   The ordered list of column names that make up the index key.
+ *   Each column name may be followed by " ASC" or " DESC" to specify the sort order. E.g. @"timestamp DESC".
+ *   The default sort order is ascending.
+ *
+ * @param includedColumns (optional)
+ *   Extra columns to append to the index (after the key columns).
+ *   Sqlite doesn't support a dedicated INCLUDE clause, but a query whose columns are all within the index
+ *   can be answered from the index alone (a "covering index"), without a lookup into the table.
+ *
+ * @param predicate (optional)
+ *   A WHERE clause expression (without the 'WHERE'), which creates a partial index.
+ *   Only rows matching the predicate are included in the index, which keeps the index small.
+ *   Sqlite only uses a partial index if the query's WHERE clause implies the predicate. E.g.:
+ *   predicate=@"isUnread = 1" may be used by a query "WHERE isUnread = 1 AND conversation = ?".
+ *   Note: sqlite partial indexes require sqlite 3.8.0 or later.
+**/
+- (void)addIndexWithName:(NSString *)name columns:(NSArray *)columns;
+- (void)addIndexWithName:(NSString *)name
+                 columns:(NSArray *)columns
+        includingColumns:(NSArray *)includedColumns
+                   where:(NSString *)predicate;
+
 - (NSUInteger)count;
 - (YapDatabaseSecondaryIndexColumn *)columnAtIndex:(NSUInteger)index;
 
 - (NSArray *)columnNames;
 
+/**
+ * The custom indexes (YapDatabaseSecondaryIndexCustomIndex instances), in the order they were added.
+**/
+- (NSArray *)customIndexes;
+
 @end
 
 #pragma mark -
@@ -28,5 +88,20 @@ typedef NS_ENUM(NSInteger, YapDatabaseSecondaryIndexType) {
 
 @property (nonatomic, copy, readonly) NSString *name;
 @property (nonatomic, assign, readonly) YapDatabaseSecondaryIndexType type;
+@property (nonatomic, assign, readonly) BOOL isIndexed;
+
+@end
+
+#pragma mark -
+
+@interface YapDatabaseSecondaryIndexCustomIndex : NSObject
+
+@property (nonatomic, copy, readonly) NSString *name;
+
+@property (nonatomic, copy, readonly) NSArray *columns;          // column names (without ASC / DESC)
+@property (nonatomic, copy, readonly) NSArray *descending;       // NSNumber (BOOL) for each column
+@property (nonatomic, copy, readonly) NSArray *includedColumns;  // column names
+
+@property (nonatomic, copy, readonly) NSString *predicate;
 
 @end
@@ -17,7 +17,15 @@
 
 
 @interface YapDatabaseSecondaryIndexColumn ()
-- (id)initWithName:(NSString *)name type:(YapDatabaseSecondaryIndexType)type;
+- (id)initWithName:(NSString *)name type:(YapDatabaseSecondaryIndexType)type isIndexed:(BOOL)isIndexed;
+@end
+
+@interface YapDatabaseSecondaryIndexCustomIndex ()
+- (id)initWithName:(NSString *)name
+           columns:(NSArray *)columns
+        descending:(NSArray *)descending
+   includedColumns:(NSArray *)includedColumns
+         predicate:(NSString *)predicate;
 @end
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -27,6 +35,7 @@
 @implementation YapDatabaseSecondaryIndexSetup
 {
 	NSMutableArray *setup;
+	NSMutableArray *customIndexes;
 }
 
 - (id)init
@@ -42,6 +51,8 @@
 			setup = [[NSMutableArray alloc] initWithCapacity:capacity];
 		else
 			setup = [[NSMutableArray alloc] init];
+		
+		customIndexes = [[NSMutableArray alloc] init];
 	}
 	return self;
 }
@@ -66,7 +77,7 @@
 	return NO;
 }
 
-- (BOOL)isExistingName:(NSString *)columnName
+- (YapDatabaseSecondaryIndexColumn *)existingColumnWithName:(NSString *)columnName
 {
 	// SQLite column names are not case sensitive.
 	
@@ -74,14 +85,24 @@
 	{
 		if ([column.name caseInsensitiveCompare:columnName] == NSOrderedSame)
 		{
-			return YES;
+			return column;
 		}
 	}
 	
-	return NO;
+	return nil;
+}
+
+- (BOOL)isExistingName:(NSString *)columnName
+{
+	return ([self existingColumnWithName:columnName] != nil);
 }
 
 - (void)addColumn:(NSString *)columnName withType:(YapDatabaseSecondaryIndexType)type
+{
+	[self addColumn:columnName withType:type indexed:YES];
+}
+
+- (void)addColumn:(NSString *)columnName withType:(YapDatabaseSecondaryIndexType)type indexed:(BOOL)indexed
 {
 	if (columnName == nil)
 	{
@@ -118,11 +139,110 @@
 	}
 	
 	YapDatabaseSecondaryIndexColumn *column =
-	    [[YapDatabaseSecondaryIndexColumn alloc] initWithName:columnName type:type];
+	    [[YapDatabaseSecondaryIndexColumn alloc] initWithName:columnName type:type isIndexed:indexed];
 	
 	[setup addObject:column];
 }
 
+- (void)addIndexWithName:(NSString *)indexName columns:(NSArray *)columns
+{
+	[self addIndexWithName:indexName columns:columns includingColumns:nil where:nil];
+}
+
+- (void)addIndexWithName:(NSString *)indexName
+                 columns:(NSArray *)columns
+        includingColumns:(NSArray *)includedColumns
+                   where:(NSString *)predicate
+{
+	if ([indexName length] == 0)
+	{
+		NSAssert(NO, @"Invalid indexName: nil");
+		
+		YDBLogError(@"%@: Invalid indexName: nil", THIS_METHOD);
+		return;
+	}
+	
+	for (YapDatabaseSecondaryIndexCustomIndex *customIndex in customIndexes)
+	{
+		if ([customIndex.name caseInsensitiveCompare:indexName] == NSOrderedSame)
+		{
+			NSAssert(NO, @"Invalid indexName: indexName already exists");
+			
+			YDBLogError(@"%@: Invalid indexName: indexName already exists", THIS_METHOD);
+			return;
+		}
+	}
+	
+	if ([columns count] == 0)
+	{
+		NSAssert(NO, @"Invalid columns: empty");
+		
+		YDBLogError(@"%@: Invalid columns: empty", THIS_METHOD);
+		return;
+	}
+	
+	// Parse the columns, which may include a sort order. E.g. @"timestamp DESC"
+	
+	NSMutableArray *columnNames = [NSMutableArray arrayWithCapacity:[columns count]];
+	NSMutableArray *descending = [NSMutableArray arrayWithCapacity:[columns count]];
+	
+	NSCharacterSet *whitespace = [NSCharacterSet whitespaceCharacterSet];
+	
+	for (NSString *columnWithOrder in columns)
+	{
+		NSString *columnName = [columnWithOrder stringByTrimmingCharactersInSet:whitespace];
+		BOOL isDescending = NO;
+		
+		NSRange range = [columnName rangeOfCharacterFromSet:whitespace options:NSBackwardsSearch];
+		if (range.location != NSNotFound)
+		{
+			NSString *order = [columnName substringFromIndex:(range.location + range.length)];
+			
+			if ([order caseInsensitiveCompare:@"DESC"] == NSOrderedSame)
+			{
+				isDescending = YES;
+				columnName = [[columnName substringToIndex:range.location] stringByTrimmingCharactersInSet:whitespace];
+			}
+			else if ([order caseInsensitiveCompare:@"ASC"] == NSOrderedSame)
+			{
+				columnName = [[columnName substringToIndex:range.location] stringByTrimmingCharactersInSet:whitespace];
+			}
+		}
+		
+		YapDatabaseSecondaryIndexColumn *column = [self existingColumnWithName:columnName];
+		if (column == nil)
+		{
+			NSAssert(NO, @"Invalid columns: unknown column (%@)", columnName);
+			
+			YDBLogError(@"%@: Invalid columns: unknown column (%@)", THIS_METHOD, columnName);
+			return;
+		}
+		
+		[columnNames addObject:column.name];
+		[descending addObject:@(isDescending)];
+	}
+	
+	for (NSString *columnName in includedColumns)
+	{
+		if (![self isExistingName:columnName])
+		{
+			NSAssert(NO, @"Invalid includedColumns: unknown column (%@)", columnName);
+			
+			YDBLogError(@"%@: Invalid includedColumns: unknown column (%@)", THIS_METHOD, columnName);
+			return;
+		}
+	}
+	
+	YapDatabaseSecondaryIndexCustomIndex *customIndex =
+	    [[YapDatabaseSecondaryIndexCustomIndex alloc] initWithName:indexName
+	                                                       columns:columnNames
+	                                                    descending:descending
+	                                               includedColumns:includedColumns
+	                                                     predicate:predicate];
+	
+	[customIndexes addObject:customIndex];
+}
+
 - (NSUInteger)count
 {
 	return [setup count];
@@ -148,10 +268,16 @@
 	return [columnNames copy];
 }
 
+- (NSArray *)customIndexes
+{
+	return [customIndexes copy];
+}
+
 - (id)copyWithZone:(NSZone *)zone
 {
 	YapDatabaseSecondaryIndexSetup *copy = [[YapDatabaseSecondaryIndexSetup alloc] initForCopy];
 	copy->setup = [setup mutableCopy];
+	copy->customIndexes = [customIndexes mutableCopy];
 	
 	return copy;
 }
@@ -216,13 +342,15 @@
 
 @synthesize name = name;
 @synthesize type = type;
+@synthesize isIndexed = isIndexed;
 
-- (id)initWithName:(NSString *)inName type:(YapDatabaseSecondaryIndexType)inType
+- (id)initWithName:(NSString *)inName type:(YapDatabaseSecondaryIndexType)inType isIndexed:(BOOL)inIsIndexed
 {
 	if ((self = [super init]))
 	{
 		name = [inName copy];
 		type = inType;
+		isIndexed = inIsIndexed;
 	}
 	return self;
 }
@@ -239,7 +367,46 @@
 	else
 		typeStr = @"Unknown";
 	
-	return [NSString stringWithFormat:@"<YapDatabaseSecondaryIndexColumn: name(%@), type(%@)>", name, typeStr];
+	return [NSString stringWithFormat:@"<YapDatabaseSecondaryIndexColumn: name(%@), type(%@), isIndexed(%@)>",
+	                                    name, typeStr, (isIndexed ? @"YES" : @"NO")];
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@implementation YapDatabaseSecondaryIndexCustomIndex
+
+@synthesize name = name;
+@synthesize columns = columns;
+@synthesize descending = descending;
+@synthesize includedColumns = includedColumns;
+@synthesize predicate = predicate;
+
+- (id)initWithName:(NSString *)inName
+           columns:(NSArray *)inColumns
+        descending:(NSArray *)inDescending
+   includedColumns:(NSArray *)inIncludedColumns
+         predicate:(NSString *)inPredicate
+{
+	if ((self = [super init]))
+	{
+		name = [inName copy];
+		columns = [inColumns copy];
+		descending = [inDescending copy];
+		includedColumns = [inIncludedColumns copy];
+		predicate = [inPredicate copy];
+	}
+	return self;
+}
+
+- (NSString *)description
+{
+	return [NSString stringWithFormat:
+	    @"<YapDatabaseSecondaryIndexCustomIndex: name(%@), columns(%@), includedColumns(%@), predicate(%@)>",
+	    name, [columns componentsJoinedByString:@", "], [includedColumns componentsJoinedByString:@", "], predicate];
 }
 
 @end
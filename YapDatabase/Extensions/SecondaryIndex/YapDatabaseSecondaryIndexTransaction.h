@@ -3,6 +3,27 @@
 #import "YapDatabaseExtensionTransaction.h"
 #import "YapDatabaseQuery.h"
 
+/**
+ * A cursor marks a position within an ordered enumeration of a secondary index (see "Pagination" below).
+ * It's returned after each page, and passed back in to fetch the next page.
+ *
+ * A cursor only contains the position (the order column value & rowid of the last row in the page),
+ * so it doesn't hold onto anything within the database, and may be used from any transaction or connection.
+ * It supports NSCoding, so it can also be persisted.
+**/
+@interface YapDatabaseSecondaryIndexCursor : NSObject <NSCoding, NSCopying>
+
+@property (nonatomic, copy, readonly) NSString *column;
+@property (nonatomic, assign, readonly) BOOL ascending;
+
+@property (nonatomic, strong, readonly) id value; // NSNumber or NSString
+@property (nonatomic, assign, readonly) int64_t rowid;
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 @interface YapDatabaseSecondaryIndexTransaction : YapDatabaseExtensionTransaction
 
@@ -49,10 +70,224 @@
 - (BOOL)enumerateRowsMatchingQuery:(YapDatabaseQuery *)query
                         usingBlock:
                             (void (^)(NSString *collection, NSString *key, id object, id metadata, BOOL *stop))block;
+/**
+ * Pagination.
+ *
+ * These methods enumerate (at most) a single page of matching rows, ordered by the given column,
+ * and return a cursor that can be used to fetch the next page.
+ *
+ * This allows you to page through a very large number of rows using several short transactions,
+ * rather than a single long-lived enumeration (which prevents the WAL from being checkpointed).
+ * Each page seeks directly to the cursor's position in the index (keyset pagination),
+ * so fetching a page costs the same regardless of how deep into the results it is (unlike LIMIT/OFFSET).
+ * And rows that are inserted or removed between pages don't cause other rows to be skipped or repeated.
+ *
+ * For example:
+ *
+ * query = [YapDatabaseQuery queryWithFormat:@"WHERE folder = ?", folder];
+ * cursor = nil;
+ * do {
+ *     [connection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+ *
+ *         cursor = [[transaction ext:@"idx"] enumerateKeysMatchingQuery:query
+ *                                                             orderedBy:@"timestamp"
+ *                                                             ascending:NO
+ *                                                                 limit:100
+ *                                                           afterCursor:cursor
+ *                                                            usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+ *             // ...
+ *         }];
+ *     }];
+ * } while (cursor);
+ *
+ * The query may only contain a WHERE clause (or be empty, e.g. [YapDatabaseQuery queryMatchingAll]),
+ * as the ORDER BY & LIMIT clauses are appended automatically.
+ * A query with its own GROUP BY, HAVING, ORDER BY or LIMIT clause is rejected (with a warning),
+ * and nothing is enumerated.
+ * Rows are ordered by the given column, with ties broken by rowid.
+ * Rows that have a null value for the column are not included.
+ *
+ * For the best performance, the column should be indexed.
+ * And if the query filters on other columns, consider a custom index such as (folder, timestamp).
+ *
+ * @param column
+ *   The name of the column to order by. Must be one of the columns in the setup.
+ *
+ * @param cursor
+ *   Pass nil to fetch the first page. Otherwise pass the cursor returned by the previous page.
+ *   (The cursor must have been created with the same column & ordering.)
+ *
+ * @return
+ *   The cursor for the next page.
+ *   Returns nil if there are no more rows (or if there was a problem with the given query).
+ *   If you stop the enumeration early, the returned cursor points to the last row you were given.
+**/
+
+- (YapDatabaseSecondaryIndexCursor *)enumerateKeysMatchingQuery:(YapDatabaseQuery *)query
+                                                      orderedBy:(NSString *)column
+                                                      ascending:(BOOL)ascending
+                                                          limit:(NSUInteger)limit
+                                                    afterCursor:(YapDatabaseSecondaryIndexCursor *)cursor
+                                                     usingBlock:
+                            (void (^)(NSString *collection, NSString *key, BOOL *stop))block;
+
+- (YapDatabaseSecondaryIndexCursor *)enumerateKeysAndMetadataMatchingQuery:(YapDatabaseQuery *)query
+                                                                 orderedBy:(NSString *)column
+                                                                 ascending:(BOOL)ascending
+                                                                     limit:(NSUInteger)limit
+                                                               afterCursor:(YapDatabaseSecondaryIndexCursor *)cursor
+                                                                usingBlock:
+                            (void (^)(NSString *collection, NSString *key, id metadata, BOOL *stop))block;
+
+- (YapDatabaseSecondaryIndexCursor *)enumerateKeysAndObjectsMatchingQuery:(YapDatabaseQuery *)query
+                                                                orderedBy:(NSString *)column
+                                                                ascending:(BOOL)ascending
+                                                                    limit:(NSUInteger)limit
+                                                              afterCursor:(YapDatabaseSecondaryIndexCursor *)cursor
+                                                               usingBlock:
+                            (void (^)(NSString *collection, NSString *key, id object, BOOL *stop))block;
+
+- (YapDatabaseSecondaryIndexCursor *)enumerateRowsMatchingQuery:(YapDatabaseQuery *)query
+                                                      orderedBy:(NSString *)column
+                                                      ascending:(BOOL)ascending
+                                                          limit:(NSUInteger)limit
+                                                    afterCursor:(YapDatabaseSecondaryIndexCursor *)cursor
+                                                     usingBlock:
+                            (void (^)(NSString *collection, NSString *key, id object, id metadata, BOOL *stop))block;
+
+/**
+ * Combined full text search + secondary index query.
+ *
+ * These methods enumerate the rows that match both the given query (against this secondary index),
+ * and the given full text search query (against the YapDatabaseFullTextSearch extension registered under ftsName).
+ * Everything is executed as a single sqlite statement, with the ordering & limit applied by sqlite.
+ * So there's no need to intersect separate result sets, and the enumeration stops as soon as the limit is reached.
+ *
+ * For example, to get the 20 most recent messages in the inbox that mention "lunch":
+ *
+ * query = [YapDatabaseQuery queryWithFormat:@"WHERE folder = ?", @"inbox"];
+ * [[transaction ext:@"idx"] enumerateKeysMatchingQuery:query
+ *                                       fullTextSearch:@"fts"
+ *                                             matching:@"lunch"
+ *                                            orderedBy:@"timestamp"
+ *                                            ascending:NO
+ *                                                limit:20
+ *                                           usingBlock:^(NSString *collection, NSString *key, BOOL *stop) {
+ *     // ...
+ * }];
+ *
+ * The query may only contain a WHERE clause (or be empty, e.g. [YapDatabaseQuery queryMatchingAll]),
+ * as the ORDER BY & LIMIT clauses are appended automatically.
+ * A query with its own GROUP BY, HAVING, ORDER BY or LIMIT clause is rejected (with a warning),
+ * and nothing is enumerated.
+ *
+ * @param ftsName
+ *   The registered name of a YapDatabaseFullTextSearch extension.
+ *
+ * @param ftsQuery
+ *   The full text search query (using the usual FTS MATCH syntax).
+ *
+ * @param column
+ *   The name of the column to order by (ties are broken by rowid). Must be one of the columns in the setup.
+ *   Pass nil to enumerate the rows in rowid order.
+ *
+ * @param limit
+ *   The maximum number of rows to enumerate. Pass zero for no limit.
+ *
+ * @return NO if there was a problem with the given query (or ftsName). YES otherwise.
+**/
+
+- (BOOL)enumerateKeysMatchingQuery:(YapDatabaseQuery *)query
+                    fullTextSearch:(NSString *)ftsName
+                          matching:(NSString *)ftsQuery
+                         orderedBy:(NSString *)column
+                         ascending:(BOOL)ascending
+                             limit:(NSUInteger)limit
+                        usingBlock:(void (^)(NSString *collection, NSString *key, BOOL *stop))block;
+
+- (BOOL)enumerateKeysAndMetadataMatchingQuery:(YapDatabaseQuery *)query
+                               fullTextSearch:(NSString *)ftsName
+                                     matching:(NSString *)ftsQuery
+                                    orderedBy:(NSString *)column
+                                    ascending:(BOOL)ascending
+                                        limit:(NSUInteger)limit
+                                   usingBlock:
+                            (void (^)(NSString *collection, NSString *key, id metadata, BOOL *stop))block;
+
+- (BOOL)enumerateKeysAndObjectsMatchingQuery:(YapDatabaseQuery *)query
+                              fullTextSearch:(NSString *)ftsName
+                                    matching:(NSString *)ftsQuery
+                                   orderedBy:(NSString *)column
+                                   ascending:(BOOL)ascending
+                                       limit:(NSUInteger)limit
+                                  usingBlock:
+                            (void (^)(NSString *collection, NSString *key, id object, BOOL *stop))block;
+
+- (BOOL)enumerateRowsMatchingQuery:(YapDatabaseQuery *)query
+                    fullTextSearch:(NSString *)ftsName
+                          matching:(NSString *)ftsQuery
+                         orderedBy:(NSString *)column
+                         ascending:(BOOL)ascending
+                             limit:(NSUInteger)limit
+                        usingBlock:
+                            (void (^)(NSString *collection, NSString *key, id object, id metadata, BOOL *stop))block;
+
 /**
  * Skips the enumeration process, and just gives you the count of matching rows.
 **/
 
 - (BOOL)getNumberOfRows:(NSUInteger *)count matchingQuery:(YapDatabaseQuery *)query;
 
+/**
+ * Runs an aggregate query against the secondary index table,
+ * without touching the database table or deserializing any objects.
+ *
+ * The result columns are SQL expressions (appropriate for SQLite semantics),
+ * and the query may include GROUP BY / HAVING / ORDER BY clauses.
+ *
+ * For example, to get the number of unread messages & the most recent timestamp for each folder:
+ *
+ * query = [YapDatabaseQuery queryWithFormat:@"WHERE isUnread = ? GROUP BY folder", @(YES)];
+ * [[transaction ext:@"idx"] enumerateAggregates:@[ @"folder", @"COUNT(*)", @"MAX(timestamp)" ]
+ *                                 matchingQuery:query
+ *                                    usingBlock:^(NSArray *values, BOOL *stop) {
+ *
+ *     NSString *folder = values[0];
+ *     NSUInteger unreadCount = [values[1] unsignedIntegerValue];
+ *     NSTimeInterval maxTimestamp = [values[2] doubleValue];
+ * }];
+ *
+ * Each result row is given as an array with one value per result column.
+ * Values are typed according to the sqlite result:
+ * NSNumber (integer or real), NSString (text), NSData (blob) or NSNull (null).
+ *
+ * @return NO if there was a problem with the given query. YES otherwise.
+**/
+- (BOOL)enumerateAggregates:(NSArray *)resultColumns
+              matchingQuery:(YapDatabaseQuery *)query
+                 usingBlock:(void (^)(NSArray *values, BOOL *stop))block;
+
+/**
+ * Convenience method for an aggregate query with a single result (e.g. @"SUM(price)").
+ * Returns nil if there was a problem with the given query, or if the result is null (e.g. MAX of zero rows).
+**/
+- (id)aggregate:(NSString *)resultColumn matchingQuery:(YapDatabaseQuery *)query;
+
+/**
+ * Returns the query plan that sqlite uses for the given query (i.e. the output of EXPLAIN QUERY PLAN),
+ * with one line per step of the plan.
+ *
+ * This is intended for diagnostics, such as verifying that a query is able to use an index:
+ * 
+ * "SEARCH TABLE secondaryIndex_idx USING INDEX timestamp (timestamp>?)"
+ * 
+ * versus having to scan the entire table (and possibly sort the results):
+ * 
+ * "SCAN TABLE secondaryIndex_idx"
+ * "USE TEMP B-TREE FOR ORDER BY"
+ *
+ * Returns nil if there was a problem with the given query.
+**/
+- (NSString *)queryPlanForQuery:(YapDatabaseQuery *)query;
+
 @end
@@ -1,11 +1,14 @@
 #import "YapDatabaseSecondaryIndexTransaction.h"
 #import "YapDatabaseSecondaryIndexPrivate.h"
 #import "YapDatabaseStatement.h"
+#import "YapRowidSet.h"
+#import "YapDatabaseFullTextSearchPrivate.h"
 
 #import "YapDatabasePrivate.h"
 #import "YapDatabaseExtensionPrivate.h"
 
 #import "YapDatabaseLogging.h"
+#import "YapNull.h"
 
 #if ! __has_feature(objc_arc)
 #warning This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
@@ -25,6 +28,105 @@ static NSString *const ExtKey_classVersion       = @"classVersion";
 static NSString *const ExtKey_versionTag         = @"versionTag";
 static NSString *const ExtKey_version_deprecated = @"version";
 
+/**
+ * Identifies the statement prepared for a YapDatabaseCompiledQuery (see the connection's compiledQueryCache),
+ * since the same compiled query may be used with several different methods.
+**/
+enum {
+	YDBSecondaryIndexQueryKindRowids = 0,
+	YDBSecondaryIndexQueryKindRows   = 1, // + 1 if fetching objects, + 2 if fetching metadata
+	YDBSecondaryIndexQueryKindCount  = 5,
+};
+
+/**
+ * A row that was inserted/modified during the transaction,
+ * and whose index values haven't been written to the table yet.
+ * 
+ * This is only used if options.deferIndexUpdates is enabled.
+**/
+@interface YDBSecondaryIndexPendingRow : NSObject {
+@public
+	
+	int64_t rowid;
+	YapCollectionKey *collectionKey;
+	
+	id object;
+	id metadata;
+	
+	BOOL hasObject;
+	BOOL hasMetadata;
+	
+	BOOL isNew; // YES if the rowid has no existing values in the index table
+	
+	NSMutableDictionary *values;
+}
+@end
+
+@implementation YDBSecondaryIndexPendingRow
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface YapDatabaseSecondaryIndexCursor ()
+
+- (id)initWithColumn:(NSString *)column ascending:(BOOL)ascending value:(id)value rowid:(int64_t)rowid;
+
+@end
+
+@implementation YapDatabaseSecondaryIndexCursor
+
+@synthesize column = column;
+@synthesize ascending = ascending;
+@synthesize value = value;
+@synthesize rowid = rowid;
+
+- (id)initWithColumn:(NSString *)inColumn ascending:(BOOL)inAscending value:(id)inValue rowid:(int64_t)inRowid
+{
+	if ((self = [super init]))
+	{
+		column = [inColumn copy];
+		ascending = inAscending;
+		value = inValue;
+		rowid = inRowid;
+	}
+	return self;
+}
+
+- (id)initWithCoder:(NSCoder *)decoder
+{
+	if ((self = [super init]))
+	{
+		column    = [decoder decodeObjectForKey:@"column"];
+		ascending = [decoder decodeBoolForKey:@"ascending"];
+		value     = [decoder decodeObjectForKey:@"value"];
+		rowid     = [decoder decodeInt64ForKey:@"rowid"];
+	}
+	return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)coder
+{
+	[coder encodeObject:column   forKey:@"column"];
+	[coder encodeBool:ascending  forKey:@"ascending"];
+	[coder encodeObject:value    forKey:@"value"];
+	[coder encodeInt64:rowid     forKey:@"rowid"];
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+	return self; // Immutable
+}
+
+- (NSString *)description
+{
+	return [NSString stringWithFormat:@"<YapDatabaseSecondaryIndexCursor[%p] column(%@) %@ value(%@) rowid(%lld)>",
+	                                     self, column, (ascending ? @"ASC" : @"DESC"), value, rowid];
+}
+
+@end
+
 
 @implementation YapDatabaseSecondaryIndexTransaction
 
@@ -247,6 +349,8 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	
 	for (YapDatabaseSecondaryIndexColumn *column in setup)
 	{
+		if (!column.isIndexed) continue;
+		
 		NSString *createIndex =
 		    [NSString stringWithFormat:@"CREATE INDEX IF NOT EXISTS \"%@\" ON \"%@\" (\"%@\");",
 		        column.name, tableName, column.name];
@@ -259,6 +363,53 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		}
 	}
 	
+	// CREATE INDEX IF NOT EXISTS "tableName_indexName" ON "tableName" ("col1", "col2" DESC, "included1") WHERE ...;
+	//
+	// Note: Index names are global within the sqlite database (not per table),
+	// so custom indexes are prefixed with the table name.
+	
+	for (YapDatabaseSecondaryIndexCustomIndex *customIndex in [setup customIndexes])
+	{
+		NSMutableString *createIndex = [NSMutableString stringWithCapacity:100];
+		[createIndex appendFormat:@"CREATE INDEX IF NOT EXISTS \"%@_%@\" ON \"%@\" (",
+		                                                       tableName, customIndex.name, tableName];
+		
+		NSUInteger i = 0;
+		for (NSString *columnName in customIndex.columns)
+		{
+			if (i > 0)
+				[createIndex appendString:@", "];
+			
+			if ([[customIndex.descending objectAtIndex:i] boolValue])
+				[createIndex appendFormat:@"\"%@\" DESC", columnName];
+			else
+				[createIndex appendFormat:@"\"%@\"", columnName];
+			
+			i++;
+		}
+		
+		for (NSString *columnName in customIndex.includedColumns)
+		{
+			[createIndex appendFormat:@", \"%@\"", columnName];
+		}
+		
+		[createIndex appendString:@")"];
+		
+		if ([customIndex.predicate length] > 0)
+		{
+			[createIndex appendFormat:@" WHERE %@", customIndex.predicate];
+		}
+		
+		[createIndex appendString:@";"];
+		
+		status = sqlite3_exec(db, [createIndex UTF8String], NULL, NULL, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"Failed creating index '%@': %d %s", customIndex.name, status, sqlite3_errmsg(db));
+			return NO;
+		}
+	}
+	
 	return YES;
 }
 
@@ -452,6 +603,14 @@ static NSString *const ExtKey_version_deprecated = @"version";
  * Adds a row to the table, using the given rowid along with the values in the 'blockDict' ivar.
 **/
 - (void)addRowid:(int64_t)rowid isNew:(BOOL)isNew
+{
+	[self addRowid:rowid withValues:secondaryIndexConnection->blockDict isNew:isNew];
+}
+
+/**
+ * Adds a row to the table, using the given rowid along with the given values.
+**/
+- (void)addRowid:(int64_t)rowid withValues:(NSDictionary *)values isNew:(BOOL)isNew
 {
 	YDBLogAutoTrace();
 	
@@ -467,14 +626,34 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	//  isNew : INSERT            INTO "tableName" ("rowid", "column1", "column2", ...) VALUES (?, ?, ? ...);
 	// !isNew : INSERT OR REPLACE INTO "tableName" ("rowid", "column1", "column2", ...) VALUES (?, ?, ? ...);
 	
-	int i = 1;
+	[self bindRowid:rowid withValues:values toStatement:statement atIndex:1];
+	
+	int status = sqlite3_step(statement);
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"Error executing '%s': %d %s",
+		            isNew ? "insertStatement" : "updateStatement",
+		            status, sqlite3_errmsg(databaseTransaction->connection->db));
+	}
+	
+	sqlite3_clear_bindings(statement);
+	sqlite3_reset(statement);
 	
+	isMutated = YES;
+}
+
+/**
+ * Binds the rowid, followed by the value for each column (in setup order), starting at the given parameter index.
+ * Returns the index of the next unbound parameter.
+**/
+- (int)bindRowid:(int64_t)rowid withValues:(NSDictionary *)values toStatement:(sqlite3_stmt *)statement atIndex:(int)i
+{
 	sqlite3_bind_int64(statement, i, rowid);
 	i++;
 	
 	for (YapDatabaseSecondaryIndexColumn *column in secondaryIndexConnection->secondaryIndex->setup)
 	{
-		id columnValue = [secondaryIndexConnection->blockDict objectForKey:column.name];
+		id columnValue = [values objectForKey:column.name];
 		if (columnValue && columnValue != [NSNull null])
 		{
 			if (column.type == YapDatabaseSecondaryIndexTypeInteger)
@@ -536,18 +715,7 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		i++;
 	}
 	
-	int status = sqlite3_step(statement);
-	if (status != SQLITE_DONE)
-	{
-		YDBLogError(@"Error executing '%s': %d %s",
-		            isNew ? "insertStatement" : "updateStatement",
-		            status, sqlite3_errmsg(databaseTransaction->connection->db));
-	}
-	
-	sqlite3_clear_bindings(statement);
-	sqlite3_reset(statement);
-	
-	isMutated = YES;
+	return i;
 }
 
 - (void)removeRowid:(int64_t)rowid
@@ -666,10 +834,268 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	isMutated = YES;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Deferred Updates
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Records the given row as pending (when options.deferIndexUpdates is enabled).
+ * The secondaryIndexBlock will be invoked for the row when the pending rows are flushed.
+ *
+ * If the row is already pending, the recorded object and/or metadata are simply replaced.
+**/
+- (void)deferRowid:(int64_t)rowid
+     collectionKey:(YapCollectionKey *)collectionKey
+            object:(id)object hasObject:(BOOL)hasObject
+          metadata:(id)metadata hasMetadata:(BOOL)hasMetadata
+             isNew:(BOOL)isNew
+{
+	if (pendingRows == nil)
+		pendingRows = [[NSMutableDictionary alloc] init];
+	
+	NSNumber *rowidNumber = @(rowid);
+	
+	YDBSecondaryIndexPendingRow *pendingRow = [pendingRows objectForKey:rowidNumber];
+	if (pendingRow == nil)
+	{
+		pendingRow = [[YDBSecondaryIndexPendingRow alloc] init];
+		pendingRow->rowid = rowid;
+		pendingRow->isNew = isNew;
+		
+		[pendingRows setObject:pendingRow forKey:rowidNumber];
+	}
+	
+	pendingRow->collectionKey = collectionKey;
+	
+	if (hasObject)
+	{
+		pendingRow->object = object;
+		pendingRow->hasObject = YES;
+	}
+	if (hasMetadata)
+	{
+		pendingRow->metadata = metadata;
+		pendingRow->hasMetadata = YES;
+	}
+	
+	isMutated = YES;
+}
+
+/**
+ * Writes all pending rows (if any) to the index table.
+ *
+ * This is invoked before the transaction is committed,
+ * as well as before any query is executed against the index table.
+**/
+- (void)flushPendingRows
+{
+	YDBLogAutoTrace();
+	
+	NSUInteger count = [pendingRows count];
+	if (count == 0) return;
+	
+	__unsafe_unretained YapDatabaseSecondaryIndex *secondaryIndex = secondaryIndexConnection->secondaryIndex;
+	YapDatabaseSecondaryIndexBlockType blockType = secondaryIndex->blockType;
+	
+	// Sort the rows by rowid, so we write to the index table in order.
+	
+	NSArray *rows = [[pendingRows allValues] sortedArrayUsingComparator:^NSComparisonResult(id obj1, id obj2) {
+		
+		__unsafe_unretained YDBSecondaryIndexPendingRow *row1 = (YDBSecondaryIndexPendingRow *)obj1;
+		__unsafe_unretained YDBSecondaryIndexPendingRow *row2 = (YDBSecondaryIndexPendingRow *)obj2;
+		
+		if (row1->rowid < row2->rowid) return NSOrderedAscending;
+		if (row1->rowid > row2->rowid) return NSOrderedDescending;
+		return NSOrderedSame;
+	}];
+	
+	[pendingRows removeAllObjects];
+	
+	// Step 1:
+	//
+	// Fetch anything the block needs that we weren't given by the hooks.
+	// E.g. handleReplaceMetadata doesn't give us the object.
+	//
+	// This has to be done on the transaction's thread (before we go concurrent).
+	
+	BOOL needsObject = (blockType == YapDatabaseSecondaryIndexBlockTypeWithObject ||
+	                    blockType == YapDatabaseSecondaryIndexBlockTypeWithRow);
+	
+	BOOL needsMetadata = (blockType == YapDatabaseSecondaryIndexBlockTypeWithMetadata ||
+	                      blockType == YapDatabaseSecondaryIndexBlockTypeWithRow);
+	
+	for (YDBSecondaryIndexPendingRow *row in rows)
+	{
+		if (needsObject && !row->hasObject)
+		{
+			row->object = [databaseTransaction objectForCollectionKey:row->collectionKey withRowid:row->rowid];
+			row->hasObject = YES;
+		}
+		if (needsMetadata && !row->hasMetadata)
+		{
+			row->metadata = [databaseTransaction metadataForCollectionKey:row->collectionKey withRowid:row->rowid];
+			row->hasMetadata = YES;
+		}
+	}
+	
+	// Step 2:
+	//
+	// Invoke the block for each row.
+	// Each row gets its own dictionary, so the block may be invoked concurrently (if allowed by the options).
+	
+	id sharedKeySet = secondaryIndex->columnNamesSharedKeySet;
+	YapDatabaseSecondaryIndexBlock block = secondaryIndex->block;
+	
+	void (^extractBlock)(size_t) = ^(size_t index) { @autoreleasepool {
+		
+		__unsafe_unretained YDBSecondaryIndexPendingRow *row = [rows objectAtIndex:index];
+		
+		__unsafe_unretained NSString *collection = row->collectionKey.collection;
+		__unsafe_unretained NSString *key = row->collectionKey.key;
+		
+		NSMutableDictionary *values = [NSMutableDictionary dictionaryWithSharedKeySet:sharedKeySet];
+		
+		if (blockType == YapDatabaseSecondaryIndexBlockTypeWithKey)
+		{
+			__unsafe_unretained YapDatabaseSecondaryIndexWithKeyBlock keyBlock =
+			    (YapDatabaseSecondaryIndexWithKeyBlock)block;
+			
+			keyBlock(values, collection, key);
+		}
+		else if (blockType == YapDatabaseSecondaryIndexBlockTypeWithObject)
+		{
+			__unsafe_unretained YapDatabaseSecondaryIndexWithObjectBlock objectBlock =
+			    (YapDatabaseSecondaryIndexWithObjectBlock)block;
+			
+			objectBlock(values, collection, key, row->object);
+		}
+		else if (blockType == YapDatabaseSecondaryIndexBlockTypeWithMetadata)
+		{
+			__unsafe_unretained YapDatabaseSecondaryIndexWithMetadataBlock metadataBlock =
+			    (YapDatabaseSecondaryIndexWithMetadataBlock)block;
+			
+			metadataBlock(values, collection, key, row->metadata);
+		}
+		else
+		{
+			__unsafe_unretained YapDatabaseSecondaryIndexWithRowBlock rowBlock =
+			    (YapDatabaseSecondaryIndexWithRowBlock)block;
+			
+			rowBlock(values, collection, key, row->object, row->metadata);
+		}
+		
+		row->values = values;
+		
+		// We no longer need these, so release them as we go.
+		row->object = nil;
+		row->metadata = nil;
+	}};
+	
+	if (secondaryIndex->options.concurrentIndexExtraction && (count > 1))
+	{
+		dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), extractBlock);
+	}
+	else
+	{
+		for (size_t index = 0; index < count; index++)
+		{
+			extractBlock(index);
+		}
+	}
+	
+	// Step 3:
+	//
+	// Write the values to the index table.
+	// Rows with values are written in batches, using a multi-row statement:
+	//
+	// INSERT OR REPLACE INTO "tableName" ("rowid", "column1", ...) VALUES (?, ?, ...), (?, ?, ...), ...;
+	//
+	// Rows without values are removed from the table (if they previously had values).
+	
+	NSMutableArray *rowsToAdd = [NSMutableArray arrayWithCapacity:count];
+	NSMutableArray *rowidsToRemove = [NSMutableArray array];
+	
+	for (YDBSecondaryIndexPendingRow *row in rows)
+	{
+		if ([row->values count] > 0)
+			[rowsToAdd addObject:row];
+		else if (!row->isNew)
+			[rowidsToRemove addObject:@(row->rowid)];
+	}
+	
+	NSUInteger addCount = [rowsToAdd count];
+	NSUInteger addOffset = 0;
+	
+	NSUInteger batchRowCount = (NSUInteger)[secondaryIndexConnection batchUpdateRowCount];
+	
+	if (addCount >= batchRowCount)
+	{
+		sqlite3_stmt *statement = [secondaryIndexConnection batchUpdateStatement];
+		if (statement)
+		{
+			while ((addCount - addOffset) >= batchRowCount)
+			{
+				int i = 1;
+				for (NSUInteger index = addOffset; index < (addOffset + batchRowCount); index++)
+				{
+					__unsafe_unretained YDBSecondaryIndexPendingRow *row = [rowsToAdd objectAtIndex:index];
+					
+					i = [self bindRowid:row->rowid withValues:row->values toStatement:statement atIndex:i];
+				}
+				
+				int status = sqlite3_step(statement);
+				if (status != SQLITE_DONE)
+				{
+					YDBLogError(@"Error executing 'batchUpdateStatement': %d %s",
+					            status, sqlite3_errmsg(databaseTransaction->connection->db));
+				}
+				
+				sqlite3_clear_bindings(statement);
+				sqlite3_reset(statement);
+				
+				addOffset += batchRowCount;
+			}
+		}
+	}
+	
+	for (NSUInteger index = addOffset; index < addCount; index++)
+	{
+		__unsafe_unretained YDBSecondaryIndexPendingRow *row = [rowsToAdd objectAtIndex:index];
+		
+		[self addRowid:row->rowid withValues:row->values isNew:row->isNew];
+	}
+	
+	// The removeRowids method expects batches capped at sqlite's max number of host parameters.
+	
+	NSUInteger removeCount = [rowidsToRemove count];
+	NSUInteger removeOffset = 0;
+	
+	while (removeOffset < removeCount)
+	{
+		NSUInteger batchCount = MIN((NSUInteger)999, (removeCount - removeOffset));
+		
+		[self removeRowids:[rowidsToRemove subarrayWithRange:NSMakeRange(removeOffset, batchCount)]];
+		removeOffset += batchCount;
+	}
+	
+	isMutated = YES;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Cleanup & Commit
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Optional override method from YapDatabaseExtension.
+ *
+ * If options.deferIndexUpdates is enabled, this is where the pending rows get written to the index table.
+ * (All changes to the main database table, including those made by other extensions, have been made at this point.)
+**/
+- (void)prepareChangeset
+{
+	[self flushPendingRows];
+}
+
 /**
  * Required override method from YapDatabaseExtension
 **/
@@ -689,6 +1115,8 @@ static NSString *const ExtKey_version_deprecated = @"version";
 **/
 - (void)rollbackTransaction
 {
+	pendingRows = nil;
+	
 	// An extensionTransaction is only valid within the scope of its encompassing databaseTransaction.
 	// I imagine this may occasionally be misunderstood, and developers may attempt to store the extension in an ivar,
 	// and then use it outside the context of the database transaction block.
@@ -724,6 +1152,15 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		return;
 	}
 	
+	if (secondaryIndex->options.deferIndexUpdates)
+	{
+		[self deferRowid:rowid collectionKey:collectionKey
+		          object:object hasObject:YES
+		        metadata:metadata hasMetadata:YES
+		           isNew:YES];
+		return;
+	}
+	
 	// Invoke the block to find out if the object should be included in the index.
 	
 	if (secondaryIndex->blockType == YapDatabaseSecondaryIndexBlockTypeWithKey)
@@ -791,6 +1228,15 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		return;
 	}
 	
+	if (secondaryIndex->options.deferIndexUpdates)
+	{
+		[self deferRowid:rowid collectionKey:collectionKey
+		          object:object hasObject:YES
+		        metadata:metadata hasMetadata:YES
+		           isNew:NO];
+		return;
+	}
+	
 	// Invoke the block to find out if the object should be included in the index.
 	
 	if (secondaryIndex->blockType == YapDatabaseSecondaryIndexBlockTypeWithKey)
@@ -875,6 +1321,15 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		// Index values are based on object or row (object+metadata).
 		// Invoke block to see what the new values are.
 		
+		if (secondaryIndex->options.deferIndexUpdates)
+		{
+			[self deferRowid:rowid collectionKey:collectionKey
+			          object:object hasObject:YES
+			        metadata:nil hasMetadata:NO
+			           isNew:NO];
+			return;
+		}
+		
 		if (secondaryIndex->blockType == YapDatabaseSecondaryIndexBlockTypeWithObject)
 		{
 			__unsafe_unretained YapDatabaseSecondaryIndexWithObjectBlock block =
@@ -945,6 +1400,15 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		// Index values are based on metadata or objectAndMetadata.
 		// Invoke block to see what the new values are.
 		
+		if (secondaryIndex->options.deferIndexUpdates)
+		{
+			[self deferRowid:rowid collectionKey:collectionKey
+			          object:nil hasObject:NO
+			        metadata:metadata hasMetadata:YES
+			           isNew:NO];
+			return;
+		}
+		
 		if (secondaryIndex->blockType == YapDatabaseSecondaryIndexBlockTypeWithMetadata)
 		{
 			__unsafe_unretained YapDatabaseSecondaryIndexWithMetadataBlock block =
@@ -1013,12 +1477,32 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		return;
 	}
 	
-	[self removeRowid:rowid];
-}
-
-/**
- * YapDatabase extension hook.
- * This method is invoked by a YapDatabaseReadWriteTransaction as a post-operation-hook.
+	if (pendingRows)
+	{
+		NSNumber *rowidNumber = @(rowid);
+		
+		YDBSecondaryIndexPendingRow *pendingRow = [pendingRows objectForKey:rowidNumber];
+		if (pendingRow)
+		{
+			[pendingRows removeObjectForKey:rowidNumber];
+			
+			if (pendingRow->isNew)
+			{
+				// The row was inserted during this transaction, and its values were never written.
+				// So there's nothing to remove from the index table.
+				
+				isMutated = YES;
+				return;
+			}
+		}
+	}
+	
+	[self removeRowid:rowid];
+}
+
+/**
+ * YapDatabase extension hook.
+ * This method is invoked by a YapDatabaseReadWriteTransaction as a post-operation-hook.
 **/
 - (void)handleRemoveObjectsForKeys:(NSArray *)keys inCollection:(NSString *)collection withRowids:(NSArray *)rowids
 {
@@ -1032,6 +1516,11 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		return;
 	}
 	
+	if (pendingRows)
+	{
+		[pendingRows removeObjectsForKeys:rowids];
+	}
+	
 	[self removeRowids:rowids];
 }
 
@@ -1043,6 +1532,7 @@ static NSString *const ExtKey_version_deprecated = @"version";
 {
 	YDBLogAutoTrace();
 	
+	[pendingRows removeAllObjects];
 	[self removeAllRowids];
 }
 
@@ -1050,48 +1540,157 @@ static NSString *const ExtKey_version_deprecated = @"version";
 #pragma mark Enumerate
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-- (BOOL)_enumerateRowidsMatchingQuery:(YapDatabaseQuery *)query
-                           usingBlock:(void (^)(int64_t rowid, BOOL *stop))block
+/**
+ * Prepares a new sqlite statement for the given query string.
+ *
+ * If the statement cannot be compiled, returns NULL.
+ * The error is only logged if logErrors is YES.
+**/
+- (sqlite3_stmt *)prepareStatementForQueryString:(NSString *)fullQueryString logErrors:(BOOL)logErrors
 {
-	// Create full query using given filtering clause(s)
-	
-	NSString *fullQueryString =
-	    [NSString stringWithFormat:@"SELECT \"rowid\" FROM \"%@\" %@;", [self tableName], query.queryString];
+	sqlite3 *db = databaseTransaction->connection->db;
+	sqlite3_stmt *statement = NULL;
 	
-	// Turn query into compiled sqlite statement.
-	// Use cache if possible.
+	int status = sqlite3_prepare_v2(db, [fullQueryString UTF8String], -1, &statement, NULL);
+	if (status != SQLITE_OK)
+	{
+		if (logErrors)
+		{
+			YDBLogError(@"%@: Error creating query:\n query: '%@'\n error: %d %s",
+			            THIS_METHOD, fullQueryString, status, sqlite3_errmsg(db));
+		}
+		else
+		{
+			YDBLogVerbose(@"%@: Unable to create query:\n query: '%@'\n error: %d %s",
+			              THIS_METHOD, fullQueryString, status, sqlite3_errmsg(db));
+		}
+		
+		return NULL;
+	}
 	
+	return statement;
+}
+
+/**
+ * Returns the compiled sqlite statement for the given query string.
+ * Uses the queryCache if possible.
+ *
+ * If the statement cannot be compiled, returns NULL.
+ * The error is only logged if logErrors is YES.
+ *
+ * Failures are cached too (as NSNull), just like in the compiledQueryCache.
+ * This matters for the joined query in _enumerateRowsMatchingQuery:, which is expected to fail for some queries,
+ * and would otherwise be prepared (and fail) every time before falling back.
+**/
+- (sqlite3_stmt *)statementForQueryString:(NSString *)fullQueryString logErrors:(BOOL)logErrors
+{
 	sqlite3_stmt *statement = NULL;
 	
-	YapDatabaseStatement *wrapper = [secondaryIndexConnection->queryCache objectForKey:fullQueryString];
+	id wrapper = [secondaryIndexConnection->queryCache objectForKey:fullQueryString];
 	if (wrapper)
 	{
-		statement = wrapper.stmt;
+		if (wrapper != [NSNull null])
+			statement = [(YapDatabaseStatement *)wrapper stmt];
 	}
 	else
 	{
-		sqlite3 *db = databaseTransaction->connection->db;
-		
-		int status = sqlite3_prepare_v2(db, [fullQueryString UTF8String], -1, &statement, NULL);
-		if (status != SQLITE_OK)
-		{
-			YDBLogError(@"%@: Error creating query:\n query: '%@'\n error: %d %s",
-						THIS_METHOD, fullQueryString, status, sqlite3_errmsg(db));
-			
-			return NO;
-		}
+		statement = [self prepareStatementForQueryString:fullQueryString logErrors:logErrors];
 		
 		if (secondaryIndexConnection->queryCache)
 		{
-			wrapper = [[YapDatabaseStatement alloc] initWithStatement:statement];
+			if (statement)
+				wrapper = [[YapDatabaseStatement alloc] initWithStatement:statement];
+			else
+				wrapper = [NSNull null];
+			
 			[secondaryIndexConnection->queryCache setObject:wrapper forKey:fullQueryString];
 		}
 	}
 	
-	// Bind query parameters appropriately.
+	return statement;
+}
+
+/**
+ * Returns the compiled sqlite statement for the given query string.
+ *
+ * If the query is a YapDatabaseCompiledQuery, the statement is stored in the compiledQueryCache,
+ * where it can be found (without building the query string) via getStatement:forCompiledQuery:kind:.
+ * Otherwise this is the same as statementForQueryString:logErrors:.
+**/
+- (sqlite3_stmt *)statementForQueryString:(NSString *)fullQueryString
+                                    query:(YapDatabaseQuery *)query
+                                     kind:(int)kind
+                                logErrors:(BOOL)logErrors
+{
+	if (![query isKindOfClass:[YapDatabaseCompiledQuery class]])
+	{
+		return [self statementForQueryString:fullQueryString logErrors:logErrors];
+	}
+	
+	sqlite3_stmt *statement = [self prepareStatementForQueryString:fullQueryString logErrors:logErrors];
+	
+	NSNumber *queryID = @([(YapDatabaseCompiledQuery *)query queryID]);
+	
+	NSMutableDictionary *statements = [secondaryIndexConnection->compiledQueryCache objectForKey:queryID];
+	if (statements == nil)
+	{
+		statements = [NSMutableDictionary dictionaryWithCapacity:1];
+		[secondaryIndexConnection->compiledQueryCache setObject:statements forKey:queryID];
+	}
+	
+	// Failures are remembered too (as NSNull), so we don't try to prepare the same statement over and over.
+	
+	if (statement)
+		[statements setObject:[[YapDatabaseStatement alloc] initWithStatement:statement] forKey:@(kind)];
+	else
+		[statements setObject:[NSNull null] forKey:@(kind)];
+	
+	return statement;
+}
+
+/**
+ * If the query is a YapDatabaseCompiledQuery, and a statement of the given kind has already been prepared for it
+ * (on this connection), returns YES, and sets statementPtr (which will be NULL if the statement failed to compile).
+ *
+ * Otherwise returns NO, and the caller needs to build the query string.
+**/
+- (BOOL)getStatement:(sqlite3_stmt **)statementPtr forCompiledQuery:(YapDatabaseQuery *)query kind:(int)kind
+{
+	if (![query isKindOfClass:[YapDatabaseCompiledQuery class]]) return NO;
+	
+	NSNumber *queryID = @([(YapDatabaseCompiledQuery *)query queryID]);
+	
+	NSMutableDictionary *statements = [secondaryIndexConnection->compiledQueryCache objectForKey:queryID];
+	id wrapper = [statements objectForKey:@(kind)];
+	
+	if (wrapper == nil) return NO;
 	
+	if (wrapper == [NSNull null])
+		*statementPtr = NULL;
+	else
+		*statementPtr = [(YapDatabaseStatement *)wrapper stmt];
+	
+	return YES;
+}
+
+/**
+ * Binds the parameters of the given query (either a regular or a compiled query) to the given statement.
+**/
+- (void)bindQuery:(YapDatabaseQuery *)query toStatement:(sqlite3_stmt *)statement
+{
+	if ([query isKindOfClass:[YapDatabaseCompiledQuery class]])
+		[(YapDatabaseCompiledQuery *)query bindToStatement:statement];
+	else
+		[self bindQueryParameters:query.queryParameters toStatement:statement];
+}
+
+/**
+ * Binds the query parameters (in order) to the given statement.
+**/
+- (void)bindQueryParameters:(NSArray *)queryParameters toStatement:(sqlite3_stmt *)statement
+{
 	int i = 1;
-	for (id value in query.queryParameters)
+	for (id value in queryParameters)
 	{
 		if ([value isKindOfClass:[NSNumber class]])
 		{
@@ -1127,6 +1726,16 @@ static NSString *const ExtKey_version_deprecated = @"version";
 			
 			sqlite3_bind_text(statement, i, [cast UTF8String], -1, SQLITE_TRANSIENT);
 		}
+		else if ([value isKindOfClass:[NSData class]])
+		{
+			__unsafe_unretained NSData *cast = (NSData *)value;
+			
+			sqlite3_bind_blob(statement, i, [cast bytes], (int)[cast length], SQLITE_TRANSIENT);
+		}
+		else if (value == [NSNull null])
+		{
+			sqlite3_bind_null(statement, i);
+		}
 		else
 		{
 			YDBLogWarn(@"Unable to bind value for with unsupported class: %@", NSStringFromClass([value class]));
@@ -1134,6 +1743,37 @@ static NSString *const ExtKey_version_deprecated = @"version";
 		
 		i++;
 	}
+}
+
+- (BOOL)_enumerateRowidsMatchingQuery:(YapDatabaseQuery *)query
+                           usingBlock:(void (^)(int64_t rowid, BOOL *stop))block
+{
+	// Write any pending changes (options.deferIndexUpdates) so the query sees them
+	
+	[self flushPendingRows];
+	
+	sqlite3_stmt *statement = NULL;
+	if (![self getStatement:&statement forCompiledQuery:query kind:YDBSecondaryIndexQueryKindRowids])
+	{
+		// Create full query using given filtering clause(s)
+		
+		NSString *fullQueryString =
+		    [NSString stringWithFormat:@"SELECT \"rowid\" FROM \"%@\" %@;", [self tableName], query.queryString];
+		
+		// Turn query into compiled sqlite statement.
+		// Use cache if possible.
+		
+		statement = [self statementForQueryString:fullQueryString
+		                                    query:query
+		                                     kind:YDBSecondaryIndexQueryKindRowids
+		                                logErrors:YES];
+	}
+	
+	if (statement == NULL) return NO;
+	
+	// Bind query parameters appropriately.
+	
+	[self bindQuery:query toStatement:statement];
 	
 	// Enumerate query results
 	
@@ -1174,15 +1814,211 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	return (status == SQLITE_DONE);
 }
 
+/**
+ * Enumerates the rows matching the query, along with their collection/key,
+ * and (optionally) their object and/or metadata.
+ *
+ * Rather than fetching the rowids from the index table, and then looking up each row in the database table
+ * (one extra statement per row when the caches are cold), this method joins the index table with the
+ * database table, so the whole result set comes from a single statement.
+ * The key, object & metadata caches are still consulted first, which avoids unneeded deserialization.
+ *
+ * If the joined statement cannot be compiled (e.g. the query references "rowid",
+ * which is ambiguous once the tables are joined), then we fallback to enumerating the rowids.
+ * The failure is cached, so later invocations go straight to the fallback.
+**/
+- (BOOL)_enumerateRowsMatchingQuery:(YapDatabaseQuery *)query
+                       fetchObjects:(BOOL)fetchObjects
+                      fetchMetadata:(BOOL)fetchMetadata
+                         usingBlock:
+                     (void (^)(int64_t rowid, YapCollectionKey *ck, id object, id metadata, BOOL *stop))block
+{
+	// Write any pending changes (options.deferIndexUpdates) so the query sees them
+	
+	[self flushPendingRows];
+	
+	int dataColumnIndex = -1;
+	int metadataColumnIndex = -1;
+	int columnCount = 3;
+	
+	if (fetchObjects)
+		dataColumnIndex = columnCount++;
+	if (fetchMetadata)
+		metadataColumnIndex = columnCount++;
+	
+	int kind = YDBSecondaryIndexQueryKindRows + (fetchObjects ? 1 : 0) + (fetchMetadata ? 2 : 0);
+	
+	sqlite3_stmt *statement = NULL;
+	if (![self getStatement:&statement forCompiledQuery:query kind:kind])
+	{
+		// Create full query using given filtering clause(s)
+		
+		NSString *tableName = [self tableName];
+		
+		NSMutableString *fullQueryString = [NSMutableString stringWithCapacity:256];
+		[fullQueryString appendString:
+		  @"SELECT \"database2\".\"rowid\", \"database2\".\"collection\", \"database2\".\"key\""];
+		
+		if (fetchObjects)
+			[fullQueryString appendString:@", \"database2\".\"data\""];
+		if (fetchMetadata)
+			[fullQueryString appendString:@", \"database2\".\"metadata\""];
+		
+		// Note: The CROSS JOIN forces sqlite to use the index table for the outer loop.
+		
+		[fullQueryString appendFormat:
+		  @" FROM \"%@\" CROSS JOIN \"database2\" ON \"database2\".\"rowid\" = \"%@\".\"rowid\" %@;",
+		  tableName, tableName, query.queryString];
+		
+		// Turn query into compiled sqlite statement.
+		// Use cache if possible.
+		
+		statement = [self statementForQueryString:fullQueryString query:query kind:kind logErrors:NO];
+	}
+	
+	if (statement == NULL)
+	{
+		return [self _enumerateRowidsMatchingQuery:query usingBlock:^(int64_t rowid, BOOL *stop) {
+			
+			YapCollectionKey *ck = nil;
+			id object = nil;
+			id metadata = nil;
+			
+			if (fetchObjects && fetchMetadata)
+				[databaseTransaction getCollectionKey:&ck object:&object metadata:&metadata forRowid:rowid];
+			else if (fetchObjects)
+				[databaseTransaction getCollectionKey:&ck object:&object forRowid:rowid];
+			else if (fetchMetadata)
+				[databaseTransaction getCollectionKey:&ck metadata:&metadata forRowid:rowid];
+			else
+				ck = [databaseTransaction collectionKeyForRowid:rowid];
+			
+			block(rowid, ck, object, metadata, stop);
+		}];
+	}
+	
+	// Bind query parameters appropriately.
+	
+	[self bindQuery:query toStatement:statement];
+	
+	// Enumerate query results
+	
+	YapDatabaseConnection *connection = databaseTransaction->connection;
+	
+	BOOL stop = NO;
+	isMutated = NO; // mutation during enumeration protection
+	
+	int status = sqlite3_step(statement);
+	if (status == SQLITE_ROW)
+	{
+		if (connection->needsMarkSqlLevelSharedReadLock)
+			[connection markSqlLevelSharedReadLockAcquired];
+		
+		do
+		{
+			int64_t rowid = sqlite3_column_int64(statement, 0);
+			NSNumber *rowidNumber = @(rowid);
+			
+			YapCollectionKey *ck = [connection->keyCache objectForKey:rowidNumber];
+			if (ck == nil)
+			{
+				const unsigned char *text1 = sqlite3_column_text(statement, 1);
+				int textSize1 = sqlite3_column_bytes(statement, 1);
+				
+				const unsigned char *text2 = sqlite3_column_text(statement, 2);
+				int textSize2 = sqlite3_column_bytes(statement, 2);
+				
+				NSString *collection =
+				  [[NSString alloc] initWithBytes:text1 length:textSize1 encoding:NSUTF8StringEncoding];
+				NSString *key =
+				  [[NSString alloc] initWithBytes:text2 length:textSize2 encoding:NSUTF8StringEncoding];
+				
+				ck = [[YapCollectionKey alloc] initWithCollection:collection key:key];
+				
+				[connection->keyCache setObject:ck forKey:rowidNumber];
+			}
+			
+			id object = nil;
+			if (fetchObjects)
+			{
+				object = [connection->objectCache objectForKey:ck];
+				if (object == nil)
+				{
+					const void *oBlob = sqlite3_column_blob(statement, dataColumnIndex);
+					int oBlobSize = sqlite3_column_bytes(statement, dataColumnIndex);
+					
+					// Performance tuning:
+					// Use dataWithBytesNoCopy to avoid an extra allocation and memcpy.
+					
+					NSData *oData = [NSData dataWithBytesNoCopy:(void *)oBlob length:oBlobSize freeWhenDone:NO];
+					object = connection->database->objectDeserializer(ck.collection, ck.key, oData);
+					
+					if (object)
+						[connection->objectCache setObject:object forKey:ck];
+				}
+			}
+			
+			id metadata = nil;
+			if (fetchMetadata)
+			{
+				metadata = [connection->metadataCache objectForKey:ck];
+				if (metadata)
+				{
+					if (metadata == [YapNull null])
+						metadata = nil;
+				}
+				else
+				{
+					const void *mBlob = sqlite3_column_blob(statement, metadataColumnIndex);
+					int mBlobSize = sqlite3_column_bytes(statement, metadataColumnIndex);
+					
+					if (mBlobSize > 0)
+					{
+						// Performance tuning:
+						// Use dataWithBytesNoCopy to avoid an extra allocation and memcpy.
+						
+						NSData *mData = [NSData dataWithBytesNoCopy:(void *)mBlob length:mBlobSize freeWhenDone:NO];
+						metadata = connection->database->metadataDeserializer(ck.collection, ck.key, mData);
+					}
+					
+					if (metadata)
+						[connection->metadataCache setObject:metadata forKey:ck];
+					else
+						[connection->metadataCache setObject:[YapNull null] forKey:ck];
+				}
+			}
+			
+			block(rowid, ck, object, metadata, &stop);
+			
+			if (stop || isMutated) break;
+			
+		} while ((status = sqlite3_step(statement)) == SQLITE_ROW);
+	}
+	
+	if ((status != SQLITE_DONE) && !stop && !isMutated)
+	{
+		YDBLogError(@"%@ - sqlite_step error: %d %s", THIS_METHOD, status, sqlite3_errmsg(connection->db));
+	}
+	
+	sqlite3_clear_bindings(statement);
+	sqlite3_reset(statement);
+	
+	if (isMutated && !stop)
+	{
+		@throw [self mutationDuringEnumerationException];
+	}
+	
+	return (status == SQLITE_DONE);
+}
+
 - (BOOL)enumerateKeysMatchingQuery:(YapDatabaseQuery *)query
                         usingBlock:(void (^)(NSString *collection, NSString *key, BOOL *stop))block
 {
 	if (query == nil) return NO;
 	if (block == nil) return NO;
 	
-	BOOL result = [self _enumerateRowidsMatchingQuery:query usingBlock:^(int64_t rowid, BOOL *stop) {
-		
-		YapCollectionKey *ck = [databaseTransaction collectionKeyForRowid:rowid];
+	BOOL result = [self _enumerateRowsMatchingQuery:query fetchObjects:NO fetchMetadata:NO
+	                                     usingBlock:^(int64_t rowid, YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
 		
 		block(ck.collection, ck.key, stop);
 	}];
@@ -1197,11 +2033,8 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	if (query == nil) return NO;
 	if (block == nil) return NO;
 	
-	BOOL result = [self _enumerateRowidsMatchingQuery:query usingBlock:^(int64_t rowid, BOOL *stop) {
-		
-		YapCollectionKey *ck = nil;
-		id metadata = nil;
-		[databaseTransaction getCollectionKey:&ck metadata:&metadata forRowid:rowid];
+	BOOL result = [self _enumerateRowsMatchingQuery:query fetchObjects:NO fetchMetadata:YES
+	                                     usingBlock:^(int64_t rowid, YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
 		
 		block(ck.collection, ck.key, metadata, stop);
 	}];
@@ -1216,11 +2049,8 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	if (query == nil) return NO;
 	if (block == nil) return NO;
 	
-	BOOL result = [self _enumerateRowidsMatchingQuery:query usingBlock:^(int64_t rowid, BOOL *stop) {
-		
-		YapCollectionKey *ck = nil;
-		id object = nil;
-		[databaseTransaction getCollectionKey:&ck object:&object forRowid:rowid];
+	BOOL result = [self _enumerateRowsMatchingQuery:query fetchObjects:YES fetchMetadata:NO
+	                                     usingBlock:^(int64_t rowid, YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
 		
 		block(ck.collection, ck.key, object, stop);
 	}];
@@ -1235,12 +2065,8 @@ static NSString *const ExtKey_version_deprecated = @"version";
 	if (query == nil) return NO;
 	if (block == nil) return NO;
 	
-	BOOL result = [self _enumerateRowidsMatchingQuery:query usingBlock:^(int64_t rowid, BOOL *stop) {
-		
-		YapCollectionKey *ck = nil;
-		id object = nil;
-		id metadata = nil;
-		[databaseTransaction getCollectionKey:&ck object:&object metadata:&metadata forRowid:rowid];
+	BOOL result = [self _enumerateRowsMatchingQuery:query fetchObjects:YES fetchMetadata:YES
+	                                     usingBlock:^(int64_t rowid, YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
 		
 		block(ck.collection, ck.key, object, metadata, stop);
 	}];
@@ -1254,114 +2080,895 @@ static NSString *const ExtKey_version_deprecated = @"version";
 
 - (BOOL)getNumberOfRows:(NSUInteger *)countPtr matchingQuery:(YapDatabaseQuery *)query
 {
-	// Create full query using given filtering clause(s)
+	// Write any pending changes (options.deferIndexUpdates) so the query sees them
 	
-	NSString *fullQueryString =
-	    [NSString stringWithFormat:@"SELECT COUNT(*) AS NumberOfRows FROM \"%@\" %@;",
-	                                                           [self tableName], query.queryString];
-	
-	// Turn query into compiled sqlite statement.
-	// Use cache if possible.
+	[self flushPendingRows];
 	
 	sqlite3_stmt *statement = NULL;
-	
-	YapDatabaseStatement *wrapper = [secondaryIndexConnection->queryCache objectForKey:fullQueryString];
-	if (wrapper)
-	{
-		statement = wrapper.stmt;
-	}
-	else
+	if (![self getStatement:&statement forCompiledQuery:query kind:YDBSecondaryIndexQueryKindCount])
 	{
-		sqlite3 *db = databaseTransaction->connection->db;
+		// Create full query using given filtering clause(s)
 		
-		int status = sqlite3_prepare_v2(db, [fullQueryString UTF8String], -1, &statement, NULL);
-		if (status != SQLITE_OK)
-		{
-			YDBLogError(@"%@: Error creating query:\n query: '%@'\n error: %d %s",
-						THIS_METHOD, fullQueryString, status, sqlite3_errmsg(db));
-			
-			return NO;
-		}
+		NSString *fullQueryString =
+		    [NSString stringWithFormat:@"SELECT COUNT(*) AS NumberOfRows FROM \"%@\" %@;",
+		                                                           [self tableName], query.queryString];
 		
-		if (secondaryIndexConnection->queryCache)
-		{
-			wrapper = [[YapDatabaseStatement alloc] initWithStatement:statement];
-			[secondaryIndexConnection->queryCache setObject:wrapper forKey:fullQueryString];
-		}
+		// Turn query into compiled sqlite statement.
+		// Use cache if possible.
+		
+		statement = [self statementForQueryString:fullQueryString
+		                                    query:query
+		                                     kind:YDBSecondaryIndexQueryKindCount
+		                                logErrors:YES];
 	}
 	
+	if (statement == NULL) return NO;
+	
 	// Bind query parameters appropriately.
 	
-	int i = 1;
-	for (id value in query.queryParameters)
-	{
-		if ([value isKindOfClass:[NSNumber class]])
-		{
-			__unsafe_unretained NSNumber *cast = (NSNumber *)value;
-			
-			CFNumberType numType = CFNumberGetType((__bridge CFNumberRef)cast);
+	[self bindQuery:query toStatement:statement];
+	
+	// Execute query
+	
+	BOOL result = YES;
+	NSUInteger count = 0;
+	
+	int status = sqlite3_step(statement);
+	if (status == SQLITE_ROW)
+	{
+		if (databaseTransaction->connection->needsMarkSqlLevelSharedReadLock)
+			[databaseTransaction->connection markSqlLevelSharedReadLockAcquired];
+		
+		count = (NSUInteger)sqlite3_column_int64(statement, 0);
+	}
+	else if (status == SQLITE_ERROR)
+	{
+		YDBLogError(@"%@ - sqlite_step error: %d %s", THIS_METHOD,
+		            status, sqlite3_errmsg(databaseTransaction->connection->db));
+		result = NO;
+	}
+	
+	sqlite3_clear_bindings(statement);
+	sqlite3_reset(statement);
+	
+	if (countPtr) *countPtr = count;
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Aggregate
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Converts the sqlite value at the given column (of the current row) into its corresponding objective-c type.
+**/
+static id YDBSecondaryIndexColumnValue(sqlite3_stmt *statement, int column)
+{
+	switch (sqlite3_column_type(statement, column))
+	{
+		case SQLITE_INTEGER :
+		{
+			return @(sqlite3_column_int64(statement, column));
+		}
+		case SQLITE_FLOAT :
+		{
+			return @(sqlite3_column_double(statement, column));
+		}
+		case SQLITE_TEXT :
+		{
+			const unsigned char *text = sqlite3_column_text(statement, column);
+			int textSize = sqlite3_column_bytes(statement, column);
 			
-			if (numType == kCFNumberFloatType   ||
-			    numType == kCFNumberFloat32Type ||
-			    numType == kCFNumberFloat64Type ||
-			    numType == kCFNumberDoubleType  ||
-			    numType == kCFNumberCGFloatType  )
+			return [[NSString alloc] initWithBytes:text length:textSize encoding:NSUTF8StringEncoding];
+		}
+		case SQLITE_BLOB :
+		{
+			const void *blob = sqlite3_column_blob(statement, column);
+			int blobSize = sqlite3_column_bytes(statement, column);
+			
+			return [NSData dataWithBytes:blob length:blobSize];
+		}
+		default :
+		{
+			return [NSNull null];
+		}
+	}
+}
+
+- (BOOL)enumerateAggregates:(NSArray *)resultColumns
+              matchingQuery:(YapDatabaseQuery *)query
+                 usingBlock:(void (^)(NSArray *values, BOOL *stop))block
+{
+	if ([resultColumns count] == 0) return NO;
+	if (query == nil) return NO;
+	if (block == nil) return NO;
+	
+	// Write any pending changes (options.deferIndexUpdates) so the query sees them
+	
+	[self flushPendingRows];
+	
+	// Create full query using given filtering clause(s)
+	
+	NSString *fullQueryString =
+	    [NSString stringWithFormat:@"SELECT %@ FROM \"%@\" %@;",
+	        [resultColumns componentsJoinedByString:@", "], [self tableName], query.queryString];
+	
+	// Turn query into compiled sqlite statement.
+	// Use cache if possible.
+	
+	sqlite3_stmt *statement = [self statementForQueryString:fullQueryString logErrors:YES];
+	if (statement == NULL) return NO;
+	
+	// Bind query parameters appropriately.
+	
+	[self bindQuery:query toStatement:statement];
+	
+	// Enumerate query results
+	
+	int columnCount = sqlite3_column_count(statement);
+	
+	BOOL stop = NO;
+	isMutated = NO; // mutation during enumeration protection
+	
+	int status = sqlite3_step(statement);
+	if (status == SQLITE_ROW)
+	{
+		if (databaseTransaction->connection->needsMarkSqlLevelSharedReadLock)
+			[databaseTransaction->connection markSqlLevelSharedReadLockAcquired];
+		
+		do
+		{
+			NSMutableArray *values = [NSMutableArray arrayWithCapacity:columnCount];
+			
+			for (int column = 0; column < columnCount; column++)
 			{
-				double num = [cast doubleValue];
-				sqlite3_bind_double(statement, i, num);
+				[values addObject:YDBSecondaryIndexColumnValue(statement, column)];
 			}
-			else
+			
+			block(values, &stop);
+			
+			if (stop || isMutated) break;
+			
+		} while ((status = sqlite3_step(statement)) == SQLITE_ROW);
+	}
+	
+	if ((status != SQLITE_DONE) && !stop && !isMutated)
+	{
+		YDBLogError(@"%@ - sqlite_step error: %d %s", THIS_METHOD,
+		            status, sqlite3_errmsg(databaseTransaction->connection->db));
+	}
+	
+	sqlite3_clear_bindings(statement);
+	sqlite3_reset(statement);
+	
+	if (isMutated && !stop)
+	{
+		@throw [self mutationDuringEnumerationException];
+	}
+	
+	return (status == SQLITE_DONE) || stop;
+}
+
+- (id)aggregate:(NSString *)resultColumn matchingQuery:(YapDatabaseQuery *)query
+{
+	if (resultColumn == nil) return nil;
+	
+	__block id result = nil;
+	
+	[self enumerateAggregates:@[ resultColumn ] matchingQuery:query usingBlock:^(NSArray *values, BOOL *stop) {
+		
+		result = [values firstObject];
+		*stop = YES;
+	}];
+	
+	if (result == [NSNull null])
+		result = nil;
+	
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Pagination
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the condition following the leading WHERE keyword of the given query,
+ * or an empty string if the query is empty.
+ *
+ * Returns nil (and logs a warning) if the query contains anything other than a WHERE clause.
+ * That is, if it doesn't start with WHERE, or if the condition is followed by a GROUP BY, HAVING, ORDER BY
+ * or LIMIT clause (or a compound SELECT). This is required for queries to which we append our own conditions,
+ * and ORDER BY & LIMIT clauses. (Such clauses within a subquery are fine.)
+**/
+- (NSString *)whereClauseForQuery:(YapDatabaseQuery *)query
+{
+	NSCharacterSet *whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+	NSString *queryString = [query.queryString stringByTrimmingCharactersInSet:whitespace];
+	
+	if ([queryString length] == 0)
+		return @"";
+	
+	NSRange range = [queryString rangeOfString:@"WHERE" options:(NSAnchoredSearch | NSCaseInsensitiveSearch)];
+	if (range.location == NSNotFound)
+	{
+		YDBLogWarn(@"%@: Query must be empty, or contain only a WHERE clause: %@", THIS_METHOD, query.queryString);
+		return nil;
+	}
+	
+	NSString *condition = [queryString substringFromIndex:NSMaxRange(range)];
+	
+	NSString *keyword = [self trailingClauseKeywordInCondition:condition];
+	if (keyword)
+	{
+		YDBLogWarn(@"%@: Query must contain only a WHERE clause (found %@): %@",
+		           THIS_METHOD, [keyword uppercaseString], query.queryString);
+		return nil;
+	}
+	
+	return condition;
+}
+
+/**
+ * Returns the first keyword (outside of any parentheses, string literals, quoted identifiers & comments)
+ * that would end the given WHERE condition and start another clause. Or nil if there isn't one.
+**/
+- (NSString *)trailingClauseKeywordInCondition:(NSString *)condition
+{
+	NSSet *keywords = [NSSet setWithObjects:@"group", @"having", @"order", @"limit",
+	                                        @"union", @"intersect", @"except", @"window", nil];
+	
+	NSUInteger length = [condition length];
+	NSUInteger depth = 0;
+	NSUInteger i = 0;
+	
+	while (i < length)
+	{
+		unichar c = [condition characterAtIndex:i];
+		
+		if (c == '\'' || c == '"' || c == '`' || c == '[')
+		{
+			// String literal or quoted identifier (see parameterCountForQueryString: in YapDatabaseQuery)
+			
+			unichar end = (c == '[') ? ']' : c;
+			
+			for (i++; i < length; i++)
 			{
-				int64_t num = [cast longLongValue];
-				sqlite3_bind_int64(statement, i, (sqlite3_int64)num);
+				if ([condition characterAtIndex:i] == end) break;
 			}
+			
+			i++;
 		}
-		else if ([value isKindOfClass:[NSDate class]])
+		else if (c == '-' && (i + 1) < length && [condition characterAtIndex:(i + 1)] == '-')
 		{
-			__unsafe_unretained NSDate *cast = (NSDate *)value;
+			for (i += 2; i < length; i++)
+			{
+				if ([condition characterAtIndex:i] == '\n') break;
+			}
+		}
+		else if (c == '/' && (i + 1) < length && [condition characterAtIndex:(i + 1)] == '*')
+		{
+			for (i += 2; i < length; i++)
+			{
+				if ([condition characterAtIndex:i] == '*' &&
+				    (i + 1) < length && [condition characterAtIndex:(i + 1)] == '/') break;
+			}
 			
-			double num = [cast timeIntervalSinceReferenceDate];
-			sqlite3_bind_double(statement, i, num);
+			i += 2;
 		}
-		else if ([value isKindOfClass:[NSString class]])
+		else if (c == '(')
 		{
-			__unsafe_unretained NSString *cast = (NSString *)value;
+			depth++;
+			i++;
+		}
+		else if (c == ')')
+		{
+			if (depth > 0) depth--;
+			i++;
+		}
+		else if (c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
+		{
+			NSUInteger start = i;
 			
-			sqlite3_bind_text(statement, i, [cast UTF8String], -1, SQLITE_TRANSIENT);
+			for (i++; i < length; i++)
+			{
+				unichar wc = [condition characterAtIndex:i];
+				
+				if (!(wc == '_' || (wc >= 'a' && wc <= 'z') || (wc >= 'A' && wc <= 'Z') || (wc >= '0' && wc <= '9')))
+					break;
+			}
+			
+			if (depth == 0)
+			{
+				NSString *word = [[condition substringWithRange:NSMakeRange(start, i - start)] lowercaseString];
+				
+				if ([keywords containsObject:word])
+					return word;
+			}
 		}
 		else
 		{
-			YDBLogWarn(@"Unable to bind value for with unsupported class: %@", NSStringFromClass([value class]));
+			i++;
 		}
+	}
+	
+	return nil;
+}
+
+/**
+ * Enumerates a single page of rows (ordered by the given column, with ties broken by rowid),
+ * starting immediately after the given cursor (or at the beginning if there's no cursor).
+ *
+ * Returns the cursor for the next page, or nil if there are no more rows.
+**/
+- (YapDatabaseSecondaryIndexCursor *)_enumerateRowsMatchingQuery:(YapDatabaseQuery *)query
+                                                       orderedBy:(NSString *)column
+                                                       ascending:(BOOL)ascending
+                                                           limit:(NSUInteger)limit
+                                                     afterCursor:(YapDatabaseSecondaryIndexCursor *)cursor
+                                                    fetchObjects:(BOOL)fetchObjects
+                                                   fetchMetadata:(BOOL)fetchMetadata
+                                                      usingBlock:
+                            (void (^)(YapCollectionKey *ck, id object, id metadata, BOOL *stop))block
+{
+	if (query == nil) return nil;
+	if (block == nil) return nil;
+	if (limit == 0) return nil;
+	
+	if (![[secondaryIndexConnection->secondaryIndex->setup columnNames] containsObject:column])
+	{
+		YDBLogWarn(@"%@: Invalid column (%@): not in setup", THIS_METHOD, column);
+		return nil;
+	}
+	
+	if (cursor && (![cursor.column isEqualToString:column] || (cursor.ascending != ascending)))
+	{
+		YDBLogWarn(@"%@: Cursor doesn't match the given ordering: %@", THIS_METHOD, cursor);
+		return nil;
+	}
+	
+	// Extract the WHERE clause from the given query (if any).
+	// The ORDER BY & LIMIT clauses are added by us.
+	
+	NSString *whereClause = [self whereClauseForQuery:query];
+	if (whereClause == nil) return nil;
+	
+	// Build the query for the page (for a descending order):
+	//
+	// WHERE (<whereClause>) AND "col" IS NOT NULL
+	//   AND "col" <= ? AND ("col" < ? OR "rowid" < ?)     <- Only if there's a cursor
+	// ORDER BY "col" DESC, "rowid" DESC LIMIT ?
+	//
+	// The cursor condition is written this way (rather than as a row value comparison),
+	// so that sqlite can use it as a range constraint on the column's index,
+	// and seek directly to the position of the cursor.
+	//
+	// Note: The column names are qualified, as the query may be joined with the database table.
+	
+	NSString *tableName = [self tableName];
+	
+	NSString *qualifiedColumn = [NSString stringWithFormat:@"\"%@\".\"%@\"", tableName, column];
+	NSString *qualifiedRowid  = [NSString stringWithFormat:@"\"%@\".\"rowid\"", tableName];
+	
+	NSMutableString *pageQueryString = [NSMutableString stringWithCapacity:256];
+	[pageQueryString appendString:@"WHERE "];
+	
+	if ([whereClause length] > 0)
+		[pageQueryString appendFormat:@"(%@) AND ", whereClause];
+	
+	[pageQueryString appendFormat:@"%@ IS NOT NULL", qualifiedColumn];
+	
+	NSMutableArray *pageQueryParameters = [NSMutableArray arrayWithArray:query.queryParameters];
+	
+	if (cursor)
+	{
+		NSString *op = ascending ? @">" : @"<";
 		
-		i++;
+		[pageQueryString appendFormat:@" AND %@ %@= ? AND (%@ %@ ? OR %@ %@ ?)",
+		                  qualifiedColumn, op, qualifiedColumn, op, qualifiedRowid, op];
+		
+		[pageQueryParameters addObject:cursor.value];
+		[pageQueryParameters addObject:cursor.value];
+		[pageQueryParameters addObject:@(cursor.rowid)];
 	}
 	
-	// Execute query
+	NSString *order = ascending ? @"ASC" : @"DESC";
 	
-	BOOL result = YES;
-	NSUInteger count = 0;
+	[pageQueryString appendFormat:@" ORDER BY %@ %@, %@ %@ LIMIT ?",
+	                  qualifiedColumn, order, qualifiedRowid, order];
+	
+	[pageQueryParameters addObject:@(limit)];
+	
+	YapDatabaseQuery *pageQuery =
+	  [[YapDatabaseQuery alloc] initWithQueryString:pageQueryString queryParameters:pageQueryParameters];
+	
+	// Enumerate the page
+	
+	__block NSUInteger count = 0;
+	__block int64_t lastRowid = 0;
+	__block BOOL stopped = NO;
+	
+	BOOL result = [self _enumerateRowsMatchingQuery:pageQuery
+	                                   fetchObjects:fetchObjects
+	                                  fetchMetadata:fetchMetadata
+	                                     usingBlock:^(int64_t rowid, YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
+		
+		block(ck, object, metadata, stop);
+		
+		lastRowid = rowid;
+		count++;
+		
+		if (*stop) stopped = YES;
+	}];
+	
+	if (!result || (count == 0)) return nil;
+	
+	if (!stopped && (count < limit))
+	{
+		// There are no more rows
+		return nil;
+	}
+	
+	// Create the cursor for the next page.
+	// We need the column value of the last row.
+	//
+	// Note: The row can't have been modified within the enumeration block,
+	// as that would have thrown a mutation during enumeration exception.
+	
+	NSString *valueQueryString =
+	    [NSString stringWithFormat:@"SELECT \"%@\" FROM \"%@\" WHERE \"rowid\" = ?;", column, tableName];
+	
+	sqlite3_stmt *statement = [self statementForQueryString:valueQueryString logErrors:YES];
+	if (statement == NULL) return nil;
+	
+	sqlite3_bind_int64(statement, 1, lastRowid);
+	
+	id lastValue = nil;
 	
 	int status = sqlite3_step(statement);
 	if (status == SQLITE_ROW)
 	{
-		if (databaseTransaction->connection->needsMarkSqlLevelSharedReadLock)
-			[databaseTransaction->connection markSqlLevelSharedReadLockAcquired];
-		
-		count = (NSUInteger)sqlite3_column_int64(statement, 0);
+		lastValue = YDBSecondaryIndexColumnValue(statement, 0);
 	}
-	else if (status == SQLITE_ERROR)
+	else if (status != SQLITE_DONE)
 	{
 		YDBLogError(@"%@ - sqlite_step error: %d %s", THIS_METHOD,
 		            status, sqlite3_errmsg(databaseTransaction->connection->db));
-		result = NO;
 	}
 	
 	sqlite3_clear_bindings(statement);
 	sqlite3_reset(statement);
 	
-	if (countPtr) *countPtr = count;
-	return result;
+	if (lastValue == nil || lastValue == [NSNull null]) return nil;
+	
+	return [[YapDatabaseSecondaryIndexCursor alloc] initWithColumn:column
+	                                                     ascending:ascending
+	                                                         value:lastValue
+	                                                         rowid:lastRowid];
+}
+
+- (YapDatabaseSecondaryIndexCursor *)enumerateKeysMatchingQuery:(YapDatabaseQuery *)query
+                                                      orderedBy:(NSString *)column
+                                                      ascending:(BOOL)ascending
+                                                          limit:(NSUInteger)limit
+                                                    afterCursor:(YapDatabaseSecondaryIndexCursor *)cursor
+                                                     usingBlock:
+                            (void (^)(NSString *collection, NSString *key, BOOL *stop))block
+{
+	if (block == nil) return nil;
+	
+	return [self _enumerateRowsMatchingQuery:query
+	                               orderedBy:column
+	                               ascending:ascending
+	                                   limit:limit
+	                             afterCursor:cursor
+	                            fetchObjects:NO
+	                           fetchMetadata:NO
+	                              usingBlock:^(YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
+		
+		block(ck.collection, ck.key, stop);
+	}];
+}
+
+- (YapDatabaseSecondaryIndexCursor *)enumerateKeysAndMetadataMatchingQuery:(YapDatabaseQuery *)query
+                                                                 orderedBy:(NSString *)column
+                                                                 ascending:(BOOL)ascending
+                                                                     limit:(NSUInteger)limit
+                                                               afterCursor:(YapDatabaseSecondaryIndexCursor *)cursor
+                                                                usingBlock:
+                            (void (^)(NSString *collection, NSString *key, id metadata, BOOL *stop))block
+{
+	if (block == nil) return nil;
+	
+	return [self _enumerateRowsMatchingQuery:query
+	                               orderedBy:column
+	                               ascending:ascending
+	                                   limit:limit
+	                             afterCursor:cursor
+	                            fetchObjects:NO
+	                           fetchMetadata:YES
+	                              usingBlock:^(YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
+		
+		block(ck.collection, ck.key, metadata, stop);
+	}];
+}
+
+- (YapDatabaseSecondaryIndexCursor *)enumerateKeysAndObjectsMatchingQuery:(YapDatabaseQuery *)query
+                                                                orderedBy:(NSString *)column
+                                                                ascending:(BOOL)ascending
+                                                                    limit:(NSUInteger)limit
+                                                              afterCursor:(YapDatabaseSecondaryIndexCursor *)cursor
+                                                               usingBlock:
+                            (void (^)(NSString *collection, NSString *key, id object, BOOL *stop))block
+{
+	if (block == nil) return nil;
+	
+	return [self _enumerateRowsMatchingQuery:query
+	                               orderedBy:column
+	                               ascending:ascending
+	                                   limit:limit
+	                             afterCursor:cursor
+	                            fetchObjects:YES
+	                           fetchMetadata:NO
+	                              usingBlock:^(YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
+		
+		block(ck.collection, ck.key, object, stop);
+	}];
+}
+
+- (YapDatabaseSecondaryIndexCursor *)enumerateRowsMatchingQuery:(YapDatabaseQuery *)query
+                                                      orderedBy:(NSString *)column
+                                                      ascending:(BOOL)ascending
+                                                          limit:(NSUInteger)limit
+                                                    afterCursor:(YapDatabaseSecondaryIndexCursor *)cursor
+                                                     usingBlock:
+                            (void (^)(NSString *collection, NSString *key, id object, id metadata, BOOL *stop))block
+{
+	if (block == nil) return nil;
+	
+	return [self _enumerateRowsMatchingQuery:query
+	                               orderedBy:column
+	                               ascending:ascending
+	                                   limit:limit
+	                             afterCursor:cursor
+	                            fetchObjects:YES
+	                           fetchMetadata:YES
+	                              usingBlock:^(YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
+		
+		block(ck.collection, ck.key, object, metadata, stop);
+	}];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Full Text Search
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Enumerates the rows matching both the given query, and the given full text search query.
+ *
+ * With an ordering, this uses a single statement (with ORDER BY & optional LIMIT).
+ * Without one, the rowids from each side are intersected in memory (see below).
+**/
+- (BOOL)_enumerateRowsMatchingQuery:(YapDatabaseQuery *)query
+                     fullTextSearch:(NSString *)ftsName
+                           matching:(NSString *)ftsQuery
+                          orderedBy:(NSString *)column
+                          ascending:(BOOL)ascending
+                              limit:(NSUInteger)limit
+                       fetchObjects:(BOOL)fetchObjects
+                      fetchMetadata:(BOOL)fetchMetadata
+                         usingBlock:(void (^)(YapCollectionKey *ck, id object, id metadata, BOOL *stop))block
+{
+	if (query == nil) return NO;
+	if (block == nil) return NO;
+	if ([ftsQuery length] == 0) return NO;
+	
+	id ftsTransaction = [databaseTransaction ext:ftsName];
+	if (![ftsTransaction isKindOfClass:[YapDatabaseFullTextSearchTransaction class]])
+	{
+		YDBLogWarn(@"%@: The specified fullTextSearch (%@) isn't a registered YapDatabaseFullTextSearch extension",
+		           THIS_METHOD, ftsName);
+		return NO;
+	}
+	
+	__unsafe_unretained YapDatabaseFullTextSearchConnection *ftsConnection =
+	  (YapDatabaseFullTextSearchConnection *)[(YapDatabaseFullTextSearchTransaction *)ftsTransaction extensionConnection];
+	
+	NSString *ftsTableName = [ftsConnection->fts tableName];
+	
+	if (column && ![[secondaryIndexConnection->secondaryIndex->setup columnNames] containsObject:column])
+	{
+		YDBLogWarn(@"%@: Invalid column (%@): not in setup", THIS_METHOD, column);
+		return NO;
+	}
+	
+	// Extract the WHERE clause from the given query (if any).
+	// The ORDER BY & LIMIT clauses are added by us.
+	
+	NSString *whereClause = [self whereClauseForQuery:query];
+	if (whereClause == nil) return NO;
+	
+	if (column == nil)
+	{
+		return [self _enumerateRowsMatchingQuery:query
+		              intersectingFullTextSearch:(YapDatabaseFullTextSearchTransaction *)ftsTransaction
+		                                matching:ftsQuery
+		                                   limit:limit
+		                            fetchObjects:fetchObjects
+		                           fetchMetadata:fetchMetadata
+		                              usingBlock:block];
+	}
+	
+	// Build the combined query:
+	//
+	// WHERE (<whereClause>) AND "index"."rowid" IN (SELECT "rowid" FROM "fts" WHERE "fts" MATCH ?)
+	// ORDER BY "index"."col" ASC, "index"."rowid" ASC LIMIT ?
+	//
+	// This leaves sqlite free to pick the best plan. If the text matches few rows, it runs the MATCH first,
+	// and looks up each matching row in the index table. Otherwise it may walk the column's index in order,
+	// checking each row against the (materialized) MATCH results, and stop as soon as the limit is reached.
+	//
+	// Note: The column names are qualified, as the query is joined with the database table.
+	
+	NSString *tableName = [self tableName];
+	NSString *qualifiedRowid = [NSString stringWithFormat:@"\"%@\".\"rowid\"", tableName];
+	
+	NSMutableString *ftsQueryString = [NSMutableString stringWithCapacity:256];
+	[ftsQueryString appendString:@"WHERE "];
+	
+	if ([whereClause length] > 0)
+		[ftsQueryString appendFormat:@"(%@) AND ", whereClause];
+	
+	[ftsQueryString appendFormat:@"%@ IN (SELECT \"rowid\" FROM \"%@\" WHERE \"%@\" MATCH ?)",
+	                              qualifiedRowid, ftsTableName, ftsTableName];
+	
+	NSMutableArray *ftsQueryParameters = [NSMutableArray arrayWithArray:query.queryParameters];
+	[ftsQueryParameters addObject:ftsQuery];
+	
+	NSString *qualifiedColumn = [NSString stringWithFormat:@"\"%@\".\"%@\"", tableName, column];
+	NSString *order = ascending ? @"ASC" : @"DESC";
+	
+	[ftsQueryString appendFormat:@" ORDER BY %@ %@, %@ %@", qualifiedColumn, order, qualifiedRowid, order];
+	
+	if (limit > 0)
+	{
+		[ftsQueryString appendString:@" LIMIT ?"];
+		[ftsQueryParameters addObject:@(limit)];
+	}
+	
+	YapDatabaseQuery *combinedQuery =
+	  [[YapDatabaseQuery alloc] initWithQueryString:ftsQueryString queryParameters:ftsQueryParameters];
+	
+	return [self _enumerateRowsMatchingQuery:combinedQuery
+	                            fetchObjects:fetchObjects
+	                           fetchMetadata:fetchMetadata
+	                              usingBlock:^(int64_t rowid, YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
+		
+		block(ck, object, metadata, stop);
+	}];
+}
+
+/**
+ * The unordered variant of the method above.
+ *
+ * Without an ordering, there's no index for sqlite to walk (and stop early on).
+ * So we gather the rowids matching each side into a YapRowidSet, and intersect the two sets.
+ * The rows are then enumerated in rowid order.
+**/
+- (BOOL)_enumerateRowsMatchingQuery:(YapDatabaseQuery *)query
+         intersectingFullTextSearch:(YapDatabaseFullTextSearchTransaction *)ftsTransaction
+                           matching:(NSString *)ftsQuery
+                              limit:(NSUInteger)limit
+                       fetchObjects:(BOOL)fetchObjects
+                      fetchMetadata:(BOOL)fetchMetadata
+                         usingBlock:(void (^)(YapCollectionKey *ck, id object, id metadata, BOOL *stop))block
+{
+	YapRowidSet *rowids = YapRowidSetCreate(0);
+	
+	BOOL result = [self _enumerateRowidsMatchingQuery:query usingBlock:^(int64_t rowid, BOOL *stop) {
+		
+		YapRowidSetAdd(rowids, rowid);
+	}];
+	
+	if (!result)
+	{
+		YapRowidSetRelease(rowids);
+		return NO;
+	}
+	
+	if (YapRowidSetCount(rowids) > 0)
+	{
+		YapRowidSet *ftsRowids = YapRowidSetCreate(0);
+		
+		[ftsTransaction enumerateRowidsMatching:ftsQuery usingBlock:^(int64_t rowid, BOOL *stop) {
+			
+			YapRowidSetAdd(ftsRowids, rowid);
+		}];
+		
+		YapRowidSetIntersect(rowids, ftsRowids);
+		YapRowidSetRelease(ftsRowids);
+	}
+	
+	__block BOOL stop = NO;
+	__block NSUInteger count = 0;
+	isMutated = NO; // mutation during enumeration protection
+	
+	YapRowidSetEnumerate(rowids, ^(int64_t rowid, BOOL *innerStop) {
+		
+		YapCollectionKey *ck = nil;
+		id object = nil;
+		id metadata = nil;
+		
+		if (fetchObjects && fetchMetadata)
+			[databaseTransaction getCollectionKey:&ck object:&object metadata:&metadata forRowid:rowid];
+		else if (fetchObjects)
+			[databaseTransaction getCollectionKey:&ck object:&object forRowid:rowid];
+		else if (fetchMetadata)
+			[databaseTransaction getCollectionKey:&ck metadata:&metadata forRowid:rowid];
+		else
+			ck = [databaseTransaction collectionKeyForRowid:rowid];
+		
+		block(ck, object, metadata, &stop);
+		
+		if (stop || isMutated || ((limit > 0) && (++count >= limit)))
+			*innerStop = YES;
+	});
+	
+	YapRowidSetRelease(rowids);
+	
+	if (isMutated && !stop)
+	{
+		@throw [self mutationDuringEnumerationException];
+	}
+	
+	return YES;
+}
+
+- (BOOL)enumerateKeysMatchingQuery:(YapDatabaseQuery *)query
+                    fullTextSearch:(NSString *)ftsName
+                          matching:(NSString *)ftsQuery
+                         orderedBy:(NSString *)column
+                         ascending:(BOOL)ascending
+                             limit:(NSUInteger)limit
+                        usingBlock:(void (^)(NSString *collection, NSString *key, BOOL *stop))block
+{
+	if (block == nil) return NO;
+	
+	return [self _enumerateRowsMatchingQuery:query
+	                          fullTextSearch:ftsName
+	                                matching:ftsQuery
+	                               orderedBy:column
+	                               ascending:ascending
+	                                   limit:limit
+	                            fetchObjects:NO
+	                           fetchMetadata:NO
+	                              usingBlock:^(YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
+		
+		block(ck.collection, ck.key, stop);
+	}];
+}
+
+- (BOOL)enumerateKeysAndMetadataMatchingQuery:(YapDatabaseQuery *)query
+                               fullTextSearch:(NSString *)ftsName
+                                     matching:(NSString *)ftsQuery
+                                    orderedBy:(NSString *)column
+                                    ascending:(BOOL)ascending
+                                        limit:(NSUInteger)limit
+                                   usingBlock:
+                            (void (^)(NSString *collection, NSString *key, id metadata, BOOL *stop))block
+{
+	if (block == nil) return NO;
+	
+	return [self _enumerateRowsMatchingQuery:query
+	                          fullTextSearch:ftsName
+	                                matching:ftsQuery
+	                               orderedBy:column
+	                               ascending:ascending
+	                                   limit:limit
+	                            fetchObjects:NO
+	                           fetchMetadata:YES
+	                              usingBlock:^(YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
+		
+		block(ck.collection, ck.key, metadata, stop);
+	}];
+}
+
+- (BOOL)enumerateKeysAndObjectsMatchingQuery:(YapDatabaseQuery *)query
+                              fullTextSearch:(NSString *)ftsName
+                                    matching:(NSString *)ftsQuery
+                                   orderedBy:(NSString *)column
+                                   ascending:(BOOL)ascending
+                                       limit:(NSUInteger)limit
+                                  usingBlock:
+                            (void (^)(NSString *collection, NSString *key, id object, BOOL *stop))block
+{
+	if (block == nil) return NO;
+	
+	return [self _enumerateRowsMatchingQuery:query
+	                          fullTextSearch:ftsName
+	                                matching:ftsQuery
+	                               orderedBy:column
+	                               ascending:ascending
+	                                   limit:limit
+	                            fetchObjects:YES
+	                           fetchMetadata:NO
+	                              usingBlock:^(YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
+		
+		block(ck.collection, ck.key, object, stop);
+	}];
+}
+
+- (BOOL)enumerateRowsMatchingQuery:(YapDatabaseQuery *)query
+                    fullTextSearch:(NSString *)ftsName
+                          matching:(NSString *)ftsQuery
+                         orderedBy:(NSString *)column
+                         ascending:(BOOL)ascending
+                             limit:(NSUInteger)limit
+                        usingBlock:
+                            (void (^)(NSString *collection, NSString *key, id object, id metadata, BOOL *stop))block
+{
+	if (block == nil) return NO;
+	
+	return [self _enumerateRowsMatchingQuery:query
+	                          fullTextSearch:ftsName
+	                                matching:ftsQuery
+	                               orderedBy:column
+	                               ascending:ascending
+	                                   limit:limit
+	                            fetchObjects:YES
+	                           fetchMetadata:YES
+	                              usingBlock:^(YapCollectionKey *ck, id object, id metadata, BOOL *stop) {
+		
+		block(ck.collection, ck.key, object, metadata, stop);
+	}];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Diagnostics
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (NSString *)queryPlanForQuery:(YapDatabaseQuery *)query
+{
+	if (query == nil) return nil;
+	
+	NSString *fullQueryString =
+	    [NSString stringWithFormat:@"EXPLAIN QUERY PLAN SELECT \"rowid\" FROM \"%@\" %@;",
+	                                                                [self tableName], query.queryString];
+	
+	// This isn't something that's executed frequently, so we don't bother caching the statement.
+	
+	sqlite3_stmt *statement = [self prepareStatementForQueryString:fullQueryString logErrors:YES];
+	if (statement == NULL) return nil;
+	
+	[self bindQuery:query toStatement:statement];
+	
+	// EXPLAIN QUERY PLAN returns a row for each step of the plan.
+	// The last column contains the human readable description of the step.
+	
+	NSMutableArray *details = [NSMutableArray array];
+	int detailColumn = sqlite3_column_count(statement) - 1;
+	
+	int status;
+	while ((status = sqlite3_step(statement)) == SQLITE_ROW)
+	{
+		const unsigned char *text = sqlite3_column_text(statement, detailColumn);
+		int textSize = sqlite3_column_bytes(statement, detailColumn);
+		
+		NSString *detail = [[NSString alloc] initWithBytes:text length:textSize encoding:NSUTF8StringEncoding];
+		if (detail)
+			[details addObject:detail];
+	}
+	
+	if (status != SQLITE_DONE)
+	{
+		YDBLogError(@"%@ - sqlite_step error: %d %s", THIS_METHOD,
+		            status, sqlite3_errmsg(databaseTransaction->connection->db));
+	}
+	
+	sqlite3_finalize(statement);
+	
+	if (status != SQLITE_DONE) return nil;
+	
+	return [details componentsJoinedByString:@"\n"];
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -365,6 +365,160 @@
 
 @end
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Index Tree
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A treap (randomized balanced binary search tree) of index values, with lazy "add to all values >= X" support.
+ * Used by processRowChanges to adjust the indexes of many row changes at once.
+ *
+ * Nodes are stored in a single array (one node per row change), and linked together via array offsets.
+ * An offset of -1 means "no node".
+**/
+typedef struct {
+	NSInteger value;
+	NSInteger lazy;     // pending amount to add to every value below this node (already added to this node)
+	uint32_t priority;
+	NSInteger left;
+	NSInteger right;
+} YDBViewIndexNode;
+
+static void YDBViewIndexTreePush(YDBViewIndexNode *nodes, NSInteger t)
+{
+	NSInteger lazy = nodes[t].lazy;
+	if (lazy != 0)
+	{
+		NSInteger left = nodes[t].left;
+		NSInteger right = nodes[t].right;
+		
+		if (left >= 0) {
+			nodes[left].value += lazy;
+			nodes[left].lazy += lazy;
+		}
+		if (right >= 0) {
+			nodes[right].value += lazy;
+			nodes[right].lazy += lazy;
+		}
+		
+		nodes[t].lazy = 0;
+	}
+}
+
+/**
+ * Splits the tree into nodes with (value < key) and nodes with (value >= key).
+**/
+static void YDBViewIndexTreeSplit(YDBViewIndexNode *nodes, NSInteger t, NSInteger key,
+                                  NSInteger *leftPtr, NSInteger *rightPtr)
+{
+	if (t < 0)
+	{
+		*leftPtr = -1;
+		*rightPtr = -1;
+		return;
+	}
+	
+	YDBViewIndexTreePush(nodes, t);
+	
+	if (nodes[t].value < key)
+	{
+		YDBViewIndexTreeSplit(nodes, nodes[t].right, key, &nodes[t].right, rightPtr);
+		*leftPtr = t;
+	}
+	else
+	{
+		YDBViewIndexTreeSplit(nodes, nodes[t].left, key, leftPtr, &nodes[t].left);
+		*rightPtr = t;
+	}
+}
+
+/**
+ * Merges two trees, where every value in the left tree is <= every value in the right tree.
+**/
+static NSInteger YDBViewIndexTreeMerge(YDBViewIndexNode *nodes, NSInteger left, NSInteger right)
+{
+	if (left < 0) return right;
+	if (right < 0) return left;
+	
+	if (nodes[left].priority > nodes[right].priority)
+	{
+		YDBViewIndexTreePush(nodes, left);
+		nodes[left].right = YDBViewIndexTreeMerge(nodes, nodes[left].right, right);
+		return left;
+	}
+	else
+	{
+		YDBViewIndexTreePush(nodes, right);
+		nodes[right].left = YDBViewIndexTreeMerge(nodes, left, nodes[right].left);
+		return right;
+	}
+}
+
+/**
+ * Adds the given amount (+1 or -1) to every value >= key.
+ * Returns the new root.
+**/
+static NSInteger YDBViewIndexTreeAdd(YDBViewIndexNode *nodes, NSInteger root, NSInteger key, NSInteger amount)
+{
+	NSInteger left, right;
+	YDBViewIndexTreeSplit(nodes, root, key, &left, &right);
+	
+	if (right >= 0)
+	{
+		nodes[right].value += amount;
+		nodes[right].lazy += amount;
+	}
+	
+	// The amount is always +1 or -1.
+	// Since every left value is <= (key - 1), the merged tree remains ordered.
+	
+	return YDBViewIndexTreeMerge(nodes, left, right);
+}
+
+/**
+ * Inserts the node (with its value already set) into the tree.
+ * Returns the new root.
+**/
+static NSInteger YDBViewIndexTreeInsert(YDBViewIndexNode *nodes, NSInteger root, NSInteger t)
+{
+	NSInteger left, right;
+	YDBViewIndexTreeSplit(nodes, root, nodes[t].value, &left, &right);
+	
+	return YDBViewIndexTreeMerge(nodes, YDBViewIndexTreeMerge(nodes, left, t), right);
+}
+
+/**
+ * Pushes all pending lazy values down the tree, so every node's value is final.
+**/
+static void YDBViewIndexTreeFlush(YDBViewIndexNode *nodes, NSInteger t)
+{
+	while (t >= 0)
+	{
+		YDBViewIndexTreePush(nodes, t);
+		YDBViewIndexTreeFlush(nodes, nodes[t].left);
+		
+		t = nodes[t].right;
+	}
+}
+
+/**
+ * Maps each group name to a small integer (used as an index into the array of tree roots).
+ * Returns -1 for a nil group.
+**/
+static NSInteger YDBViewIndexTreeGroupId(NSMutableDictionary *groupIds, NSString *group)
+{
+	if (group == nil) return -1;
+	
+	NSNumber *groupId = [groupIds objectForKey:group];
+	if (groupId == nil)
+	{
+		groupId = @([groupIds count]);
+		[groupIds setObject:groupId forKey:group];
+	}
+	
+	return [groupId integerValue];
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -627,18 +781,55 @@
 	// TestViewChangeLogic.m
 	
 	__block NSUInteger i;
-	__block NSUInteger j;
-	
-	// STEP 1
-	//
-	// First we enumerate the items BACKWARDS,
-	// and update the ORIGINAL index values.
 	
 	NSUInteger rowChangesCount = [rowChanges count];
 	
 	__unsafe_unretained id *_rowChanges = (__unsafe_unretained id *)malloc(sizeof(id) * rowChangesCount);
 	[rowChanges getObjects:_rowChanges range:NSMakeRange(0, rowChangesCount)];
 	
+	// Every insert/delete operation shifts the index of the (earlier or later) changes in the same group
+	// that sit above the operation's index.
+	// Comparing every change against every other change is O(n^2), which gets painfully slow for big commits.
+	//
+	// So instead we sweep over the changes (once backwards, once forwards),
+	// and keep the index values of the changes we've passed in a sorted tree (one tree per group).
+	// Each operation then shifts every affected index at once, in O(log n).
+	
+	NSMutableDictionary *groupIds = [[NSMutableDictionary alloc] init];
+	
+	NSInteger *originalGroupIds = (NSInteger *)malloc(sizeof(NSInteger) * rowChangesCount);
+	NSInteger *finalGroupIds    = (NSInteger *)malloc(sizeof(NSInteger) * rowChangesCount);
+	
+	YDBViewIndexNode *nodes = (YDBViewIndexNode *)malloc(sizeof(YDBViewIndexNode) * rowChangesCount);
+	uint32_t priority = 2463534242;
+	
+	for (i = 0; i < rowChangesCount; i++)
+	{
+		__unsafe_unretained YapDatabaseViewRowChange *rowChange = _rowChanges[i];
+		
+		originalGroupIds[i] = YDBViewIndexTreeGroupId(groupIds, rowChange->originalGroup);
+		finalGroupIds[i]    = YDBViewIndexTreeGroupId(groupIds, rowChange->finalGroup);
+		
+		// xorshift32
+		priority ^= priority << 13;
+		priority ^= priority >> 17;
+		priority ^= priority << 5;
+		
+		nodes[i].priority = priority;
+	}
+	
+	NSUInteger groupCount = [groupIds count];
+	
+	NSInteger *roots = (NSInteger *)malloc(sizeof(NSInteger) * (groupCount + 1));
+	for (NSUInteger g = 0; g < groupCount; g++) {
+		roots[g] = -1;
+	}
+	
+	// STEP 1
+	//
+	// First we enumerate the items BACKWARDS,
+	// and update the ORIGINAL index values.
+	
 	for (i = rowChangesCount; i > 0; i--)
 	{
 		__unsafe_unretained YapDatabaseViewRowChange *rowChange = _rowChanges[i-1];
@@ -648,40 +839,48 @@
 			// A DELETE operation may affect the ORIGINAL index value of operations that occurred AFTER it,
 			//  IF the later operation occurs at a greater or equal index value.  ( +1 )
 			
-			for (j = i; j < rowChangesCount; j++)
-			{
-				__unsafe_unretained YapDatabaseViewRowChange *laterRowChange = _rowChanges[j];
-				
-				if (laterRowChange->type == YapDatabaseViewChangeDelete ||
-					laterRowChange->type == YapDatabaseViewChangeUpdate)
-				{
-					if (laterRowChange->originalIndex >= rowChange->opOriginalIndex &&
-					   [laterRowChange->originalGroup isEqualToString:rowChange->originalGroup])
-					{
-						laterRowChange->originalIndex += 1;
-					}
-				}
-			}
+			NSInteger g = originalGroupIds[i-1];
+			roots[g] = YDBViewIndexTreeAdd(nodes, roots[g], (NSInteger)rowChange->opOriginalIndex, 1);
 		}
 		else if (rowChange->type == YapDatabaseViewChangeInsert)
 		{
 			// An INSERT operation may affect the ORIGINAL index value of operations that occurred AFTER it,
 			//   IF the later operation occurs at a greater (but not equal) index value.  ( -1 )
 			
-			for (j = i; j < rowChangesCount; j++)
-			{
-				__unsafe_unretained YapDatabaseViewRowChange *laterRowChange = _rowChanges[j];
-				
-				if (laterRowChange->type == YapDatabaseViewChangeDelete ||
-				    laterRowChange->type == YapDatabaseViewChangeUpdate)
-				{
-					if (laterRowChange->originalIndex > rowChange->opFinalIndex &&
-					   [laterRowChange->originalGroup isEqualToString:rowChange->finalGroup])
-					{
-						laterRowChange->originalIndex -= 1;
-					}
-				}
-			}
+			NSInteger g = finalGroupIds[i-1];
+			roots[g] = YDBViewIndexTreeAdd(nodes, roots[g], (NSInteger)rowChange->opFinalIndex + 1, -1);
+		}
+		
+		if (rowChange->type == YapDatabaseViewChangeDelete ||
+		    rowChange->type == YapDatabaseViewChangeUpdate)
+		{
+			// Track the original index of this change,
+			// so it gets updated by the operations that occurred BEFORE it.
+			
+			NSInteger g = originalGroupIds[i-1];
+			
+			nodes[i-1].value = (NSInteger)rowChange->originalIndex;
+			nodes[i-1].lazy = 0;
+			nodes[i-1].left = nodes[i-1].right = -1;
+			
+			roots[g] = YDBViewIndexTreeInsert(nodes, roots[g], (NSInteger)(i-1));
+		}
+	}
+	
+	for (NSUInteger g = 0; g < groupCount; g++)
+	{
+		YDBViewIndexTreeFlush(nodes, roots[g]);
+		roots[g] = -1;
+	}
+	
+	for (i = 0; i < rowChangesCount; i++)
+	{
+		__unsafe_unretained YapDatabaseViewRowChange *rowChange = _rowChanges[i];
+		
+		if (rowChange->type == YapDatabaseViewChangeDelete ||
+		    rowChange->type == YapDatabaseViewChangeUpdate)
+		{
+			rowChange->originalIndex = (NSUInteger)nodes[i].value;
 		}
 	}
 	
@@ -690,7 +889,7 @@
 	// Next we enumerate the items FORWARDS,
 	// and update the FINAL index values.
 	
-	for (i = 1; i < rowChangesCount; i++)
+	for (i = 0; i < rowChangesCount; i++)
 	{
 		__unsafe_unretained YapDatabaseViewRowChange *rowChange = _rowChanges[i];
 		
@@ -699,43 +898,55 @@
 			// A DELETE operation may affect the FINAL index value of operations that occurred BEFORE it,
 			//  IF the earlier operation occurs at a greater (but not equal) index value. ( -1 )
 			
-			for (j = i; j > 0; j--)
-			{
-				__unsafe_unretained YapDatabaseViewRowChange *earlierRowChange = _rowChanges[j-1];
-				
-				if (earlierRowChange->type == YapDatabaseViewChangeInsert ||
-				    earlierRowChange->type == YapDatabaseViewChangeUpdate  )
-				{
-					if (earlierRowChange->finalIndex > rowChange->opOriginalIndex &&
-					   [earlierRowChange->finalGroup isEqualToString:rowChange->originalGroup])
-					{
-						earlierRowChange->finalIndex -= 1;
-					}
-				}
-			}
+			NSInteger g = originalGroupIds[i];
+			roots[g] = YDBViewIndexTreeAdd(nodes, roots[g], (NSInteger)rowChange->opOriginalIndex + 1, -1);
 		}
 		else if (rowChange->type == YapDatabaseViewChangeInsert)
 		{
 			// An INSERT operation may affect the FINAL index value of operations that occurred BEFORE it,
 			//   IF the earlier operation occurs at a greater index value ( +1 )
 			
-			for (j = i; j > 0; j--)
-			{
-				__unsafe_unretained YapDatabaseViewRowChange *earlierRowChange = _rowChanges[j-1];
-				
-				if (earlierRowChange->type == YapDatabaseViewChangeInsert ||
-				    earlierRowChange->type == YapDatabaseViewChangeUpdate)
-				{
-					if (earlierRowChange->finalIndex >= rowChange->opFinalIndex &&
-					   [earlierRowChange->finalGroup isEqualToString:rowChange->finalGroup])
-					{
-						earlierRowChange->finalIndex += 1;
-					}
-				}
-			}
+			NSInteger g = finalGroupIds[i];
+			roots[g] = YDBViewIndexTreeAdd(nodes, roots[g], (NSInteger)rowChange->opFinalIndex, 1);
+		}
+		
+		if (rowChange->type == YapDatabaseViewChangeInsert ||
+		    rowChange->type == YapDatabaseViewChangeUpdate)
+		{
+			// Track the final index of this change,
+			// so it gets updated by the operations that occur AFTER it.
+			
+			NSInteger g = finalGroupIds[i];
+			
+			nodes[i].value = (NSInteger)rowChange->finalIndex;
+			nodes[i].lazy = 0;
+			nodes[i].left = nodes[i].right = -1;
+			
+			roots[g] = YDBViewIndexTreeInsert(nodes, roots[g], (NSInteger)i);
+		}
+	}
+	
+	for (NSUInteger g = 0; g < groupCount; g++)
+	{
+		YDBViewIndexTreeFlush(nodes, roots[g]);
+	}
+	
+	for (i = 0; i < rowChangesCount; i++)
+	{
+		__unsafe_unretained YapDatabaseViewRowChange *rowChange = _rowChanges[i];
+		
+		if (rowChange->type == YapDatabaseViewChangeInsert ||
+		    rowChange->type == YapDatabaseViewChangeUpdate)
+		{
+			rowChange->finalIndex = (NSUInteger)nodes[i].value;
 		}
 	}
 	
+	free(originalGroupIds);
+	free(finalGroupIds);
+	free(nodes);
+	free(roots);
+	
 	// STEP 3
 	//
 	// The user may have various range options set for each group.
@@ -1019,6 +1230,46 @@
 	__unsafe_unretained id *_changes = (__unsafe_unretained id *)malloc(sizeof(id) * changesCount);
 	[changes getObjects:_changes range:NSMakeRange(0, changesCount)];
 	
+	// If every change has a key (the common case), then we can link together the changes for each key upfront.
+	// This saves us from comparing every change against every later change, which is O(n^2).
+	//
+	// Changes with a nil key (injected during pre-processing due to cell drawing dependencies)
+	// have to be matched by index & group, so in that case we fallback to scanning.
+	
+	NSUInteger *nextIndexes = NULL; // nextIndexes[i] => index of next change with same key (or NSNotFound)
+	
+	BOOL allChangesHaveKeys = YES;
+	for (i = 0; i < changesCount; i++)
+	{
+		__unsafe_unretained YapDatabaseViewRowChange *change = _changes[i];
+		if (change->collectionKey == nil)
+		{
+			allChangesHaveKeys = NO;
+			break;
+		}
+	}
+	
+	if (allChangesHaveKeys && (changesCount > 0))
+	{
+		nextIndexes = (NSUInteger *)malloc(sizeof(NSUInteger) * changesCount);
+		
+		NSMutableDictionary *lastIndexForKey = [NSMutableDictionary dictionaryWithCapacity:changesCount];
+		
+		for (i = 0; i < changesCount; i++)
+		{
+			__unsafe_unretained YapDatabaseViewRowChange *change = _changes[i];
+			
+			nextIndexes[i] = NSNotFound;
+			
+			NSNumber *lastIndex = [lastIndexForKey objectForKey:change->collectionKey];
+			if (lastIndex) {
+				nextIndexes[[lastIndex unsignedIntegerValue]] = i;
+			}
+			
+			[lastIndexForKey setObject:@(i) forKey:change->collectionKey];
+		}
+	}
+	
 	for (i = 0; i < changesCount; i++)
 	{
 		if ([indexesToRemove containsIndex:i]) continue;
@@ -1028,69 +1279,82 @@
 		
 		// Find later operations with the same key
 		
-		for (j = i+1; j < changesCount; j++)
+		if (nextIndexes)
 		{
-			if ([indexesToRemove containsIndex:j]) continue;
-			
-			__unsafe_unretained YapDatabaseViewRowChange *laterChange = _changes[j];
-			BOOL changesAreForSameKey = NO;
-			
-			if (firstChangeForKey->collectionKey && laterChange->collectionKey)
+			for (j = nextIndexes[i]; j != NSNotFound; j = nextIndexes[j])
 			{
-				// Compare keys
+				__unsafe_unretained YapDatabaseViewRowChange *laterChange = _changes[j];
 				
-				if (YapCollectionKeyEqual(laterChange->collectionKey, firstChangeForKey->collectionKey))
-					changesAreForSameKey = YES;
+				firstChangeForKey->changes |= laterChange->changes;
+				[indexesThatMatch addIndex:j];
 			}
-			else
+		}
+		else
+		{
+			for (j = i+1; j < changesCount; j++)
 			{
-				// Compare indexes & groups
-				//
-				// This technique is used if one of the keys is nil,
-				// and applies to situations where one of the changes is an Update with a nil key,
-				// which was injected during pre-processing due to cell drawing dependencies.
+				if ([indexesToRemove containsIndex:j]) continue;
+				
+				__unsafe_unretained YapDatabaseViewRowChange *laterChange = _changes[j];
+				BOOL changesAreForSameKey = NO;
 				
-				if (mostRecentChangeForKey->type == YapDatabaseViewChangeUpdate)
+				if (firstChangeForKey->collectionKey && laterChange->collectionKey)
 				{
-					if (laterChange->type == YapDatabaseViewChangeUpdate ||
-					    laterChange->type == YapDatabaseViewChangeDelete)
+					// Compare keys
+					
+					if (YapCollectionKeyEqual(laterChange->collectionKey, firstChangeForKey->collectionKey))
+						changesAreForSameKey = YES;
+				}
+				else
+				{
+					// Compare indexes & groups
+					//
+					// This technique is used if one of the keys is nil,
+					// and applies to situations where one of the changes is an Update with a nil key,
+					// which was injected during pre-processing due to cell drawing dependencies.
+					
+					if (mostRecentChangeForKey->type == YapDatabaseViewChangeUpdate)
 					{
-						if (mostRecentChangeForKey->originalIndex == laterChange->originalIndex &&
-						   [mostRecentChangeForKey->originalGroup isEqualToString:laterChange->originalGroup]) {
-							changesAreForSameKey = YES;
+						if (laterChange->type == YapDatabaseViewChangeUpdate ||
+						    laterChange->type == YapDatabaseViewChangeDelete)
+						{
+							if (mostRecentChangeForKey->originalIndex == laterChange->originalIndex &&
+							   [mostRecentChangeForKey->originalGroup isEqualToString:laterChange->originalGroup]) {
+								changesAreForSameKey = YES;
+							}
 						}
 					}
-				}
-				else if (mostRecentChangeForKey->type == YapDatabaseViewChangeInsert)
-				{
-					if (laterChange->type == YapDatabaseViewChangeUpdate)
+					else if (mostRecentChangeForKey->type == YapDatabaseViewChangeInsert)
 					{
-						if (mostRecentChangeForKey->originalIndex == laterChange->originalIndex &&
-						   [mostRecentChangeForKey->originalGroup isEqualToString:laterChange->originalGroup]) {
-							changesAreForSameKey = YES;
+						if (laterChange->type == YapDatabaseViewChangeUpdate)
+						{
+							if (mostRecentChangeForKey->originalIndex == laterChange->originalIndex &&
+							   [mostRecentChangeForKey->originalGroup isEqualToString:laterChange->originalGroup]) {
+								changesAreForSameKey = YES;
+							}
 						}
 					}
+					
+					if (changesAreForSameKey)
+					{
+						if (mostRecentChangeForKey->collectionKey == nil)
+							mostRecentChangeForKey->collectionKey = laterChange->collectionKey;
+						else
+							laterChange->collectionKey = mostRecentChangeForKey->collectionKey;
+						
+						if (firstChangeForKey->collectionKey == nil)
+							firstChangeForKey->collectionKey = mostRecentChangeForKey->collectionKey;
+					}
 				}
 				
 				if (changesAreForSameKey)
 				{
-					if (mostRecentChangeForKey->collectionKey == nil)
-						mostRecentChangeForKey->collectionKey = laterChange->collectionKey;
-					else
-						laterChange->collectionKey = mostRecentChangeForKey->collectionKey;
+					firstChangeForKey->changes |= laterChange->changes;
+					[indexesThatMatch addIndex:j];
 					
-					if (firstChangeForKey->collectionKey == nil)
-						firstChangeForKey->collectionKey = mostRecentChangeForKey->collectionKey;
+					mostRecentChangeForKey = laterChange;
 				}
 			}
-			
-			if (changesAreForSameKey)
-			{
-				firstChangeForKey->changes |= laterChange->changes;
-				[indexesThatMatch addIndex:j];
-				
-				mostRecentChangeForKey = laterChange;
-			}
 		}
 		
 		if ([indexesThatMatch count] > 0)
@@ -1270,6 +1534,9 @@
 	if (_changes) {
 		free(_changes);
 	}
+	if (nextIndexes) {
+		free(nextIndexes);
+	}
 	
 	if ([indexesToRemove count] > 0) {
 		[changes removeObjectsAtIndexes:indexesToRemove];
@@ -2671,6 +2938,142 @@
 	}
 }
 
+/**
+ * If a single transaction makes a large number of changes to a group, then it's cheaper (for the UI)
+ * to reload the section than it is to animate every single row change.
+ *
+ * This method replaces the row changes for every group that exceeds the mappings' resetGroupThreshold
+ * with a section delete + section insert.
+ * It's invoked after post-processing, so the row changes have their final sections & indexes.
+**/
++ (void)resetGroupsWithSectionChanges:(NSMutableArray *)sectionChanges
+                           rowChanges:(NSMutableArray *)rowChanges
+                 withOriginalMappings:(YapDatabaseViewMappings *)originalMappings
+                        finalMappings:(YapDatabaseViewMappings *)finalMappings
+{
+	NSUInteger threshold = [originalMappings resetGroupThreshold];
+	
+	if (threshold == 0) return;
+	if ([rowChanges count] <= threshold) return;
+	
+	if ([originalMappings isUsingConsolidatedGroup] || [finalMappings isUsingConsolidatedGroup]) return;
+	
+	// Count the number of row changes per group.
+	// A move between groups counts towards both groups.
+	
+	NSCountedSet *changeCounts = [[NSCountedSet alloc] init];
+	
+	for (YapDatabaseViewRowChange *rowChange in rowChanges)
+	{
+		if (rowChange->type == YapDatabaseViewChangeInsert)
+		{
+			[changeCounts addObject:rowChange->finalGroup];
+		}
+		else
+		{
+			[changeCounts addObject:rowChange->originalGroup];
+			
+			if (rowChange->type == YapDatabaseViewChangeMove &&
+			    ![rowChange->finalGroup isEqualToString:rowChange->originalGroup])
+			{
+				[changeCounts addObject:rowChange->finalGroup];
+			}
+		}
+	}
+	
+	// Figure out which groups to reset.
+	// The group must be visible before & after (without any other section changes).
+	
+	NSMutableSet *groupsWithSectionChanges = [NSMutableSet setWithCapacity:[sectionChanges count]];
+	for (YapDatabaseViewSectionChange *sectionChange in sectionChanges)
+	{
+		[groupsWithSectionChanges addObject:sectionChange->group];
+	}
+	
+	NSMutableSet *resetGroups = [NSMutableSet set];
+	
+	for (NSString *group in [originalMappings visibleGroups])
+	{
+		if ([changeCounts countForObject:group] <= threshold) continue;
+		if ([groupsWithSectionChanges containsObject:group]) continue;
+		if ([finalMappings sectionForGroup:group] == NSNotFound) continue;
+		
+		[resetGroups addObject:group];
+	}
+	
+	if ([resetGroups count] == 0) return;
+	
+	// Remove the row changes within the reset groups.
+	//
+	// A move from a reset group into another group becomes an insert (in the other group).
+	// A move from another group into a reset group becomes a delete (in the other group).
+	
+	NSMutableIndexSet *indexesToRemove = [NSMutableIndexSet indexSet];
+	
+	NSUInteger rowChangeIndex = 0;
+	for (YapDatabaseViewRowChange *rowChange in rowChanges)
+	{
+		if (rowChange->type == YapDatabaseViewChangeInsert)
+		{
+			if ([resetGroups containsObject:rowChange->finalGroup])
+				[indexesToRemove addIndex:rowChangeIndex];
+		}
+		else if (rowChange->type == YapDatabaseViewChangeMove)
+		{
+			BOOL originalGroupIsReset = [resetGroups containsObject:rowChange->originalGroup];
+			BOOL finalGroupIsReset = [resetGroups containsObject:rowChange->finalGroup];
+			
+			if (originalGroupIsReset && finalGroupIsReset)
+			{
+				[indexesToRemove addIndex:rowChangeIndex];
+			}
+			else if (originalGroupIsReset)
+			{
+				rowChange->type = YapDatabaseViewChangeInsert;
+				rowChange->originalGroup = nil;
+				rowChange->originalSection = rowChange->originalIndex = NSNotFound;
+			}
+			else if (finalGroupIsReset)
+			{
+				rowChange->type = YapDatabaseViewChangeDelete;
+				rowChange->finalGroup = nil;
+				rowChange->finalSection = rowChange->finalIndex = NSNotFound;
+			}
+		}
+		else // if (rowChange->type == YapDatabaseViewChangeDelete || rowChange->type == YapDatabaseViewChangeUpdate)
+		{
+			if ([resetGroups containsObject:rowChange->originalGroup])
+				[indexesToRemove addIndex:rowChangeIndex];
+		}
+		
+		rowChangeIndex++;
+	}
+	
+	[rowChanges removeObjectsAtIndexes:indexesToRemove];
+	
+	// Reload the sections (in order)
+	
+	for (NSString *group in [originalMappings visibleGroups])
+	{
+		if (![resetGroups containsObject:group]) continue;
+		
+		YapDatabaseViewSectionChange *deleteOp = [YapDatabaseViewSectionChange deleteGroup:group];
+		deleteOp->originalSection = [originalMappings sectionForGroup:group];
+		
+		[sectionChanges addObject:deleteOp];
+	}
+	
+	for (NSString *group in [finalMappings visibleGroups])
+	{
+		if (![resetGroups containsObject:group]) continue;
+		
+		YapDatabaseViewSectionChange *insertOp = [YapDatabaseViewSectionChange insertGroup:group];
+		insertOp->finalSection = [finalMappings sectionForGroup:group];
+		
+		[sectionChanges addObject:insertOp];
+	}
+}
+
 + (void)getSectionChanges:(NSArray **)sectionChangesPtr
                rowChanges:(NSArray **)rowChangesPtr
 	 withOriginalMappings:(YapDatabaseViewMappings *)originalMappings
@@ -2724,6 +3127,15 @@
 	                    withOriginalMappings:originalMappings
 	                           finalMappings:finalMappings];
 	
+	// RESET
+	//
+	// Replace large numbers of row changes within a group with a section reload (if configured).
+	
+	[self resetGroupsWithSectionChanges:sectionChanges
+	                         rowChanges:rowChanges
+	               withOriginalMappings:originalMappings
+	                      finalMappings:finalMappings];
+	
 	//
 	// DONE
 	//
@@ -494,6 +494,25 @@ typedef NSComparisonResult (^YapDatabaseViewMappingGroupSort)(NSString *group1,
 - (NSUInteger)autoConsolidateGroupsThreshold;
 - (NSString *)consolidatedGroupName;
 
+/**
+ * When a single transaction makes a large number of changes to a group (e.g. a big import or a re-sort),
+ * animating every single row change can be slower than simply reloading the section.
+ * And the tableView / collectionView animation for thousands of row changes isn't all that meaningful anyway.
+ *
+ * This configuration allows you to set a threshold for this situation.
+ * If the number of row changes within a group exceeds the threshold,
+ * then the row changes for that group are replaced with a section delete + section insert (i.e. a section reload).
+ *
+ * This only applies to groups that are visible in both the original & final mappings,
+ * and is skipped if either mappings is using a consolidated group.
+ * Row moves between a reset group and another group become a plain insert or delete in the other group.
+ *
+ * The default threshold value is 0 (disabled).
+**/
+
+- (void)setResetGroupThreshold:(NSUInteger)threshold;
+- (NSUInteger)resetGroupThreshold;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Initialization & Updates
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
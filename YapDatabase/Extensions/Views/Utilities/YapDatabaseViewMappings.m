@@ -47,6 +47,7 @@
 	NSMutableDictionary *dependencies;
 	NSUInteger autoConsolidateGroupsThreshold;
 	NSString *consolidatedGroupName;
+	NSUInteger resetGroupThreshold;
 	
 	// Snapshot (used for error detection)
 	uint64_t snapshotOfLastUpdate;
@@ -134,6 +135,7 @@
 	copy->dependencies = [dependencies mutableCopy];
 	copy->autoConsolidateGroupsThreshold = autoConsolidateGroupsThreshold;
 	copy->consolidatedGroupName = consolidatedGroupName;
+	copy->resetGroupThreshold = resetGroupThreshold;
 	
 	copy->snapshotOfLastUpdate = snapshotOfLastUpdate;
 	
@@ -330,6 +332,16 @@
 	return consolidatedGroupName;
 }
 
+- (void)setResetGroupThreshold:(NSUInteger)threshold
+{
+	resetGroupThreshold = threshold;
+}
+
+- (NSUInteger)resetGroupThreshold
+{
+	return resetGroupThreshold;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Initialization & Updates
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -61,4 +61,21 @@
 **/
 @property (nonatomic, strong, readwrite) YapWhitelistBlacklist *allowedCollections;
 
+/**
+ * When a YapDatabaseFilteredView (re)populates itself, such as after its filtering has been changed,
+ * it must invoke the filteringBlock for every row in the parentView.
+ *
+ * The rows are fetched from the parentView in chunks, using a single query per chunk.
+ * If your filteringBlock is thread-safe (that is, it only inspects the parameters it's handed),
+ * then you can set this option to YES, and the filteredView will deserialize & filter each chunk
+ * on a concurrent queue. The results are still applied to the view serially, and in order,
+ * so the end result is exactly the same as a serial population.
+ *
+ * This option only applies to YapDatabaseFilteredView, and only to (re)population.
+ * The filteringBlock is always invoked serially for inserted / updated rows.
+ *
+ * The default value is NO.
+**/
+@property (nonatomic, assign, readwrite) BOOL allowsConcurrentFiltering;
+
 @end
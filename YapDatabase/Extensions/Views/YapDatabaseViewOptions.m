@@ -5,6 +5,7 @@
 
 @synthesize isPersistent = isPersistent;
 @synthesize allowedCollections = allowedCollections;
+@synthesize allowsConcurrentFiltering = allowsConcurrentFiltering;
 
 - (id)init
 {
@@ -20,6 +21,7 @@
 	YapDatabaseViewOptions *copy = [[[self class] alloc] init]; // [self class] required to support subclassing
 	copy->isPersistent = isPersistent;
 	copy->allowedCollections = allowedCollections;
+	copy->allowsConcurrentFiltering = allowsConcurrentFiltering;
 	
 	return copy;
 }
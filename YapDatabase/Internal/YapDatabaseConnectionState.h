@@ -12,6 +12,7 @@
 	BOOL yapLevelSharedReadLock;
 	BOOL sqlLevelSharedReadLock;
 	BOOL longLivedReadTransaction;
+	BOOL lazyChangesetProcessing;
 	
 	BOOL yapLevelExclusiveWriteLock;
 	BOOL waitingForWriteLock;
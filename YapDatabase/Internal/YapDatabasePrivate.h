@@ -36,6 +36,7 @@ extern NSString *const YapDatabaseNotificationKey;
 	YapDatabaseOptions *options;
 	
 	NSMutableArray *changesets;
+	NSUInteger completedChangesetsCount;
 	uint64_t snapshot;
 	
 	dispatch_queue_t internalQueue;
@@ -67,6 +68,8 @@ extern NSString *const YapDatabaseNotificationKey;
 	dispatch_queue_t snapshotQueue;   // Only to be used by YapDatabaseConnection
 	dispatch_queue_t writeQueue;      // Only to be used by YapDatabaseConnection
 	
+	volatile int64_t atomicSnapshot;  // Only to be used by YapDatabaseConnection (via OSAtomic)
+	
 	NSMutableArray *connectionStates; // Only to be used by YapDatabaseConnection
 	
 	NSArray *previouslyRegisteredExtensionNames; // Only to be used by YapDatabaseConnection
@@ -183,6 +186,10 @@ extern NSString *const YapDatabaseNotificationKey;
 	BOOL throwExceptionsForImplicitlyEndingLongLivedReadTransaction;
 	NSMutableArray *pendingChangesets;
 	NSMutableArray *processedChangesets;
+	BOOL lazyChangesetProcessing;
+	
+	YapDatabaseReadTransaction *reusableReadTransaction;
+	BOOL readTransactionReuseEnabled;
 	
 	NSDictionary *registeredExtensions;
 	BOOL registeredExtensionsChanged;
@@ -293,6 +300,7 @@ extern NSString *const YapDatabaseNotificationKey;
 - (void)noteCommittedChanges:(NSDictionary *)changeset;
 
 - (void)maybeResetLongLivedReadTransaction;
+- (void)maybeReleaseReusableReadTransaction;
 
 @end
 
@@ -10,6 +10,14 @@
  * The memory table is accessed via a YapMemoryTableTransaction instance,
  * which is itself associated with a particular timestamp. Thus the transaction is able to properly identify
  * which version is appropriate for itself.
+ *
+ * Reads never take a lock. Modifications (and pruning of old versions) are serialized on an internal queue.
+ *
+ * Note that pruning and reclamation are two separate steps.
+ * Old versions are only pruned by asyncCheckpoint, based on the minSnapshot given to it by the database.
+ * The table itself doesn't track which snapshots are still in use.
+ * Pruned versions are then retired, and their memory is reclaimed by reader epoch:
+ * once every reader that was pinned when they were retired has finished its access.
 **/
 @interface YapMemoryTable : NSObject
 
@@ -29,6 +37,9 @@
 
 /**
  * Invoked automatically by YapDatabase architecture.
+ *
+ * The minSnapshot is the oldest snapshot that may still be read from.
+ * For each key, the newest version <= minSnapshot is kept, and everything older is pruned.
 **/
 - (void)asyncCheckpoint:(int64_t)minSnapshot;
 
@@ -0,0 +1,918 @@
+#import "YapMemoryTable.h"
+
+#include <atomic>
+#include <vector>
+
+
+/**
+ * There may be multiple simulatneous database transactions, each using different atomic snapshots.
+ * In other words, the value in the database at snapshot A may be different than at snapshot B.
+ * Each value is correct, and depends entirely on the snapshot being used by the transaction.
+ *
+ * This presents a unique property of the table:
+ * - the table may store multiple values for a single key.
+ * - the stored values are associated with a snapshot
+ *
+ * This struct represents a single stored value and its associated snapshot.
+ * It is one value contained within a linked-list of possibly multiple values for the same key.
+ * The linked-list remains sorted, with the most recent value at the front of the linked-list.
+ *
+ * Readers walk these lists without taking any locks.
+ * Once a version has been committed, only its 'older' pointer is ever modified (by the writer, when pruning).
+**/
+struct YapMemoryTableVersion
+{
+	std::atomic<YapMemoryTableVersion *> older;
+	
+	uint64_t snapshot;
+	__strong id object; // nil represents a removed value
+	
+	YapMemoryTableVersion(YapMemoryTableVersion *inOlder, uint64_t inSnapshot, id inObject)
+	  : older(inOlder), snapshot(inSnapshot), object(inObject) {}
+};
+
+/**
+ * Every key in the table has a single entry, which points to the most recent version for the key.
+ * Entries that fall into the same bucket form a singly linked list.
+**/
+struct YapMemoryTableEntry
+{
+	std::atomic<YapMemoryTableEntry *> next;
+	std::atomic<YapMemoryTableVersion *> latest;
+	
+	NSUInteger hash;
+	__strong id key;
+	
+	YapMemoryTableEntry(id inKey, NSUInteger inHash, YapMemoryTableVersion *inLatest)
+	  : next(nullptr), latest(inLatest), hash(inHash), key(inKey) {}
+};
+
+struct YapMemoryTableBuckets
+{
+	NSUInteger mask; // capacity - 1 (capacity is always a power of 2)
+	std::atomic<YapMemoryTableEntry *> *heads;
+	
+	YapMemoryTableBuckets(NSUInteger capacity) : mask(capacity - 1)
+	{
+		heads = new std::atomic<YapMemoryTableEntry *>[capacity];
+		for (NSUInteger i = 0; i < capacity; i++)
+		{
+			heads[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+	
+	~YapMemoryTableBuckets()
+	{
+		delete [] heads;
+	}
+	
+	NSUInteger indexForHash(NSUInteger hash) const
+	{
+		// NSNumber & NSString hashes tend to be poorly distributed in their low bits.
+		uint64_t h = hash;
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		
+		return (NSUInteger)h & mask;
+	}
+};
+
+/**
+ * Everything unlinked by the writer during a single epoch.
+ * Readers may still be looking at these items, so they're not deleted until the epoch is quiescent.
+ *
+ * Entries in the limbo never own their versions. (Versions are always retired individually.)
+**/
+struct YapMemoryTableLimbo
+{
+	std::vector<YapMemoryTableVersion *> versions;
+	std::vector<YapMemoryTableEntry *> entries;
+	std::vector<YapMemoryTableBuckets *> buckets;
+	
+	void drain()
+	{
+		for (YapMemoryTableVersion *version : versions) delete version;
+		for (YapMemoryTableEntry *entry : entries) delete entry;
+		for (YapMemoryTableBuckets *oldBuckets : buckets) delete oldBuckets;
+		
+		versions.clear();
+		entries.clear();
+		buckets.clear();
+	}
+};
+
+struct YapMemoryTableReaderCount
+{
+	std::atomic<NSUInteger> value;
+	char padding[64 - sizeof(std::atomic<NSUInteger>)]; // each counter gets its own cache line
+};
+
+/**
+ * The storage behind a YapMemoryTable: a hash table of version chains.
+ *
+ * Readers never block.
+ * They pin the current epoch, walk the buckets & version chains, and unpin.
+ *
+ * There is only ever a single writer at a time (the YapMemoryTable serializes them on its writeQueue).
+ * Anything the writer unlinks is retired into the limbo of the current epoch,
+ * and is only deleted once every reader that pinned that epoch (or an earlier one) has unpinned.
+ *
+ * Two reader counts are enough, since a reader re-checks the epoch after incrementing its count.
+ * Thus nothing is ever deleted while a reader might still be holding a pointer to it.
+**/
+class YapMemoryTableStorage
+{
+public:
+	
+	YapMemoryTableStorage() : count(0)
+	{
+		buckets.store(new YapMemoryTableBuckets(64), std::memory_order_relaxed);
+		epoch.store(0, std::memory_order_relaxed);
+		readers[0].value.store(0, std::memory_order_relaxed);
+		readers[1].value.store(0, std::memory_order_relaxed);
+	}
+	
+	~YapMemoryTableStorage()
+	{
+		YapMemoryTableBuckets *currentBuckets = buckets.load(std::memory_order_relaxed);
+		
+		for (NSUInteger i = 0; i <= currentBuckets->mask; i++)
+		{
+			YapMemoryTableEntry *entry = currentBuckets->heads[i].load(std::memory_order_relaxed);
+			while (entry)
+			{
+				YapMemoryTableEntry *next = entry->next.load(std::memory_order_relaxed);
+				
+				retireAll(entry->latest.load(std::memory_order_relaxed));
+				delete entry;
+				
+				entry = next;
+			}
+		}
+		
+		delete currentBuckets;
+		
+		limbo[0].drain();
+		limbo[1].drain();
+	}
+	
+	//
+	// Readers
+	//
+	
+	uint64_t pin()
+	{
+		while (true)
+		{
+			uint64_t e = epoch.load();
+			readers[e & 1].value.fetch_add(1);
+			
+			if (epoch.load() == e) return e;
+			
+			// The writer advanced the epoch before it could see our count. Try again.
+			readers[e & 1].value.fetch_sub(1);
+		}
+	}
+	
+	void unpin(uint64_t e)
+	{
+		readers[e & 1].value.fetch_sub(1);
+	}
+	
+	YapMemoryTableBuckets * currentBuckets() const
+	{
+		return buckets.load(std::memory_order_acquire);
+	}
+	
+	YapMemoryTableEntry * find(id key, NSUInteger hash) const
+	{
+		YapMemoryTableBuckets *currentBuckets = buckets.load(std::memory_order_acquire);
+		
+		NSUInteger index = currentBuckets->indexForHash(hash);
+		YapMemoryTableEntry *entry = currentBuckets->heads[index].load(std::memory_order_acquire);
+		
+		while (entry)
+		{
+			if (entry->hash == hash && [entry->key isEqual:key])
+				return entry;
+			
+			entry = entry->next.load(std::memory_order_acquire);
+		}
+		
+		return nullptr;
+	}
+	
+	static YapMemoryTableVersion * visibleVersion(YapMemoryTableEntry *entry, uint64_t snapshot)
+	{
+		YapMemoryTableVersion *version = entry ? entry->latest.load(std::memory_order_acquire) : nullptr;
+		
+		while (version && version->snapshot > snapshot)
+		{
+			version = version->older.load(std::memory_order_acquire);
+		}
+		
+		return version;
+	}
+	
+	//
+	// Writer
+	//
+	
+	void insert(id key, NSUInteger hash, YapMemoryTableVersion *version)
+	{
+		YapMemoryTableBuckets *currentBuckets = buckets.load(std::memory_order_relaxed);
+		
+		if (count > currentBuckets->mask)
+			currentBuckets = grow(currentBuckets);
+		
+		YapMemoryTableEntry *entry = new YapMemoryTableEntry(key, hash, version);
+		
+		std::atomic<YapMemoryTableEntry *> &head = currentBuckets->heads[currentBuckets->indexForHash(hash)];
+		entry->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		head.store(entry, std::memory_order_release);
+		
+		count++;
+	}
+	
+	/**
+	 * Unlinks the entry, and retires it along with all of its versions.
+	**/
+	void remove(YapMemoryTableEntry *entry)
+	{
+		YapMemoryTableBuckets *currentBuckets = buckets.load(std::memory_order_relaxed);
+		
+		std::atomic<YapMemoryTableEntry *> *link = &currentBuckets->heads[currentBuckets->indexForHash(entry->hash)];
+		YapMemoryTableEntry *current;
+		
+		while ((current = link->load(std::memory_order_relaxed)) != entry)
+		{
+			if (current == nullptr) return;
+			link = &current->next;
+		}
+		
+		link->store(entry->next.load(std::memory_order_relaxed), std::memory_order_release);
+		count--;
+		
+		retireAll(entry->latest.load(std::memory_order_relaxed));
+		limbo[epoch.load(std::memory_order_relaxed) & 1].entries.push_back(entry);
+	}
+	
+	void pushVersion(YapMemoryTableEntry *entry, uint64_t snapshot, id object)
+	{
+		YapMemoryTableVersion *latest = entry->latest.load(std::memory_order_relaxed);
+		
+		entry->latest.store(new YapMemoryTableVersion(latest, snapshot, object), std::memory_order_release);
+	}
+	
+	/**
+	 * Unlinks & retires the most recent version (which must have an older version).
+	**/
+	void popVersion(YapMemoryTableEntry *entry)
+	{
+		YapMemoryTableVersion *latest = entry->latest.load(std::memory_order_relaxed);
+		
+		entry->latest.store(latest->older.load(std::memory_order_relaxed), std::memory_order_release);
+		limbo[epoch.load(std::memory_order_relaxed) & 1].versions.push_back(latest);
+	}
+	
+	/**
+	 * Unlinks & retires every version older than the given version.
+	**/
+	void truncate(YapMemoryTableVersion *version)
+	{
+		YapMemoryTableVersion *older = version->older.load(std::memory_order_relaxed);
+		if (older == nullptr) return;
+		
+		version->older.store(nullptr, std::memory_order_release);
+		retireAll(older);
+	}
+	
+	/**
+	 * Deletes whatever has been retired, provided no reader could still be looking at it.
+	 * This never blocks. If a reader is pinned, the items simply stay in limbo until the next attempt.
+	**/
+	void reclaim()
+	{
+		// Advancing the epoch twice allows everything retired up until now to be deleted.
+		
+		for (int i = 0; i < 2; i++)
+		{
+			uint64_t e = epoch.load(std::memory_order_relaxed);
+			
+			// The readers that pinned epoch (e - 1) share the counter of epoch (e + 1).
+			if (readers[(e + 1) & 1].value.load() != 0) return;
+			
+			limbo[(e + 1) & 1].drain();
+			epoch.store(e + 1);
+		}
+	}
+
+private:
+	
+	std::atomic<YapMemoryTableBuckets *> buckets;
+	NSUInteger count;
+	
+	std::atomic<uint64_t> epoch;
+	YapMemoryTableReaderCount readers[2];
+	YapMemoryTableLimbo limbo[2];
+	
+	void retireAll(YapMemoryTableVersion *version)
+	{
+		YapMemoryTableLimbo &currentLimbo = limbo[epoch.load(std::memory_order_relaxed) & 1];
+		
+		while (version)
+		{
+			currentLimbo.versions.push_back(version);
+			version = version->older.load(std::memory_order_relaxed);
+		}
+	}
+	
+	/**
+	 * Readers may be walking the old buckets, so the entries can't be relinked in place.
+	 * Instead each entry is copied into the new buckets (the copy shares the version list),
+	 * and the old buckets & entries are retired.
+	**/
+	YapMemoryTableBuckets * grow(YapMemoryTableBuckets *oldBuckets)
+	{
+		YapMemoryTableBuckets *newBuckets = new YapMemoryTableBuckets((oldBuckets->mask + 1) * 2);
+		YapMemoryTableLimbo &currentLimbo = limbo[epoch.load(std::memory_order_relaxed) & 1];
+		
+		for (NSUInteger i = 0; i <= oldBuckets->mask; i++)
+		{
+			YapMemoryTableEntry *entry = oldBuckets->heads[i].load(std::memory_order_relaxed);
+			while (entry)
+			{
+				YapMemoryTableEntry *copy =
+				  new YapMemoryTableEntry(entry->key, entry->hash, entry->latest.load(std::memory_order_relaxed));
+				
+				std::atomic<YapMemoryTableEntry *> &head = newBuckets->heads[newBuckets->indexForHash(entry->hash)];
+				copy->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				head.store(copy, std::memory_order_relaxed);
+				
+				currentLimbo.entries.push_back(entry);
+				entry = entry->next.load(std::memory_order_relaxed);
+			}
+		}
+		
+		currentLimbo.buckets.push_back(oldBuckets);
+		buckets.store(newBuckets, std::memory_order_release);
+		
+		return newBuckets;
+	}
+};
+
+/**
+ * Pins the storage for the lifetime of the guard (unless the transaction has already pinned it).
+**/
+class YapMemoryTableReadGuard
+{
+public:
+	
+	YapMemoryTableReadGuard(YapMemoryTableStorage *inStorage, BOOL *isPinnedPtr)
+	  : storage(nullptr), epoch(0), isPinned(isPinnedPtr)
+	{
+		if (*isPinned == NO)
+		{
+			storage = inStorage;
+			epoch = inStorage->pin();
+			*isPinned = YES;
+		}
+	}
+	
+	~YapMemoryTableReadGuard()
+	{
+		if (storage)
+		{
+			storage->unpin(epoch);
+			*isPinned = NO;
+		}
+	}
+
+private:
+	
+	YapMemoryTableStorage *storage;
+	uint64_t epoch;
+	BOOL *isPinned;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface YapMemoryTable () {
+@public
+	
+	Class keyClass;
+	
+	YapMemoryTableStorage *storage;
+	
+	dispatch_queue_t writeQueue;
+	void *IsOnWriteQueueKey;
+	
+	NSMutableArray *snapshots; // only accessed from within writeQueue
+	NSMutableArray *changes;   // only accessed from within writeQueue
+	
+	std::atomic<int64_t> checkpointSnapshot;
+	std::atomic<bool> checkpointScheduled;
+}
+
+- (void)didCommit:(uint64_t)snapshot withChanges:(NSSet *)changedKeys;
+- (void)rollback:(uint64_t)snapshot withChanges:(NSSet *)changedKeys;
+
+@end
+
+@interface YapMemoryTableTransaction () {
+@public
+	
+	__unsafe_unretained YapMemoryTable *table;
+	
+	uint64_t snapshot;
+	BOOL isReadWriteTransaction;
+	BOOL isPinned;
+	
+	NSMutableSet *changedKeys;
+}
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@implementation YapMemoryTable
+
+- (id)initWithKeyClass:(Class)inKeyClass
+{
+	if ((self = [super init]))
+	{
+		keyClass = inKeyClass;
+		
+		storage = new YapMemoryTableStorage();
+		
+		writeQueue = dispatch_queue_create("YapMemoryTable", DISPATCH_QUEUE_SERIAL);
+		
+		IsOnWriteQueueKey = &IsOnWriteQueueKey;
+		dispatch_queue_set_specific(writeQueue, IsOnWriteQueueKey, IsOnWriteQueueKey, NULL);
+		
+		snapshots = [[NSMutableArray alloc] init];
+		changes   = [[NSMutableArray alloc] init];
+		
+		checkpointSnapshot.store(0);
+		checkpointScheduled.store(false);
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	delete storage;
+}
+
+- (YapMemoryTableTransaction *)newReadTransactionWithSnapshot:(uint64_t)snapshot
+{
+	YapMemoryTableTransaction *transaction = [[YapMemoryTableTransaction alloc] init];
+	transaction->table = self;
+	transaction->snapshot = snapshot;
+	transaction->isReadWriteTransaction = NO;
+	
+	return transaction;
+}
+
+- (YapMemoryTableTransaction *)newReadWriteTransactionWithSnapshot:(uint64_t)snapshot
+{
+	YapMemoryTableTransaction *transaction = [[YapMemoryTableTransaction alloc] init];
+	transaction->table = self;
+	transaction->snapshot = snapshot;
+	transaction->isReadWriteTransaction = YES;
+	
+	return transaction;
+}
+
+- (void)asyncCheckpoint:(int64_t)minSnapshot
+{
+	// Every connection that finishes a transaction may invoke this method.
+	// So rather than queuing a pruning pass for each invocation,
+	// we raise the target snapshot, and let a single pending pass prune everything up to it.
+	
+	int64_t target = checkpointSnapshot.load();
+	while (minSnapshot > target && !checkpointSnapshot.compare_exchange_weak(target, minSnapshot)) { }
+	
+	if (checkpointScheduled.exchange(true))
+	{
+		// A pruning pass is already pending, and will pick up the new target.
+		return;
+	}
+	
+	dispatch_async(writeQueue, ^{ @autoreleasepool {
+		
+		checkpointScheduled.store(false);
+		[self checkpoint:checkpointSnapshot.load()];
+	}});
+}
+
+/**
+ * Prunes the versions that are no longer visible to any transaction.
+ * Must be invoked from within writeQueue.
+**/
+- (void)checkpoint:(int64_t)minSnapshot
+{
+	// Gather the changes from every commit older than minSnapshot.
+	// A key that was modified in several of these commits only needs to be pruned once.
+	
+	NSUInteger checkpointCount = 0;
+	while (checkpointCount < [snapshots count])
+	{
+		if ([[snapshots objectAtIndex:checkpointCount] longLongValue] < minSnapshot)
+			checkpointCount++;
+		else
+			break;
+	}
+	
+	if (checkpointCount == 0) return;
+	
+	NSMutableSet *changedKeys = [NSMutableSet setWithSet:[changes objectAtIndex:0]];
+	for (NSUInteger i = 1; i < checkpointCount; i++)
+	{
+		[changedKeys unionSet:[changes objectAtIndex:i]];
+	}
+	
+	NSRange range = NSMakeRange(0, checkpointCount);
+	[snapshots removeObjectsInRange:range];
+	[changes removeObjectsInRange:range];
+	
+	for (id key in changedKeys)
+	{
+		YapMemoryTableEntry *entry = storage->find(key, [key hash]);
+		if (entry == nullptr) continue;
+		
+		// A transaction at minSnapshot sees the newest version <= minSnapshot.
+		// That's the oldest version anybody can still see, so everything older than it can go.
+		
+		BOOL hasObject = NO;
+		
+		YapMemoryTableVersion *prvValue = nullptr;
+		YapMemoryTableVersion *value = entry->latest.load(std::memory_order_relaxed);
+		
+		while (value && value->snapshot > (uint64_t)minSnapshot)
+		{
+			if (hasObject == NO)
+				hasObject = (value->object != nil);
+			
+			prvValue = value;
+			value = value->older.load(std::memory_order_relaxed);
+		}
+		
+		if (value)
+		{
+			if (hasObject == NO)
+				hasObject = (value->object != nil);
+			
+			if (!hasObject)
+			{
+				// Every visible version represents a deletion.
+				// So we can just dump all values.
+				
+				storage->remove(entry);
+			}
+			else if (value->object == nil)
+			{
+				// The 'value' is a deletion, and there are newer values.
+				// A missing version reads the same as a deletion, so 'value' can go too.
+				
+				storage->truncate(prvValue);
+			}
+			else
+			{
+				// The 'value' is still visible at minSnapshot.
+				// So it stays in the table.
+				// But everything older than it can go (if there is anything).
+				
+				storage->truncate(value);
+			}
+			
+		} // end: if (value)
+		
+	} // end: for (id key in changedKeys)
+	
+	storage->reclaim();
+}
+
+- (void)didCommit:(uint64_t)snapshot withChanges:(NSSet *)changedKeys
+{
+	dispatch_async(writeQueue, ^{ @autoreleasepool {
+		
+		[snapshots addObject:@(snapshot)];
+		[changes addObject:changedKeys];
+		
+		storage->reclaim();
+	}});
+}
+
+- (void)rollback:(uint64_t)snapshot withChanges:(NSSet *)changedKeys
+{
+	// This must be synchronous.
+	// Readers don't go through the writeQueue, and the next read-write transaction will reuse the same snapshot.
+	// So it must not be able to see any of these values.
+	
+	dispatch_block_t block = ^{ @autoreleasepool {
+		
+		for (id key in changedKeys)
+		{
+			YapMemoryTableEntry *entry = storage->find(key, [key hash]);
+			YapMemoryTableVersion *value = entry ? entry->latest.load(std::memory_order_relaxed) : nullptr;
+			
+			if (value && value->snapshot == snapshot)
+			{
+				if (value->older.load(std::memory_order_relaxed) == nullptr)
+					storage->remove(entry);
+				else
+					storage->popVersion(entry);
+			}
+		}
+		
+		storage->reclaim();
+	}};
+	
+	if (dispatch_get_specific(IsOnWriteQueueKey))
+		block();
+	else
+		dispatch_sync(writeQueue, block);
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@implementation YapMemoryTableTransaction
+
+@synthesize snapshot = snapshot;
+@synthesize isReadWriteTransaction = isReadWriteTransaction;
+
+- (id)objectForKey:(id)key
+{
+	NSAssert([key isKindOfClass:table->keyClass],
+	         @"Unexpected key class. Expected %@, passed %@", table->keyClass, [key class]);
+	
+	YapMemoryTableStorage *storage = table->storage;
+	id result = nil;
+	{
+		YapMemoryTableReadGuard guard(storage, &isPinned);
+		
+		YapMemoryTableEntry *entry = storage->find(key, [key hash]);
+		YapMemoryTableVersion *value = YapMemoryTableStorage::visibleVersion(entry, snapshot);
+		
+		if (value)
+			result = value->object;
+	}
+	
+	return result;
+}
+
+- (void)enumerateKeysWithBlock:(void (^)(id key, BOOL *stop))block
+{
+	[self enumerateKeysAndObjectsWithBlock:^(id key, id obj, BOOL *stop) {
+		
+		block(key, stop);
+	}];
+}
+
+- (void)enumerateKeysAndObjectsWithBlock:(void (^)(id key, id obj, BOOL *stop))block
+{
+	YapMemoryTableStorage *storage = table->storage;
+	YapMemoryTableReadGuard guard(storage, &isPinned);
+	
+	YapMemoryTableBuckets *buckets = storage->currentBuckets();
+	BOOL stop = NO;
+	
+	for (NSUInteger i = 0; i <= buckets->mask; i++)
+	{
+		YapMemoryTableEntry *entry = buckets->heads[i].load(std::memory_order_acquire);
+		while (entry)
+		{
+			YapMemoryTableVersion *value = YapMemoryTableStorage::visibleVersion(entry, snapshot);
+			if (value && value->object)
+			{
+				block(entry->key, value->object, &stop);
+				if (stop) return;
+			}
+			
+			entry = entry->next.load(std::memory_order_acquire);
+		}
+	}
+}
+
+/**
+ * Executes the block within the writeQueue (unless we're already there).
+**/
+- (void)performWrite:(dispatch_block_t)block
+{
+	if (dispatch_get_specific(table->IsOnWriteQueueKey))
+		block();
+	else
+		dispatch_sync(table->writeQueue, block);
+}
+
+- (void)setObject:(id)object forKey:(id)key
+{
+	NSAssert([key isKindOfClass:table->keyClass],
+	         @"Unexpected key class. Expected %@, passed %@", table->keyClass, [key class]);
+	
+	if (!isReadWriteTransaction) {
+		NSAssert(NO, @"Cannot modify table in read-only transaction.");
+		return;
+	}
+	
+	if (changedKeys == nil)
+		changedKeys = [[NSMutableSet alloc] init];
+	
+	YapMemoryTableStorage *storage = table->storage;
+	
+	[self performWrite:^{ @autoreleasepool {
+		
+		NSUInteger hash = [key hash];
+		
+		YapMemoryTableEntry *entry = storage->find(key, hash);
+		YapMemoryTableVersion *value = entry ? entry->latest.load(std::memory_order_relaxed) : nullptr;
+		
+		if (value && value->snapshot == snapshot)
+		{
+			// We've already updated this key during this transaction.
+			// No other transaction can see values for our snapshot, so it's safe to modify in place.
+			
+			value->object = object;
+		}
+		else
+		{
+			// First update for this key during this transaction.
+			
+			if (entry)
+				storage->pushVersion(entry, snapshot, object);
+			else
+				storage->insert(key, hash, new YapMemoryTableVersion(nullptr, snapshot, object));
+			
+			[changedKeys addObject:key];
+		}
+	}}];
+}
+
+/**
+ * Must be invoked from within the writeQueue.
+**/
+- (void)removeObjectForEntry:(YapMemoryTableEntry *)entry key:(id)key
+{
+	YapMemoryTableStorage *storage = table->storage;
+	YapMemoryTableVersion *value = entry->latest.load(std::memory_order_relaxed);
+	
+	if (value->snapshot == snapshot)
+	{
+		// We've already updated this key during this transaction.
+		
+		if (value->older.load(std::memory_order_relaxed) == nullptr)
+		{
+			// Removing a previously set value within this transaction.
+			// And there are no other values outside this transaction.
+			
+			storage->remove(entry);
+			
+			[changedKeys removeObject:key];
+		}
+		else
+		{
+			// Updating a previously set value within this transaction.
+			// But there are other values for older snapshots.
+			
+			value->object = nil;
+		}
+	}
+	else
+	{
+		// First update for this key during this transaction.
+		
+		storage->pushVersion(entry, snapshot, nil);
+		
+		[changedKeys addObject:key];
+	}
+}
+
+- (void)removeObjectForKey:(id)key
+{
+	NSAssert([key isKindOfClass:table->keyClass],
+	         @"Unexpected key class. Expected %@, passed %@", table->keyClass, [key class]);
+	
+	if (!isReadWriteTransaction) {
+		NSAssert(NO, @"Cannot modify table in read-only transaction.");
+		return;
+	}
+	
+	if (changedKeys == nil)
+		changedKeys = [[NSMutableSet alloc] init];
+	
+	YapMemoryTableStorage *storage = table->storage;
+	
+	[self performWrite:^{ @autoreleasepool {
+		
+		YapMemoryTableEntry *entry = storage->find(key, [key hash]);
+		if (entry)
+		{
+			[self removeObjectForEntry:entry key:key];
+		}
+	}}];
+}
+
+- (void)removeObjectsForKeys:(NSArray *)keys
+{
+	if (!isReadWriteTransaction) {
+		NSAssert(NO, @"Cannot modify table in read-only transaction.");
+		return;
+	}
+	
+	if (changedKeys == nil)
+		changedKeys = [[NSMutableSet alloc] init];
+	
+	YapMemoryTableStorage *storage = table->storage;
+	
+	[self performWrite:^{ @autoreleasepool {
+		
+		for (id key in keys)
+		{
+			NSAssert([key isKindOfClass:table->keyClass],
+			         @"Unexpected key class. Expected %@, passed %@", table->keyClass, [key class]);
+			
+			YapMemoryTableEntry *entry = storage->find(key, [key hash]);
+			if (entry)
+			{
+				[self removeObjectForEntry:entry key:key];
+			}
+		}
+	}}];
+}
+
+- (void)removeAllObjects
+{
+	NSAssert(isReadWriteTransaction, @"Cannot modify table in read-only transaction.");
+	
+	if (changedKeys == nil)
+		changedKeys = [[NSMutableSet alloc] init];
+	
+	YapMemoryTableStorage *storage = table->storage;
+	
+	[self performWrite:^{ @autoreleasepool {
+		
+		// Grab all entries (removing an entry modifies the bucket lists)
+		
+		std::vector<YapMemoryTableEntry *> entries;
+		
+		YapMemoryTableBuckets *buckets = storage->currentBuckets();
+		for (NSUInteger i = 0; i <= buckets->mask; i++)
+		{
+			YapMemoryTableEntry *entry = buckets->heads[i].load(std::memory_order_relaxed);
+			while (entry)
+			{
+				entries.push_back(entry);
+				entry = entry->next.load(std::memory_order_relaxed);
+			}
+		}
+		
+		// Now enumerate all the keys, and update accordingly
+		
+		for (YapMemoryTableEntry *entry : entries)
+		{
+			[self removeObjectForEntry:entry key:entry->key];
+		}
+	}}];
+}
+
+- (void)accessWithBlock:(dispatch_block_t)block
+{
+	// Readers don't need a lock.
+	// But pinning the table once for the entire block is cheaper than pinning it for each access.
+	
+	YapMemoryTableReadGuard guard(table->storage, &isPinned);
+	
+	block();
+}
+
+- (void)modifyWithBlock:(dispatch_block_t)block
+{
+	[self performWrite:block];
+}
+
+- (void)commit
+{
+	if (isReadWriteTransaction && [changedKeys count] > 0)
+	{
+		[table didCommit:snapshot withChanges:changedKeys];
+	}
+}
+
+- (void)rollback
+{
+	if (isReadWriteTransaction && [changedKeys count] > 0)
+	{
+		[table rollback:snapshot withChanges:changedKeys];
+	}
+}
+
+@end
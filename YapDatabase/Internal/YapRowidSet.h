@@ -1,5 +1,24 @@
 /**
- * Wrapper for C++ code (std::unordered_set<int64_t>)
+ * Compressed set of rowids (a roaring bitmap, written in C++).
+ *
+ * Each rowid is split into a 48-bit high key and a 16-bit low value.
+ * Rowids that share the same high key are stored together in a container,
+ * which uses whichever representation is most compact for its contents:
+ *
+ * - array  : sorted list of 16-bit values (sparse containers, up to 4096 values)
+ * - bitmap : 65536 bits (dense containers)
+ * - run    : sorted list of [start, length] runs (consecutive values, see YapRowidSetOptimize)
+ *
+ * Since sqlite allocates rowids sequentially, a set of rowids generally fits in a handful of containers.
+ * This means the set uses a few bits (rather than a few dozen bytes) per rowid,
+ * and operations between sets (intersect, union, minus) are performed a container at a time.
+ *
+ * Why 48/16, rather than the 32-bit containers found in 32-bit roaring bitmaps?
+ * Rowids are 64-bit, so something has to hold the upper bits. The 16-bit low value keeps every container small:
+ * a bitmap container is 8 KB, and an array container converts to a bitmap once it would exceed that size.
+ * A 32-bit low value would instead require a second level of containers within each container
+ * (which is how 64-bit roaring implementations do it). Since rowids are sequential,
+ * even a large table only uses a few high keys, so a flat sorted list of 48-bit keys is sufficient.
 **/
 
 #import <Foundation/Foundation.h>
@@ -13,6 +32,9 @@ extern "C" {
 
 typedef struct _YapRowidSet YapRowidSet;
 
+/**
+ * The capacity parameter is a hint, and may be ignored.
+**/
 YapRowidSet* YapRowidSetCreate(NSUInteger capacity);
 
 YapRowidSet* YapRowidSetCopy(YapRowidSet *set);
@@ -27,6 +49,30 @@ NSUInteger YapRowidSetCount(YapRowidSet *set);
 
 BOOL YapRowidSetContains(YapRowidSet *set, int64_t rowid);
 
+/**
+ * Set algebra.
+ * The first set is modified in-place (just like NSMutableSet's intersectSet:, unionSet: & minusSet:).
+ *
+ * This allows extensions to combine their results without going through sqlite.
+ * For example, the rowids matching a full text search can be intersected with those matching a secondary index.
+**/
+void YapRowidSetIntersect(YapRowidSet *set, YapRowidSet *otherSet);
+void YapRowidSetUnion(YapRowidSet *set, YapRowidSet *otherSet);
+void YapRowidSetMinus(YapRowidSet *set, YapRowidSet *otherSet);
+
+/**
+ * Converts each container to its most compact representation,
+ * including run-length encoding for consecutive rowids.
+ *
+ * This is best invoked after populating a set that will mostly be read from.
+ * (Modifying a run container converts it back into an array or bitmap container.)
+**/
+void YapRowidSetOptimize(YapRowidSet *set);
+
+/**
+ * Enumerates the rowids in ascending order.
+ * The set must not be modified during enumeration.
+**/
 void YapRowidSetEnumerate(YapRowidSet *set, void (^block)(int64_t rowid, BOOL *stop));
 
 #if defined(__cplusplus)
@@ -1,19 +1,532 @@
 #include "YapRowidSet.h"
-#include <unordered_set>
+#include <vector>
+#include <algorithm>
 
-struct _YapRowidSet {
-    std::unordered_set<int64_t> *rowids;
+/**
+ * A container holds all the rowids that share the same 48-bit high key.
+ * Within the container, each rowid is represented by its low 16 bits.
+ *
+ * The representation is chosen based on the contents:
+ * - array  : sorted uint16_t values (when cardinality <= 4096, which is <= 8 KB)
+ * - bitmap : 1024 uint64_t words (when cardinality > 4096, always 8 KB)
+ * - run    : sorted runs of consecutive values (only created by runOptimize)
+**/
+
+static const uint32_t YapRowidArrayMaxCardinality = 4096;
+static const uint32_t YapRowidBitmapWordCount = 1024;
+
+enum YapRowidContainerType : uint8_t {
+	YapRowidContainerTypeArray,
+	YapRowidContainerTypeBitmap,
+	YapRowidContainerTypeRun,
 };
 
-YapRowidSet* YapRowidSetCreate(NSUInteger capacity)
+struct YapRowidRun {
+	uint16_t start;
+	uint16_t length; // number of values in the run, minus one
+};
+
+class YapRowidContainer
 {
-	YapRowidSet *set = (YapRowidSet *)malloc(sizeof(YapRowidSet));
+public:
+
+	YapRowidContainerType type;
+	uint32_t cardinality;
+	
+	std::vector<uint16_t> array;
+	std::vector<uint64_t> bitmap;
+	std::vector<YapRowidRun> runs;
+	
+	YapRowidContainer() : type(YapRowidContainerTypeArray), cardinality(0) {}
+	
+	bool contains(uint16_t value) const
+	{
+		switch (type)
+		{
+			case YapRowidContainerTypeArray:
+			{
+				return std::binary_search(array.begin(), array.end(), value);
+			}
+			case YapRowidContainerTypeBitmap:
+			{
+				return ((bitmap[value >> 6] >> (value & 63)) & 1) != 0;
+			}
+			case YapRowidContainerTypeRun:
+			{
+				// Find the last run with (start <= value)
+				std::vector<YapRowidRun>::const_iterator it =
+				  std::upper_bound(runs.begin(), runs.end(), value, [](uint16_t v, const YapRowidRun &run) {
+					  return v < run.start;
+				  });
+				
+				if (it == runs.begin()) return false;
+				--it;
+				
+				return ((uint32_t)value <= ((uint32_t)it->start + it->length));
+			}
+		}
+		return false;
+	}
+	
+	/**
+	 * Returns true if the value was added (i.e. it wasn't already in the container).
+	**/
+	bool add(uint16_t value)
+	{
+		if (type == YapRowidContainerTypeRun)
+		{
+			if (contains(value)) return false;
+			expandRuns();
+		}
+		
+		if (type == YapRowidContainerTypeArray)
+		{
+			std::vector<uint16_t>::iterator it = std::lower_bound(array.begin(), array.end(), value);
+			if (it != array.end() && *it == value) return false;
+			
+			if (cardinality < YapRowidArrayMaxCardinality)
+			{
+				array.insert(it, value);
+				cardinality++;
+				return true;
+			}
+			
+			convertArrayToBitmap();
+		}
+		
+		uint64_t mask = (uint64_t)1 << (value & 63);
+		uint64_t &word = bitmap[value >> 6];
+		
+		if (word & mask) return false;
+		
+		word |= mask;
+		cardinality++;
+		return true;
+	}
+	
+	/**
+	 * Returns true if the value was removed (i.e. it was in the container).
+	**/
+	bool remove(uint16_t value)
+	{
+		if (type == YapRowidContainerTypeRun)
+		{
+			if (!contains(value)) return false;
+			expandRuns();
+		}
+		
+		if (type == YapRowidContainerTypeArray)
+		{
+			std::vector<uint16_t>::iterator it = std::lower_bound(array.begin(), array.end(), value);
+			if (it == array.end() || *it != value) return false;
+			
+			array.erase(it);
+			cardinality--;
+			return true;
+		}
+		
+		uint64_t mask = (uint64_t)1 << (value & 63);
+		uint64_t &word = bitmap[value >> 6];
+		
+		if ((word & mask) == 0) return false;
+		
+		word &= ~mask;
+		cardinality--;
+		
+		if (cardinality <= YapRowidArrayMaxCardinality) {
+			convertBitmapToArray();
+		}
+		return true;
+	}
+	
+	/**
+	 * Invokes the block for each value (in ascending order).
+	 * Returns false if the enumeration was stopped.
+	**/
+	template <typename Block>
+	bool enumerate(Block block) const
+	{
+		switch (type)
+		{
+			case YapRowidContainerTypeArray:
+			{
+				for (std::vector<uint16_t>::const_iterator it = array.begin(); it != array.end(); ++it)
+				{
+					if (!block(*it)) return false;
+				}
+				break;
+			}
+			case YapRowidContainerTypeBitmap:
+			{
+				for (uint32_t i = 0; i < YapRowidBitmapWordCount; i++)
+				{
+					uint64_t word = bitmap[i];
+					while (word)
+					{
+						uint32_t bit = (uint32_t)__builtin_ctzll(word);
+						if (!block((uint16_t)((i << 6) + bit))) return false;
+						
+						word &= (word - 1);
+					}
+				}
+				break;
+			}
+			case YapRowidContainerTypeRun:
+			{
+				for (std::vector<YapRowidRun>::const_iterator it = runs.begin(); it != runs.end(); ++it)
+				{
+					uint32_t end = (uint32_t)it->start + it->length;
+					for (uint32_t value = it->start; value <= end; value++)
+					{
+						if (!block((uint16_t)value)) return false;
+					}
+				}
+				break;
+			}
+		}
+		return true;
+	}
+	
+	void convertArrayToBitmap()
+	{
+		bitmap.assign(YapRowidBitmapWordCount, 0);
+		for (std::vector<uint16_t>::const_iterator it = array.begin(); it != array.end(); ++it)
+		{
+			bitmap[*it >> 6] |= (uint64_t)1 << (*it & 63);
+		}
+		
+		std::vector<uint16_t>().swap(array);
+		type = YapRowidContainerTypeBitmap;
+	}
+	
+	void convertBitmapToArray()
+	{
+		std::vector<uint16_t> values;
+		values.reserve(cardinality);
+		
+		enumerate([&values](uint16_t value) {
+			values.push_back(value);
+			return true;
+		});
+		
+		array.swap(values);
+		std::vector<uint64_t>().swap(bitmap);
+		type = YapRowidContainerTypeArray;
+	}
+	
+	/**
+	 * Converts a run container back into an array or bitmap container (so it can be modified).
+	**/
+	void expandRuns()
+	{
+		if (cardinality > YapRowidArrayMaxCardinality)
+		{
+			bitmap.assign(YapRowidBitmapWordCount, 0);
+			enumerate([this](uint16_t value) {
+				bitmap[value >> 6] |= (uint64_t)1 << (value & 63);
+				return true;
+			});
+			type = YapRowidContainerTypeBitmap;
+		}
+		else
+		{
+			array.reserve(cardinality);
+			enumerate([this](uint16_t value) {
+				array.push_back(value);
+				return true;
+			});
+			type = YapRowidContainerTypeArray;
+		}
+		
+		std::vector<YapRowidRun>().swap(runs);
+	}
+	
+	/**
+	 * Switches between array & bitmap (based on cardinality), after a bulk operation.
+	**/
+	void normalize()
+	{
+		if (type == YapRowidContainerTypeBitmap && cardinality <= YapRowidArrayMaxCardinality)
+			convertBitmapToArray();
+		else if (type == YapRowidContainerTypeArray && cardinality > YapRowidArrayMaxCardinality)
+			convertArrayToBitmap();
+	}
 	
-	set->rowids = new std::unordered_set<int64_t>();
-	if (capacity > 0) {
-		set->rowids->reserve(capacity);
+	/**
+	 * Converts to a run container if that would be the most compact representation.
+	**/
+	void runOptimize()
+	{
+		if (type == YapRowidContainerTypeRun) return;
+		
+		size_t numRuns = 0;
+		
+		if (type == YapRowidContainerTypeArray)
+		{
+			for (size_t i = 0; i < array.size(); i++)
+			{
+				if (i == 0 || array[i] != (uint16_t)(array[i-1] + 1)) numRuns++;
+			}
+		}
+		else
+		{
+			uint64_t carry = 0;
+			for (uint32_t i = 0; i < YapRowidBitmapWordCount; i++)
+			{
+				uint64_t word = bitmap[i];
+				uint64_t starts = word & ~((word << 1) | carry);
+				
+				numRuns += (size_t)__builtin_popcountll(starts);
+				carry = word >> 63;
+			}
+		}
+		
+		size_t runBytes = numRuns * sizeof(YapRowidRun);
+		size_t currentBytes = (type == YapRowidContainerTypeArray)
+		                    ? (array.size() * sizeof(uint16_t))
+		                    : (YapRowidBitmapWordCount * sizeof(uint64_t));
+		
+		if (runBytes >= currentBytes) return;
+		
+		std::vector<YapRowidRun> newRuns;
+		newRuns.reserve(numRuns);
+		
+		enumerate([&newRuns](uint16_t value) {
+		
+			if (!newRuns.empty() && ((uint32_t)newRuns.back().start + newRuns.back().length + 1) == value)
+			{
+				newRuns.back().length++;
+			}
+			else
+			{
+				YapRowidRun run = { value, 0 };
+				newRuns.push_back(run);
+			}
+			
+			return true;
+		});
+		
+		runs.swap(newRuns);
+		std::vector<uint16_t>().swap(array);
+		std::vector<uint64_t>().swap(bitmap);
+		type = YapRowidContainerTypeRun;
+	}
+	
+	static uint32_t bitmapCardinality(const std::vector<uint64_t> &words)
+	{
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < YapRowidBitmapWordCount; i++)
+		{
+			count += (uint32_t)__builtin_popcountll(words[i]);
+		}
+		return count;
+	}
+	
+	/**
+	 * Set operations don't operate on run containers directly.
+	 * Instead, a run container is first expanded into a temporary array/bitmap container.
+	**/
+	static const YapRowidContainer& expanded(const YapRowidContainer &container, YapRowidContainer &temp)
+	{
+		if (container.type != YapRowidContainerTypeRun) return container;
+		
+		temp = container;
+		temp.expandRuns();
+		return temp;
 	}
 	
+	static YapRowidContainer intersection(const YapRowidContainer &inA, const YapRowidContainer &inB)
+	{
+		YapRowidContainer tempA, tempB;
+		const YapRowidContainer &a = expanded(inA, tempA);
+		const YapRowidContainer &b = expanded(inB, tempB);
+		
+		YapRowidContainer result;
+		
+		if (a.type == YapRowidContainerTypeArray && b.type == YapRowidContainerTypeArray)
+		{
+			result.array.reserve(std::min(a.array.size(), b.array.size()));
+			std::set_intersection(a.array.begin(), a.array.end(),
+			                      b.array.begin(), b.array.end(), std::back_inserter(result.array));
+			
+			result.cardinality = (uint32_t)result.array.size();
+		}
+		else if (a.type == YapRowidContainerTypeArray || b.type == YapRowidContainerTypeArray)
+		{
+			const YapRowidContainer &arr = (a.type == YapRowidContainerTypeArray) ? a : b;
+			const YapRowidContainer &bmp = (a.type == YapRowidContainerTypeArray) ? b : a;
+			
+			result.array.reserve(arr.array.size());
+			for (std::vector<uint16_t>::const_iterator it = arr.array.begin(); it != arr.array.end(); ++it)
+			{
+				if (bmp.contains(*it)) result.array.push_back(*it);
+			}
+			
+			result.cardinality = (uint32_t)result.array.size();
+		}
+		else
+		{
+			result.type = YapRowidContainerTypeBitmap;
+			result.bitmap.resize(YapRowidBitmapWordCount);
+			
+			for (uint32_t i = 0; i < YapRowidBitmapWordCount; i++)
+			{
+				result.bitmap[i] = a.bitmap[i] & b.bitmap[i];
+			}
+			
+			result.cardinality = bitmapCardinality(result.bitmap);
+			result.normalize();
+		}
+		
+		return result;
+	}
+	
+	static YapRowidContainer combinedUnion(const YapRowidContainer &inA, const YapRowidContainer &inB)
+	{
+		YapRowidContainer tempA, tempB;
+		const YapRowidContainer &a = expanded(inA, tempA);
+		const YapRowidContainer &b = expanded(inB, tempB);
+		
+		YapRowidContainer result;
+		
+		if (a.type == YapRowidContainerTypeArray && b.type == YapRowidContainerTypeArray)
+		{
+			result.array.reserve(a.array.size() + b.array.size());
+			std::set_union(a.array.begin(), a.array.end(),
+			               b.array.begin(), b.array.end(), std::back_inserter(result.array));
+			
+			result.cardinality = (uint32_t)result.array.size();
+			result.normalize();
+		}
+		else if (a.type == YapRowidContainerTypeArray || b.type == YapRowidContainerTypeArray)
+		{
+			const YapRowidContainer &arr = (a.type == YapRowidContainerTypeArray) ? a : b;
+			const YapRowidContainer &bmp = (a.type == YapRowidContainerTypeArray) ? b : a;
+			
+			result = bmp;
+			for (std::vector<uint16_t>::const_iterator it = arr.array.begin(); it != arr.array.end(); ++it)
+			{
+				result.add(*it);
+			}
+		}
+		else
+		{
+			result.type = YapRowidContainerTypeBitmap;
+			result.bitmap.resize(YapRowidBitmapWordCount);
+			
+			for (uint32_t i = 0; i < YapRowidBitmapWordCount; i++)
+			{
+				result.bitmap[i] = a.bitmap[i] | b.bitmap[i];
+			}
+			
+			result.cardinality = bitmapCardinality(result.bitmap);
+		}
+		
+		return result;
+	}
+	
+	static YapRowidContainer difference(const YapRowidContainer &inA, const YapRowidContainer &inB)
+	{
+		YapRowidContainer tempA, tempB;
+		const YapRowidContainer &a = expanded(inA, tempA);
+		const YapRowidContainer &b = expanded(inB, tempB);
+		
+		YapRowidContainer result;
+		
+		if (a.type == YapRowidContainerTypeArray)
+		{
+			result.array.reserve(a.array.size());
+			
+			if (b.type == YapRowidContainerTypeArray)
+			{
+				std::set_difference(a.array.begin(), a.array.end(),
+				                    b.array.begin(), b.array.end(), std::back_inserter(result.array));
+			}
+			else
+			{
+				for (std::vector<uint16_t>::const_iterator it = a.array.begin(); it != a.array.end(); ++it)
+				{
+					if (!b.contains(*it)) result.array.push_back(*it);
+				}
+			}
+			
+			result.cardinality = (uint32_t)result.array.size();
+		}
+		else
+		{
+			result.type = YapRowidContainerTypeBitmap;
+			result.bitmap = a.bitmap;
+			
+			if (b.type == YapRowidContainerTypeArray)
+			{
+				for (std::vector<uint16_t>::const_iterator it = b.array.begin(); it != b.array.end(); ++it)
+				{
+					result.bitmap[*it >> 6] &= ~((uint64_t)1 << (*it & 63));
+				}
+			}
+			else
+			{
+				for (uint32_t i = 0; i < YapRowidBitmapWordCount; i++)
+				{
+					result.bitmap[i] &= ~b.bitmap[i];
+				}
+			}
+			
+			result.cardinality = bitmapCardinality(result.bitmap);
+			result.normalize();
+		}
+		
+		return result;
+	}
+};
+
+/**
+ * The keys are sorted, and keys[i] is the high key for containers[i].
+**/
+struct _YapRowidSet {
+	std::vector<uint64_t> keys;
+	std::vector<YapRowidContainer> containers;
+	NSUInteger count;
+};
+
+/**
+ * The sign bit is flipped, so that negative rowids sort before positive rowids (for ordered enumeration).
+**/
+static const uint64_t YapRowidSignBit = 0x8000000000000000ULL;
+
+static inline uint64_t YapRowidHigh(int64_t rowid)
+{
+	return (((uint64_t)rowid) ^ YapRowidSignBit) >> 16;
+}
+
+static inline uint16_t YapRowidLow(int64_t rowid)
+{
+	return (uint16_t)(((uint64_t)rowid) & 0xFFFF);
+}
+
+static inline int64_t YapRowidMake(uint64_t high, uint16_t low)
+{
+	return (int64_t)(((high << 16) | low) ^ YapRowidSignBit);
+}
+
+/**
+ * Returns the index of the container for the given high key, or NSNotFound.
+**/
+static NSUInteger YapRowidSetContainerIndex(YapRowidSet *set, uint64_t high)
+{
+	std::vector<uint64_t>::iterator it = std::lower_bound(set->keys.begin(), set->keys.end(), high);
+	
+	if (it != set->keys.end() && *it == high)
+		return (NSUInteger)(it - set->keys.begin());
+	else
+		return NSNotFound;
+}
+
+YapRowidSet* YapRowidSetCreate(NSUInteger capacity)
+{
+	YapRowidSet *set = new YapRowidSet();
+	set->count = 0;
+	
 	return set;
 }
 
@@ -21,69 +534,237 @@ YapRowidSet* YapRowidSetCopy(YapRowidSet *set)
 {
 	if (set == NULL) return NULL;
 	
-	YapRowidSet *copy = (YapRowidSet *)malloc(sizeof(YapRowidSet));
-	
-	if (set->rowids) {
-		copy->rowids = new std::unordered_set<int64_t>(*(set->rowids));
-	}
-	else {
-		copy->rowids = new std::unordered_set<int64_t>();
-	}
-	
-	return copy;
+	return new YapRowidSet(*set);
 }
 
 void YapRowidSetRelease(YapRowidSet *set)
 {
-	if (set == NULL) return;
-	
-	if (set->rowids) {
-		free(set->rowids);
-		set->rowids = NULL;
-	}
-	
-	free(set);
+	delete set;
 }
 
 void YapRowidSetAdd(YapRowidSet *set, int64_t rowid)
 {
-	set->rowids->insert(rowid);
+	uint64_t high = YapRowidHigh(rowid);
+	
+	std::vector<uint64_t>::iterator it = std::lower_bound(set->keys.begin(), set->keys.end(), high);
+	size_t index = (size_t)(it - set->keys.begin());
+	
+	if (it == set->keys.end() || *it != high)
+	{
+		set->keys.insert(it, high);
+		set->containers.insert(set->containers.begin() + index, YapRowidContainer());
+	}
+	
+	if (set->containers[index].add(YapRowidLow(rowid))) {
+		set->count++;
+	}
 }
 
 void YapRowidSetRemove(YapRowidSet *set, int64_t rowid)
 {
-	set->rowids->erase(rowid);
+	NSUInteger index = YapRowidSetContainerIndex(set, YapRowidHigh(rowid));
+	if (index == NSNotFound) return;
+	
+	YapRowidContainer &container = set->containers[index];
+	
+	if (container.remove(YapRowidLow(rowid)))
+	{
+		set->count--;
+		
+		if (container.cardinality == 0)
+		{
+			set->keys.erase(set->keys.begin() + index);
+			set->containers.erase(set->containers.begin() + index);
+		}
+	}
 }
 
 void YapRowidSetRemoveAll(YapRowidSet *set)
 {
-	set->rowids->clear();
+	set->keys.clear();
+	set->containers.clear();
+	set->count = 0;
 }
 
 NSUInteger YapRowidSetCount(YapRowidSet *set)
 {
-	return (NSUInteger)(set->rowids->size());
+	return set->count;
 }
 
 BOOL YapRowidSetContains(YapRowidSet *set, int64_t rowid)
 {
-	return (set->rowids->find(rowid) != set->rowids->end());
+	NSUInteger index = YapRowidSetContainerIndex(set, YapRowidHigh(rowid));
+	if (index == NSNotFound) return NO;
+	
+	return set->containers[index].contains(YapRowidLow(rowid)) ? YES : NO;
+}
+
+void YapRowidSetIntersect(YapRowidSet *set, YapRowidSet *otherSet)
+{
+	if (set == otherSet) return;
+	
+	std::vector<uint64_t> keys;
+	std::vector<YapRowidContainer> containers;
+	NSUInteger count = 0;
+	
+	size_t i = 0;
+	size_t j = 0;
+	
+	while (i < set->keys.size() && j < otherSet->keys.size())
+	{
+		uint64_t keyA = set->keys[i];
+		uint64_t keyB = otherSet->keys[j];
+		
+		if (keyA < keyB) {
+			i++;
+		}
+		else if (keyB < keyA) {
+			j++;
+		}
+		else
+		{
+			YapRowidContainer container =
+			  YapRowidContainer::intersection(set->containers[i], otherSet->containers[j]);
+			
+			if (container.cardinality > 0)
+			{
+				count += container.cardinality;
+				
+				keys.push_back(keyA);
+				containers.push_back(std::move(container));
+			}
+			
+			i++;
+			j++;
+		}
+	}
+	
+	set->keys.swap(keys);
+	set->containers.swap(containers);
+	set->count = count;
+}
+
+void YapRowidSetUnion(YapRowidSet *set, YapRowidSet *otherSet)
+{
+	if (set == otherSet) return;
+	
+	std::vector<uint64_t> keys;
+	std::vector<YapRowidContainer> containers;
+	NSUInteger count = 0;
+	
+	keys.reserve(set->keys.size() + otherSet->keys.size());
+	containers.reserve(set->keys.size() + otherSet->keys.size());
+	
+	size_t i = 0;
+	size_t j = 0;
+	
+	while (i < set->keys.size() || j < otherSet->keys.size())
+	{
+		if (j >= otherSet->keys.size() || (i < set->keys.size() && set->keys[i] < otherSet->keys[j]))
+		{
+			keys.push_back(set->keys[i]);
+			containers.push_back(std::move(set->containers[i]));
+			i++;
+		}
+		else if (i >= set->keys.size() || otherSet->keys[j] < set->keys[i])
+		{
+			keys.push_back(otherSet->keys[j]);
+			containers.push_back(otherSet->containers[j]);
+			j++;
+		}
+		else
+		{
+			keys.push_back(set->keys[i]);
+			containers.push_back(YapRowidContainer::combinedUnion(set->containers[i], otherSet->containers[j]));
+			i++;
+			j++;
+		}
+		
+		count += containers.back().cardinality;
+	}
+	
+	set->keys.swap(keys);
+	set->containers.swap(containers);
+	set->count = count;
+}
+
+void YapRowidSetMinus(YapRowidSet *set, YapRowidSet *otherSet)
+{
+	if (set == otherSet)
+	{
+		YapRowidSetRemoveAll(set);
+		return;
+	}
+	
+	std::vector<uint64_t> keys;
+	std::vector<YapRowidContainer> containers;
+	NSUInteger count = 0;
+	
+	keys.reserve(set->keys.size());
+	containers.reserve(set->keys.size());
+	
+	size_t j = 0;
+	
+	for (size_t i = 0; i < set->keys.size(); i++)
+	{
+		uint64_t key = set->keys[i];
+		
+		while (j < otherSet->keys.size() && otherSet->keys[j] < key) {
+			j++;
+		}
+		
+		if (j < otherSet->keys.size() && otherSet->keys[j] == key)
+		{
+			YapRowidContainer container =
+			  YapRowidContainer::difference(set->containers[i], otherSet->containers[j]);
+			
+			if (container.cardinality > 0)
+			{
+				count += container.cardinality;
+				
+				keys.push_back(key);
+				containers.push_back(std::move(container));
+			}
+		}
+		else
+		{
+			count += set->containers[i].cardinality;
+			
+			keys.push_back(key);
+			containers.push_back(std::move(set->containers[i]));
+		}
+	}
+	
+	set->keys.swap(keys);
+	set->containers.swap(containers);
+	set->count = count;
+}
+
+void YapRowidSetOptimize(YapRowidSet *set)
+{
+	for (std::vector<YapRowidContainer>::iterator it = set->containers.begin(); it != set->containers.end(); ++it)
+	{
+		it->runOptimize();
+	}
+	
+	set->keys.shrink_to_fit();
+	set->containers.shrink_to_fit();
 }
 
 void YapRowidSetEnumerate(YapRowidSet *set, void (^block)(int64_t rowid, BOOL *stop))
 {
 	__block BOOL stop = NO;
 	
-	std::unordered_set<int64_t>::iterator iterator = set->rowids->begin();
-	std::unordered_set<int64_t>::iterator end = set->rowids->end();
-	
-	while (iterator != end)
+	for (size_t i = 0; i < set->keys.size(); i++)
 	{
-		int64_t rowid = *iterator;
+		uint64_t high = set->keys[i];
+		
+		bool completed = set->containers[i].enumerate([&](uint16_t low) {
 		
-		block(rowid, &stop);
+			block(YapRowidMake(high, low), &stop);
+			return !stop;
+		});
 		
-		if (stop) break;
-		iterator++;
+		if (!completed) break;
 	}
 }
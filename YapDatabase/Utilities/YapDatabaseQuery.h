@@ -45,3 +45,79 @@
 @property (nonatomic, strong, readonly) NSArray *queryParameters;
 
 @end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A YapDatabaseCompiledQuery is a reusable query, intended for queries that are executed frequently.
+ * It can be used anywhere a YapDatabaseQuery can be used.
+ *
+ * A regular YapDatabaseQuery is a one-off: the parameters are boxed into objects,
+ * the full SQL string is rebuilt (and looked up in the statement cache) every time the query is executed,
+ * and the parameters are copied when they're bound to the sqlite statement.
+ *
+ * A compiled query is created once, and the parameters are then bound directly (by type) before each use.
+ * The extension keeps the prepared sqlite statement for the compiled query (per connection),
+ * so executing the query again (in the same or a later transaction on the same connection)
+ * skips the SQL string formatting & statement cache lookup.
+ * Text & blob parameters are bound without copying them.
+ *
+ * Example:
+ *
+ * // Create once (e.g. in an ivar)
+ * query = [YapDatabaseCompiledQuery compiledQueryWithString:@"WHERE jid = ? AND timestamp > ?"];
+ *
+ * // Then for each use
+ * [query bindText:message.jid atIndex:0];
+ * [query bindDouble:[minDate timeIntervalSinceReferenceDate] atIndex:1];
+ *
+ * [[transaction ext:@"idx"] enumerateKeysMatchingQuery:query usingBlock:^(NSString *collection, NSString *key, BOOL *stop){
+ *     ...
+ * }];
+ *
+ * A compiled query is not thread-safe.
+ * That is, you shouldn't bind parameters from one thread while executing the query on another.
+ * Similarly, you shouldn't bind parameters from within the enumeration block of the same query.
+**/
+@interface YapDatabaseCompiledQuery : YapDatabaseQuery
+
+/**
+ * The query string uses '?' for each parameter, just like queryWithFormat.
+ * (However, unlike queryWithFormat, parameters cannot be arrays.)
+ *
+ * All parameters are initially bound to null.
+**/
++ (instancetype)compiledQueryWithString:(NSString *)queryString;
+
+/**
+ * The number of parameters in the query string.
+ *
+ * This is the number of '?' parameters, not counting any within string literals, quoted identifiers or comments.
+ * If the query uses numbered parameters ("?NNN"), it's the largest parameter number (just like sqlite).
+**/
+@property (nonatomic, assign, readonly) NSUInteger parameterCount;
+
+/**
+ * Binds a value to the parameter at the given index.
+ * The index is zero-based, and corresponds to the order of the '?' parameters in the query string.
+ * (For a numbered parameter "?NNN", the index is NNN - 1.)
+ *
+ * Dates should be bound as a double using timeIntervalSinceReferenceDate
+ * (which is how they're stored in secondary index tables).
+ *
+ * Bound values remain in effect until they're replaced, or until clearBindings is called.
+**/
+- (void)bindInt64:(int64_t)value atIndex:(NSUInteger)index;
+- (void)bindDouble:(double)value atIndex:(NSUInteger)index;
+- (void)bindText:(NSString *)value atIndex:(NSUInteger)index;
+- (void)bindBlob:(NSData *)value atIndex:(NSUInteger)index;
+- (void)bindNullAtIndex:(NSUInteger)index;
+
+/**
+ * Resets all parameters to null.
+**/
+- (void)clearBindings;
+
+@end
@@ -1,6 +1,10 @@
 #import "YapDatabaseQuery.h"
 #import "YapDatabaseLogging.h"
 
+#import "sqlite3.h"
+
+#import <libkern/OSAtomic.h>
+
 #if ! __has_feature(objc_arc)
 #warning This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
 #endif
@@ -15,6 +19,12 @@
   static const int ydbLogLevel = YDB_LOG_LEVEL_WARN;
 #endif
 
+@interface YapDatabaseQuery ()
+
+- (id)initWithQueryString:(NSString *)queryString queryParameters:(NSArray *)queryParameters;
+
+@end
+
 
 @implementation YapDatabaseQuery
 {
@@ -164,3 +174,340 @@
 @synthesize queryParameters;
 
 @end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+	
+	int type; // SQLITE_NULL, SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT or SQLITE_BLOB
+	
+	union {
+		int64_t int64Value;
+		double doubleValue;
+	} value;
+	
+} YapDatabaseCompiledQueryParameter;
+
+
+@implementation YapDatabaseCompiledQuery
+{
+	NSUInteger parameterCount;
+	
+	YapDatabaseCompiledQueryParameter *parameters;
+	NSMutableArray *objectParameters; // Holds the NSString/NSData for text/blob parameters (NSNull otherwise)
+	NSMutableArray *utf8Parameters;   // Holds the UTF-8 NSData for text parameters (NSNull otherwise)
+	
+	uint64_t queryID;
+}
+
+@synthesize parameterCount = parameterCount;
+@synthesize queryID = queryID;
+
++ (instancetype)compiledQueryWithString:(NSString *)queryString
+{
+	if (queryString == nil) return nil;
+	
+	return [[YapDatabaseCompiledQuery alloc] initWithQueryString:queryString queryParameters:nil];
+}
+
+- (id)initWithQueryString:(NSString *)inQueryString queryParameters:(NSArray *)inQueryParameters
+{
+	if ((self = [super initWithQueryString:inQueryString queryParameters:nil]))
+	{
+		static volatile int64_t nextQueryID = 0;
+		queryID = (uint64_t)OSAtomicIncrement64Barrier(&nextQueryID);
+		
+		parameterCount = [[self class] parameterCountForQueryString:inQueryString];
+		
+		if (parameterCount > 0)
+			parameters = malloc(parameterCount * sizeof(YapDatabaseCompiledQueryParameter));
+		
+		objectParameters = [[NSMutableArray alloc] initWithCapacity:parameterCount];
+		utf8Parameters = [[NSMutableArray alloc] initWithCapacity:parameterCount];
+		for (NSUInteger i = 0; i < parameterCount; i++)
+		{
+			[objectParameters addObject:[NSNull null]];
+			[utf8Parameters addObject:[NSNull null]];
+		}
+		
+		[self clearBindings];
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	if (parameters)
+		free(parameters);
+}
+
+/**
+ * Returns the number of parameters sqlite will see in the given query string.
+ *
+ * A '?' within a string literal, quoted identifier or comment isn't a parameter.
+ * A numbered parameter ("?NNN") has the given (one-based) index,
+ * and a plain '?' gets the index one greater than the largest index seen so far (which is how sqlite numbers them).
+ * The count is the largest index.
+**/
++ (NSUInteger)parameterCountForQueryString:(NSString *)queryString
+{
+	NSUInteger maxIndex = 0;
+	
+	NSUInteger length = [queryString length];
+	NSUInteger i = 0;
+	
+	while (i < length)
+	{
+		unichar c = [queryString characterAtIndex:i];
+		
+		if (c == '\'' || c == '"' || c == '`' || c == '[')
+		{
+			// String literal or quoted identifier.
+			// A doubled quote character within it is an escaped quote (which we can skip like any other character).
+			
+			unichar end = (c == '[') ? ']' : c;
+			
+			for (i++; i < length; i++)
+			{
+				if ([queryString characterAtIndex:i] == end) break;
+			}
+			
+			i++;
+		}
+		else if (c == '-' && (i + 1) < length && [queryString characterAtIndex:(i + 1)] == '-')
+		{
+			// Comment until end of line
+			
+			for (i += 2; i < length; i++)
+			{
+				if ([queryString characterAtIndex:i] == '\n') break;
+			}
+		}
+		else if (c == '/' && (i + 1) < length && [queryString characterAtIndex:(i + 1)] == '*')
+		{
+			// Comment until "*/"
+			
+			for (i += 2; i < length; i++)
+			{
+				if ([queryString characterAtIndex:i] == '*' &&
+				    (i + 1) < length && [queryString characterAtIndex:(i + 1)] == '/') break;
+			}
+			
+			i += 2;
+		}
+		else if (c == '?')
+		{
+			NSUInteger number = 0;
+			BOOL numbered = NO;
+			
+			for (i++; i < length; i++)
+			{
+				unichar digit = [queryString characterAtIndex:i];
+				if (digit < '0' || digit > '9') break;
+				
+				number = (number * 10) + (digit - '0');
+				numbered = YES;
+			}
+			
+			if (numbered)
+				maxIndex = MAX(maxIndex, number);
+			else
+				maxIndex++;
+		}
+		else
+		{
+			i++;
+		}
+	}
+	
+	return maxIndex;
+}
+
+/**
+ * Returns the currently bound values (boxed), for debugging & compatibility.
+**/
+- (NSArray *)queryParameters
+{
+	NSMutableArray *queryParameters = [NSMutableArray arrayWithCapacity:parameterCount];
+	
+	for (NSUInteger i = 0; i < parameterCount; i++)
+	{
+		switch (parameters[i].type)
+		{
+			case SQLITE_INTEGER : [queryParameters addObject:@(parameters[i].value.int64Value)];  break;
+			case SQLITE_FLOAT   : [queryParameters addObject:@(parameters[i].value.doubleValue)]; break;
+			default             : [queryParameters addObject:[objectParameters objectAtIndex:i]]; break;
+		}
+	}
+	
+	return queryParameters;
+}
+
+- (BOOL)isValidParameterIndex:(NSUInteger)index
+{
+	if (index < parameterCount) return YES;
+	
+	NSAssert(NO, @"Parameter index (%lu) out of bounds (parameterCount = %lu)",
+	         (unsigned long)index, (unsigned long)parameterCount);
+	
+	YDBLogWarn(@"Unable to bind parameter: index (%lu) out of bounds (parameterCount = %lu) for query: %@",
+	           (unsigned long)index, (unsigned long)parameterCount, self.queryString);
+	return NO;
+}
+
+- (void)bindInt64:(int64_t)value atIndex:(NSUInteger)index
+{
+	if (![self isValidParameterIndex:index]) return;
+	
+	parameters[index].type = SQLITE_INTEGER;
+	parameters[index].value.int64Value = value;
+	
+	[objectParameters replaceObjectAtIndex:index withObject:[NSNull null]];
+	[utf8Parameters replaceObjectAtIndex:index withObject:[NSNull null]];
+}
+
+- (void)bindDouble:(double)value atIndex:(NSUInteger)index
+{
+	if (![self isValidParameterIndex:index]) return;
+	
+	parameters[index].type = SQLITE_FLOAT;
+	parameters[index].value.doubleValue = value;
+	
+	[objectParameters replaceObjectAtIndex:index withObject:[NSNull null]];
+	[utf8Parameters replaceObjectAtIndex:index withObject:[NSNull null]];
+}
+
+- (void)bindText:(NSString *)value atIndex:(NSUInteger)index
+{
+	if (value == nil)
+	{
+		[self bindNullAtIndex:index];
+		return;
+	}
+	
+	if (![self isValidParameterIndex:index]) return;
+	
+	parameters[index].type = SQLITE_TEXT;
+	
+	value = [value copy];
+	[objectParameters replaceObjectAtIndex:index withObject:value];
+	
+	// If the string's internal buffer is already UTF-8, sqlite can use it directly.
+	// Otherwise we convert the string once (here), rather than every time the query is executed.
+	// Either way the bytes are retained by this object, so sqlite can use them without a copy (SQLITE_STATIC).
+	
+	if (CFStringGetCStringPtr((__bridge CFStringRef)value, kCFStringEncodingUTF8) == NULL)
+	{
+		NSData *utf8 = [value dataUsingEncoding:NSUTF8StringEncoding];
+		[utf8Parameters replaceObjectAtIndex:index withObject:(utf8 ?: [NSData data])];
+	}
+	else
+	{
+		[utf8Parameters replaceObjectAtIndex:index withObject:[NSNull null]];
+	}
+}
+
+- (void)bindBlob:(NSData *)value atIndex:(NSUInteger)index
+{
+	if (value == nil)
+	{
+		[self bindNullAtIndex:index];
+		return;
+	}
+	
+	if (![self isValidParameterIndex:index]) return;
+	
+	parameters[index].type = SQLITE_BLOB;
+	
+	[objectParameters replaceObjectAtIndex:index withObject:[value copy]];
+	[utf8Parameters replaceObjectAtIndex:index withObject:[NSNull null]];
+}
+
+- (void)bindNullAtIndex:(NSUInteger)index
+{
+	if (![self isValidParameterIndex:index]) return;
+	
+	parameters[index].type = SQLITE_NULL;
+	
+	[objectParameters replaceObjectAtIndex:index withObject:[NSNull null]];
+	[utf8Parameters replaceObjectAtIndex:index withObject:[NSNull null]];
+}
+
+- (void)clearBindings
+{
+	for (NSUInteger i = 0; i < parameterCount; i++)
+	{
+		parameters[i].type = SQLITE_NULL;
+		
+		[objectParameters replaceObjectAtIndex:i withObject:[NSNull null]];
+		[utf8Parameters replaceObjectAtIndex:i withObject:[NSNull null]];
+	}
+}
+
+/**
+ * Binds the current values to the given statement.
+ *
+ * Text & blob values are bound using SQLITE_STATIC (i.e. without sqlite making a copy).
+ * This is safe because the values are retained by this object,
+ * and the caller resets the statement (and clears the bindings) before returning from the query.
+**/
+- (void)bindToStatement:(sqlite3_stmt *)statement
+{
+	for (NSUInteger i = 0; i < parameterCount; i++)
+	{
+		int bindIndex = (int)(i + 1);
+		
+		switch (parameters[i].type)
+		{
+			case SQLITE_INTEGER :
+			{
+				sqlite3_bind_int64(statement, bindIndex, (sqlite3_int64)parameters[i].value.int64Value);
+				break;
+			}
+			case SQLITE_FLOAT :
+			{
+				sqlite3_bind_double(statement, bindIndex, parameters[i].value.doubleValue);
+				break;
+			}
+			case SQLITE_TEXT :
+			{
+				__unsafe_unretained id utf8 = [utf8Parameters objectAtIndex:i];
+				
+				if (utf8 == [NSNull null])
+				{
+					// The string's internal buffer is UTF-8 (see bindText:atIndex:)
+					
+					__unsafe_unretained NSString *string = [objectParameters objectAtIndex:i];
+					const char *text = CFStringGetCStringPtr((__bridge CFStringRef)string, kCFStringEncodingUTF8);
+					
+					sqlite3_bind_text(statement, bindIndex, text, -1, SQLITE_STATIC);
+				}
+				else
+				{
+					__unsafe_unretained NSData *data = (NSData *)utf8;
+					
+					const char *text = ([data length] > 0) ? [data bytes] : ""; // NULL would bind a null value
+					
+					sqlite3_bind_text(statement, bindIndex, text, (int)[data length], SQLITE_STATIC);
+				}
+				break;
+			}
+			case SQLITE_BLOB :
+			{
+				__unsafe_unretained NSData *data = [objectParameters objectAtIndex:i];
+				
+				sqlite3_bind_blob(statement, bindIndex, [data bytes], (int)[data length], SQLITE_STATIC);
+				break;
+			}
+			default :
+			{
+				sqlite3_bind_null(statement, bindIndex);
+				break;
+			}
+		}
+	}
+}
+
+@end
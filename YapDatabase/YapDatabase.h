@@ -2,6 +2,7 @@
 
 #import "YapDatabaseOptions.h"
 #import "YapDatabaseConnection.h"
+#import "YapDatabaseConnectionPool.h"
 #import "YapDatabaseTransaction.h"
 #import "YapDatabaseExtension.h"
 
@@ -2207,7 +2207,8 @@ NSString *const YapDatabaseNotificationKey           = @"notification";
 /**
  * This method is only accessible from within the snapshotQueue.
  *
- * This method is used if a transaction finds itself in a race condition.
+ * This method is used if a transaction finds itself in a race condition,
+ * or by a connection using lazyChangesetProcessing that needs to catch up.
  * It should retrieve the database's pending and/or committed changes,
  * and then process them via [connection noteCommittedChanges:].
 **/
@@ -2252,6 +2253,11 @@ NSString *const YapDatabaseNotificationKey           = @"notification";
 	
 	snapshot = [[changeset objectForKey:YapDatabaseSnapshotKey] unsignedLongLongValue];
 	
+	// Publish it for connections checking whether they can reuse their read transaction (without the snapshotQueue).
+	// We're the only writer, so the compare-and-swap always succeeds; it's used for the barrier.
+	
+	OSAtomicCompareAndSwap64Barrier(atomicSnapshot, (int64_t)snapshot, &atomicSnapshot);
+	
 	// Update registeredExtensions, if changed.
 	
 	NSDictionary *newRegisteredExtensions = [changeset objectForKey:YapDatabaseRegisteredExtensionsKey];
@@ -2289,11 +2295,21 @@ NSString *const YapDatabaseNotificationKey           = @"notification";
 	
 	// Forward the changeset to all other connections so they can perform any needed updates.
 	// Generally this means updating the in-memory components such as the cache.
+	//
+	// Connections using lazyChangesetProcessing are skipped, unless they're holding a read transaction open
+	// (a longLivedReadTransaction, or a reusable read transaction that this changeset needs to end).
+	// They'll catch up on their own at the start of their next transaction,
+	// via the changesets we retain below.
 	
 	dispatch_group_t group = NULL;
 	
 	for (YapDatabaseConnectionState *state in connectionStates)
 	{
+		if (state->lazyChangesetProcessing && !state->yapLevelSharedReadLock)
+		{
+			continue;
+		}
+		
 		if (state->connection != sender)
 		{
 			// Create strong reference (state->connection is weak)
@@ -2328,10 +2344,29 @@ NSString *const YapDatabaseNotificationKey           = @"notification";
 		}
 		else
 		{
-			YDBLogVerbose(@"Dropping processed changeset %@ for database: %@",
-			              [changeset objectForKey:YapDatabaseSnapshotKey], self);
+			completedChangesetsCount++;
+			
+			// Lazy connections catch up from the retained changesets,
+			// so we hold onto a bounded number of them while any such connection exists.
 			
-			[changesets removeObjectAtIndex:0];
+			NSUInteger maxRetainedCount = 0;
+			for (YapDatabaseConnectionState *state in connectionStates)
+			{
+				if (state->lazyChangesetProcessing)
+				{
+					maxRetainedCount = options.maxRetainedChangesets;
+					break;
+				}
+			}
+			
+			while (completedChangesetsCount > maxRetainedCount)
+			{
+				YDBLogVerbose(@"Dropping processed changeset %@ for database: %@",
+				              [[changesets objectAtIndex:0] objectForKey:YapDatabaseSnapshotKey], self);
+				
+				[changesets removeObjectAtIndex:0];
+				completedChangesetsCount--;
+			}
 		}
 		
 		#if !OS_OBJECT_USE_OBJC
@@ -2440,10 +2475,12 @@ NSString *const YapDatabaseNotificationKey           = @"notification";
 				for (YapDatabaseConnectionState *state in strongSelf->connectionStates)
 				{
 					if (state->yapLevelSharedReadLock &&
-					    state->longLivedReadTransaction &&
 					    state->lastKnownSnapshot == strongSelf->snapshot)
 					{
-						[state->connection maybeResetLongLivedReadTransaction];
+						if (state->longLivedReadTransaction)
+							[state->connection maybeResetLongLivedReadTransaction];
+						else
+							[state->connection maybeReleaseReusableReadTransaction];
 					}
 				}
 			});
@@ -277,6 +277,47 @@ typedef NS_OPTIONS(NSUInteger, YapDatabaseConnectionFlushMemoryFlags) {
 **/
 @property (atomic, assign, readonly) uint64_t snapshot;
 
+/**
+ * Normally, every commit is immediately forwarded to every other connection,
+ * which then updates its in-memory components (caches, extensions, etc) to match.
+ * For an app with many connections, most of which are idle at any given moment, this is wasted work.
+ * 
+ * When lazyChangesetProcessing is enabled, the connection isn't sent changesets while idle.
+ * Instead it catches up at the start of its next transaction, by processing the changesets it missed.
+ * If it has fallen too far behind (see YapDatabaseOptions.maxRetainedChangesets),
+ * it simply drops its caches and jumps directly to the most recent snapshot.
+ * 
+ * Because of this, the snapshot property of an idle lazy connection may lag behind the database.
+ * 
+ * While in a longLivedReadTransaction the connection receives changesets as usual,
+ * as they're needed to produce the notifications returned from endLongLivedReadTransaction.
+ * However, a connection that falls too far behind between long-lived transactions can't report the notifications
+ * it missed. So connections that drive your UI via longLivedReadTransactions should generally keep the default.
+ * 
+ * The default value is NO.
+**/
+@property (atomic, assign, readwrite) BOOL lazyChangesetProcessing;
+
+/**
+ * Every read transaction has a fixed cost: sqlite BEGIN & COMMIT statements,
+ * plus a pair of trips through the database's internal synchronization queue.
+ * For tiny reads that are served from the cache, this overhead dominates.
+ * 
+ * When readTransactionReuseEnabled is set, the connection keeps its sqlite read transaction open
+ * after a read block completes. If nothing has been committed by the time the next read block starts,
+ * the block is simply run within that same transaction, skipping all of the fixed costs.
+ * In other words, it's an automatically managed longLivedReadTransaction that ends as soon as
+ * any other connection commits.
+ * 
+ * The open transaction is ended automatically when:
+ * - any connection commits a readWrite transaction
+ * - this connection starts a readWrite transaction, vacuum, or longLivedReadTransaction
+ * - this property is set back to NO
+ * 
+ * The default value is NO.
+**/
+@property (atomic, assign, readwrite) BOOL readTransactionReuseEnabled;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Transactions
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
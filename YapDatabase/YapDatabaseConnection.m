@@ -309,6 +309,8 @@ NS_INLINE BOOL YDBIsMainThread()
 			[self postReadTransaction:longLivedReadTransaction];
 			longLivedReadTransaction = nil;
 		}
+		
+		[self releaseReusableReadTransaction];
 	}};
 	
 	if (dispatch_get_specific(IsOnConnectionQueueKey))
@@ -721,6 +723,83 @@ NS_INLINE BOOL YDBIsMainThread()
 	return result;
 }
 
+- (BOOL)lazyChangesetProcessing
+{
+	__block BOOL result = NO;
+	
+	dispatch_block_t block = ^{
+		result = lazyChangesetProcessing;
+	};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_sync(connectionQueue, block);
+	
+	return result;
+}
+
+- (void)setLazyChangesetProcessing:(BOOL)flag
+{
+	dispatch_block_t block = ^{ @autoreleasepool {
+		
+		if (lazyChangesetProcessing == flag) return;
+		lazyChangesetProcessing = flag;
+		
+		// The state table is what the database consults when forwarding changesets.
+		
+		dispatch_sync(database->snapshotQueue, ^{ @autoreleasepool {
+			
+			for (YapDatabaseConnectionState *state in database->connectionStates)
+			{
+				if (state->connection == self)
+				{
+					state->lazyChangesetProcessing = flag;
+					break;
+				}
+			}
+		}});
+	}};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_sync(connectionQueue, block);
+}
+
+- (BOOL)readTransactionReuseEnabled
+{
+	__block BOOL result = NO;
+	
+	dispatch_block_t block = ^{
+		result = readTransactionReuseEnabled;
+	};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_sync(connectionQueue, block);
+	
+	return result;
+}
+
+- (void)setReadTransactionReuseEnabled:(BOOL)flag
+{
+	dispatch_block_t block = ^{ @autoreleasepool {
+		
+		readTransactionReuseEnabled = flag;
+		
+		if (!flag) {
+			[self releaseReusableReadTransaction];
+		}
+	}};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_sync(connectionQueue, block);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Utilities
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1446,13 +1525,19 @@ NS_INLINE BOOL YDBIsMainThread()
 		{
 			block(longLivedReadTransaction);
 		}
+		else if ([self canReuseReadTransaction])
+		{
+			block(reusableReadTransaction);
+		}
 		else
 		{
 			YapDatabaseReadTransaction *transaction = [self newReadTransaction];
 		
 			[self preReadTransaction:transaction];
 			block(transaction);
-			[self postReadTransaction:transaction];
+			
+			if (![self retainReadTransactionForReuse:transaction])
+				[self postReadTransaction:transaction];
 		}
 	}});
 }
@@ -1503,6 +1588,8 @@ NS_INLINE BOOL YDBIsMainThread()
 			}
 		}
 		
+		[self releaseReusableReadTransaction];
+		
 		__preWriteQueue(self);
 		dispatch_sync(database->writeQueue, ^{ @autoreleasepool {
 			
@@ -1584,13 +1671,19 @@ NS_INLINE BOOL YDBIsMainThread()
 		{
 			block(longLivedReadTransaction);
 		}
+		else if ([self canReuseReadTransaction])
+		{
+			block(reusableReadTransaction);
+		}
 		else
 		{
 			YapDatabaseReadTransaction *transaction = [self newReadTransaction];
 			
 			[self preReadTransaction:transaction];
 			block(transaction);
-			[self postReadTransaction:transaction];
+			
+			if (![self retainReadTransactionForReuse:transaction])
+				[self postReadTransaction:transaction];
 		}
 		
 		if (completionBlock)
@@ -1717,6 +1810,8 @@ NS_INLINE BOOL YDBIsMainThread()
 			}
 		}
 		
+		[self releaseReusableReadTransaction];
+		
 		__preWriteQueue(self);
 		dispatch_sync(database->writeQueue, ^{ @autoreleasepool {
 			
@@ -1875,12 +1970,7 @@ NS_INLINE BOOL YDBIsMainThread()
 				// The transaction can see the sqlite commit from another transaction,
 				// and it hasn't processed the changeset(s) yet. We need to process them now.
 				
-				NSArray *changesets = [database pendingAndCommittedChangesSince:yapSnapshot until:sqlSnapshot];
-				
-				for (NSDictionary *changeset in changesets)
-				{
-					[self noteCommittedChanges:changeset];
-				}
+				NSArray *changesets = [self catchUpToSnapshot:sqlSnapshot];
 				
 				NSAssert(snapshot == sqlSnapshot,
 				         @"Invalid connection state in preReadTransaction: snapshot(%llu) != sqlSnapshot(%llu): %@",
@@ -1911,12 +2001,7 @@ NS_INLINE BOOL YDBIsMainThread()
 			{
 				// The transaction hasn't processed recent changeset(s) yet. We need to process them now.
 				
-				NSArray *changesets = [database pendingAndCommittedChangesSince:localSnapshot until:globalSnapshot];
-				
-				for (NSDictionary *changeset in changesets)
-				{
-					[self noteCommittedChanges:changeset];
-				}
+				NSArray *changesets = [self catchUpToSnapshot:globalSnapshot];
 				
 				NSAssert(snapshot == globalSnapshot,
 				         @"Invalid connection state in preReadTransaction: snapshot(%llu) != globalSnapshot(%llu): %@",
@@ -2049,6 +2134,79 @@ NS_INLINE BOOL YDBIsMainThread()
 	}
 }
 
+/**
+ * Invoked at the start of a read block (if not using a longLivedReadTransaction).
+ * 
+ * Returns YES if the reusableReadTransaction is still valid, meaning nothing has been committed since it began.
+ * This is the fast path: the atomic snapshot check replaces the BEGIN statement and the snapshotQueue round trip.
+ * 
+ * Otherwise the stale transaction (if any) is ended, and the caller should start a new transaction.
+ *
+ * This method must be invoked from within the connectionQueue.
+**/
+- (BOOL)canReuseReadTransaction
+{
+	if (reusableReadTransaction == nil) return NO;
+	
+	uint64_t globalSnapshot = (uint64_t)OSAtomicAdd64Barrier(0, &database->atomicSnapshot);
+	if (snapshot == globalSnapshot)
+	{
+		return YES;
+	}
+	
+	[self releaseReusableReadTransaction];
+	return NO;
+}
+
+/**
+ * Invoked at the end of a read block, in place of postReadTransaction:.
+ * 
+ * If readTransactionReuseEnabled, the transaction is left open so the next read block can reuse it.
+ * For this to be safe, the transaction must hold an "sql-level" snapshot that matches our "yap-level" snapshot.
+ * Otherwise a write transaction could wait on us indefinitely (see markSqlLevelSharedReadLockAcquired),
+ * or our next read could see a database state that doesn't match our caches.
+ * 
+ * Returns NO if the transaction wasn't retained, in which case the caller must invoke postReadTransaction:.
+ *
+ * This method must be invoked from within the connectionQueue.
+**/
+- (BOOL)retainReadTransactionForReuse:(YapDatabaseReadTransaction *)transaction
+{
+	if (!readTransactionReuseEnabled) return NO;
+	
+	if (needsMarkSqlLevelSharedReadLock)
+	{
+		// The block was served entirely from our caches, so sqlite hasn't acquired its snapshot yet.
+		// Acquire it now. This is a one-time cost for the lifetime of the reusable transaction.
+		
+		if ([self readSnapshotFromDatabase] != snapshot) return NO;
+		
+		[self markSqlLevelSharedReadLockAcquired];
+	}
+	
+	uint64_t globalSnapshot = (uint64_t)OSAtomicAdd64Barrier(0, &database->atomicSnapshot);
+	if (snapshot != globalSnapshot) return NO;
+	
+	reusableReadTransaction = transaction;
+	return YES;
+}
+
+/**
+ * Ends the reusableReadTransaction, if there is one.
+ *
+ * This method must be invoked from within the connectionQueue.
+**/
+- (void)releaseReusableReadTransaction
+{
+	if (reusableReadTransaction)
+	{
+		YapDatabaseReadTransaction *transaction = reusableReadTransaction;
+		reusableReadTransaction = nil;
+		
+		[self postReadTransaction:transaction];
+	}
+}
+
 /**
  * This method executes the state transition steps required before executing a read-write transaction block.
  * 
@@ -2105,12 +2263,7 @@ NS_INLINE BOOL YDBIsMainThread()
 		
 		if (localSnapshot < globalSnapshot)
 		{
-			NSArray *changesets = [database pendingAndCommittedChangesSince:localSnapshot until:globalSnapshot];
-			
-			for (NSDictionary *changeset in changesets)
-			{
-				[self noteCommittedChanges:changeset];
-			}
+			[self catchUpToSnapshot:globalSnapshot];
 			
 			NSAssert(snapshot == globalSnapshot,
 			         @"Invalid connection state in preReadWriteTransaction: snapshot(%llu) != globalSnapshot(%llu)",
@@ -2789,6 +2942,10 @@ NS_INLINE BOOL YDBIsMainThread()
 			// Caller using implicit atomic reBeginLongLivedReadTransaction
 			notifications = (NSMutableArray *)[self endLongLivedReadTransaction];
 		}
+		else
+		{
+			[self releaseReusableReadTransaction];
+		}
 		
 		longLivedReadTransaction = [self newReadTransaction];
 		[self preReadTransaction:longLivedReadTransaction];
@@ -2908,6 +3065,52 @@ NS_INLINE BOOL YDBIsMainThread()
 #pragma mark Changeset Architecture
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Removed rowids are broadcast to the other connections as a sorted array of int64_t values (packed into NSData).
+ * This is created once per commit, and is far more compact than a set of NSNumbers.
+**/
+static NSData* YDBPackSortedRowids(NSSet *rowidNumbers)
+{
+	NSUInteger count = [rowidNumbers count];
+	NSMutableData *data = [NSMutableData dataWithLength:(count * sizeof(int64_t))];
+	
+	int64_t *rowids = (int64_t *)[data mutableBytes];
+	NSUInteger i = 0;
+	
+	for (NSNumber *rowidNumber in rowidNumbers)
+	{
+		rowids[i++] = [rowidNumber longLongValue];
+	}
+	
+	qsort_b(rowids, count, sizeof(int64_t), ^int(const void *a, const void *b) {
+		
+		int64_t rowidA = *(const int64_t *)a;
+		int64_t rowidB = *(const int64_t *)b;
+		
+		return (rowidA < rowidB) ? -1 : ((rowidA > rowidB) ? 1 : 0);
+	});
+	
+	return data;
+}
+
+static BOOL YDBSortedRowidsContains(const int64_t *rowids, NSUInteger count, int64_t rowid)
+{
+	NSUInteger min = 0;
+	NSUInteger max = count;
+	
+	while (min < max)
+	{
+		NSUInteger mid = (min + max) / 2;
+		
+		if (rowids[mid] < rowid)
+			min = mid + 1;
+		else
+			max = mid;
+	}
+	
+	return (min < count) && (rowids[min] == rowid);
+}
+
 /**
  * The creation of changeset dictionaries happens constantly.
  * So, to optimize a bit, we use sharedKeySet's (part of NSDictionary).
@@ -3088,7 +3291,7 @@ NS_INLINE BOOL YDBIsMainThread()
 		
 		if ([removedRowids count] > 0)
 		{
-			internalChangeset[YapDatabaseRemovedRowidsKey] = removedRowids;
+			internalChangeset[YapDatabaseRemovedRowidsKey] = YDBPackSortedRowids(removedRowids);
 		}
 		
 		if (allKeysRemoved)
@@ -3172,7 +3375,7 @@ NS_INLINE BOOL YDBIsMainThread()
 	NSDictionary *changeset_objectChanges   =  [changeset objectForKey:YapDatabaseObjectChangesKey];
 	NSDictionary *changeset_metadataChanges =  [changeset objectForKey:YapDatabaseMetadataChangesKey];
 	
-	NSSet *changeset_removedRowids      = [changeset objectForKey:YapDatabaseRemovedRowidsKey];
+	NSData *changeset_removedRowids     = [changeset objectForKey:YapDatabaseRemovedRowidsKey];
 	NSSet *changeset_removedKeys        = [changeset objectForKey:YapDatabaseRemovedKeysKey];
 	NSSet *changeset_removedCollections = [changeset objectForKey:YapDatabaseRemovedCollectionsKey];
 	
@@ -3215,10 +3418,37 @@ NS_INLINE BOOL YDBIsMainThread()
 		
 		if (changeset_removedRowids)
 		{
-			[changeset_removedRowids enumerateObjectsUsingBlock:^(id obj, BOOL *stop) {
+			const int64_t *removedRowids = (const int64_t *)[changeset_removedRowids bytes];
+			NSUInteger removedRowidsCount = [changeset_removedRowids length] / sizeof(int64_t);
+			
+			if ([keyCache count] < removedRowidsCount)
+			{
+				// The cache is smaller than the changeset (e.g. a large commit).
+				// So check each cached rowid against the sorted list of removed rowids.
 				
-				[keyCache removeObjectForKey:obj];
-			}];
+				__block NSMutableArray *toRemove = nil;
+				[keyCache enumerateKeysWithBlock:^(id key, BOOL *stop) {
+					
+					__unsafe_unretained NSNumber *rowidNumber = (NSNumber *)key;
+					
+					if (YDBSortedRowidsContains(removedRowids, removedRowidsCount, [rowidNumber longLongValue]))
+					{
+						if (toRemove == nil)
+							toRemove = [NSMutableArray array];
+						
+						[toRemove addObject:rowidNumber];
+					}
+				}];
+				
+				[keyCache removeObjectsForKeys:toRemove];
+			}
+			else
+			{
+				for (NSUInteger i = 0; i < removedRowidsCount; i++)
+				{
+					[keyCache removeObjectForKey:@(removedRowids[i])];
+				}
+			}
 		}
 	}
 	
@@ -3230,46 +3460,6 @@ NS_INLINE BOOL YDBIsMainThread()
 		
 		[objectCache removeAllObjects];
 	}
-	else if (hasObjectChanges && !hasRemovedKeys && !hasRemovedCollections && !changeset_allKeysRemoved)
-	{
-		// Shortcut: Nothing was removed from the database.
-		// So we can simply enumerate over the changes and update the cache inline as needed.
-		
-		id yapNull = [YapNull null];    // value == yapNull  : setPrimitive or containment policy
-		id yapTouch = [YapTouch touch]; // value == yapTouch : touchObjectForKey: was used
-		
-		BOOL isPolicyContainment = (objectPolicy == YapDatabasePolicyContainment);
-		BOOL isPolicyShare       = (objectPolicy == YapDatabasePolicyShare);
-		
-		[changeset_objectChanges enumerateKeysAndObjectsUsingBlock:^(id key, id newObject, BOOL *stop) {
-			
-			__unsafe_unretained YapCollectionKey *cacheKey = (YapCollectionKey *)key;
-			
-			if ([objectCache containsKey:cacheKey])
-			{
-				if (newObject == yapNull)
-				{
-					[objectCache removeObjectForKey:cacheKey];
-				}
-				else if (newObject != yapTouch)
-				{
-					if (isPolicyContainment) {
-						[objectCache removeObjectForKey:cacheKey];
-					}
-					else if (isPolicyShare) {
-						[objectCache setObject:newObject forKey:cacheKey];
-					}
-					else // if (isPolicyCopy)
-					{
-						if ([newObject conformsToProtocol:@protocol(NSCopying)])
-							[objectCache setObject:[newObject copy] forKey:cacheKey];
-						else
-							[objectCache removeObjectForKey:cacheKey];
-					}
-				}
-			}
-		}];
-	}
 	else if (hasObjectChanges || hasRemovedKeys || hasRemovedCollections)
 	{
 		NSUInteger updateCapacity = MIN([objectCache count], [changeset_objectChanges count]);
@@ -3278,26 +3468,46 @@ NS_INLINE BOOL YDBIsMainThread()
 		NSMutableArray *keysToUpdate = [NSMutableArray arrayWithCapacity:updateCapacity];
 		NSMutableArray *keysToRemove = [NSMutableArray arrayWithCapacity:removeCapacity];
 		
-		[objectCache enumerateKeysWithBlock:^(id key, BOOL *stop) {
-			
-			// Order matters.
-			// Consider the following database change:
-			//
-			// [transaction removeAllObjectsInAllCollections];
-			// [transaction setObject:obj forKey:key inCollection:collection];
+		if (!hasRemovedKeys && !hasRemovedCollections && !changeset_allKeysRemoved &&
+		    ([changeset_objectChanges count] < [objectCache count]))
+		{
+			// Shortcut: Nothing was removed from the database, and the changeset is smaller than the cache.
+			// So we can simply enumerate over the changes, and look them up in the cache.
 			
-			__unsafe_unretained YapCollectionKey *cacheKey = (YapCollectionKey *)key;
+			[changeset_objectChanges enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+				
+				if ([objectCache containsKey:key])
+				{
+					[keysToUpdate addObject:key];
+				}
+			}];
+		}
+		else
+		{
+			// Enumerate over the cache, and look up each key in the changeset.
+			// This is the cheaper side for large commits (the cache has a limited size).
 			
-			if ([changeset_objectChanges objectForKey:cacheKey])
-			{
-				[keysToUpdate addObject:key];
-			}
-			else if ([changeset_removedKeys containsObject:cacheKey] ||
-					 [changeset_removedCollections containsObject:cacheKey.collection] || changeset_allKeysRemoved)
-			{
-				[keysToRemove addObject:key];
-			}
-		}];
+			[objectCache enumerateKeysWithBlock:^(id key, BOOL *stop) {
+				
+				// Order matters.
+				// Consider the following database change:
+				//
+				// [transaction removeAllObjectsInAllCollections];
+				// [transaction setObject:obj forKey:key inCollection:collection];
+				
+				__unsafe_unretained YapCollectionKey *cacheKey = (YapCollectionKey *)key;
+				
+				if ([changeset_objectChanges objectForKey:cacheKey])
+				{
+					[keysToUpdate addObject:key];
+				}
+				else if ([changeset_removedKeys containsObject:cacheKey] ||
+				         [changeset_removedCollections containsObject:cacheKey.collection] || changeset_allKeysRemoved)
+				{
+					[keysToRemove addObject:key];
+				}
+			}];
+		}
 		
 		[objectCache removeObjectsForKeys:keysToRemove];
 		
@@ -3342,46 +3552,6 @@ NS_INLINE BOOL YDBIsMainThread()
 		
 		[metadataCache removeAllObjects];
 	}
-	else if (hasMetadataChanges && !hasRemovedKeys && !hasRemovedCollections && !changeset_allKeysRemoved)
-	{
-		// Shortcut: Nothing was removed from the database.
-		// So we can simply enumerate over the changes and update the cache inline as needed.
-		
-		id yapNull = [YapNull null];    // value == yapNull  : setPrimitive or containment policy
-		id yapTouch = [YapTouch touch]; // value == yapTouch : touchObjectForKey: was used
-		
-		BOOL isPolicyContainment = (metadataPolicy == YapDatabasePolicyContainment);
-		BOOL isPolicyShare       = (metadataPolicy == YapDatabasePolicyShare);
-		
-		[changeset_metadataChanges enumerateKeysAndObjectsUsingBlock:^(id key, id newMetadata, BOOL *stop) {
-			
-			__unsafe_unretained YapCollectionKey *cacheKey = (YapCollectionKey *)key;
-			
-			if ([metadataCache containsKey:cacheKey])
-			{
-				if (newMetadata == yapNull)
-				{
-					[metadataCache removeObjectForKey:cacheKey];
-				}
-				else if (newMetadata != yapTouch)
-				{
-					if (isPolicyContainment) {
-						[metadataCache removeObjectForKey:cacheKey];
-					}
-					else if (isPolicyShare) {
-						[metadataCache setObject:newMetadata forKey:cacheKey];
-					}
-					else // if (isPolicyCopy)
-					{
-						if ([newMetadata conformsToProtocol:@protocol(NSCopying)])
-							[metadataCache setObject:[newMetadata copy] forKey:cacheKey];
-						else
-							[metadataCache removeObjectForKey:cacheKey];
-					}
-				}
-			}
-		}];
-	}
 	else if (hasMetadataChanges || hasRemovedKeys || hasRemovedCollections)
 	{
 		NSUInteger updateCapacity = MIN([metadataCache count], [changeset_metadataChanges count]);
@@ -3390,26 +3560,46 @@ NS_INLINE BOOL YDBIsMainThread()
 		NSMutableArray *keysToUpdate = [NSMutableArray arrayWithCapacity:updateCapacity];
 		NSMutableArray *keysToRemove = [NSMutableArray arrayWithCapacity:removeCapacity];
 		
-		[metadataCache enumerateKeysWithBlock:^(id key, BOOL *stop) {
-			
-			// Order matters.
-			// Consider the following database change:
-			//
-			// [transaction removeAllObjectsInAllCollections];
-			// [transaction setObject:obj forKey:key inCollection:collection];
+		if (!hasRemovedKeys && !hasRemovedCollections && !changeset_allKeysRemoved &&
+		    ([changeset_metadataChanges count] < [metadataCache count]))
+		{
+			// Shortcut: Nothing was removed from the database, and the changeset is smaller than the cache.
+			// So we can simply enumerate over the changes, and look them up in the cache.
 			
-			__unsafe_unretained YapCollectionKey *cacheKey = (YapCollectionKey *)key;
+			[changeset_metadataChanges enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+				
+				if ([metadataCache containsKey:key])
+				{
+					[keysToUpdate addObject:key];
+				}
+			}];
+		}
+		else
+		{
+			// Enumerate over the cache, and look up each key in the changeset.
+			// This is the cheaper side for large commits (the cache has a limited size).
 			
-			if ([changeset_metadataChanges objectForKey:cacheKey])
-			{
-				[keysToUpdate addObject:key];
-			}
-			else if ([changeset_removedKeys containsObject:cacheKey] ||
-					 [changeset_removedCollections containsObject:cacheKey.collection] || changeset_allKeysRemoved)
-			{
-				[keysToRemove addObject:key];
-			}
-		}];
+			[metadataCache enumerateKeysWithBlock:^(id key, BOOL *stop) {
+				
+				// Order matters.
+				// Consider the following database change:
+				//
+				// [transaction removeAllObjectsInAllCollections];
+				// [transaction setObject:obj forKey:key inCollection:collection];
+				
+				__unsafe_unretained YapCollectionKey *cacheKey = (YapCollectionKey *)key;
+				
+				if ([changeset_metadataChanges objectForKey:cacheKey])
+				{
+					[keysToUpdate addObject:key];
+				}
+				else if ([changeset_removedKeys containsObject:cacheKey] ||
+				         [changeset_removedCollections containsObject:cacheKey.collection] || changeset_allKeysRemoved)
+				{
+					[keysToRemove addObject:key];
+				}
+			}];
+		}
 		
 		[metadataCache removeObjectsForKeys:keysToRemove];
 		
@@ -3447,6 +3637,64 @@ NS_INLINE BOOL YDBIsMainThread()
 	}
 }
 
+/**
+ * Internal method.
+ *
+ * Brings the connection up to the given snapshot by processing the changesets it hasn't seen yet,
+ * and returns the changesets that were processed.
+ *
+ * Normally the database still has every changeset we need.
+ * But a connection using lazyChangesetProcessing may have fallen further behind than the database is willing
+ * to remember. In that case we reset our in-memory components to match the database's current snapshot,
+ * and then process whatever pending changesets remain (those are never dropped).
+ *
+ * This method must be invoked from within connectionQueue, within database->snapshotQueue.
+**/
+- (NSArray *)catchUpToSnapshot:(uint64_t)maxSnapshot
+{
+	NSAssert(dispatch_get_specific(database->IsOnSnapshotQueueKey), @"Must be invoked within snapshotQueue");
+	
+	NSArray *changesets = [database pendingAndCommittedChangesSince:snapshot until:maxSnapshot];
+	
+	BOOL missedChangesets = ([changesets count] != (maxSnapshot - snapshot));
+	if (!missedChangesets && [changesets count] > 0)
+	{
+		NSDictionary *firstChangeset = [changesets objectAtIndex:0];
+		uint64_t firstSnapshot = [[firstChangeset objectForKey:YapDatabaseSnapshotKey] unsignedLongLongValue];
+		
+		missedChangesets = (firstSnapshot != (snapshot + 1));
+	}
+	
+	if (missedChangesets)
+	{
+		YDBLogVerbose(@"Connection %@ missed dropped changesets (%llu -> %llu), resetting in-memory state",
+		              self, snapshot, maxSnapshot);
+		
+		// Anything we have cached may be stale, and we can no longer find out which parts.
+		
+		[keyCache removeAllObjects];
+		[objectCache removeAllObjects];
+		[metadataCache removeAllObjects];
+		
+		// Extension connections are created lazily, so it's simplest to let them be recreated on demand.
+		
+		[extensions removeAllObjects];
+		
+		// Reload snapshot, registeredExtensions, registeredMemoryTables, etc. from the database.
+		
+		[self prepare];
+		
+		changesets = [database pendingAndCommittedChangesSince:snapshot until:maxSnapshot];
+	}
+	
+	for (NSDictionary *changeset in changesets)
+	{
+		[self noteCommittedChanges:changeset];
+	}
+	
+	return changesets;
+}
+
 /**
  * Internal method.
  *
@@ -3500,6 +3748,14 @@ NS_INLINE BOOL YDBIsMainThread()
 		return;
 	}
 	
+	if (reusableReadTransaction && !dispatch_get_specific(database->IsOnSnapshotQueueKey))
+	{
+		// The reusable read transaction is still on the previous snapshot.
+		// End it so we can move forward (the next read block will start a fresh one).
+		
+		[self releaseReusableReadTransaction];
+	}
+	
 	if (longLivedReadTransaction)
 	{
 		if (dispatch_get_specific(database->IsOnSnapshotQueueKey))
@@ -3523,6 +3779,20 @@ NS_INLINE BOOL YDBIsMainThread()
 		}
 	}
 	
+	if ((changesetSnapshot > (snapshot + 1)) && !dispatch_get_specific(database->IsOnSnapshotQueueKey))
+	{
+		// We skipped some changesets while using lazyChangesetProcessing,
+		// and the database has started forwarding them to us again.
+		// Get caught up first, which also processes this changeset.
+		
+		dispatch_sync(database->snapshotQueue, ^{ @autoreleasepool {
+			
+			[self catchUpToSnapshot:changesetSnapshot];
+		}});
+		
+		return;
+	}
+	
 	// Changeset processing
 	
 	YDBLogVerbose(@"Processing changeset %lu for connection %@, database %@",
@@ -4386,6 +4656,8 @@ NS_INLINE BOOL YDBIsMainThread()
 			}
 		}
 		
+		[self releaseReusableReadTransaction];
+		
 		__preWriteQueue(self);
 		dispatch_sync(database->writeQueue, ^{ @autoreleasepool {
 			
@@ -4477,6 +4749,8 @@ NS_INLINE BOOL YDBIsMainThread()
 			}
 		}
 		
+		[self releaseReusableReadTransaction];
+		
 		__preWriteQueue(self);
 		dispatch_sync(database->writeQueue, ^{ @autoreleasepool {
 			
@@ -4622,6 +4896,19 @@ NS_INLINE BOOL YDBIsMainThread()
 	});
 }
 
+/**
+ * A reusable read transaction poses the same problem for the WAL as a long-lived read transaction.
+ * But since it's just an optimization, there's no need to preserve it. We simply end it,
+ * and the next read block will start a new transaction (which won't lock the WAL).
+**/
+- (void)maybeReleaseReusableReadTransaction
+{
+	dispatch_async(connectionQueue, ^{ @autoreleasepool {
+		
+		[self releaseReusableReadTransaction];
+	}});
+}
+
 NS_INLINE void __preWriteQueue(YapDatabaseConnection *connection)
 {
 	OSSpinLockLock(&connection->lock);
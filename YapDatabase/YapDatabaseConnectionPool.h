@@ -0,0 +1,104 @@
+#import <Foundation/Foundation.h>
+
+@class YapDatabase;
+@class YapDatabaseConnection;
+@class YapDatabaseReadTransaction;
+
+/**
+ * Welcome to YapDatabase!
+ *
+ * The project page has a wealth of documentation if you have any questions.
+ * https://github.com/yaptv/YapDatabase
+ *
+ * If you're new to the project you may want to visit the wiki.
+ * https://github.com/yaptv/YapDatabase/wiki
+ *
+ * A connection pool owns a fixed number of read-only connections,
+ * and spreads read transactions across them.
+ *
+ * Recall that a single connection serializes access to itself.
+ * So if many threads share one connection, they'll all wait in line for it.
+ * The usual answer is to create multiple connections, and the pool simply does that bookkeeping for you.
+ * Each read is dispatched to an idle connection if there is one, or else to the least busy connection.
+ *
+ * Reads may optionally specify a collection "affinity".
+ * Reads with the same affinity prefer the same connection (as long as it isn't busy),
+ * which tends to keep related objects in that connection's cache.
+ *
+ * The pool is for reads only. Use a dedicated connection for readWrite transactions.
+ *
+ * Note: Don't start a synchronous pool read from within a pool read block.
+ * Just as with a single connection, this may deadlock if the pool picks the connection you're already using.
+**/
+@interface YapDatabaseConnectionPool : NSObject
+
+/**
+ * Creates a pool with one connection per active processor.
+**/
+- (id)initWithDatabase:(YapDatabase *)database;
+
+/**
+ * Creates a pool with the given number of connections (minimum of 1).
+**/
+- (id)initWithDatabase:(YapDatabase *)database connectionCount:(NSUInteger)connectionCount;
+
+@property (nonatomic, strong, readonly) YapDatabase *database;
+
+/**
+ * The connections owned by the pool.
+ *
+ * These are regular connections created via [database newConnection], and named after the pool.
+ * You may configure them as needed (e.g. objectCacheLimit, readTransactionReuseEnabled).
+ * But you should not use them directly for transactions, as the pool doesn't track such usage.
+**/
+@property (nonatomic, copy, readonly) NSArray *connections;
+
+/**
+ * Read-only access to the database, via an idle or least busy connection.
+ *
+ * The readWithBlock variants are synchronous.
+ * The asyncReadWithBlock variants are asynchronous.
+ *
+ * If completionQueue is NULL, dispatch_get_main_queue() is automatically used.
+ *
+ * @see YapDatabaseConnection readWithBlock:
+**/
+- (void)readWithBlock:(void (^)(YapDatabaseReadTransaction *transaction))block;
+
+- (void)asyncReadWithBlock:(void (^)(YapDatabaseReadTransaction *transaction))block;
+
+- (void)asyncReadWithBlock:(void (^)(YapDatabaseReadTransaction *transaction))block
+           completionBlock:(dispatch_block_t)completionBlock;
+
+- (void)asyncReadWithBlock:(void (^)(YapDatabaseReadTransaction *transaction))block
+           completionQueue:(dispatch_queue_t)completionQueue
+           completionBlock:(dispatch_block_t)completionBlock;
+
+/**
+ * Same as above, but the connection is chosen by affinity to the given collection.
+ *
+ * The preferred connection is chosen by hashing the collection name.
+ * It's used if it's idle (or if all connections are equally busy).
+ * Otherwise the read goes to the least busy connection.
+**/
+- (void)readWithCollectionAffinity:(NSString *)collection
+                             block:(void (^)(YapDatabaseReadTransaction *transaction))block;
+
+- (void)asyncReadWithCollectionAffinity:(NSString *)collection
+                                  block:(void (^)(YapDatabaseReadTransaction *transaction))block
+                        completionQueue:(dispatch_queue_t)completionQueue
+                        completionBlock:(dispatch_block_t)completionBlock;
+
+/**
+ * Metrics.
+ *
+ * The queue depth of a connection is the number of pool reads that have been dispatched to it,
+ * and haven't yet completed (including the one currently executing, if any).
+ *
+ * The queueDepths array contains an NSNumber for each connection, in the same order as the connections array.
+ * These values are a point-in-time sample, and may already be out-of-date by the time you inspect them.
+**/
+- (NSArray *)queueDepths;
+- (NSUInteger)totalQueueDepth;
+
+@end
@@ -0,0 +1,214 @@
+#import "YapDatabaseConnectionPool.h"
+#import "YapDatabase.h"
+#import "YapDatabaseConnection.h"
+
+#import <libkern/OSAtomic.h>
+
+#if ! __has_feature(objc_arc)
+#warning This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+
+@implementation YapDatabaseConnectionPool
+{
+	NSArray *connections;
+	
+	volatile int32_t *connectionQueueDepths; // One per connection, modified via OSAtomic
+	volatile int32_t nextIndex;              // Rotating start position for reads without affinity
+}
+
+@synthesize database = database;
+@synthesize connections = connections;
+
+- (id)initWithDatabase:(YapDatabase *)inDatabase
+{
+	return [self initWithDatabase:inDatabase connectionCount:[[NSProcessInfo processInfo] activeProcessorCount]];
+}
+
+- (id)initWithDatabase:(YapDatabase *)inDatabase connectionCount:(NSUInteger)connectionCount
+{
+	if (inDatabase == nil) return nil;
+	
+	if ((self = [super init]))
+	{
+		database = inDatabase;
+		
+		if (connectionCount == 0)
+			connectionCount = 1;
+		
+		NSMutableArray *newConnections = [NSMutableArray arrayWithCapacity:connectionCount];
+		
+		for (NSUInteger i = 0; i < connectionCount; i++)
+		{
+			YapDatabaseConnection *connection = [database newConnection];
+			connection.name = [NSString stringWithFormat:@"YapDatabaseConnectionPool[%lu]", (unsigned long)i];
+			
+			[newConnections addObject:connection];
+		}
+		
+		connections = [newConnections copy];
+		
+		connectionQueueDepths = calloc(connectionCount, sizeof(int32_t));
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	if (connectionQueueDepths)
+		free((void *)connectionQueueDepths);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Connection Selection
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the index of the connection to use for the next read.
+ *
+ * If a collection is given, we start at the connection it hashes to. Otherwise we start at a rotating position,
+ * so that concurrent reads without affinity don't all pile onto the first connection.
+ * From there we take the first idle connection, or else the least busy one (ties going to the starting connection).
+ *
+ * The queue depths are read without synchronization. A stale value just means a slightly less optimal choice.
+**/
+- (NSUInteger)connectionIndexForCollection:(NSString *)collection
+{
+	NSUInteger count = [connections count];
+	NSUInteger startIndex;
+	
+	if (collection)
+		startIndex = [collection hash] % count;
+	else
+		startIndex = (NSUInteger)((uint32_t)OSAtomicIncrement32(&nextIndex)) % count;
+	
+	NSUInteger bestIndex = startIndex;
+	int32_t bestDepth = connectionQueueDepths[startIndex];
+	
+	for (NSUInteger i = 1; (i < count) && (bestDepth > 0); i++)
+	{
+		NSUInteger index = (startIndex + i) % count;
+		int32_t depth = connectionQueueDepths[index];
+		
+		if (depth < bestDepth)
+		{
+			bestIndex = index;
+			bestDepth = depth;
+		}
+	}
+	
+	return bestIndex;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Transactions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (void)_readWithCollection:(NSString *)collection block:(void (^)(YapDatabaseReadTransaction *))block
+{
+	NSUInteger index = [self connectionIndexForCollection:collection];
+	YapDatabaseConnection *connection = [connections objectAtIndex:index];
+	
+	OSAtomicIncrement32Barrier(&connectionQueueDepths[index]);
+	
+	[connection readWithBlock:block];
+	
+	OSAtomicDecrement32Barrier(&connectionQueueDepths[index]);
+}
+
+- (void)_asyncReadWithCollection:(NSString *)collection
+                           block:(void (^)(YapDatabaseReadTransaction *))block
+                 completionQueue:(dispatch_queue_t)completionQueue
+                 completionBlock:(dispatch_block_t)completionBlock
+{
+	NSUInteger index = [self connectionIndexForCollection:collection];
+	YapDatabaseConnection *connection = [connections objectAtIndex:index];
+	
+	OSAtomicIncrement32Barrier(&connectionQueueDepths[index]);
+	
+	// Note: The block retains self (and thus connectionQueueDepths) until the read has executed.
+	
+	[connection asyncReadWithBlock:^(YapDatabaseReadTransaction *transaction) {
+		
+		block(transaction);
+		
+		OSAtomicDecrement32Barrier(&self->connectionQueueDepths[index]);
+	
+	} completionQueue:completionQueue completionBlock:completionBlock];
+}
+
+- (void)readWithBlock:(void (^)(YapDatabaseReadTransaction *transaction))block
+{
+	[self _readWithCollection:nil block:block];
+}
+
+- (void)asyncReadWithBlock:(void (^)(YapDatabaseReadTransaction *transaction))block
+{
+	[self _asyncReadWithCollection:nil block:block completionQueue:NULL completionBlock:NULL];
+}
+
+- (void)asyncReadWithBlock:(void (^)(YapDatabaseReadTransaction *transaction))block
+           completionBlock:(dispatch_block_t)completionBlock
+{
+	[self _asyncReadWithCollection:nil block:block completionQueue:NULL completionBlock:completionBlock];
+}
+
+- (void)asyncReadWithBlock:(void (^)(YapDatabaseReadTransaction *transaction))block
+           completionQueue:(dispatch_queue_t)completionQueue
+           completionBlock:(dispatch_block_t)completionBlock
+{
+	[self _asyncReadWithCollection:nil block:block completionQueue:completionQueue completionBlock:completionBlock];
+}
+
+- (void)readWithCollectionAffinity:(NSString *)collection
+                             block:(void (^)(YapDatabaseReadTransaction *transaction))block
+{
+	if (collection == nil) collection = @"";
+	
+	[self _readWithCollection:collection block:block];
+}
+
+- (void)asyncReadWithCollectionAffinity:(NSString *)collection
+                                  block:(void (^)(YapDatabaseReadTransaction *transaction))block
+                        completionQueue:(dispatch_queue_t)completionQueue
+                        completionBlock:(dispatch_block_t)completionBlock
+{
+	if (collection == nil) collection = @"";
+	
+	[self _asyncReadWithCollection:collection
+	                         block:block
+	               completionQueue:completionQueue
+	               completionBlock:completionBlock];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Metrics
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (NSArray *)queueDepths
+{
+	NSUInteger count = [connections count];
+	NSMutableArray *result = [NSMutableArray arrayWithCapacity:count];
+	
+	for (NSUInteger i = 0; i < count; i++)
+	{
+		[result addObject:@(OSAtomicAdd32Barrier(0, &connectionQueueDepths[i]))];
+	}
+	
+	return result;
+}
+
+- (NSUInteger)totalQueueDepth
+{
+	NSUInteger count = [connections count];
+	NSUInteger total = 0;
+	
+	for (NSUInteger i = 0; i < count; i++)
+	{
+		total += (NSUInteger)OSAtomicAdd32Barrier(0, &connectionQueueDepths[i]);
+	}
+	
+	return total;
+}
+
+@end
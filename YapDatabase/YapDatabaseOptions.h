@@ -76,6 +76,22 @@ typedef NSString* (^YapDatabaseOptionsPassphraseBlock)(void);
 **/
 @property (nonatomic, assign, readwrite) NSInteger pragmaJournalSizeLimit;
 
+/**
+ * Connections with lazyChangesetProcessing enabled don't receive changesets while they're idle.
+ * Instead they catch up at the start of their next transaction, using the changesets retained by the database.
+ * 
+ * This option bounds the number of committed changesets the database will hold onto for such connections.
+ * A lazy connection that has fallen further behind than this simply drops its caches,
+ * and jumps directly to the most recent snapshot.
+ * 
+ * Changesets are only retained while at least one connection has lazyChangesetProcessing enabled.
+ * 
+ * The default value is 25.
+ * 
+ * @see YapDatabaseConnection lazyChangesetProcessing
+**/
+@property (nonatomic, assign, readwrite) NSUInteger maxRetainedChangesets;
+
 #ifdef SQLITE_HAS_CODEC
 /**
  * Set a block here that returns the passphrase for the SQLCipher
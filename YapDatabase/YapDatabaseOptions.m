@@ -17,6 +17,7 @@
 @synthesize corruptAction = corruptAction;
 @synthesize pragmaSynchronous = pragmaSynchronous;
 @synthesize pragmaJournalSizeLimit = pragmaJournalSizeLimit;
+@synthesize maxRetainedChangesets = maxRetainedChangesets;
 
 - (id)init
 {
@@ -25,6 +26,7 @@
 		corruptAction = YapDatabaseCorruptAction_Rename;
 		pragmaSynchronous = YapDatabasePragmaSynchronous_Full;
 		pragmaJournalSizeLimit = 0;
+		maxRetainedChangesets = 25;
 	}
 	return self;
 }
@@ -35,6 +37,7 @@
 	copy->corruptAction = corruptAction;
 	copy->pragmaSynchronous = pragmaSynchronous;
 	copy->pragmaJournalSizeLimit = pragmaJournalSizeLimit;
+	copy->maxRetainedChangesets = maxRetainedChangesets;
 #ifdef SQLITE_HAS_CODEC
     copy.passphraseBlock = _passphraseBlock;
 #endif